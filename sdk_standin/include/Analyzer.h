@@ -0,0 +1,60 @@
+#ifndef ANALYZER
+#define ANALYZER
+
+#include "AnalyzerTypes.h"
+#include "AnalyzerResults.h"
+#include "AnalyzerSettings.h"
+#include "AnalyzerChannelData.h"
+#include "SimulationChannelDescriptor.h"
+#include <memory>
+#include <cstring>
+
+struct AnalyzerStandInData;
+
+class ANALYZER_EXPORT Analyzer
+{
+public:
+	Analyzer();
+	virtual ~Analyzer() = 0;
+
+	virtual void WorkerThread() = 0;
+
+	//sample_rate: if there are multiple devices attached, and one is faster than the other,
+	//we can sample at the speed of the faster one; and pretend the slower one is the same speed.
+	virtual U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels ) = 0;
+	virtual U32 GetMinimumSampleRateHz() = 0; //provide the sample rate required to generate good simulation data
+	virtual const char* GetAnalyzerName() const = 0;
+	virtual bool NeedsRerun() = 0;
+
+	//use, but don't override:
+	void SetAnalyzerSettings( AnalyzerSettings* settings );
+	void KillThread();
+	AnalyzerChannelData* GetAnalyzerChannelData( Channel& channel ); //only valid to use in WorkerThread
+	void ReportProgress( U64 sample_number );
+	void SetAnalyzerResults( AnalyzerResults* results );
+	U32 GetSimulationSampleRate();
+	U32 GetSampleRate();
+	U64 GetTriggerSample();
+
+	void CheckIfThreadShouldExit();
+	double GetAnalyzerProgress();
+
+	//stand-in:
+	AnalyzerSettings* GetAnalyzerSettings();
+	AnalyzerResults* GetAnalyzerResults();
+	AnalyzerStandInData* GetStandInData();
+
+	virtual void SetupResults();
+
+protected:
+	AnalyzerStandInData* mStandInData;
+};
+
+class ANALYZER_EXPORT Analyzer2 : public Analyzer
+{
+public:
+	Analyzer2();
+	virtual void SetupResults();
+};
+
+#endif //ANALYZER
@@ -0,0 +1,54 @@
+#ifndef ANALYZER_CHANNEL_DATA
+#define ANALYZER_CHANNEL_DATA
+
+#include "LogicPublicTypes.h"
+#include <vector>
+#include <cstddef>
+
+/* Edge-list backed channel: mEdges holds the sample numbers at which the line changes state, in increasing order. */
+/* Asking for data beyond mLastSample throws AnalyzerStandIn::EndOfCapture - the stand-in equivalent of the real */
+/* SDK blocking until more data is captured. */
+
+class ANALYZER_EXPORT AnalyzerChannelData
+{
+public:
+	AnalyzerChannelData( BitState initial_state, const std::vector<U64>& edges, U64 last_sample );
+	~AnalyzerChannelData();
+
+	//State
+	U64 GetSampleNumber();
+	BitState GetBitState();
+
+	//Basic:
+	U32 Advance( U32 num_samples ); //move forward the specified number of samples. Returns the number of times the bit changed state during the move.
+	U32 AdvanceToAbsPosition( U64 sample_number ); //move forward to the specified sample number. Returns the number of times the bit changed state during the move.
+	void AdvanceToNextEdge(); //move forward until the bit state changes from what it is now.
+
+	//Fancier:
+	U64 GetSampleOfNextEdge(); //without moving, get the sample of the next transition.
+	bool WouldAdvancingCauseTransition( U32 num_samples ); //if we advanced, would we encounter any transitions?
+	bool WouldAdvancingToAbsPositionCauseTransition( U64 sample_number ); //if we advanced, would we encounter any transitions?
+
+	//minimum pulse tracking.
+	void TrackMinimumPulseWidth();
+	U64 GetMinimumPulseWidthSoFar();
+
+	//Fancier, part II
+	bool DoMoreTransitionsExistInCurrentData(); //use this when you have a situation where you have multiple lines, and you need to handle the case where one or the other of them may never change again, and you don't know which.
+
+protected:
+	void CheckAvailable( U64 sample_number );
+	void MoveTo( U64 sample_number );
+
+	const std::vector<U64>& mEdges;
+	U64 mLastSample;
+	U64 mSampleNumber;
+	size_t mNextEdge;
+	BitState mBitState;
+
+	bool mTrackMinimumPulseWidth;
+	U64 mLastEdge;
+	U64 mMinimumPulseWidth;
+};
+
+#endif //ANALYZER_CHANNEL_DATA
@@ -0,0 +1,101 @@
+#ifndef ANALYZER_RESULTS
+#define ANALYZER_RESULTS
+
+#include "AnalyzerTypes.h"
+#include <string>
+#include <vector>
+#include <map>
+
+#define INVALID_RESULT_INDEX 0xFFFFFFFFFFFFFFFFull
+
+class ANALYZER_EXPORT Frame
+{
+public:
+	Frame();
+	Frame( const Frame& frame );
+	~Frame();
+
+	S64 mStartingSampleInclusive;
+	S64 mEndingSampleInclusive;
+	U64 mData1;
+	U64 mData2;
+	U8 mType;
+	U8 mFlags;
+
+	bool HasFlag( U8 flag );
+};
+
+class ANALYZER_EXPORT AnalyzerResults
+{
+public:
+	enum MarkerType { Dot, ErrorDot, Square, ErrorSquare, UpArrow, DownArrow, X, ErrorX, Start, Stop, One, Zero };
+
+	AnalyzerResults();
+	virtual ~AnalyzerResults();
+
+	//override:
+	virtual void GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base ) = 0;
+	virtual void GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id ) = 0;
+	virtual void GenerateFrameTabularText( U64 frame_index, DisplayBase display_base ) = 0;
+	virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base ) = 0;
+	virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base ) = 0;
+
+	//use:
+	void AddMarker( U64 sample_number, MarkerType marker_type, Channel& channel );
+
+	U64 AddFrame( const Frame& frame );
+	U64 CommitPacketAndStartNewPacket();
+	void CancelPacketAndStartNewPacket();
+	void AddPacketToTransaction( U64 transaction_id, U64 packet_id );
+	void AddChannelBubblesWillAppearOn( const Channel& channel );
+
+	void CommitResults();
+
+	U64 GetNumFrames();
+	U64 GetNumPackets();
+	Frame GetFrame( U64 frame_id );
+
+	U64 GetPacketContainingFrame( U64 frame_id );
+	U64 GetPacketContainingFrameSequential( U64 frame_id );
+	void GetFramesContainedInPacket( U64 packet_id, U64* first_frame_id, U64* last_frame_id );
+
+	U64 GetTransactionContainingPacket( U64 packet_id );
+	void GetPacketsContainedInTransaction( U64 transaction_id, U64** packet_id_array, U64* packet_id_count );
+
+	void ClearTabularText();
+	void AddTabularText( const char* str1, const char* str2 = NULL, const char* str3 = NULL, const char* str4 = NULL, const char* str5 = NULL, const char* str6 = NULL );
+
+	void ClearResultStrings();
+	void AddResultString( const char* str1, const char* str2 = NULL, const char* str3 = NULL, const char* str4 = NULL, const char* str5 = NULL, const char* str6 = NULL );
+
+	bool UpdateExportProgressAndCheckForCancel( U64 completed_frames, U64 total_frames );
+
+	//stand-in inspection:
+	U64 GetNumMarkers( Channel& channel );
+	void GetMarker( Channel& channel, U64 index, MarkerType* marker_type, U64* marker_sample );
+	U64 GetNumCommittedFrames();
+	const std::vector<std::string>& GetResultStrings();
+	const std::vector<std::string>& GetTabularText();
+
+protected:
+	struct Marker
+	{
+		U64 mSample;
+		MarkerType mType;
+	};
+
+	std::vector<Frame> mFrames;
+	std::vector<U64> mPacketFirstFrame;
+	std::vector<U64> mPacketLastFrame;
+	U64 mPacketStartFrame;
+	std::map<Channel, std::vector<Marker> > mMarkers;
+	std::map<U64, std::vector<U64> > mTransactions;
+	std::map<U64, U64> mPacketTransaction;
+	std::vector<Channel> mBubbleChannels;
+	U64 mCommittedFrames;
+
+	std::vector<std::string> mResultStrings;
+	std::vector<std::string> mTabularText;
+};
+
+#endif //ANALYZER_RESULTS
@@ -0,0 +1,62 @@
+#ifndef ANALYZER_SETTINGS
+#define ANALYZER_SETTINGS
+
+#include "AnalyzerTypes.h"
+#include "AnalyzerSettingInterface.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+class ANALYZER_EXPORT AnalyzerSettings
+{
+public:
+	AnalyzerSettings();
+	virtual ~AnalyzerSettings();
+
+	//Implement
+	virtual bool SetSettingsFromInterfaces() = 0;
+	virtual void LoadSettings( const char* settings ) = 0;
+	virtual const char* SaveSettings() = 0;
+
+	//Use, and provide in Constructor
+	void ClearChannels();
+	void AddChannel( Channel& channel, const char* channel_label, bool is_used );
+	void SetErrorText( const char* error_text );
+	void AddInterface( AnalyzerSettingInterface* analyzer_setting_interface );
+
+	void AddExportOption( U32 user_id, const char* menu_text );
+	void AddExportExtension( U32 user_id, const char* extension_description, const char* extension );
+
+	const char* SetReturnString( const char* str );
+
+	//Stand-in inspection
+	U32 GetSettingsInterfacesCount();
+	AnalyzerSettingInterface* GetSettingsInterface( U32 index );
+	U32 GetChannelsCount();
+	Channel GetChannel( U32 index, const char** channel_label, bool* channel_is_used );
+	U32 GetExportOptionsCount();
+	void GetExportOption( U32 index, U32* user_id, const char** menu_text );
+	const char* GetSaveErrorMessage();
+
+protected:
+	struct ChannelEntry
+	{
+		Channel mChannel;
+		std::string mLabel;
+		bool mIsUsed;
+	};
+
+	struct ExportOption
+	{
+		U32 mUserId;
+		std::string mMenuText;
+	};
+
+	std::vector<AnalyzerSettingInterface*> mInterfaces;
+	std::vector<ChannelEntry> mChannels;
+	std::vector<ExportOption> mExportOptions;
+	std::string mErrorText;
+	std::string mReturnString;
+};
+
+#endif //ANALYZER_SETTINGS
@@ -0,0 +1,44 @@
+#ifndef ANALYZER_STAND_IN
+#define ANALYZER_STAND_IN
+
+#include "Analyzer.h"
+#include <vector>
+
+/* Headless driver for analyzers built against the stand-in SDK. A Capture is a set of edge lists, one per channel, */
+/* either loaded by the caller or produced by the analyzer's own simulation data generator. RunAnalyzer then runs */
+/* the WorkerThread on the calling thread until it has consumed the whole capture. */
+
+namespace AnalyzerStandIn
+{
+	//thrown from the channel data when the analyzer asks for samples beyond the end of the capture.
+	class EndOfCapture
+	{
+	};
+
+	//thrown from CheckIfThreadShouldExit after KillThread.
+	class ThreadExit
+	{
+	};
+
+	struct CaptureChannel
+	{
+		Channel mChannel;
+		BitState mInitialBitState;
+		std::vector<U64> mEdges;
+	};
+
+	struct Capture
+	{
+		Capture();
+
+		U32 mSampleRateHz;
+		U64 mTriggerSample;
+		U64 mNumSamples;
+		std::vector<CaptureChannel> mChannels;
+	};
+
+	ANALYZER_EXPORT void CaptureFromSimulation( Analyzer* analyzer, U32 sample_rate_hz, U64 num_samples, Capture& capture );
+	ANALYZER_EXPORT void RunAnalyzer( Analyzer* analyzer, const Capture& capture );
+}
+
+#endif //ANALYZER_STAND_IN
@@ -0,0 +1,34 @@
+#ifndef ANALYZER_TYPES
+#define ANALYZER_TYPES
+
+#include "LogicPublicTypes.h"
+
+enum ChannelDataType { ANALOG, DIGITAL, UNDEFINED };
+
+class ANALYZER_EXPORT Channel
+{
+public:
+	Channel();
+	Channel( const Channel& channel );
+	Channel( U64 device_id, U32 channel_index, ChannelDataType data_type );
+	~Channel();
+
+	Channel& operator=( const Channel& channel );
+	bool operator==( const Channel& channel ) const;
+	bool operator!=( const Channel& channel ) const;
+	bool operator>( const Channel& channel ) const;
+	bool operator<( const Channel& channel ) const;
+
+	U64 mDeviceId;
+	U32 mChannelIndex;
+	ChannelDataType mDataType;
+};
+
+#define UNDEFINED_CHANNEL Channel( 0xFFFFFFFFFFFFFFFFull, 0xFFFFFFFF, UNDEFINED )
+
+enum DisplayBase { Binary, Decimal, Hexadecimal, ASCII, AsciiHex };
+
+#define DISPLAY_AS_ERROR_FLAG ( 1 << 7 )
+#define DISPLAY_AS_WARNING_FLAG ( 1 << 6 )
+
+#endif //ANALYZER_TYPES
@@ -0,0 +1,33 @@
+#ifndef LOGIC_PUBLIC_TYPES
+#define LOGIC_PUBLIC_TYPES
+
+/* Stand-in for the Saleae Analyzer SDK - see sdk_standin/README.md */
+
+#ifdef _WIN32
+#define ANALYZER_EXPORT __declspec( dllexport )
+#else
+#define ANALYZER_EXPORT __attribute__( ( visibility( "default" ) ) )
+#define __cdecl
+#define __stdcall
+#define __fastcall
+#endif
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+typedef char S8;
+typedef short S16;
+typedef int S32;
+typedef long long int S64;
+
+typedef unsigned char U8;
+typedef unsigned short U16;
+typedef unsigned int U32;
+typedef unsigned long long int U64;
+
+enum BitState { BIT_LOW, BIT_HIGH };
+#define Toggle( x ) ( x == BIT_LOW ? BIT_HIGH : BIT_LOW )
+#define Invert( x ) ( x == BIT_LOW ? BIT_HIGH : BIT_LOW )
+
+#endif //LOGIC_PUBLIC_TYPES
@@ -0,0 +1,95 @@
+#include "Analyzer.h"
+#include "AnalyzerStandIn.h"
+#include "AnalyzerStandInData.h"
+
+Analyzer::Analyzer()
+:	mStandInData( new AnalyzerStandInData() )
+{
+}
+
+Analyzer::~Analyzer()
+{
+	delete mStandInData;
+}
+
+void Analyzer::SetAnalyzerSettings( AnalyzerSettings* settings )
+{
+	mStandInData->mSettings = settings;
+}
+
+void Analyzer::KillThread()
+{
+	mStandInData->mKillThread = true;
+}
+
+AnalyzerChannelData* Analyzer::GetAnalyzerChannelData( Channel& channel )
+{
+	return mStandInData->GetChannelData( channel );
+}
+
+void Analyzer::ReportProgress( U64 sample_number )
+{
+	mStandInData->mProgressSample = sample_number;
+}
+
+void Analyzer::SetAnalyzerResults( AnalyzerResults* results )
+{
+	mStandInData->mResults = results;
+}
+
+U32 Analyzer::GetSimulationSampleRate()
+{
+	return mStandInData->mSimulationSampleRateHz;
+}
+
+U32 Analyzer::GetSampleRate()
+{
+	return mStandInData->mSampleRateHz;
+}
+
+U64 Analyzer::GetTriggerSample()
+{
+	return mStandInData->mTriggerSample;
+}
+
+void Analyzer::CheckIfThreadShouldExit()
+{
+	if( mStandInData->mKillThread == true )
+		throw AnalyzerStandIn::ThreadExit();
+}
+
+double Analyzer::GetAnalyzerProgress()
+{
+	if( mStandInData->mNumSamples == 0 )
+		return 0.0;
+
+	return double( mStandInData->mProgressSample ) / double( mStandInData->mNumSamples );
+}
+
+AnalyzerSettings* Analyzer::GetAnalyzerSettings()
+{
+	return mStandInData->mSettings;
+}
+
+AnalyzerResults* Analyzer::GetAnalyzerResults()
+{
+	return mStandInData->mResults;
+}
+
+AnalyzerStandInData* Analyzer::GetStandInData()
+{
+	return mStandInData;
+}
+
+void Analyzer::SetupResults()
+{
+}
+
+Analyzer2::Analyzer2()
+:	Analyzer()
+{
+}
+
+void Analyzer2::SetupResults()
+{
+}
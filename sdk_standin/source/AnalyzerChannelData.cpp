@@ -0,0 +1,136 @@
+#include "AnalyzerChannelData.h"
+#include "AnalyzerStandIn.h"
+#include "AnalyzerHelpers.h"
+#include <algorithm>
+
+AnalyzerChannelData::AnalyzerChannelData( BitState initial_state, const std::vector<U64>& edges, U64 last_sample )
+:	mEdges( edges ),
+	mLastSample( last_sample ),
+	mSampleNumber( 0 ),
+	mNextEdge( 0 ),
+	mBitState( initial_state ),
+	mTrackMinimumPulseWidth( false ),
+	mLastEdge( 0 ),
+	mMinimumPulseWidth( 0 )
+{
+	//an edge at sample 0 only sets the initial state.
+	while( ( mNextEdge < mEdges.size() ) && ( mEdges[ mNextEdge ] == 0 ) )
+	{
+		mBitState = Invert( mBitState );
+		mNextEdge++;
+	}
+}
+
+AnalyzerChannelData::~AnalyzerChannelData()
+{
+}
+
+U64 AnalyzerChannelData::GetSampleNumber()
+{
+	return mSampleNumber;
+}
+
+BitState AnalyzerChannelData::GetBitState()
+{
+	return mBitState;
+}
+
+U32 AnalyzerChannelData::Advance( U32 num_samples )
+{
+	return AdvanceToAbsPosition( mSampleNumber + num_samples );
+}
+
+U32 AnalyzerChannelData::AdvanceToAbsPosition( U64 sample_number )
+{
+	if( sample_number < mSampleNumber )
+		AnalyzerHelpers::Assert( "AdvanceToAbsPosition can't move backwards" );
+
+	CheckAvailable( sample_number );
+
+	size_t first_edge = mNextEdge;
+	MoveTo( sample_number );
+	return U32( mNextEdge - first_edge );
+}
+
+void AnalyzerChannelData::AdvanceToNextEdge()
+{
+	if( mNextEdge >= mEdges.size() )
+		throw AnalyzerStandIn::EndOfCapture();
+
+	MoveTo( mEdges[ mNextEdge ] );
+}
+
+U64 AnalyzerChannelData::GetSampleOfNextEdge()
+{
+	if( mNextEdge >= mEdges.size() )
+		throw AnalyzerStandIn::EndOfCapture();
+
+	return mEdges[ mNextEdge ];
+}
+
+bool AnalyzerChannelData::WouldAdvancingCauseTransition( U32 num_samples )
+{
+	return WouldAdvancingToAbsPositionCauseTransition( mSampleNumber + num_samples );
+}
+
+bool AnalyzerChannelData::WouldAdvancingToAbsPositionCauseTransition( U64 sample_number )
+{
+	if( ( mNextEdge < mEdges.size() ) && ( mEdges[ mNextEdge ] <= sample_number ) )
+		return true;
+
+	CheckAvailable( sample_number );
+	return false;
+}
+
+void AnalyzerChannelData::TrackMinimumPulseWidth()
+{
+	mTrackMinimumPulseWidth = true;
+	mLastEdge = mSampleNumber;
+}
+
+U64 AnalyzerChannelData::GetMinimumPulseWidthSoFar()
+{
+	return mMinimumPulseWidth;
+}
+
+bool AnalyzerChannelData::DoMoreTransitionsExistInCurrentData()
+{
+	return mNextEdge < mEdges.size();
+}
+
+void AnalyzerChannelData::CheckAvailable( U64 sample_number )
+{
+	if( sample_number > mLastSample )
+		throw AnalyzerStandIn::EndOfCapture();
+}
+
+void AnalyzerChannelData::MoveTo( U64 sample_number )
+{
+	if( mTrackMinimumPulseWidth == false )
+	{
+		size_t next_edge = std::upper_bound( mEdges.begin() + mNextEdge, mEdges.end(), sample_number ) - mEdges.begin();
+		if( ( ( next_edge - mNextEdge ) & 1 ) != 0 )
+			mBitState = Invert( mBitState );
+
+		mNextEdge = next_edge;
+		mSampleNumber = sample_number;
+		return;
+	}
+
+	while( ( mNextEdge < mEdges.size() ) && ( mEdges[ mNextEdge ] <= sample_number ) )
+	{
+		U64 edge = mEdges[ mNextEdge ];
+		if( mTrackMinimumPulseWidth == true )
+		{
+			U64 width = edge - mLastEdge;
+			if( ( mMinimumPulseWidth == 0 ) || ( width < mMinimumPulseWidth ) )
+				mMinimumPulseWidth = width;
+			mLastEdge = edge;
+		}
+
+		mBitState = Invert( mBitState );
+		mNextEdge++;
+	}
+
+	mSampleNumber = sample_number;
+}
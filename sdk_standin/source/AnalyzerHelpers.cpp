@@ -0,0 +1,352 @@
+#include "AnalyzerHelpers.h"
+#include "AnalyzerStandIn.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+bool AnalyzerHelpers::IsEven( U64 value )
+{
+	return ( value & 1 ) == 0;
+}
+
+bool AnalyzerHelpers::IsOdd( U64 value )
+{
+	return ( value & 1 ) != 0;
+}
+
+U32 AnalyzerHelpers::GetOnesCount( U64 value )
+{
+	U32 count = 0;
+	while( value != 0 )
+	{
+		count += U32( value & 1 );
+		value >>= 1;
+	}
+	return count;
+}
+
+U32 AnalyzerHelpers::Diff32( U32 a, U32 b )
+{
+	if( a > b )
+		return a - b;
+	return b - a;
+}
+
+void AnalyzerHelpers::GetNumberString( U64 number, DisplayBase display_base, U32 num_data_bits, char* result_string, U32 result_string_max_length )
+{
+	std::string result;
+	char buffer[ 128 ];
+
+	if( ( num_data_bits > 0 ) && ( num_data_bits < 64 ) )
+		number &= ( 1ull << num_data_bits ) - 1;
+
+	switch( display_base )
+	{
+	case Binary:
+	{
+		U32 bits = num_data_bits;
+		if( bits == 0 )
+		{
+			bits = 1;
+			while( ( bits < 64 ) && ( ( number >> bits ) != 0 ) )
+				bits++;
+		}
+
+		result = "0b";
+		for( U32 i = bits; i > 0; i-- )
+			result += ( ( number >> ( i - 1 ) ) & 1 ) ? '1' : '0';
+	}
+	break;
+
+	case Decimal:
+		snprintf( buffer, sizeof( buffer ), "%llu", number );
+		result = buffer;
+		break;
+
+	case Hexadecimal:
+	{
+		U32 digits = ( num_data_bits + 3 ) / 4;
+		if( digits == 0 )
+			digits = 1;
+		snprintf( buffer, sizeof( buffer ), "0x%0*llX", int( digits ), number );
+		result = buffer;
+	}
+	break;
+
+	case ASCII:
+	case AsciiHex:
+		if( ( number >= 32 ) && ( number < 127 ) )
+			snprintf( buffer, sizeof( buffer ), "%c", char( number ) );
+		else
+			snprintf( buffer, sizeof( buffer ), "'%llu'", number );
+		result = buffer;
+
+		if( display_base == AsciiHex )
+		{
+			snprintf( buffer, sizeof( buffer ), " (0x%0*llX)", int( ( num_data_bits + 3 ) / 4 ), number );
+			result += buffer;
+		}
+		break;
+	}
+
+	strncpy( result_string, result.c_str(), result_string_max_length );
+	result_string[ result_string_max_length - 1 ] = '\0';
+}
+
+void AnalyzerHelpers::GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length )
+{
+	double time_s = double( S64( sample - trigger_sample ) ) / double( sample_rate_hz );
+	snprintf( result_string, result_string_max_length, "%.9f", time_s );
+}
+
+void AnalyzerHelpers::Assert( const char* message )
+{
+	fprintf( stderr, "Analyzer assert: %s\n", message );
+	abort();
+}
+
+U64 AnalyzerHelpers::AdjustSimulationTargetSample( U64 target_sample, U32 sample_rate, U32 simulation_sample_rate )
+{
+	if( sample_rate == simulation_sample_rate )
+		return target_sample;
+
+	return U64( double( target_sample ) * double( simulation_sample_rate ) / double( sample_rate ) );
+}
+
+bool AnalyzerHelpers::DoesChannelExist( Channel& channel )
+{
+	return channel != UNDEFINED_CHANNEL;
+}
+
+void* AnalyzerHelpers::StartFile( const char* file, bool append )
+{
+	FILE* f = fopen( file, append ? "ab" : "wb" );
+	if( f == NULL )
+		Assert( "StartFile: unable to open file" );
+	return f;
+}
+
+void AnalyzerHelpers::AppendToFile( U8* data, U32 data_length, void* file )
+{
+	fwrite( data, 1, data_length, ( FILE* )file );
+}
+
+void AnalyzerHelpers::EndFile( void* file )
+{
+	fclose( ( FILE* )file );
+}
+
+ClockGenerator::ClockGenerator()
+:	mSamplesPerHalfPeriod( 1.0 ),
+	mSampleRateHz( 1.0 ),
+	mError( 0.0 )
+{
+}
+
+ClockGenerator::~ClockGenerator()
+{
+}
+
+void ClockGenerator::Init( double target_frequency, U32 sample_rate_hz )
+{
+	//one "half period" is one transition interval of a clock running at target_frequency transitions per second.
+	mSampleRateHz = double( sample_rate_hz );
+	mSamplesPerHalfPeriod = mSampleRateHz / target_frequency;
+	mError = 0.0;
+}
+
+U32 ClockGenerator::AdvanceByHalfPeriod( double multiple )
+{
+	double samples = mSamplesPerHalfPeriod * multiple + mError;
+	U32 whole_samples = U32( samples );
+	mError = samples - double( whole_samples );
+	return whole_samples;
+}
+
+U32 ClockGenerator::AdvanceByTimeS( double time_s )
+{
+	double samples = mSampleRateHz * time_s + mError;
+	U32 whole_samples = U32( samples );
+	mError = samples - double( whole_samples );
+	return whole_samples;
+}
+
+SimpleArchive::SimpleArchive()
+:	mReadPosition( 0 )
+{
+}
+
+SimpleArchive::~SimpleArchive()
+{
+}
+
+void SimpleArchive::SetString( const char* archive_string )
+{
+	mArchive = archive_string;
+	mReadPosition = 0;
+}
+
+const char* SimpleArchive::GetString()
+{
+	return mArchive.c_str();
+}
+
+bool SimpleArchive::operator<<( U64 data )
+{
+	char buffer[ 32 ];
+	snprintf( buffer, sizeof( buffer ), "%llu ", data );
+	mArchive += buffer;
+	return true;
+}
+
+bool SimpleArchive::operator<<( U32 data )
+{
+	return *this << U64( data );
+}
+
+bool SimpleArchive::operator<<( S64 data )
+{
+	char buffer[ 32 ];
+	snprintf( buffer, sizeof( buffer ), "%lld ", data );
+	mArchive += buffer;
+	return true;
+}
+
+bool SimpleArchive::operator<<( S32 data )
+{
+	return *this << S64( data );
+}
+
+bool SimpleArchive::operator<<( double data )
+{
+	char buffer[ 64 ];
+	snprintf( buffer, sizeof( buffer ), "%.17g ", data );
+	mArchive += buffer;
+	return true;
+}
+
+bool SimpleArchive::operator<<( bool data )
+{
+	return *this << U64( data ? 1 : 0 );
+}
+
+bool SimpleArchive::operator<<( const char* data )
+{
+	//strings are length prefixed so that they may contain spaces.
+	*this << U64( strlen( data ) );
+	mArchive += data;
+	mArchive += ' ';
+	return true;
+}
+
+bool SimpleArchive::operator<<( Channel& data )
+{
+	*this << data.mDeviceId;
+	*this << data.mChannelIndex;
+	*this << U32( data.mDataType );
+	return true;
+}
+
+bool SimpleArchive::ReadToken( std::string& token )
+{
+	while( ( mReadPosition < mArchive.size() ) && ( mArchive[ mReadPosition ] == ' ' ) )
+		mReadPosition++;
+
+	if( mReadPosition >= mArchive.size() )
+		return false;
+
+	size_t end = mArchive.find( ' ', mReadPosition );
+	if( end == std::string::npos )
+		end = mArchive.size();
+
+	token = mArchive.substr( mReadPosition, end - mReadPosition );
+	mReadPosition = end;
+	return true;
+}
+
+bool SimpleArchive::operator>>( U64& data )
+{
+	std::string token;
+	if( ReadToken( token ) == false )
+		return false;
+	data = strtoull( token.c_str(), NULL, 10 );
+	return true;
+}
+
+bool SimpleArchive::operator>>( U32& data )
+{
+	U64 value;
+	if( ( *this >> value ) == false )
+		return false;
+	data = U32( value );
+	return true;
+}
+
+bool SimpleArchive::operator>>( S64& data )
+{
+	std::string token;
+	if( ReadToken( token ) == false )
+		return false;
+	data = strtoll( token.c_str(), NULL, 10 );
+	return true;
+}
+
+bool SimpleArchive::operator>>( S32& data )
+{
+	S64 value;
+	if( ( *this >> value ) == false )
+		return false;
+	data = S32( value );
+	return true;
+}
+
+bool SimpleArchive::operator>>( double& data )
+{
+	std::string token;
+	if( ReadToken( token ) == false )
+		return false;
+	data = strtod( token.c_str(), NULL );
+	return true;
+}
+
+bool SimpleArchive::operator>>( bool& data )
+{
+	U64 value;
+	if( ( *this >> value ) == false )
+		return false;
+	data = ( value != 0 );
+	return true;
+}
+
+bool SimpleArchive::operator>>( char const** data )
+{
+	U64 length;
+	if( ( *this >> length ) == false )
+		return false;
+
+	mReadPosition++; //the separator after the length
+	if( mReadPosition + length > mArchive.size() )
+		return false;
+
+	mStringData = mArchive.substr( mReadPosition, size_t( length ) );
+	mReadPosition += size_t( length );
+	*data = mStringData.c_str();
+	return true;
+}
+
+bool SimpleArchive::operator>>( Channel& data )
+{
+	U64 device_id;
+	U32 channel_index;
+	U32 data_type;
+	if( ( *this >> device_id ) == false )
+		return false;
+	if( ( *this >> channel_index ) == false )
+		return false;
+	if( ( *this >> data_type ) == false )
+		return false;
+
+	data = Channel( device_id, channel_index, ChannelDataType( data_type ) );
+	return true;
+}
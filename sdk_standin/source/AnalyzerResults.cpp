@@ -0,0 +1,222 @@
+#include "AnalyzerResults.h"
+#include "AnalyzerHelpers.h"
+
+Frame::Frame()
+:	mStartingSampleInclusive( 0 ),
+	mEndingSampleInclusive( 0 ),
+	mData1( 0 ),
+	mData2( 0 ),
+	mType( 0 ),
+	mFlags( 0 )
+{
+}
+
+Frame::Frame( const Frame& frame )
+:	mStartingSampleInclusive( frame.mStartingSampleInclusive ),
+	mEndingSampleInclusive( frame.mEndingSampleInclusive ),
+	mData1( frame.mData1 ),
+	mData2( frame.mData2 ),
+	mType( frame.mType ),
+	mFlags( frame.mFlags )
+{
+}
+
+Frame::~Frame()
+{
+}
+
+bool Frame::HasFlag( U8 flag )
+{
+	return ( mFlags & flag ) != 0;
+}
+
+AnalyzerResults::AnalyzerResults()
+:	mPacketStartFrame( 0 ),
+	mCommittedFrames( 0 )
+{
+}
+
+AnalyzerResults::~AnalyzerResults()
+{
+}
+
+void AnalyzerResults::AddMarker( U64 sample_number, MarkerType marker_type, Channel& channel )
+{
+	Marker marker;
+	marker.mSample = sample_number;
+	marker.mType = marker_type;
+	mMarkers[ channel ].push_back( marker );
+}
+
+U64 AnalyzerResults::AddFrame( const Frame& frame )
+{
+	mFrames.push_back( frame );
+	return mFrames.size() - 1;
+}
+
+U64 AnalyzerResults::CommitPacketAndStartNewPacket()
+{
+	if( mPacketStartFrame >= mFrames.size() )
+		return INVALID_RESULT_INDEX;
+
+	mPacketFirstFrame.push_back( mPacketStartFrame );
+	mPacketLastFrame.push_back( mFrames.size() - 1 );
+	mPacketStartFrame = mFrames.size();
+	return mPacketFirstFrame.size() - 1;
+}
+
+void AnalyzerResults::CancelPacketAndStartNewPacket()
+{
+	mPacketStartFrame = mFrames.size();
+}
+
+void AnalyzerResults::AddPacketToTransaction( U64 transaction_id, U64 packet_id )
+{
+	mTransactions[ transaction_id ].push_back( packet_id );
+	mPacketTransaction[ packet_id ] = transaction_id;
+}
+
+void AnalyzerResults::AddChannelBubblesWillAppearOn( const Channel& channel )
+{
+	mBubbleChannels.push_back( channel );
+}
+
+void AnalyzerResults::CommitResults()
+{
+	mCommittedFrames = mFrames.size();
+}
+
+U64 AnalyzerResults::GetNumFrames()
+{
+	return mFrames.size();
+}
+
+U64 AnalyzerResults::GetNumPackets()
+{
+	return mPacketFirstFrame.size();
+}
+
+Frame AnalyzerResults::GetFrame( U64 frame_id )
+{
+	if( frame_id >= mFrames.size() )
+		AnalyzerHelpers::Assert( "GetFrame: frame_id out of range" );
+
+	return mFrames[ size_t( frame_id ) ];
+}
+
+U64 AnalyzerResults::GetPacketContainingFrame( U64 frame_id )
+{
+	size_t lo = 0;
+	size_t hi = mPacketFirstFrame.size();
+	while( lo < hi )
+	{
+		size_t mid = ( lo + hi ) / 2;
+		if( mPacketLastFrame[ mid ] < frame_id )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if( ( lo < mPacketFirstFrame.size() ) && ( mPacketFirstFrame[ lo ] <= frame_id ) )
+		return lo;
+
+	return INVALID_RESULT_INDEX;
+}
+
+U64 AnalyzerResults::GetPacketContainingFrameSequential( U64 frame_id )
+{
+	return GetPacketContainingFrame( frame_id );
+}
+
+void AnalyzerResults::GetFramesContainedInPacket( U64 packet_id, U64* first_frame_id, U64* last_frame_id )
+{
+	if( packet_id >= mPacketFirstFrame.size() )
+	{
+		*first_frame_id = INVALID_RESULT_INDEX;
+		*last_frame_id = INVALID_RESULT_INDEX;
+		return;
+	}
+
+	*first_frame_id = mPacketFirstFrame[ size_t( packet_id ) ];
+	*last_frame_id = mPacketLastFrame[ size_t( packet_id ) ];
+}
+
+U64 AnalyzerResults::GetTransactionContainingPacket( U64 packet_id )
+{
+	std::map<U64, U64>::iterator it = mPacketTransaction.find( packet_id );
+	if( it == mPacketTransaction.end() )
+		return INVALID_RESULT_INDEX;
+
+	return it->second;
+}
+
+void AnalyzerResults::GetPacketsContainedInTransaction( U64 transaction_id, U64** packet_id_array, U64* packet_id_count )
+{
+	std::vector<U64>& packets = mTransactions[ transaction_id ];
+	*packet_id_count = packets.size();
+	*packet_id_array = packets.empty() ? NULL : &packets[ 0 ];
+}
+
+void AnalyzerResults::ClearTabularText()
+{
+	mTabularText.clear();
+}
+
+static void AppendStrings( std::string& result, const char* str1, const char* str2, const char* str3, const char* str4, const char* str5, const char* str6 )
+{
+	const char* strings[] = { str1, str2, str3, str4, str5, str6 };
+	for( U32 i = 0; i < 6; i++ )
+		if( strings[ i ] != NULL )
+			result += strings[ i ];
+}
+
+void AnalyzerResults::AddTabularText( const char* str1, const char* str2, const char* str3, const char* str4, const char* str5, const char* str6 )
+{
+	std::string text;
+	AppendStrings( text, str1, str2, str3, str4, str5, str6 );
+	mTabularText.push_back( text );
+}
+
+void AnalyzerResults::ClearResultStrings()
+{
+	mResultStrings.clear();
+}
+
+void AnalyzerResults::AddResultString( const char* str1, const char* str2, const char* str3, const char* str4, const char* str5, const char* str6 )
+{
+	std::string text;
+	AppendStrings( text, str1, str2, str3, str4, str5, str6 );
+	mResultStrings.push_back( text );
+}
+
+bool AnalyzerResults::UpdateExportProgressAndCheckForCancel( U64 /*completed_frames*/, U64 /*total_frames*/ )
+{
+	return false;
+}
+
+U64 AnalyzerResults::GetNumMarkers( Channel& channel )
+{
+	return mMarkers[ channel ].size();
+}
+
+void AnalyzerResults::GetMarker( Channel& channel, U64 index, MarkerType* marker_type, U64* marker_sample )
+{
+	Marker& marker = mMarkers[ channel ][ size_t( index ) ];
+	*marker_type = marker.mType;
+	*marker_sample = marker.mSample;
+}
+
+U64 AnalyzerResults::GetNumCommittedFrames()
+{
+	return mCommittedFrames;
+}
+
+const std::vector<std::string>& AnalyzerResults::GetResultStrings()
+{
+	return mResultStrings;
+}
+
+const std::vector<std::string>& AnalyzerResults::GetTabularText()
+{
+	return mTabularText;
+}
@@ -0,0 +1,89 @@
+#include "AnalyzerSettings.h"
+
+AnalyzerSettings::AnalyzerSettings()
+{
+}
+
+AnalyzerSettings::~AnalyzerSettings()
+{
+}
+
+void AnalyzerSettings::ClearChannels()
+{
+	mChannels.clear();
+}
+
+void AnalyzerSettings::AddChannel( Channel& channel, const char* channel_label, bool is_used )
+{
+	ChannelEntry entry;
+	entry.mChannel = channel;
+	entry.mLabel = channel_label;
+	entry.mIsUsed = is_used;
+	mChannels.push_back( entry );
+}
+
+void AnalyzerSettings::SetErrorText( const char* error_text )
+{
+	mErrorText = error_text;
+}
+
+void AnalyzerSettings::AddInterface( AnalyzerSettingInterface* analyzer_setting_interface )
+{
+	mInterfaces.push_back( analyzer_setting_interface );
+}
+
+void AnalyzerSettings::AddExportOption( U32 user_id, const char* menu_text )
+{
+	ExportOption option;
+	option.mUserId = user_id;
+	option.mMenuText = menu_text;
+	mExportOptions.push_back( option );
+}
+
+void AnalyzerSettings::AddExportExtension( U32 /*user_id*/, const char* /*extension_description*/, const char* /*extension*/ )
+{
+}
+
+const char* AnalyzerSettings::SetReturnString( const char* str )
+{
+	mReturnString = str;
+	return mReturnString.c_str();
+}
+
+U32 AnalyzerSettings::GetSettingsInterfacesCount()
+{
+	return U32( mInterfaces.size() );
+}
+
+AnalyzerSettingInterface* AnalyzerSettings::GetSettingsInterface( U32 index )
+{
+	return mInterfaces[ index ];
+}
+
+U32 AnalyzerSettings::GetChannelsCount()
+{
+	return U32( mChannels.size() );
+}
+
+Channel AnalyzerSettings::GetChannel( U32 index, const char** channel_label, bool* channel_is_used )
+{
+	*channel_label = mChannels[ index ].mLabel.c_str();
+	*channel_is_used = mChannels[ index ].mIsUsed;
+	return mChannels[ index ].mChannel;
+}
+
+U32 AnalyzerSettings::GetExportOptionsCount()
+{
+	return U32( mExportOptions.size() );
+}
+
+void AnalyzerSettings::GetExportOption( U32 index, U32* user_id, const char** menu_text )
+{
+	*user_id = mExportOptions[ index ].mUserId;
+	*menu_text = mExportOptions[ index ].mMenuText.c_str();
+}
+
+const char* AnalyzerSettings::GetSaveErrorMessage()
+{
+	return mErrorText.c_str();
+}
@@ -0,0 +1,124 @@
+#include "AnalyzerStandIn.h"
+#include "AnalyzerStandInData.h"
+
+AnalyzerStandInData::AnalyzerStandInData()
+:	mSettings( NULL ),
+	mResults( NULL ),
+	mSampleRateHz( 0 ),
+	mSimulationSampleRateHz( 0 ),
+	mTriggerSample( 0 ),
+	mNumSamples( 0 ),
+	mProgressSample( 0 ),
+	mKillThread( false ),
+	mCapture( NULL )
+{
+}
+
+AnalyzerStandInData::~AnalyzerStandInData()
+{
+	ClearChannelData();
+}
+
+AnalyzerChannelData* AnalyzerStandInData::GetChannelData( Channel& channel )
+{
+	std::map<Channel, AnalyzerChannelData*>::iterator it = mChannelData.find( channel );
+	if( it != mChannelData.end() )
+		return it->second;
+
+	U64 last_sample = ( mNumSamples > 0 ) ? mNumSamples - 1 : 0;
+	AnalyzerChannelData* channel_data = NULL;
+
+	if( mCapture != NULL )
+	{
+		for( size_t i = 0; i < mCapture->mChannels.size(); i++ )
+		{
+			const AnalyzerStandIn::CaptureChannel& capture_channel = mCapture->mChannels[ i ];
+			if( capture_channel.mChannel == channel )
+				channel_data = new AnalyzerChannelData( capture_channel.mInitialBitState, capture_channel.mEdges, last_sample );
+		}
+	}
+
+	//channels that were not captured read as a line that never changes.
+	if( channel_data == NULL )
+		channel_data = new AnalyzerChannelData( BIT_HIGH, mNoEdges, last_sample );
+
+	mChannelData[ channel ] = channel_data;
+	return channel_data;
+}
+
+void AnalyzerStandInData::ClearChannelData()
+{
+	for( std::map<Channel, AnalyzerChannelData*>::iterator it = mChannelData.begin(); it != mChannelData.end(); ++it )
+		delete it->second;
+
+	mChannelData.clear();
+}
+
+namespace AnalyzerStandIn
+{
+	Capture::Capture()
+	:	mSampleRateHz( 0 ),
+		mTriggerSample( 0 ),
+		mNumSamples( 0 )
+	{
+	}
+
+	void CaptureFromSimulation( Analyzer* analyzer, U32 sample_rate_hz, U64 num_samples, Capture& capture )
+	{
+		AnalyzerStandInData* data = analyzer->GetStandInData();
+		data->mSimulationSampleRateHz = sample_rate_hz;
+
+		SimulationChannelDescriptor* simulation_channels = NULL;
+		U32 count = analyzer->GenerateSimulationData( num_samples, sample_rate_hz, &simulation_channels );
+
+		capture.mSampleRateHz = sample_rate_hz;
+		capture.mTriggerSample = 0;
+		capture.mNumSamples = num_samples;
+		capture.mChannels.clear();
+
+		for( U32 i = 0; i < count; i++ )
+		{
+			CaptureChannel channel;
+			channel.mChannel = simulation_channels[ i ].GetChannel();
+			channel.mInitialBitState = simulation_channels[ i ].GetInitialBitState();
+
+			const std::vector<U64>& transitions = simulation_channels[ i ].GetTransitions();
+			for( size_t j = 0; j < transitions.size(); j++ )
+				if( transitions[ j ] < num_samples )
+					channel.mEdges.push_back( transitions[ j ] );
+
+			capture.mChannels.push_back( channel );
+		}
+	}
+
+	void RunAnalyzer( Analyzer* analyzer, const Capture& capture )
+	{
+		AnalyzerStandInData* data = analyzer->GetStandInData();
+		data->ClearChannelData();
+		data->mCapture = &capture;
+		data->mSampleRateHz = capture.mSampleRateHz;
+		data->mTriggerSample = capture.mTriggerSample;
+		data->mNumSamples = capture.mNumSamples;
+		data->mProgressSample = 0;
+		data->mKillThread = false;
+
+		analyzer->SetupResults();
+
+		try
+		{
+			analyzer->WorkerThread();
+		}
+		catch( EndOfCapture& )
+		{
+		}
+		catch( ThreadExit& )
+		{
+		}
+
+		if( data->mResults != NULL )
+			data->mResults->CommitResults();
+
+		data->ClearChannelData();
+		data->mCapture = NULL;
+	}
+}
@@ -0,0 +1,30 @@
+#ifndef ANALYZER_STAND_IN_DATA
+#define ANALYZER_STAND_IN_DATA
+
+#include "AnalyzerStandIn.h"
+#include <map>
+
+struct AnalyzerStandInData
+{
+	AnalyzerStandInData();
+	~AnalyzerStandInData();
+
+	AnalyzerChannelData* GetChannelData( Channel& channel );
+	void ClearChannelData();
+
+	AnalyzerSettings* mSettings;
+	AnalyzerResults* mResults;
+
+	U32 mSampleRateHz;
+	U32 mSimulationSampleRateHz;
+	U64 mTriggerSample;
+	U64 mNumSamples;
+	U64 mProgressSample;
+	bool mKillThread;
+
+	const AnalyzerStandIn::Capture* mCapture;
+	std::map<Channel, AnalyzerChannelData*> mChannelData;
+	std::vector<U64> mNoEdges;
+};
+
+#endif //ANALYZER_STAND_IN_DATA
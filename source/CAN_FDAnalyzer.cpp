@@ -1,925 +1,1493 @@
-#include "CAN_FDAnalyzer.h"
-#include "CAN_FDAnalyzerSettings.h"
-#include <AnalyzerChannelData.h>
-
-CAN_FDAnalyzer::CAN_FDAnalyzer()
-:	Analyzer2(),  
-	mSettings( new CAN_FDAnalyzerSettings() ),
-	mSimulationInitilized( false )
-{
-	SetAnalyzerSettings( mSettings.get() );
-}
-
-CAN_FDAnalyzer::~CAN_FDAnalyzer()
-{
-	KillThread();
-}
-
-void CAN_FDAnalyzer::SetupResults()
-{
-	mResults.reset( new CAN_FDAnalyzerResults( this, mSettings.get() ) );
-	SetAnalyzerResults( mResults.get() );
-	mResults->AddChannelBubblesWillAppearOn( mSettings->mInputChannel );
-}
-
-void CAN_FDAnalyzer::WorkerThread()
-{
-	mSampleRateHz = GetSampleRate();
-	mCAN_FD = GetAnalyzerChannelData(mSettings->mInputChannel);
-
-	InitSampleOffsets();
-
-	/* Get to an inter-frame gap at the slow timing */
-	WaitFor7RecessiveBits();
-
-	//now let's pull in the frames, one at a time.
-	for (; ; )
-	{
-		if (mCAN_FD->GetBitState() == mSettings->Recessive())
-			mCAN_FD->AdvanceToNextEdge();
-
-		//we're at the first DOMINANT edge of the frame
-		GetRawFrame();
-		AnalyzeRawFrame();
-
-		if (mCanError == true)
-		{
-			Frame frame;
-			frame.mStartingSampleInclusive = mErrorStartingSample;
-			frame.mEndingSampleInclusive = mErrorEndingSample;
-			frame.mType = CanError;
-			mResults->AddFrame(frame);
-			mResults->CancelPacketAndStartNewPacket();
-		}
-
-		U32 count = (U32)mCanMarkers.size();
-		for (U32 i = 0; i < count; i++)
-		{
-			if (mCanMarkers[i].mType == Standard)
-				mResults->AddMarker(mCanMarkers[i].mSample, AnalyzerResults::Dot, mSettings->mInputChannel);
-			else
-				mResults->AddMarker(mCanMarkers[i].mSample, AnalyzerResults::ErrorX, mSettings->mInputChannel);
-		}
-
-		mResults->CommitResults();
-		ReportProgress(mCAN_FD->GetSampleNumber());
-		CheckIfThreadShouldExit();
-
-		if (mCanError == true)
-		{
-			WaitFor7RecessiveBits();
-		}
-	}
-}
-
-void CAN_FDAnalyzer::InitSampleOffsets()
-{
-	mSampleOffsets.resize(1440);
-
-	mBitRateFactor = (int)mSettings->mBitRateData / (int)mSettings->mBitRateHdr;
-
-	double samples_per_bit = double(mSampleRateHz) / double(mSettings->mBitRateData);
-	double samples_behind = 0.0;
-
-	U32 increment = U32((samples_per_bit * .5) + samples_behind);
-	samples_behind = (samples_per_bit * .5) + samples_behind - double(increment);
-
-	mSampleOffsets[0] = increment;
-	U32 current_offset = increment;
-
-	for (U32 i = 1; i < 1440; i++)
-	{
-		U32 increment = U32(samples_per_bit + samples_behind);
-		samples_behind = samples_per_bit + samples_behind - double(increment);
-		current_offset += increment;
-		mSampleOffsets[i] = current_offset;
-	}
-
-	mNumSamplesIn7Bits = U32(samples_per_bit * 7.0 * mBitRateFactor);   /* This bit time is at the slow header bit rate */
-}
-
-void CAN_FDAnalyzer::WaitFor7RecessiveBits()
-{
-	if (mCAN_FD->GetBitState() == mSettings->Dominant())
-		mCAN_FD->AdvanceToNextEdge();
-
-	for (; ; )
-	{
-		if (mCAN_FD->WouldAdvancingCauseTransition(mNumSamplesIn7Bits) == false)
-			return;
-
-		mCAN_FD->AdvanceToNextEdge();
-		mCAN_FD->AdvanceToNextEdge();
-	}
-}
-
-void CAN_FDAnalyzer::GetRawFrame()
-{
-	mCanError = false;
-	mRecessiveCount = 0;
-	mDominantCount = 0;
-	mRawBitResults.clear();
-
-	if (mCAN_FD->GetBitState() != mSettings->Dominant())
-		AnalyzerHelpers::Assert("GetFrameOrError assumes we start DOMINANT");
-
-	mStartOfFrame = mCAN_FD->GetSampleNumber();
-
-	U32 i = 0;
-	U32 j = 0;
-	//what we're going to do now is capture a sequence up until we get 7 recessive bits (at slow timing) in a row.
-	for (; ; )
-	{
-		if (i > 1440)
-		{
-			//we are in garbage data most likely, lets get out of here.
-			return;
-		}
-
-		mCAN_FD->AdvanceToAbsPosition(mStartOfFrame + mSampleOffsets[i]);
-		i++;
-
-		if (mCAN_FD->GetBitState() == mSettings->Dominant())
-		{
-			//the bit is DOMINANT
-			mDominantCount++;
-			mRecessiveCount = 0;
-			mRawBitResults.push_back(mSettings->Dominant());
-
-			if (mDominantCount == (6 * mBitRateFactor))
-			{
-				//we have detected an error.
-
-				mCanError = true;
-				mErrorStartingSample = mStartOfFrame + mSampleOffsets[i - (5 * mBitRateFactor)];
-				mErrorEndingSample = mStartOfFrame + mSampleOffsets[i];
-
-				//don't use any of these error bits in analysis.
-				for (j = 0; j < (6 * mBitRateFactor); j++)
-				{
-					mRawBitResults.pop_back();
-				}
-
-				mNumRawBits = (U32)mRawBitResults.size();
-
-				break;
-			}
-		}
-		else
-		{
-			//the bit is RECESSIVE
-			mRecessiveCount++;
-			mDominantCount = 0;
-			mRawBitResults.push_back(mSettings->Recessive());
-
-			if (mRecessiveCount == (7 * mBitRateFactor))
-			{
-				//we're done.
-				break;
-			}
-		}
-	}
-
-	mNumRawBits = (U32)mRawBitResults.size();
-}
-
-void CAN_FDAnalyzer::AnalyzeRawFrame()
-{
-	BitState bit;
-	U8 frametype;
-	U64 last_sample;
-
-	mBaudSwitch = false;  /* Assume no baud rate switch required */
-	mCheckingBRS = false; /* Not checking the BRS bit at present */
-
-	UnstuffRawFrameBit(bit, last_sample, true);  //grab the start bit, and reset everything.
-	mArbitrationField.clear();
-	mControlField.clear();
-	mDataField.clear();
-	mCrcFieldWithoutDelimiter.clear();
-	mAckField.clear();
-
-	bool done;
-
-	/* Identifier section comes immediately after start bit */
-
-	mIdentifier = 0;
-	for (U32 i = 0; i < 11; i++)
-	{
-		mIdentifier <<= 1;
-		BitState bit;
-		done = UnstuffRawFrameBit(bit, last_sample);
-		if (done == true)
-			return;
-		mArbitrationField.push_back(bit);
-
-		if (bit == mSettings->Recessive())
-			mIdentifier |= 1;
-	}
-
-	//ok, the next three bits will let us know if this is 11-bit or 29-bit can.  If it's 11-bit, then it'll also tell us if this is a remote frame request or not.
-
-	BitState rtr_rrs;
-	done = UnstuffRawFrameBit(rtr_rrs, last_sample);
-	if (done == true)
-		return;
-
-	BitState ide;
-	done = UnstuffRawFrameBit(ide, last_sample);
-	if (done == true)
-		return;
-
-	/* If ide is dominant, then this is an 11-bit header, else it is a 29-bit */
-
-	if (ide == mSettings->Dominant())
-	{
-		//11-bit CAN
-
-		BitState fdf_res;
-		done = UnstuffRawFrameBit(fdf_res, last_sample);
-		if (done == true)
-			return;
-
-		/* fdf_res bit is the key to recognising whether the frame is standard CAN or CAN-FD */
-		/* This bit is dominant 0 on classic CAN, and recessive 1 on CAN-FD */
-
-		if (fdf_res == mSettings->Dominant())
-		{
-			/* Standard 11-bit CAN */
-			frametype = IdentifierField;
-			mStandardCan = true;
-			mStandardCanFD = false;
-
-			Frame frame;
-			frame.mStartingSampleInclusive = mStartOfFrame + mSampleOffsets[1];
-			frame.mEndingSampleInclusive = last_sample;
-			frame.mType = frametype;
-
-			if (rtr_rrs == mSettings->Recessive()) //since this is 11-bit Standard CAN, we know that rtr_rrs is the RTR bit
-			{
-				mRemoteFrame = true;
-				frame.mFlags = REMOTE_FRAME;
-			}
-			else
-			{
-				mRemoteFrame = false;
-				frame.mFlags = 0;
-			}
-
-			frame.mData1 = mIdentifier;
-			mResults->AddFrame(frame);
-		}
-		else
-		{
-			/* Standard CAN-FD frame */
-
-			frametype = FDIdentifier;
-			mStandardCan = false;
-			mStandardCanFD = true;
-
-			Frame frame;
-			frame.mStartingSampleInclusive = mStartOfFrame + mSampleOffsets[1];
-			frame.mEndingSampleInclusive = last_sample;
-			frame.mType = frametype;
-
-			mRemoteFrame = false;    /* Always a data frame */
-			frame.mFlags = 0;
-
-			frame.mData1 = mIdentifier;
-			mResults->AddFrame(frame);
-
-			/* 3 additional bits before control frame */
-
-			/* Reserved bit for future use - ignored */
-			BitState fdres;
-			done = UnstuffRawFrameBit(fdres, last_sample);
-			if (done == true)
-				return;
-
-			mCheckingBRS = true;
-
-			/* Baud Rate Switch - data section of packet sent at higher rate if this bit is recessive*/
-			BitState brs;
-			done = UnstuffRawFrameBit(brs, last_sample);
-			if (done == true)
-				return;
-
-			mCheckingBRS = false;
-
-			/* If using flexible data rate, fast bit timing starts now */
-			
-			/* Error state indicator */
-			BitState esi;
-			done = UnstuffRawFrameBit(esi, last_sample);
-			if (done == true)
-				return;
-		}
-	}
-	else
-	{
-		//29-bit CAN
-
-		//get the next 18 address bits.
-		for (U32 i = 0; i < 18; i++)
-		{
-			mIdentifier <<= 1;
-
-			BitState bit;
-			done = UnstuffRawFrameBit(bit, last_sample);
-			if (done == true)
-				return;
-			mArbitrationField.push_back(bit);
-
-			if (bit == mSettings->Recessive())
-				mIdentifier |= 1;
-		}
-
-		//get the RTR bit
-		BitState rtr;
-		done = UnstuffRawFrameBit(rtr, last_sample);
-		if (done == true)
-			return;
-
-		/* Get r0_fdf - this determines whether this is an FD frame or not */
-		BitState r0_fdf;
-		done = UnstuffRawFrameBit(r0_fdf, last_sample);
-		if (done == true)
-			return;
-
-		if (r0_fdf == mSettings->Dominant())
-		{
-			/* Standard 29-bit CAN frame */
-			frametype = IdentifierFieldEx;
-			BitState r1;
-			done = UnstuffRawFrameBit(r1, last_sample);
-			if (done == true)
-				return;
-
-			Frame frame;
-			frame.mStartingSampleInclusive = mStartOfFrame + mSampleOffsets[1];
-			frame.mEndingSampleInclusive = last_sample;
-			frame.mType = frametype;
-
-			if (rtr == mSettings->Recessive())
-			{
-				mRemoteFrame = true;
-				frame.mFlags = REMOTE_FRAME;
-			}
-			else
-			{
-				mRemoteFrame = false;
-				frame.mFlags = 0;
-			}
-
-			frame.mData1 = mIdentifier;
-			mResults->AddFrame(frame);
-		}
-		else
-		{
-			/* 29-bit extended CAN-FD frame */
-			frametype = FDIdentifierEx;
-			Frame frame;
-			frame.mStartingSampleInclusive = mStartOfFrame + mSampleOffsets[1];
-			frame.mEndingSampleInclusive = last_sample;
-			frame.mType = frametype;
-
-			mRemoteFrame = false;    /* Always a data frame */
-			frame.mFlags = 0;
-
-			frame.mData1 = mIdentifier;
-			mResults->AddFrame(frame);
-
-			/* 3 additional bits in CAN-FD prior to control frame */
-
-			/* Reserved bit for future use - ignored */
-			BitState fdres;
-			done = UnstuffRawFrameBit(fdres, last_sample);
-			if (done == true)
-				return;
-
-			mCheckingBRS = true;
-
-			/* Baud Rate Switch - rest of frame sent at higher rate if this bit is recessive*/
-			BitState brs;
-			done = UnstuffRawFrameBit(brs, last_sample);
-			if (done == true)
-				return;
-
-			mCheckingBRS = false;
-
-			/* If using flexible data rate, fast bit timing starts now */
-
-			/* Error state indicator */
-			BitState esi;
-			done = UnstuffRawFrameBit(esi, last_sample);
-			if (done == true)
-				return;
-		}
-	}
-
-	/* 4 control bits come next - defines the Data Length Code (DLC) for this packet */
-
-	U32 mask = 0x8;
-	U32 dlc = 0;
-	U64 first_sample = 0;
-	for (U32 i = 0; i < 4; i++)
-	{
-		BitState bit;
-		if (i == 0)
-			done = UnstuffRawFrameBit(bit, first_sample);
-		else
-			done = UnstuffRawFrameBit(bit, last_sample);
-
-		if (done == true)
-			return;
-
-		mControlField.push_back(bit);
-
-		if (bit == mSettings->Recessive())
-			dlc |= mask;
-
-		mask >>= 1;
-	}
-
-	if ((frametype == FDIdentifierEx) || (frametype == FDIdentifier))
-	{
-		/* CAN-FD frame - DLC is extended and is not equal to number of bytes in packet in all cases */
-		if (dlc < 9)
-		{
-			mNumDataBytes = dlc;
-		}
-		else if (dlc == 9)
-		{
-			mNumDataBytes = 12;
-		}
-		else if (dlc == 10)
-		{
-			mNumDataBytes = 16;
-		}
-		else if (dlc == 11)
-		{
-			mNumDataBytes = 20;
-		}
-		else if (dlc == 12)
-		{
-			mNumDataBytes = 24;
-		}
-		else if (dlc == 13)
-		{
-			mNumDataBytes = 32;
-		}
-		else if (dlc == 14)
-		{
-			mNumDataBytes = 48;
-		}
-		else
-		{
-			mNumDataBytes = 64;
-		}
-	}
-	else
-	{
-		/* Standard CAN frame - supplied DLC is the exact number of bytes in the frame */
-		mNumDataBytes = dlc;
-	}
-
-	Frame frame;
-	frame.mStartingSampleInclusive = first_sample;
-	frame.mEndingSampleInclusive = last_sample;
-	frame.mType = ControlField;
-	frame.mData1 = mNumDataBytes;
-	frame.mFlags = 0;
-	mResults->AddFrame(frame);
-
-	U32 num_bytes = mNumDataBytes;
-
-	if (mRemoteFrame == true)
-		num_bytes = 0; //ignore the num_bytes if this is a remote frame.
-
-	/* Data section. Get and unpack pre-determined number of bytes from this packet */
-
-	for (U32 i = 0; i < num_bytes; i++)
-	{
-		U32 data = 0;
-		U32 mask = 0x80;
-		for (U32 j = 0; j < 8; j++)
-		{
-			BitState bit;
-			if (j == 0)
-				done = UnstuffRawFrameBit(bit, first_sample);
-			else
-				done = UnstuffRawFrameBit(bit, last_sample);
-
-			if (done == true)
-				return;
-
-			if (bit == mSettings->Recessive())
-				data |= mask;
-
-			mask >>= 1;
-
-			mDataField.push_back(bit);
-		}
-		Frame frame;
-		frame.mStartingSampleInclusive = first_sample;
-		frame.mEndingSampleInclusive = last_sample;
-		frame.mType = DataField;
-		frame.mData1 = data;
-		mResults->AddFrame(frame);
-	}
-
-	/* End of data section */
-
-	U32 crc_bytes;
-
-	if ((frametype == FDIdentifierEx) || (frametype == FDIdentifier))
-	{
-		/* 6 additional bits in CAN-FD identifier frame prior to CRC Section */
-
-	    /* Fixed Stuff bit 1 */
-		BitState fsb1;
-		done = UnstuffFixedStuffBit(fsb1, last_sample);
-		if (done == true)
-			return;
-
-		/* Stuff count bit 2 */
-		BitState sc_bit2;
-		done = UnstuffRawFrameBit(sc_bit2, last_sample);
-		if (done == true)
-			return;
-
-		/* Stuff count bit 1 */
-		BitState sc_bit1;
-		done = UnstuffRawFrameBit(sc_bit1, last_sample);
-		if (done == true)
-			return;
-
-		/* Stuff count bit 0 */
-		BitState sc_bit0;
-		done = UnstuffRawFrameBit(sc_bit0, last_sample);
-		if (done == true)
-			return;
-
-		/* Stuff bits parity */
-		BitState stuff_parity;
-		done = UnstuffRawFrameBit(stuff_parity, last_sample);
-		if (done == true)
-			return;
-
-		/* Fixed Stuff bit 2 */
-		BitState fsb2;
-		done = UnstuffFixedStuffBit(fsb2, last_sample);
-		if (done == true)
-			return;
-
-		/* CRC section for CAN-FD */
-
-		/* CRC length depends on packet data length. Stuffing bits are in fixed, known positions */
-		if (mNumDataBytes >= 20)
-		{
-			crc_bytes = 21;
-		}
-		else
-		{
-			crc_bytes = 17;
-		}
-
-		mCrcValue = 0;
-		for (U32 i = 0; i < crc_bytes; i++)
-		{
-			mCrcValue <<= 1;
-			BitState bit;
-
-			/* Rule for flagging fixed stuff bits in CAN-FD frames */
-			/* Every 4th bit is a fixed stuffing bit in the CRC field. */
-			if ((i > 0) && ((i % 4) == 0))
-			{
-				done = UnstuffFixedStuffBit(fsb2, last_sample);
-				if (done == true)
-					return;
-			}
-
-			if (i == 0)
-				done = UnstuffRawFrameBit(bit, first_sample);
-			else
-				done = UnstuffRawFrameBit(bit, last_sample);
-
-			if (done == true)
-				return;
-
-			mCrcFieldWithoutDelimiter.push_back(bit);
-
-			if (bit == mSettings->Recessive())
-				mCrcValue |= 1;
-		}
-
-		frame.mStartingSampleInclusive = first_sample;
-		frame.mEndingSampleInclusive = last_sample;
-		frame.mType = CrcField;
-		frame.mData1 = mCrcValue;
-		mResults->AddFrame(frame);
-
-	}
-	else
-	{
-		/* CRC section for Standard CAN */		
-		/* Standard 11 or 29-bit CAN - always 15 bits and normal stuffing behaviour */
-		crc_bytes = 15;
-
-		mCrcValue = 0;
-		for (U32 i = 0; i < crc_bytes; i++)
-		{
-			mCrcValue <<= 1;
-			BitState bit;
-
-			if (i == 0)
-				done = UnstuffRawFrameBit(bit, first_sample);
-			else
-				done = UnstuffRawFrameBit(bit, last_sample);
-
-			if (done == true)
-				return;
-
-			mCrcFieldWithoutDelimiter.push_back(bit);
-
-			if (bit == mSettings->Recessive())
-				mCrcValue |= 1;
-		}
-
-		frame.mStartingSampleInclusive = first_sample;
-		frame.mEndingSampleInclusive = last_sample;
-		frame.mType = CrcField;
-		frame.mData1 = mCrcValue;
-		mResults->AddFrame(frame);
-	}
-	
-	/* Trailer section is common to all formats */
-
-	done = UnstuffRawFrameBit(mCrcDelimiter, first_sample);
-
-	if (done == true)
-		return;
-
-	if ((frametype == FDIdentifierEx) || (frametype == FDIdentifier))
-	{
-		/* Add one extra bit time at this point - given examples accessible to code author have 2 bits of delimiter */
-		/* Protocol specification allows for one or two bits at this point */
-		/* Potentially make this optional to the user via menu. */
-		BitState crc_delim2;
-		done = UnstuffRawFrameBit(crc_delim2, last_sample);
-		if (done == true)
-			return;
-	}
-
-	/* If using flexible data rate, fast bit timing should finish here */
-    mBaudSwitch = false;
-
-	BitState ackslot;
-	done = GetFixedFormFrameBit(ackslot, first_sample);
-
-	mAckField.push_back(ackslot);
-	if (ackslot == mSettings->Dominant())
-		mAck = true;
-	else
-		mAck = false;
-
-	BitState ackdelim;
-	done = GetFixedFormFrameBit(ackdelim, last_sample);
-
-	if (done == true)
-		return;
-
-	mAckField.push_back(ackdelim);
-
-	frame.mStartingSampleInclusive = first_sample;
-	frame.mEndingSampleInclusive = last_sample;
-	frame.mType = AckField;
-	frame.mData1 = mAck;
-	mResults->AddFrame(frame);
-
-
-	mResults->CommitPacketAndStartNewPacket();
-}
-
-bool CAN_FDAnalyzer::GetFixedFormFrameBit(BitState& result, U64& sample)
-{
-	if (mNumRawBits <= mRawFrameIndex)
-		return true;
-
-	result = mRawBitResults[mRawFrameIndex];
-	sample = mStartOfFrame + mSampleOffsets[mRawFrameIndex];
-	mCanMarkers.push_back(CanMarker(sample, Standard));
-
-	if (mBaudSwitch == true)
-	{
-		mRawFrameIndex++;
-	}
-	else
-	{
-		mRawFrameIndex += mBitRateFactor;
-	}
-
-	return false;
-}
-
-bool CAN_FDAnalyzer::UnstuffFixedStuffBit(BitState& result, U64& sample, bool reset)
-{
-	/* Some bits in CAN-FD are known stuffing bits. We mark these as stuffed bits */
-	/* Note that this routine does not provide a result which should be used as part */
-	/* of a data field in the message, but it does then increment the FrameIndex to */
-	/* point at the next bit which will be part of the message */
-	
-	/* Initial check to ensure we aren't beyond the end of the raw frame */
-	if (mRawFrameIndex >= mNumRawBits)
-		return true;
-
-	/* Get this sample */
-	sample = mStartOfFrame + mSampleOffsets[mRawFrameIndex];
-	result = mRawBitResults[mRawFrameIndex];
-
-	/* Fixed stuffing bit used by CAN-FD protocol */
-	if (result == mSettings->Recessive())
-	{
-		mDominantCount = 0;
-		mRecessiveCount++;
-	}
-	else
-	{
-		mRecessiveCount = 0;
-		mDominantCount++;
-	}
-	mCanMarkers.push_back(CanMarker(sample, BitStuff));
-	/* Next bit is always one data bit time from here */
-	mRawFrameIndex++;
-
-	return false;
-}
-
-bool CAN_FDAnalyzer::UnstuffRawFrameBit(BitState& result, U64& sample, bool reset)
-{
-	/* This routine is the one normally called by the frame analysis function to unpack bits to be included */
-	/* It also acts as the place which detects if the CAN or CAN-FD protocol has added a stuffing bit into the */
-	/* protocol. This is important, since the code which called this routine is expecting the bits to be */
-	/* according to a specified protocol. Depending on the values of real data in this packet, the protocol rules */
-	/* may add a stuffing bit or not into the serial data. This routine must identify if bit stuffing has taken place */
-	/* mark the bit as one which is an inserted bit, and then go on to process the next bit in the frame which will be */
-	/* the bit that was expected originally. This routine, therefore, unless set to reset the frame - *must* return */
-	/* the result of the expected bit, and then finish by incrementing the FramINdex by an appropriate value. */
-	/* Returns true if FrameIndex now points past the end of the acquired data, otherwise returns false. */
-	
-	if (reset == true)
-	{
-		mRecessiveCount = 0;
-		mDominantCount = 0;
-		mCanMarkers.clear();
-		mRawFrameIndex = 1; /* get away from the leading sample edge just a little */
-	}
-
-	/* Initial check to ensure we aren't beyond the end of the raw frame */
-	if (mRawFrameIndex >= mNumRawBits)
-		return true;
-
-	/* Get the number of this sample */
-	sample = mStartOfFrame + mSampleOffsets[mRawFrameIndex];
-
-	/* Check for a dominant bit stuffing bit */
-	if (mRecessiveCount == 5)
-	{
-		mRecessiveCount = 0;
-		mDominantCount = 1; //this bit is DOMINANT, and counts towards the next bit stuff
-		mCanMarkers.push_back(CanMarker(sample, BitStuff));
-
-		/* Point at next bit */
-		if (mBaudSwitch == true)
-		{
-			mRawFrameIndex++;
-		}
-		else
-		{
-			mRawFrameIndex += mBitRateFactor;
-		}
-	}
-
-	/* Check for a recessive bit stuffing bit */
-	if (mDominantCount == 5)
-	{
-		mDominantCount = 0;
-		mRecessiveCount = 1; //this bit is RECESSIVE, and counts towards the next bit stuff
-		mCanMarkers.push_back(CanMarker(sample, BitStuff));
-
-		/* Point at next bit */
-		if (mBaudSwitch == true)
-		{
-			mRawFrameIndex++;
-		}
-		else
-		{
-			mRawFrameIndex += mBitRateFactor;
-		}
-	}
-
-	/* Check to ensure we aren't beyond the end of the raw frame */
-	if (mRawFrameIndex >= mNumRawBits)
-		return true;
-
-	/* This bit contributes to message */
-	sample = mStartOfFrame + mSampleOffsets[mRawFrameIndex];
-	result = mRawBitResults[mRawFrameIndex];
-
-	if (result == mSettings->Recessive())
-	{
-		mRecessiveCount++;
-		mDominantCount = 0;
-	}
-	else
-	{
-		mDominantCount++;
-		mRecessiveCount = 0;
-	}
-
-	/* Add marker */
-	mCanMarkers.push_back(CanMarker(sample, Standard));
-
-	/* Get next sample - may need adjustment if a baud switch is being made */
-
-	if ((mCheckingBRS == true) && (result == mSettings->Recessive()))
-	{
-		mBaudSwitch = true;
-		/* Must go to next edge now */
-		if (mBitRateFactor < 2)
-		{
-			/* Catch for when header and data rates are the same with the BRS bit set */
-			mRawFrameIndex++;
-		}
-		else
-		{
-			/* Puts next bit to process as the ESI bit */
-			mRawFrameIndex += (U32)(mBitRateFactor - 2);
-		}
-	}
-	else
-	{
-		if (mBaudSwitch == true)
-		{
-			mRawFrameIndex++;
-		}
-		else
-		{
-			mRawFrameIndex += mBitRateFactor;
-		}
-	}
-
-	return false;
-}
-
-
-
-bool CAN_FDAnalyzer::NeedsRerun()
-{
-	return false;
-}
-
-U32 CAN_FDAnalyzer::GenerateSimulationData( U64 minimum_sample_index, U32 device_sample_rate, SimulationChannelDescriptor** simulation_channels )
-{
-	if( mSimulationInitilized == false )
-	{
-		mSimulationDataGenerator.Initialize( GetSimulationSampleRate(), mSettings.get() );
-		mSimulationInitilized = true;
-	}
-
-	return mSimulationDataGenerator.GenerateSimulationData( minimum_sample_index, device_sample_rate, simulation_channels );
-}
-
-U32 CAN_FDAnalyzer::GetMinimumSampleRateHz()
-{
-	/* Ensure we have at least 4 samples per bit at the higher bit rate of the header and data */
-	
-	if (mSettings->mBitRateData >= mSettings->mBitRateHdr)
-	{
-		return mSettings->mBitRateData * 4;
-	}
-	else
-	{
-		return mSettings->mBitRateHdr * 4;
-	}
-}
-
-const char* CAN_FDAnalyzer::GetAnalyzerName() const
-{
-	return "CAN_FD";
-}
-
-const char* GetAnalyzerName()
-{
-	return "CAN_FD";
-}
-
-Analyzer* CreateAnalyzer()
-{
-	return new CAN_FDAnalyzer();
-}
-
-void DestroyAnalyzer( Analyzer* analyzer )
-{
-	delete analyzer;
+#include "CAN_FDAnalyzer.h"
+#include "CAN_FDAnalyzerSettings.h"
+#include <AnalyzerChannelData.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+/* Header and data bit rates that detected rates are snapped to, slowest first */
+static const U32 gStandardHeaderRates[] = { 10000, 20000, 33333, 50000, 62500, 83333, 100000, 125000, 250000, 500000, 800000, 1000000 };
+static const U32 gNumStandardHeaderRates = sizeof(gStandardHeaderRates) / sizeof(gStandardHeaderRates[0]);
+
+/* Data bytes of a CAN-FD frame by DLC */
+static const U8 gFdDataBytes[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+
+CAN_FDAnalyzer::CAN_FDAnalyzer()
+:	Analyzer2(),  
+	mSettings( new CAN_FDAnalyzerSettings() ),
+	mSimulationInitilized( false ),
+	mRerunRequired( false ),
+	mAutoDetectedCapture( 0 ),
+	mAutoDetectedCaptureKnown( false ),
+	mCheckAutoDetectedCapture( false ),
+	mCurrentBus( NULL ),
+	mReader( this, mSettings.get(), mPerf, mTrace ),
+	mSampleOffsets( NULL )
+{
+	SetAnalyzerSettings( mSettings.get() );
+}
+
+CAN_FDAnalyzer::~CAN_FDAnalyzer()
+{
+	KillThread();
+}
+
+void CAN_FDAnalyzer::SetupResults()
+{
+	mResults.reset( new CAN_FDAnalyzerResults( this, mSettings.get() ) );
+	SetAnalyzerResults( mResults.get() );
+
+	for (U32 i = 0; i < CAN_FD_MAX_BUSES; i++)
+	{
+		if (mSettings->IsBusEnabled(i) == true)
+			mResults->AddChannelBubblesWillAppearOn( mSettings->GetBusChannel(i) );
+	}
+}
+
+void CAN_FDAnalyzer::WorkerThread()
+{
+	mSampleRateHz = GetSampleRate();
+	mRerunRequired = false;
+	mPerf.Reset();
+	mTrace.Start(mSettings->mTraceFile);
+
+	mBuses.clear();
+	for (U32 i = 0; i < CAN_FD_MAX_BUSES; i++)
+	{
+		if (mSettings->IsBusEnabled(i) == false)
+			continue;
+
+		CanBusState bus;
+		bus.mBus = i;
+		bus.mChannel = mSettings->GetBusChannel(i);
+		bus.mChannelData = GetAnalyzerChannelData(bus.mChannel);
+		bus.mBitRateHdr = mSettings->GetBusBitRateHdr(i);
+		bus.mBitRateData = mSettings->GetBusBitRateData(i);
+		bus.mInverted = mSettings->GetBusInverted(i);
+		mBuses.push_back(bus);
+	}
+
+	/* Detection is skipped when the settings are the ones it produced before. Whether the capture is the */
+	/* one they were produced on is only known once its first frames are decoded. */
+	mDetectedBuses.clear();
+	mCheckAutoDetectedCapture = false;
+	if ((mSettings->mAutoDetect == true) && (mAutoDetectedSettings != mSettings->SaveSettings()))
+	{
+		for (U32 i = 0; i < mBuses.size(); i++)
+		{
+			SelectBus(i);
+
+			/* The frames used for detection have been consumed, they are decoded on the rerun. The rest */
+			/* of the capture is decoded with what was found meanwhile. */
+			if (DetectBusParameters() == true)
+			{
+				mDetectedBuses.push_back(mBuses[i]);
+				mRerunRequired = true;
+			}
+		}
+	}
+	else if (mSettings->mAutoDetect == true)
+	{
+		mCheckAutoDetectedCapture = true;
+	}
+
+	for (U32 i = 0; i < mBuses.size(); i++)
+	{
+		if (mBuses[i].mInverted == true)
+		{
+			mBuses[i].mRecessive = BIT_LOW;
+			mBuses[i].mDominant = BIT_HIGH;
+			mBuses[i].mPolarity = 1;
+		}
+		else
+		{
+			mBuses[i].mRecessive = BIT_HIGH;
+			mBuses[i].mDominant = BIT_LOW;
+			mBuses[i].mPolarity = 0;
+		}
+
+		InitSampleOffsets(mBuses[i]);
+		mBusStatistics[mBuses[i].mBus].Reset(mSampleRateHz);
+	}
+
+	mIsoTp.Reset(mSampleRateHz, mSettings->mIsoTpTimeoutMs, mSettings->mIsoTpIdentifiers);
+	mJ1939.Reset(mSampleRateHz);
+	mIdIndex.Reset();
+	mDecodeCache.Reset();
+	mSofIndex.Open(mSettings->mDecodeCacheFolder, GetSofIndexKey(), (U32)mBuses.size());
+
+	CanCacheBusProgress no_progress;
+	no_progress.mProgressSample = 0;
+	no_progress.mLastStartOfFrame = 0;
+	mBusProgress.assign(mBuses.size(), no_progress);
+
+	/* The file was checked when the settings were applied. If it can't be read any more no signals are */
+	/* decoded, and the signals export says why. */
+	std::string dbc_error;
+	mDbc.Load(mSettings->mDbcFile, dbc_error);
+
+	mFramesSinceCommit = 0;
+	mLastCommitTime = std::chrono::steady_clock::now();
+
+	mProgressSample = 0;
+	mCaughtUp = false;
+	GetDecodeWindow();
+
+	/* Not after detection, which has used up the first frames */
+	bool cached = (mSettings->mDecodeCacheFolder.empty() == false) && (mRerunRequired == false);
+	bool started = (cached == true) || (mDecodeStartSample > 0);
+
+	/* Recording from the first frame decoded, including those read to find the start of frame index */
+	if (cached == true)
+		mDecodeCache.Start(mSettings->mDecodeCacheFolder, (U32)mBuses.size());
+
+	if (mDecodeStartSample > 0)
+		StartDecodeWindow();
+	else if (cached == true)
+		mReader.Start(mBuses, true);
+
+	if (cached == true)
+		OpenDecodeCache();
+
+	try
+	{
+		if (started == false)
+			mReader.Start(mBuses, true);
+
+		//now let's pull in the frames, one at a time.
+		CanRawFrame raw;
+		while (mDecodeWindowEnded == false)
+		{
+			mReader.ReadRawFrame(raw);
+			DecodeRawFrame(raw);
+		}
+	}
+	catch (...)
+	{
+		/* The end of the capture, or the decode being stopped */
+		mIsoTp.Finish();
+		mJ1939.Finish();
+		throw;
+	}
+
+	EndDecodeWindow();
+}
+
+static U64 GetWindowSample(U64 origin, double seconds, U32 sample_rate)
+{
+	S64 sample = S64(origin) + S64(floor(seconds * double(sample_rate) + 0.5));
+	return (sample < 0) ? 0 : U64(sample);
+}
+
+void CAN_FDAnalyzer::GetDecodeWindow()
+{
+	mDecodeStartSample = 0;
+	mDecodeEndSample = 0xFFFFFFFFFFFFFFFFull;
+	mDecodeWindowEnded = false;
+	mTriggerFirstPass = false;
+
+	U64 origin = (mSettings->mDecodeFromCaptureStart == true) ? 0 : GetTriggerSample();
+
+	bool has_from;
+	bool has_to;
+	double from;
+	double to;
+	CAN_FDAnalyzerSettings::ParseWindowTime(mSettings->mDecodeFrom, has_from, from);
+	CAN_FDAnalyzerSettings::ParseWindowTime(mSettings->mDecodeTo, has_to, to);
+
+	if (has_from == true)
+		mDecodeStartSample = GetWindowSample(origin, from, mSampleRateHz);
+	if (has_to == true)
+		mDecodeEndSample = GetWindowSample(origin, to, mSampleRateHz);
+	if ((has_from == true) || (has_to == true))
+		return;
+
+	/* A trigger-first pass decodes the window around the trigger on its own, then asks for the whole */
+	/* capture to be decoded again in order. The results only take frames in time order, so the parts */
+	/* either side can't be added to the window's afterwards. */
+	bool has_window;
+	double window;
+	CAN_FDAnalyzerSettings::ParseWindowTime(mSettings->mTriggerFirstWindow, has_window, window);
+	if (has_window == false)
+		return;
+
+	/* This is the rerun after the pass */
+	std::string settings = mSettings->SaveSettings();
+	if (mTriggerFirstSettings == settings)
+	{
+		mTriggerFirstSettings.clear();
+		return;
+	}
+
+	/* With the window reaching back to the start of the capture, the ordinary decode gets there as soon */
+	U64 trigger_sample = GetTriggerSample();
+	U64 start_sample = GetWindowSample(trigger_sample, -window, mSampleRateHz);
+	if (start_sample == 0)
+		return;
+
+	mDecodeStartSample = start_sample;
+	mDecodeEndSample = GetWindowSample(trigger_sample, window, mSampleRateHz);
+	mTriggerFirstPass = true;
+}
+
+void CAN_FDAnalyzer::StartDecodeWindow()
+{
+	/* The first frames of the capture tell which start of frame index goes with it. Those before the */
+	/* window are skipped like noise. */
+	mReader.Start(mBuses, true);
+
+	CanRawFrame raw;
+	while ((mSofIndex.IsFingerprinted() == false) && (mDecodeWindowEnded == false))
+	{
+		mReader.ReadRawFrame(raw);
+		DecodeRawFrame(raw);
+	}
+
+	/* Each bus starts at its last indexed start of frame before the window, so the frames found are the */
+	/* ones a decode of the whole capture finds. Without one it starts at the first inter-frame gap in the */
+	/* window. A bus already read into the window reads on. */
+	for (U32 i = 0; i < mBuses.size(); i++)
+	{
+		if (mBuses[i].mChannelData->GetSampleNumber() >= mDecodeStartSample)
+			continue;
+
+		CanSofIndexEntry entry;
+		if ((mSofIndex.Find(i, mDecodeStartSample, entry) == true) && (mReader.AdvanceToStartOfFrame(mBuses[i], entry.mStartOfFrame, false) == true))
+			continue;
+
+		mReader.SkipTo(mBuses, i, mDecodeStartSample);
+	}
+
+	mReader.Continue(mBuses, true);
+}
+
+void CAN_FDAnalyzer::EndDecodeWindow()
+{
+	/* The rest of the capture is left alone, unless this was the trigger-first pass */
+	if (mTriggerFirstPass == true)
+	{
+		mTriggerFirstSettings = mSettings->SaveSettings();
+		mRerunRequired = true;
+	}
+
+	mIsoTp.Finish();
+	mJ1939.Finish();
+
+	mProgressSample = mDecodeEndSample;
+	mCaughtUp = true;
+	CommitResults();
+}
+
+void CAN_FDAnalyzer::OpenDecodeCache()
+{
+	/* The first frames are decoded as usual, they also identify the capture */
+	CanRawFrame raw;
+	for (U32 i = 0; (i < CAN_DECODE_CACHE_FINGERPRINT_FRAMES) && (mDecodeWindowEnded == false); i++)
+	{
+		mReader.ReadRawFrame(raw);
+		mDecodeCache.AddToFingerprint(raw);
+		DecodeRawFrame(raw);
+	}
+
+	std::string settings = mSettings->GetDecodeSettings();
+	if (mDecodeCache.Open(settings, mSampleRateHz, mProgressSample, mBusProgress, (settings != mRejectedCacheSettings)) == false)
+		return;
+
+	if (CheckDecodeCache() == false)
+	{
+		/* The channels have been moved on past frames that are now missing from the results, so the capture */
+		/* is decoded again, without the cache this time. Carrying on gives results for the rest meanwhile. */
+		mDecodeCache.Reset();
+		mRejectedCacheSettings = settings;
+		mRerunRequired = true;
+		mReader.Continue(mBuses, true);
+		return;
+	}
+
+	mDecodeCache.BeginReplay(true);
+	ReplayDecodeCache();
+
+	/* Decoding carries on from where the readers were when the cache was last written */
+	const std::vector<CanCacheBusProgress>& progress = mDecodeCache.GetReplayProgress();
+	for (U32 i = 0; i < mBuses.size(); i++)
+	{
+		AnalyzerChannelData* channel = mBuses[i].mChannelData;
+		if (progress[i].mProgressSample > channel->GetSampleNumber())
+			channel->AdvanceToAbsPosition(progress[i].mProgressSample);
+
+		if (progress[i].mProgressSample > mBusProgress[i].mProgressSample)
+			mBusProgress[i] = progress[i];
+	}
+
+	mReader.Continue(mBuses, true);
+	mSofIndex.Resync();
+
+	mProgressSample = mDecodeCache.GetReplayProgressSample();
+	CommitResults();
+}
+
+bool CAN_FDAnalyzer::CheckDecodeCache()
+{
+	/* Each bus's last start of frame in the file has to be a dominant edge in the capture. Those already */
+	/* read past were in the fingerprinted frames. */
+	const std::vector<CanCacheBusProgress>& progress = mDecodeCache.GetReplayProgress();
+	for (U32 i = 0; i < mBuses.size(); i++)
+	{
+		if (progress[i].mLastStartOfFrame <= mBuses[i].mChannelData->GetSampleNumber())
+			continue;
+
+		if (mReader.AdvanceToStartOfFrame(mBuses[i], progress[i].mLastStartOfFrame, true) == false)
+			return false;
+	}
+
+	return true;
+}
+
+void CAN_FDAnalyzer::ReplayDecodeCache()
+{
+	CanTraceScope trace_scope(mTrace, "Cache replay", mProgressSample);
+
+	/* The same calls as the decode made, so the results and the protocol layers end up as they were */
+	mCaughtUp = false;
+
+	CanCacheRecord record;
+	while (mDecodeCache.ReadRecord(record) == true)
+	{
+		switch (record.mOp)
+		{
+		case CacheOpBus:
+			SelectBus(record.mBusIndex);
+			break;
+
+		case CacheOpFrame:
+			AddResultFrame(record.mFrame);
+			break;
+
+		case CacheOpMarkers:
+			for (U32 i = 0; i < record.mMarkerSamples.size(); i++)
+				mResults->AddMarker(record.mMarkerSamples[i], (record.mMarkerStuffed[i] != 0) ? AnalyzerResults::ErrorX : AnalyzerResults::Dot, mCurrentBus->mChannel);
+			break;
+
+		case CacheOpCommitPacket:
+			mDecodedFrame.mPacketId = mResults->CommitPacketAndStartNewPacket();
+			mIdIndex.AddPacket(mCurrentBus->mBus, record.mIdentifier, record.mExtended, mDecodedFrame.mPacketId, record.mStartingSample);
+			mProgressSample = record.mStartingSample;
+			CommitResultsIfDue();
+			break;
+
+		case CacheOpCancelPacket:
+			mResults->CancelPacketAndStartNewPacket();
+			CommitResultsIfDue();
+			break;
+
+		case CacheOpStatisticsFrame:
+			mBusStatistics[mCurrentBus->mBus].AddFrame(record.mIdentifier, record.mExtended, record.mStartingSample, record.mEndingSample);
+			break;
+
+		case CacheOpStatisticsError:
+			mBusStatistics[mCurrentBus->mBus].AddError(record.mStartingSample, record.mEndingSample);
+			break;
+
+		case CacheOpDecodedFrame:
+		{
+			U64 packet_id = mDecodedFrame.mPacketId;
+			mDecodedFrame = record.mDecodedFrame;
+			mDecodedFrame.mBus = mCurrentBus->mBus;
+			mDecodedFrame.mPacketId = packet_id;
+			ProcessDecodedFrame();
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+
+	trace_scope.SetLastSample(mProgressSample);
+}
+
+void CAN_FDAnalyzer::DecodeRawFrame(CanRawFrame& raw)
+{
+	if ((mCheckAutoDetectedCapture == true) && (mSofIndex.IsFingerprinted() == true))
+		CheckAutoDetectedCapture();
+
+	if (raw.mStartOfFrame > mDecodeEndSample)
+	{
+		mDecodeWindowEnded = true;
+		return;
+	}
+
+	mProgressSample = raw.mProgressSample;
+	mCaughtUp = raw.mCaughtUp;
+
+	mBusProgress[raw.mBusIndex].mProgressSample = raw.mProgressSample;
+	mBusProgress[raw.mBusIndex].mLastStartOfFrame = raw.mStartOfFrame;
+
+	/* Reading may start at an indexed frame before the decode window, those frames are skipped like noise */
+	if ((raw.mGarbage == true) || (raw.mStartOfFrame < mDecodeStartSample))
+	{
+		mSofIndex.AddFrame(raw.mBusIndex, raw.mStartOfFrame, false, SofKindClassic);
+		CommitResultsIfDue();
+		return;
+	}
+
+	SelectBus(raw.mBusIndex);
+
+	if (mDecodeCache.IsRecording() == true)
+		mDecodeCache.AddBus(raw.mBusIndex);
+
+	mStartOfFrame = raw.mStartOfFrame;
+	mRawFrameTruncated = raw.mTruncated;
+	mCanError = raw.mCanError;
+	mErrorStartingSample = raw.mErrorStartingSample;
+	mErrorEndingSample = raw.mErrorEndingSample;
+	mTruncatedEndingSample = raw.mTruncatedEndingSample;
+
+	/* Swapped rather than copied, so both buffers keep their capacity */
+	mRawBitResults.swap(raw.mRawBits);
+	mNumRawBits = (U32)mRawBitResults.size();
+
+	AnalyzeRawFrame();
+	EmitFrameResults();
+	UpdateBusStatistics();
+
+	CanSofKind kind = (mFdFrame == true) ? SofKindFd : ((mRemoteFrame == true) ? SofKindRemote : SofKindClassic);
+	mSofIndex.AddFrame(raw.mBusIndex, mStartOfFrame, (mCanError == false) && (mIdentifierDecoded == true), kind);
+
+	if (mFrameDecoded == true)
+		ProcessDecodedFrame();
+
+	CommitResultsIfDue();
+}
+
+void CAN_FDAnalyzer::ProcessDecodedFrame()
+{
+	CAN_PERF_TIME(mPerf, PerfTimeResults);
+
+	if (mDecodeCache.IsRecording() == true)
+		mDecodeCache.AddDecodedFrame(mDecodedFrame);
+
+	if (mSettings->mIsoTpReassembly == true)
+	{
+		U64 transaction_id;
+		if (mIsoTp.AddFrame(mDecodedFrame, transaction_id) == true)
+			mResults->AddPacketToTransaction(transaction_id, mDecodedFrame.mPacketId);
+	}
+
+	if (mSettings->mJ1939Decoding == true)
+		mJ1939.AddFrame(mDecodedFrame);
+
+	if (mDbc.IsLoaded() == true)
+		mDbc.AddFrame(mDecodedFrame);
+}
+
+void CAN_FDAnalyzer::EmitFrameResults()
+{
+	CAN_PERF_TIME(mPerf, PerfTimeResults);
+
+	if (mCanError == true)
+	{
+		Frame frame;
+		frame.mStartingSampleInclusive = mErrorStartingSample;
+		frame.mEndingSampleInclusive = mErrorEndingSample;
+		frame.mType = CanError;
+		AddResultFrame(frame);
+		mResults->CancelPacketAndStartNewPacket();
+
+		if (mDecodeCache.IsRecording() == true)
+			mDecodeCache.AddCancelPacket();
+
+		CAN_PERF_COUNT(mPerf, PerfErrorResyncs);
+	}
+	else if (mIdentifierDecoded == false)
+	{
+		CAN_PERF_COUNT(mPerf, PerfFramesIncomplete);
+	}
+	else
+	{
+		if (mFdFrame == true)
+			CAN_PERF_COUNT(mPerf, (mExtendedIdentifier == true) ? PerfFramesFDExtended : PerfFramesFD);
+		else
+			CAN_PERF_COUNT(mPerf, (mExtendedIdentifier == true) ? PerfFramesClassicExtended : PerfFramesClassic);
+
+		if (mRemoteFrame == true)
+			CAN_PERF_COUNT(mPerf, PerfFramesRemote);
+	}
+
+	U32 count = (U32)mCanMarkers.size();
+	if ((mDecodeCache.IsRecording() == true) && (count > 0))
+	{
+		mCacheMarkerSamples.resize(count);
+		mCacheMarkerStuffed.resize(count);
+		for (U32 i = 0; i < count; i++)
+		{
+			mCacheMarkerSamples[i] = mCanMarkers[i].mSample;
+			mCacheMarkerStuffed[i] = (mCanMarkers[i].mType == BitStuff) ? 1 : 0;
+		}
+		mDecodeCache.AddMarkers(mCacheMarkerSamples, mCacheMarkerStuffed);
+	}
+
+	for (U32 i = 0; i < count; i++)
+	{
+		if (mCanMarkers[i].mType == Standard)
+		{
+			mResults->AddMarker(mCanMarkers[i].mSample, AnalyzerResults::Dot, mCurrentBus->mChannel);
+			CAN_PERF_COUNT(mPerf, PerfBitsUsed);
+		}
+		else
+		{
+			mResults->AddMarker(mCanMarkers[i].mSample, AnalyzerResults::ErrorX, mCurrentBus->mChannel);
+			CAN_PERF_COUNT(mPerf, PerfStuffBits);
+		}
+	}
+}
+
+void CAN_FDAnalyzer::UpdateBusStatistics()
+{
+	CAN_PERF_TIME(mPerf, PerfTimeResults);
+
+	if (mCanError == true)
+	{
+		mBusStatistics[mCurrentBus->mBus].AddError(mStartOfFrame, mErrorEndingSample);
+
+		if (mDecodeCache.IsRecording() == true)
+			mDecodeCache.AddStatisticsError(mStartOfFrame, mErrorEndingSample);
+		return;
+	}
+
+	if (mIdentifierDecoded == false)
+		return;
+
+	/* The raw frame runs up to the end of frame field. A skimmed frame ends where its trailing recessive bits start */
+	U64 ending_sample;
+	if (mRawFrameTruncated == true)
+		ending_sample = mTruncatedEndingSample;
+	else if (mNumRawBits > 0)
+		ending_sample = mStartOfFrame + mSampleOffsets[mNumRawBits - 1];
+	else
+		ending_sample = mStartOfFrame;
+
+	mBusStatistics[mCurrentBus->mBus].AddFrame(mIdentifier, mExtendedIdentifier, mStartOfFrame, ending_sample);
+
+	if (mDecodeCache.IsRecording() == true)
+		mDecodeCache.AddStatisticsFrame(mIdentifier, mExtendedIdentifier, mStartOfFrame, ending_sample);
+}
+
+void CAN_FDAnalyzer::CommitResultsIfDue()
+{
+	/* Committing, progress reporting and the exit check all synchronise with the UI, so they are batched */
+	/* over several frames. Results are always published when the decoder has caught up with the capture, */
+	/* since the next channel call may then block waiting for more data. */
+	CAN_PERF_TIME(mPerf, PerfTimeResults);
+
+	mFramesSinceCommit++;
+
+	if (mFramesSinceCommit < mSettings->mCommitIntervalFrames)
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if ((now - mLastCommitTime) < std::chrono::milliseconds(mSettings->mCommitIntervalMs))
+		{
+			if (mCaughtUp == false)
+				return;
+		}
+	}
+
+	CommitResults();
+	CheckIfThreadShouldExit();
+}
+
+void CAN_FDAnalyzer::CommitResultsIfCaughtUp(AnalyzerChannelData* channel)
+{
+	/* Called by the reader part way through a frame, when the channel has just used up edges. If those were */
+	/* the last ones available, the rest of the frame may never arrive, so the batch before it is published now. */
+	if (mFramesSinceCommit == 0)
+		return;
+
+	if (channel->DoMoreTransitionsExistInCurrentData() == true)
+		return;
+
+	mProgressSample = channel->GetSampleNumber();
+	mCaughtUp = true;
+	CommitResults();
+}
+
+void CAN_FDAnalyzer::CommitResults()
+{
+	{
+		CanTraceScope trace_scope(mTrace, "Commit", mProgressSample);
+		mResults->CommitResults();
+		ReportProgress(mProgressSample);
+	}
+
+	/* Whatever ends the decode from here on, the cache has everything that was published */
+	mDecodeCache.Flush(mProgressSample, mBusProgress);
+	mSofIndex.Save();
+
+	mFramesSinceCommit = 0;
+	mLastCommitTime = std::chrono::steady_clock::now();
+
+	/* The decoder may be about to wait for more data, possibly for good, so this is the place to */
+	/* publish the counters and the trace */
+	if (mCaughtUp == true)
+	{
+		if (mSettings->mPerfCounterFile.empty() == false)
+			mPerf.WriteToFile(mSettings->mPerfCounterFile.c_str());
+
+		mTrace.Flush();
+	}
+}
+
+std::string CAN_FDAnalyzer::GetSofIndexKey()
+{
+	/* Where frames start depends on the capture and the bus timing, not on how the frames are decoded */
+	std::stringstream ss;
+	ss << mSampleRateHz << " " << mSettings->mGlitchFilterNs;
+	for (U32 i = 0; i < mBuses.size(); i++)
+	{
+		U32 bus = mBuses[i].mBus;
+		ss << " " << bus << " " << mBuses[i].mChannel.mDeviceId << " " << mBuses[i].mChannel.mChannelIndex;
+		ss << " " << mBuses[i].mBitRateHdr << " " << mBuses[i].mBitRateData << " " << mBuses[i].mInverted;
+	}
+	return ss.str();
+}
+
+void CAN_FDAnalyzer::InitSampleOffsets(CanBusState& bus)
+{
+	U32 bit_rate_hdr = bus.mBitRateHdr;
+	U32 bit_rate_data = bus.mBitRateData;
+
+	bus.mBitRateFactor = (int)bit_rate_data / (int)bit_rate_hdr;
+
+	/* Sampled at the data bit rate, a frame without a bit rate switch takes a header bit's worth of raw bits per bit. */
+	/* One more offset than raw bits, for the end of an error flag completed by the last raw bit. */
+	U32 max_raw_bits = MAX_FRAME_BITS * bus.mBitRateFactor;
+	U32 num_offsets = max_raw_bits + 1;
+	bus.mSampleOffsets.resize(num_offsets);
+
+	double samples_per_bit = double(mSampleRateHz) / double(bit_rate_data);
+	double samples_behind = 0.0;
+
+	U32 increment = U32((samples_per_bit * .5) + samples_behind);
+	samples_behind = (samples_per_bit * .5) + samples_behind - double(increment);
+
+	bus.mSampleOffsets[0] = increment;
+	U32 current_offset = increment;
+
+	for (U32 i = 1; i < num_offsets; i++)
+	{
+		U32 increment = U32(samples_per_bit + samples_behind);
+		samples_behind = samples_per_bit + samples_behind - double(increment);
+		current_offset += increment;
+		bus.mSampleOffsets[i] = current_offset;
+	}
+
+	bus.mNumSamplesIn7Bits = U32(samples_per_bit * 7.0 * bus.mBitRateFactor);   /* This bit time is at the slow header bit rate */
+
+	/* The glitch filter samples either side of each sample point, so it has to stay well inside a data bit */
+	double glitch_samples = double(mSettings->mGlitchFilterNs) * double(mSampleRateHz) / 1000000000.0;
+	if (glitch_samples > (samples_per_bit * 0.25))
+		glitch_samples = samples_per_bit * 0.25;
+	bus.mGlitchSamples = U32(glitch_samples);
+
+	/* Skim mode only needs the raw bits up to the end of the control field */
+	if (mSettings->mSkimMode == true)
+		bus.mMaxRawBits = (SKIM_HEADER_BITS * bus.mBitRateFactor) + 1;
+	else
+		bus.mMaxRawBits = max_raw_bits;
+}
+
+void CAN_FDAnalyzer::SelectBus(U32 index)
+{
+	mCurrentBus = &mBuses[index];
+
+	mCAN_FD = mCurrentBus->mChannelData;
+	mBitRateFactor = mCurrentBus->mBitRateFactor;
+	mSampleOffsets = &mCurrentBus->mSampleOffsets[0];
+}
+
+void CAN_FDAnalyzer::AddResultFrame(Frame& frame)
+{
+	/* mData2 carries the bus number, so bubbles and exports can tell the buses apart */
+	frame.mData2 = mCurrentBus->mBus;
+	mResults->AddFrame(frame);
+
+	if (mDecodeCache.IsRecording() == true)
+		mDecodeCache.AddFrame(frame);
+}
+
+bool CAN_FDAnalyzer::DetectBusParameters()
+{
+	/* Collect the pulse widths of the first few hundred frames. The partial pulse at the start of the */
+	/* capture is only used for the idle level, as its real width is unknown. */
+	std::vector<U32> widths;
+	std::vector<BitState> levels;
+	widths.reserve(AUTO_DETECT_PULSES);
+	levels.reserve(AUTO_DETECT_PULSES);
+
+	BitState idle_level = mCAN_FD->GetBitState();
+	CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+	mCAN_FD->AdvanceToNextEdge();
+	U64 longest = mCAN_FD->GetSampleNumber();
+
+	while (widths.size() < AUTO_DETECT_PULSES)
+	{
+		if ((widths.size() >= AUTO_DETECT_MIN_PULSES) && (mCAN_FD->DoMoreTransitionsExistInCurrentData() == false))
+			break;
+
+		BitState level = mCAN_FD->GetBitState();
+		U64 start = mCAN_FD->GetSampleNumber();
+		CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+		mCAN_FD->AdvanceToNextEdge();
+		U64 width = mCAN_FD->GetSampleNumber() - start;
+
+		widths.push_back((U32)std::min<U64>(width, 0xFFFFFFFF));
+		levels.push_back(level);
+
+		/* The bus idles recessive, and nothing else lasts as long as an idle period */
+		if (width > longest)
+		{
+			longest = width;
+			idle_level = level;
+		}
+	}
+
+	if (widths.size() < AUTO_DETECT_MIN_PULSES)
+		return false;
+
+	BitState dominant = (idle_level == BIT_HIGH) ? BIT_LOW : BIT_HIGH;
+
+	/* Header rate: the slowest standard rate for which the pulses at the start of each frame, which are all */
+	/* in the arbitration phase, are whole numbers of bits. Faster rates that divide it would match as well. */
+	U32 header_rate = 0;
+	for (U32 r = 0; (r < gNumStandardHeaderRates) && (header_rate == 0); r++)
+	{
+		double bit = double(mSampleRateHz) / double(gStandardHeaderRates[r]);
+		if (bit < 2.0)
+			break;
+
+		double tolerance = (bit * 0.15) + 1.0;
+		U32 frames = 0;
+		U32 matching = 0;
+
+		for (U32 i = 1; (i + AUTO_DETECT_FRAME_PULSES) <= widths.size(); i++)
+		{
+			/* Start of frame is a dominant pulse after at least 10 recessive bits */
+			if ((levels[i] != dominant) || (double(widths[i - 1]) < (bit * 10.0)))
+				continue;
+
+			bool match = true;
+			for (U32 k = i; k < (i + AUTO_DETECT_FRAME_PULSES); k++)
+			{
+				double bits = double(widths[k]) / bit;
+				double whole = double(U32(bits + 0.5));
+				if ((whole < 1.0) || (std::abs(double(widths[k]) - (whole * bit)) > tolerance))
+					match = false;
+			}
+
+			frames++;
+			if (match == true)
+				matching++;
+		}
+
+		if ((frames >= AUTO_DETECT_MIN_FRAMES) && ((matching * 10) >= (frames * 9)))
+			header_rate = gStandardHeaderRates[r];
+	}
+
+	if (header_rate == 0)
+		return false;
+
+	/* Data rate: the shortest pulse width that makes up a fair share of all pulses, so glitches and */
+	/* noise bursts do not count */
+	std::vector<U32> sorted(widths);
+	std::sort(sorted.begin(), sorted.end());
+
+	U32 repeats = (U32)((sorted.size() * AUTO_DETECT_DATA_BIT_PERCENT) / 100);
+	if (repeats < 3)
+		repeats = 3;
+
+	U32 shortest = 0;
+	for (U32 i = 0; (i + repeats) <= sorted.size(); i++)
+	{
+		if (double(sorted[i + repeats - 1]) <= ((double(sorted[i]) * 1.15) + 1.0))
+		{
+			shortest = sorted[i + (repeats / 2)];
+			break;
+		}
+	}
+
+	if (shortest == 0)
+		return false;
+
+	double header_bit = double(mSampleRateHz) / double(header_rate);
+	U32 factor = U32((header_bit / double(shortest)) + 0.5);
+	if (factor < 1)
+		factor = 1;
+	while ((factor > 1) && ((U64(header_rate) * factor) > AUTO_DETECT_MAX_DATA_RATE))
+		factor--;
+
+	mCurrentBus->mBitRateHdr = header_rate;
+	mCurrentBus->mBitRateData = header_rate * factor;
+	mCurrentBus->mInverted = (idle_level == BIT_LOW);
+
+	return true;
+}
+
+void CAN_FDAnalyzer::CheckAutoDetectedCapture()
+{
+	/* The first decode with the detected settings fingerprints the capture they were detected on. On */
+	/* another capture they are detected again on a rerun. Carrying on gives results for the rest meanwhile. */
+	mCheckAutoDetectedCapture = false;
+
+	U64 capture = mSofIndex.GetFingerprint();
+	if (mAutoDetectedCaptureKnown == false)
+	{
+		mAutoDetectedCapture = capture;
+		mAutoDetectedCaptureKnown = true;
+		return;
+	}
+
+	if (capture != mAutoDetectedCapture)
+	{
+		mAutoDetectedSettings.clear();
+		mRerunRequired = true;
+	}
+}
+
+void CAN_FDAnalyzer::AnalyzeRawFrame()
+{
+	CAN_PERF_TIME(mPerf, PerfTimeAnalyze);
+	CanTraceScope trace_scope(mTrace, "Field analysis", mStartOfFrame);
+	if (mNumRawBits > 0)
+		trace_scope.SetLastSample(mStartOfFrame + mSampleOffsets[mNumRawBits - 1]);
+
+	U8 bit;
+	U64 last_sample;
+
+	mIdentifierDecoded = false;
+	mFrameDecoded = false;
+
+	StartRawFrameBits();
+	UnstuffRawFrameBit(bit, last_sample);  //grab the start bit
+
+	bool done;
+
+	/* Identifier section comes immediately after start bit */
+
+	mIdentifier = 0;
+	for (U32 i = 0; i < 11; i++)
+	{
+		done = UnstuffRawFrameBit(bit, last_sample);
+		if (done == true)
+			return;
+
+		mIdentifier = (mIdentifier << 1) | bit;
+	}
+
+	//ok, the next bits will let us know if this is 11-bit or 29-bit can, and if it is CAN-FD.
+
+	U8 rtr_srr;
+	done = UnstuffRawFrameBit(rtr_srr, last_sample);
+	if (done == true)
+		return;
+
+	U8 ide;
+	done = UnstuffRawFrameBit(ide, last_sample);
+	if (done == true)
+		return;
+
+	/* If ide is dominant, then this is an 11-bit header and rtr_srr was the RTR bit, else 18 more */
+	/* identifier bits and the RTR bit follow */
+	U8 rtr = rtr_srr;
+	if (ide == CAN_RECESSIVE)
+	{
+		for (U32 i = 0; i < 18; i++)
+		{
+			done = UnstuffRawFrameBit(bit, last_sample);
+			if (done == true)
+				return;
+
+			mIdentifier = (mIdentifier << 1) | bit;
+		}
+
+		done = UnstuffRawFrameBit(rtr, last_sample);
+		if (done == true)
+			return;
+	}
+
+	/* fdf bit is the key to recognising whether the frame is standard CAN or CAN-FD */
+	/* This bit is dominant 0 (r0) on classic CAN, and recessive 1 on CAN-FD */
+	U8 fdf;
+	done = UnstuffRawFrameBit(fdf, last_sample);
+	if (done == true)
+		return;
+
+	/* The format is known now, the rest of the frame is parsed by the variant for it */
+	if (ide == CAN_DOMINANT)
+	{
+		if (fdf == CAN_DOMINANT)
+			AnalyzeFrame<false, false>(rtr, last_sample);
+		else
+			AnalyzeFrame<true, false>(rtr, last_sample);
+	}
+	else
+	{
+		if (fdf == CAN_DOMINANT)
+			AnalyzeFrame<false, true>(rtr, last_sample);
+		else
+			AnalyzeFrame<true, true>(rtr, last_sample);
+	}
+}
+
+template <bool FD, bool EXTENDED>
+void CAN_FDAnalyzer::AnalyzeFrame(U8 rtr, U64 last_sample)
+{
+	bool done;
+	U8 bit;
+
+	if ((FD == false) && (EXTENDED == true))
+	{
+		/* Classic 29-bit frames have a second reserved bit */
+		U8 r1;
+		done = UnstuffRawFrameBit(r1, last_sample);
+		if (done == true)
+			return;
+	}
+
+	Frame frame;
+	frame.mStartingSampleInclusive = mStartOfFrame + mSampleOffsets[1];
+	frame.mEndingSampleInclusive = last_sample;
+	if (FD == true)
+		frame.mType = (EXTENDED == true) ? FDIdentifierEx : FDIdentifier;
+	else
+		frame.mType = (EXTENDED == true) ? IdentifierFieldEx : IdentifierField;
+
+	/* CAN-FD frames are always data frames */
+	mRemoteFrame = ((FD == false) && (rtr == CAN_RECESSIVE));
+	frame.mFlags = (mRemoteFrame == true) ? REMOTE_FRAME : 0;
+
+	frame.mData1 = mIdentifier;
+	AddResultFrame(frame);
+	mIdentifierDecoded = true;
+	mExtendedIdentifier = EXTENDED;
+	mFdFrame = FD;
+
+	if (FD == true)
+	{
+		/* 3 additional bits in CAN-FD prior to control frame */
+
+		/* Reserved bit for future use - ignored */
+		U8 fdres;
+		done = UnstuffRawFrameBit(fdres, last_sample);
+		if (done == true)
+			return;
+
+		/* Baud Rate Switch - rest of frame sent at higher rate if this bit is recessive*/
+		U8 brs;
+		done = UnstuffRawFrameBit(brs, last_sample);
+		if (done == true)
+			return;
+
+		/* If using flexible data rate, fast bit timing starts now */
+		if (brs == CAN_RECESSIVE)
+			SwitchToDataBitRate();
+
+		/* Error state indicator */
+		U8 esi;
+		done = UnstuffRawFrameBit(esi, last_sample);
+		if (done == true)
+			return;
+	}
+
+	/* 4 control bits come next - defines the Data Length Code (DLC) for this packet */
+
+	U64 first_sample;
+	done = UnstuffRawFrameBit(bit, first_sample);
+	if (done == true)
+		return;
+
+	U32 dlc = bit;
+	for (U32 i = 1; i < 4; i++)
+	{
+		done = UnstuffRawFrameBit(bit, last_sample);
+		if (done == true)
+			return;
+
+		dlc = (dlc << 1) | bit;
+	}
+
+	/* On CAN-FD the DLC is not equal to number of bytes in packet in all cases. On standard CAN it is up */
+	/* to 8, and codes above that still mean 8 bytes. */
+	if (FD == true)
+		mNumDataBytes = gFdDataBytes[dlc];
+	else
+		mNumDataBytes = std::min<U32>(dlc, 8);
+
+	frame.mStartingSampleInclusive = first_sample;
+	frame.mEndingSampleInclusive = last_sample;
+	frame.mType = ControlField;
+	frame.mData1 = dlc;
+	frame.mFlags = (FD == true) ? FD_FRAME : 0;
+	AddResultFrame(frame);
+
+	if (mSettings->mSkimMode == true)
+	{
+		/* Arbitration only - data, CRC and ACK fields are not decoded. An error flag found while */
+		/* skipping them cancels the packet instead. */
+		if (mCanError == true)
+			return;
+
+		U64 packet_id = mResults->CommitPacketAndStartNewPacket();
+		mIdIndex.AddPacket(mCurrentBus->mBus, mIdentifier, EXTENDED, packet_id, mStartOfFrame);
+
+		if (mDecodeCache.IsRecording() == true)
+			mDecodeCache.AddCommitPacket(mIdentifier, EXTENDED, mStartOfFrame);
+		return;
+	}
+
+	U32 num_bytes = mNumDataBytes;
+
+	if (mRemoteFrame == true)
+		num_bytes = 0; //ignore the num_bytes if this is a remote frame.
+
+	/* Data section. Get and unpack pre-determined number of bytes from this packet */
+
+	for (U32 i = 0; i < num_bytes; i++)
+	{
+		done = UnstuffRawFrameBit(bit, first_sample);
+		if (done == true)
+			return;
+
+		U32 data = bit;
+		for (U32 j = 1; j < 8; j++)
+		{
+			done = UnstuffRawFrameBit(bit, last_sample);
+			if (done == true)
+				return;
+
+			data = (data << 1) | bit;
+		}
+		mDecodedFrame.mData[i] = (U8)data;
+
+		frame.mStartingSampleInclusive = first_sample;
+		frame.mEndingSampleInclusive = last_sample;
+		frame.mType = DataField;
+		frame.mData1 = data;
+		AddResultFrame(frame);
+	}
+
+	/* End of data section */
+
+	/* Standard 11 or 29-bit CAN - always 15 bits and normal stuffing behaviour */
+	U32 crc_bits = 15;
+
+	if (FD == true)
+	{
+		/* 6 additional bits in CAN-FD identifier frame prior to CRC Section */
+
+		/* Fixed Stuff bit 1 */
+		U8 fsb1;
+		done = UnstuffFixedStuffBit(fsb1, last_sample);
+		if (done == true)
+			return;
+
+		/* Stuff count bits 2 to 0, then the stuff bits parity */
+		for (U32 i = 0; i < 4; i++)
+		{
+			U8 stuff_count;
+			done = UnstuffRawFrameBit(stuff_count, last_sample);
+			if (done == true)
+				return;
+		}
+
+		/* Fixed Stuff bit 2 */
+		U8 fsb2;
+		done = UnstuffFixedStuffBit(fsb2, last_sample);
+		if (done == true)
+			return;
+
+		/* CRC length depends on packet data length. Stuffing bits are in fixed, known positions */
+		crc_bits = (mNumDataBytes >= 20) ? 21 : 17;
+	}
+
+	done = UnstuffRawFrameBit(bit, first_sample);
+	if (done == true)
+		return;
+
+	mCrcValue = bit;
+	for (U32 i = 1; i < crc_bits; i++)
+	{
+		/* Rule for flagging fixed stuff bits in CAN-FD frames */
+		/* Every 4th bit is a fixed stuffing bit in the CRC field. */
+		if ((FD == true) && ((i % 4) == 0))
+		{
+			U8 fsb;
+			done = UnstuffFixedStuffBit(fsb, last_sample);
+			if (done == true)
+				return;
+		}
+
+		done = UnstuffRawFrameBit(bit, last_sample);
+		if (done == true)
+			return;
+
+		mCrcValue = (mCrcValue << 1) | bit;
+	}
+
+	frame.mStartingSampleInclusive = first_sample;
+	frame.mEndingSampleInclusive = last_sample;
+	frame.mType = CrcField;
+	frame.mData1 = mCrcValue;
+	if (FD == true)
+		frame.mFlags = (crc_bits == 21) ? (FD_FRAME | CRC_21) : FD_FRAME;
+	AddResultFrame(frame);
+
+	/* Trailer section is common to all formats */
+
+	U8 crc_delimiter;
+	done = UnstuffRawFrameBit(crc_delimiter, first_sample);
+	if (done == true)
+		return;
+
+	if (FD == true)
+	{
+		/* The transmitter sends one delimiter bit, but receivers accept two, as the ACK can come late */
+		/* after the bit rate switches back. That happens at the delimiter's sample point, so with BRS */
+		/* the delimiter is part data bit, part header bit. The ACK slot starts at the first dominant */
+		/* raw bit within two header bits, and without one it is read after a two bit delimiter. */
+		done = FindAckSlot();
+		if (done == true)
+			return;
+	}
+
+	/* If using flexible data rate, fast bit timing should finish here */
+	mBitStep = mBitRateFactor;
+
+	U8 ackslot = CAN_RECESSIVE;
+	done = GetFixedFormFrameBit(ackslot, first_sample);
+	mAck = (ackslot == CAN_DOMINANT);
+
+	U8 ackdelim;
+	done = GetFixedFormFrameBit(ackdelim, last_sample);
+
+	if (done == true)
+		return;
+
+	frame.mStartingSampleInclusive = first_sample;
+	frame.mEndingSampleInclusive = last_sample;
+	frame.mType = AckField;
+	frame.mData1 = mAck;
+	AddResultFrame(frame);
+
+	mDecodedFrame.mBus = mCurrentBus->mBus;
+	mDecodedFrame.mIdentifier = mIdentifier;
+	mDecodedFrame.mExtended = mExtendedIdentifier;
+	mDecodedFrame.mFdFrame = mFdFrame;
+	mDecodedFrame.mRemoteFrame = mRemoteFrame;
+	mDecodedFrame.mAck = mAck;
+	mDecodedFrame.mStartingSample = mStartOfFrame;
+	mDecodedFrame.mEndingSample = last_sample;
+	mDecodedFrame.mNumDataBytes = std::min<U32>(num_bytes, CAN_FD_MAX_DATA_BYTES);
+	mDecodedFrame.mPacketId = mResults->CommitPacketAndStartNewPacket();
+	mIdIndex.AddPacket(mCurrentBus->mBus, mIdentifier, EXTENDED, mDecodedFrame.mPacketId, mStartOfFrame);
+	mFrameDecoded = true;
+
+	if (mDecodeCache.IsRecording() == true)
+		mDecodeCache.AddCommitPacket(mIdentifier, EXTENDED, mStartOfFrame);
+}
+
+void CAN_FDAnalyzer::StartRawFrameBits()
+{
+	mRecessiveCount = 0;
+	mDominantCount = 0;
+	mCanMarkers.clear();
+	mBitStep = mBitRateFactor;
+
+	/* get away from the leading sample edge just a little. With one data bit per header bit */
+	/* the first sample is already in the middle of the start bit */
+	if (mBitRateFactor > 1)
+		mRawFrameIndex = 1;
+	else
+		mRawFrameIndex = 0;
+}
+
+void CAN_FDAnalyzer::SwitchToDataBitRate()
+{
+	/* Called once the BRS bit has been read, which moved on by a whole header bit. The ESI bit is the */
+	/* first one at the data bit rate, which takes over at the BRS bit's sample point. That depends on */
+	/* the nodes' bit timing, so the ESI bit is found by its dominant edge, as sent by any node that is */
+	/* error active. A recessive ESI has no edge, and then the switch is taken to be one data bit before */
+	/* the end of the BRS bit. */
+	if (mBitRateFactor >= 2)
+	{
+		U32 brs_index = mRawFrameIndex - mBitRateFactor;
+		U32 esi_index = mRawFrameIndex - 2;
+
+		for (U32 i = brs_index + 1; (i <= mRawFrameIndex) && (i < mNumRawBits); i++)
+		{
+			if (mRawBitResults[i] == CAN_DOMINANT)
+			{
+				esi_index = i;
+				break;
+			}
+		}
+
+		mRawFrameIndex = esi_index;
+	}
+
+	mBitStep = 1;
+}
+
+bool CAN_FDAnalyzer::FindAckSlot()
+{
+	/* Called after the first CRC delimiter bit of a CAN-FD frame, with the raw frame index on the */
+	/* next bit at the current bit step. Without an ACK, the slot follows a second delimiter bit. */
+	U32 ack_index = mRawFrameIndex + mBitStep;
+	U32 search_end = mRawFrameIndex + (2 * mBitRateFactor);
+
+	for (U32 i = mRawFrameIndex; (i < search_end) && (i < mNumRawBits); i++)
+	{
+		if (mRawBitResults[i] == CAN_DOMINANT)
+		{
+			/* Header bits are read one raw bit into the bit, as from the start of frame */
+			ack_index = ((mBitStep > 1) && (i > mRawFrameIndex)) ? (i + 1) : i;
+			break;
+		}
+	}
+
+	if (ack_index > mRawFrameIndex)
+	{
+		/* The second delimiter bit */
+		if (mRawFrameIndex >= mNumRawBits)
+			return true;
+
+		mCanMarkers.push_back(CanMarker(mStartOfFrame + mSampleOffsets[mRawFrameIndex], Standard));
+	}
+
+	mRawFrameIndex = ack_index;
+	return false;
+}
+
+bool CAN_FDAnalyzer::GetFixedFormFrameBit(U8& result, U64& sample)
+{
+	if (mNumRawBits <= mRawFrameIndex)
+		return true;
+
+	result = mRawBitResults[mRawFrameIndex];
+	sample = mStartOfFrame + mSampleOffsets[mRawFrameIndex];
+	mCanMarkers.push_back(CanMarker(sample, Standard));
+
+	mRawFrameIndex += mBitStep;
+
+	return false;
+}
+
+bool CAN_FDAnalyzer::UnstuffFixedStuffBit(U8& result, U64& sample)
+{
+	/* Some bits in CAN-FD are known stuffing bits. We mark these as stuffed bits */
+	/* Note that this routine does not provide a result which should be used as part */
+	/* of a data field in the message, but it does then increment the FrameIndex to */
+	/* point at the next bit which will be part of the message */
+
+	/* Initial check to ensure we aren't beyond the end of the raw frame */
+	if (mRawFrameIndex >= mNumRawBits)
+		return true;
+
+	/* Get this sample */
+	sample = mStartOfFrame + mSampleOffsets[mRawFrameIndex];
+	result = mRawBitResults[mRawFrameIndex];
+
+	/* Fixed stuffing bit used by CAN-FD protocol */
+	if (result == CAN_RECESSIVE)
+	{
+		mDominantCount = 0;
+		mRecessiveCount++;
+	}
+	else
+	{
+		mRecessiveCount = 0;
+		mDominantCount++;
+	}
+	mCanMarkers.push_back(CanMarker(sample, BitStuff));
+
+	/* Next bit is one data bit time from here, or one header bit time when the bit rate doesn't switch */
+	mRawFrameIndex += mBitStep;
+
+	return false;
+}
+
+bool CAN_FDAnalyzer::UnstuffRawFrameBit(U8& result, U64& sample)
+{
+	/* This routine is the one normally called by the frame analysis function to unpack bits to be included */
+	/* It also acts as the place which detects if the CAN or CAN-FD protocol has added a stuffing bit into the */
+	/* protocol. This is important, since the code which called this routine is expecting the bits to be */
+	/* according to a specified protocol. Depending on the values of real data in this packet, the protocol rules */
+	/* may add a stuffing bit or not into the serial data. This routine must identify if bit stuffing has taken place */
+	/* mark the bit as one which is an inserted bit, and then go on to process the next bit in the frame which will be */
+	/* the bit that was expected originally. This routine, therefore, *must* return the result of the expected */
+	/* bit, and then finish by incrementing the FrameIndex by an appropriate value. */
+	/* Returns true if FrameIndex now points past the end of the acquired data, otherwise returns false. */
+
+	/* Initial check to ensure we aren't beyond the end of the raw frame */
+	if (mRawFrameIndex >= mNumRawBits)
+		return true;
+
+	/* Get the number of this sample */
+	sample = mStartOfFrame + mSampleOffsets[mRawFrameIndex];
+
+	/* Check for a dominant bit stuffing bit */
+	if (mRecessiveCount == 5)
+	{
+		mRecessiveCount = 0;
+		mDominantCount = 1; //this bit is DOMINANT, and counts towards the next bit stuff
+		mCanMarkers.push_back(CanMarker(sample, BitStuff));
+
+		/* Point at next bit */
+		mRawFrameIndex += mBitStep;
+	}
+
+	/* Check for a recessive bit stuffing bit */
+	if (mDominantCount == 5)
+	{
+		mDominantCount = 0;
+		mRecessiveCount = 1; //this bit is RECESSIVE, and counts towards the next bit stuff
+		mCanMarkers.push_back(CanMarker(sample, BitStuff));
+
+		/* Point at next bit */
+		mRawFrameIndex += mBitStep;
+	}
+
+	/* Check to ensure we aren't beyond the end of the raw frame */
+	if (mRawFrameIndex >= mNumRawBits)
+		return true;
+
+	/* This bit contributes to message */
+	sample = mStartOfFrame + mSampleOffsets[mRawFrameIndex];
+	result = mRawBitResults[mRawFrameIndex];
+
+	if (result == CAN_RECESSIVE)
+	{
+		mRecessiveCount++;
+		mDominantCount = 0;
+	}
+	else
+	{
+		mDominantCount++;
+		mRecessiveCount = 0;
+	}
+
+	/* Add marker */
+	mCanMarkers.push_back(CanMarker(sample, Standard));
+
+	/* Get next sample - one data bit on from here once the bit rate has switched */
+	mRawFrameIndex += mBitStep;
+
+	return false;
+}
+
+
+
+CAN_FDBusStatistics& CAN_FDAnalyzer::GetBusStatistics(U32 bus)
+{
+	return mBusStatistics[bus];
+}
+
+CanTrace& CAN_FDAnalyzer::GetTrace()
+{
+	return mTrace;
+}
+
+CAN_FDIsoTp& CAN_FDAnalyzer::GetIsoTp()
+{
+	return mIsoTp;
+}
+
+CAN_FDJ1939& CAN_FDAnalyzer::GetJ1939()
+{
+	return mJ1939;
+}
+
+CAN_FDDbc& CAN_FDAnalyzer::GetDbc()
+{
+	return mDbc;
+}
+
+CAN_FDIdIndex& CAN_FDAnalyzer::GetIdIndex()
+{
+	return mIdIndex;
+}
+
+void CAN_FDAnalyzer::SetSimulationOptions(const CanSimulationOptions& options)
+{
+	mSimulationDataGenerator.SetOptions(options);
+	mSimulationInitilized = false;
+}
+
+bool CAN_FDAnalyzer::NeedsRerun()
+{
+	/* Called once the decode is over, so the settings can take what detection found */
+	if (mDetectedBuses.empty() == false)
+	{
+		for (U32 i = 0; i < mDetectedBuses.size(); i++)
+		{
+			const CanBusState& bus = mDetectedBuses[i];
+			mSettings->SetBusParameters(bus.mBus, bus.mBitRateHdr, bus.mBitRateData, bus.mInverted);
+		}
+		mDetectedBuses.clear();
+
+		mSettings->UpdateInterfacesFromSettings();
+		mAutoDetectedSettings = mSettings->SaveSettings();
+		mAutoDetectedCaptureKnown = false;
+	}
+
+	return mRerunRequired;
+}
+
+U32 CAN_FDAnalyzer::GenerateSimulationData( U64 minimum_sample_index, U32 device_sample_rate, SimulationChannelDescriptor** simulation_channels )
+{
+	if( mSimulationInitilized == false )
+	{
+		mSimulationDataGenerator.Initialize( GetSimulationSampleRate(), mSettings.get() );
+		mSimulationInitilized = true;
+	}
+
+	return mSimulationDataGenerator.GenerateSimulationData( minimum_sample_index, device_sample_rate, simulation_channels );
+}
+
+U32 CAN_FDAnalyzer::GetMinimumSampleRateHz()
+{
+	/* Ensure we have at least 4 samples per bit at the highest bit rate of any bus */
+	U32 fastest = 0;
+
+	for (U32 i = 0; i < CAN_FD_MAX_BUSES; i++)
+	{
+		if (mSettings->IsBusEnabled(i) == false)
+			continue;
+
+		if (mSettings->GetBusBitRateHdr(i) > fastest)
+			fastest = mSettings->GetBusBitRateHdr(i);
+		if (mSettings->GetBusBitRateData(i) > fastest)
+			fastest = mSettings->GetBusBitRateData(i);
+	}
+
+	return fastest * 4;
+}
+
+const char* CAN_FDAnalyzer::GetAnalyzerName() const
+{
+	return "CAN_FD";
+}
+
+const char* GetAnalyzerName()
+{
+	return "CAN_FD";
+}
+
+Analyzer* CreateAnalyzer()
+{
+	return new CAN_FDAnalyzer();
+}
+
+void DestroyAnalyzer( Analyzer* analyzer )
+{
+	delete analyzer;
 }
\ No newline at end of file
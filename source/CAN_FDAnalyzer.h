@@ -1,104 +1,208 @@
-#ifndef CAN_FD_ANALYZER_H
-#define CAN_FD_ANALYZER_H
-
-#include <Analyzer.h>
-#include "CAN_FDAnalyzerResults.h"
-#include "CAN_FDSimulationDataGenerator.h"
-
-enum CanBitType { Standard, BitStuff };
-
-class CanMarker
-{
-public:
-	CanMarker(U64 sample, enum CanBitType type)
-	{
-		mSample = sample;
-		mType = type;
-	}
-
-	U64 mSample;
-	enum CanBitType mType;
-};
-
-class CAN_FDAnalyzerSettings;
-
-class ANALYZER_EXPORT CAN_FDAnalyzer : public Analyzer2
-{
-public:
-	CAN_FDAnalyzer();
-	virtual ~CAN_FDAnalyzer();
-
-	virtual void SetupResults();
-	virtual void WorkerThread();
-
-	virtual U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels );
-	virtual U32 GetMinimumSampleRateHz();
-
-	virtual const char* GetAnalyzerName() const;
-	virtual bool NeedsRerun();
-
-
-protected: //analysis functions
-	void WaitFor7RecessiveBits();
-	void InitSampleOffsets();
-	void GetRawFrame();
-	void AnalyzeRawFrame();
-	bool UnstuffFixedStuffBit(BitState& result, U64& sample, bool reset = false);
-	bool UnstuffRawFrameBit(BitState& result, U64& sample, bool reset = false);
-	bool GetFixedFormFrameBit(BitState& result, U64& sample);
-
-protected: //vars
-	std::auto_ptr< CAN_FDAnalyzerSettings > mSettings;
-	std::auto_ptr< CAN_FDAnalyzerResults > mResults;
-	AnalyzerChannelData* mCAN_FD;
-	U32 mSampleRateHz;
-
-	CAN_FDSimulationDataGenerator mSimulationDataGenerator;
-	bool mSimulationInitilized;
-
-
-protected: //analysis vars:
-
-	U32 mBitRateFactor;
-	bool mCheckingBRS;
-	bool mBaudSwitch;
-
-	U32 mNumSamplesIn7Bits;
-	U32 mRecessiveCount;
-	U32 mDominantCount;
-	U32 mRawFrameIndex;
-	U64 mStartOfFrame;
-	U32 mIdentifier;
-	U32 mCrcValue;
-	bool mAck;
-
-	std::vector<U32> mSampleOffsets;
-	std::vector<BitState> mRawBitResults;
-	std::vector<BitState> mBitResults;
-	std::vector<CanMarker> mCanMarkers;
-	std::vector<BitState> mArbitrationField;
-
-	bool mStandardCan;
-	bool mStandardCanFD;
-	bool mRemoteFrame;
-	U32 mNumDataBytes;
-
-	std::vector<BitState> mControlField;
-	std::vector<BitState> mDataField;
-	std::vector<BitState> mCrcFieldWithoutDelimiter;
-	BitState mCrcDelimiter;
-	std::vector<BitState> mAckField;
-	std::vector<BitState> mEndOfFrame;
-
-	U32 mNumRawBits;
-	bool mCanError;
-	U64 mErrorStartingSample;
-	U64 mErrorEndingSample;
-	
-};
-
-extern "C" ANALYZER_EXPORT const char* __cdecl GetAnalyzerName();
-extern "C" ANALYZER_EXPORT Analyzer* __cdecl CreateAnalyzer( );
-extern "C" ANALYZER_EXPORT void __cdecl DestroyAnalyzer( Analyzer* analyzer );
-
-#endif //CAN_FD_ANALYZER_H
+#ifndef CAN_FD_ANALYZER_H
+#define CAN_FD_ANALYZER_H
+
+#include <Analyzer.h>
+#include <chrono>
+#include <string>
+#include "CAN_FDAnalyzerResults.h"
+#include "CAN_FDSimulationDataGenerator.h"
+#include "CAN_FDBusStatistics.h"
+#include "CAN_FDAnalyzerSettings.h"
+#include "CAN_FDPerfCounters.h"
+#include "CAN_FDTrace.h"
+#include "CAN_FDFrameReader.h"
+#include "CAN_FDDecodedFrame.h"
+#include "CAN_FDIsoTp.h"
+#include "CAN_FDJ1939.h"
+#include "CAN_FDDbc.h"
+#include "CAN_FDIdIndex.h"
+#include "CAN_FDDecodeCache.h"
+#include "CAN_FDSofIndex.h"
+
+enum CanBitType { Standard, BitStuff };
+
+/* Worst case length of SOF, arbitration and control fields (29-bit FD) including stuff bits, in header bit times */
+#define SKIM_HEADER_BITS 52
+
+/* Worst case length of a whole frame (29-bit FD, 64 bytes, no bit rate switch) including stuff bits, in header bit times */
+#define MAX_FRAME_BITS 740
+
+/* Bus parameter detection looks at this many pulses, and gives up with fewer pulses or frames than the minimums */
+#define AUTO_DETECT_PULSES 32768
+#define AUTO_DETECT_MIN_PULSES 256
+#define AUTO_DETECT_MIN_FRAMES 8
+#define AUTO_DETECT_MAX_DATA_RATE 8000000
+
+/* Pulses checked at the start of each frame when matching a header rate. These lie before any bit rate switch. */
+#define AUTO_DETECT_FRAME_PULSES 5
+
+/* The data bit width is the shortest pulse width found in at least this percentage of the pulses */
+#define AUTO_DETECT_DATA_BIT_PERCENT 1
+
+class CanMarker
+{
+public:
+	CanMarker(U64 sample, enum CanBitType type)
+	{
+		mSample = sample;
+		mType = type;
+	}
+
+	U64 mSample;
+	enum CanBitType mType;
+};
+
+class CAN_FDAnalyzerSettings;
+
+class ANALYZER_EXPORT CAN_FDAnalyzer : public Analyzer2
+{
+public:
+	CAN_FDAnalyzer();
+	virtual ~CAN_FDAnalyzer();
+
+	virtual void SetupResults();
+	virtual void WorkerThread();
+
+	virtual U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels );
+	virtual U32 GetMinimumSampleRateHz();
+
+	virtual const char* GetAnalyzerName() const;
+	virtual bool NeedsRerun();
+
+	CAN_FDBusStatistics& GetBusStatistics(U32 bus);
+	CanTrace& GetTrace();
+	CAN_FDIsoTp& GetIsoTp();
+	CAN_FDJ1939& GetJ1939();
+	CAN_FDDbc& GetDbc();
+	CAN_FDIdIndex& GetIdIndex();
+
+	/* Takes effect from the next simulation, which starts again from the beginning */
+	void SetSimulationOptions(const CanSimulationOptions& options);
+
+protected: //analysis functions
+	friend class CAN_FDFrameReader;
+
+	bool DetectBusParameters();
+	void CheckAutoDetectedCapture();
+	void InitSampleOffsets(CanBusState& bus);
+	void SelectBus(U32 index);
+	void AddResultFrame(Frame& frame);
+	void OpenDecodeCache();
+	bool CheckDecodeCache();
+	void ReplayDecodeCache();
+	std::string GetSofIndexKey();
+	void GetDecodeWindow();
+	void StartDecodeWindow();
+	void EndDecodeWindow();
+	void DecodeRawFrame(CanRawFrame& raw);
+	void AnalyzeRawFrame();
+	template <bool FD, bool EXTENDED> void AnalyzeFrame(U8 rtr, U64 last_sample);
+	void ProcessDecodedFrame();
+	void StartRawFrameBits();
+	void SwitchToDataBitRate();
+	bool FindAckSlot();
+	bool UnstuffFixedStuffBit(U8& result, U64& sample);
+	bool UnstuffRawFrameBit(U8& result, U64& sample);
+	bool GetFixedFormFrameBit(U8& result, U64& sample);
+	void EmitFrameResults();
+	void CommitResultsIfDue();
+	void CommitResultsIfCaughtUp(AnalyzerChannelData* channel);
+	void CommitResults();
+	void UpdateBusStatistics();
+
+protected: //vars
+	std::auto_ptr< CAN_FDAnalyzerSettings > mSettings;
+	std::auto_ptr< CAN_FDAnalyzerResults > mResults;
+	AnalyzerChannelData* mCAN_FD;
+	U32 mSampleRateHz;
+
+	CAN_FDSimulationDataGenerator mSimulationDataGenerator;
+	bool mSimulationInitilized;
+
+	bool mRerunRequired;
+
+	/* Detection runs on the worker thread, while the UI may be reading the settings. What it finds is */
+	/* kept in mDetectedBuses and only put in the settings by NeedsRerun, once the decode is over. */
+	std::vector<CanBusState> mDetectedBuses;
+	std::string mAutoDetectedSettings;
+	U64 mAutoDetectedCapture;			/* fingerprint of the capture the settings were detected on */
+	bool mAutoDetectedCaptureKnown;
+	bool mCheckAutoDetectedCapture;
+	std::string mTriggerFirstSettings;
+
+	U32 mFramesSinceCommit;
+	std::chrono::steady_clock::time_point mLastCommitTime;
+
+	CAN_FDBusStatistics mBusStatistics[CAN_FD_MAX_BUSES];
+	CAN_FDIsoTp mIsoTp;
+	CAN_FDJ1939 mJ1939;
+	CAN_FDDbc mDbc;
+	CAN_FDIdIndex mIdIndex;
+
+	/* Results kept between sessions. mBusProgress is where each bus's reader was after its last raw frame. */
+	CAN_FDDecodeCache mDecodeCache;
+	std::vector<CanCacheBusProgress> mBusProgress;
+	std::vector<U64> mCacheMarkerSamples;
+	std::vector<U8> mCacheMarkerStuffed;
+	std::string mRejectedCacheSettings;
+	CAN_FDSofIndex mSofIndex;
+
+	/* Frames starting in the window are decoded, the first one after it ends the decode */
+	U64 mDecodeStartSample;
+	U64 mDecodeEndSample;
+	bool mDecodeWindowEnded;
+	bool mTriggerFirstPass;
+
+	std::vector<CanBusState> mBuses;
+	CanBusState* mCurrentBus;
+
+	CanPerfCounters mPerf;
+	CanTrace mTrace;
+	CAN_FDFrameReader mReader;
+
+protected: //analysis vars:
+
+	/* Copied from the current bus by SelectBus */
+	U32 mBitRateFactor;
+
+	/* Raw bits from one frame bit to the next, the bit rate factor or 1 after a bit rate switch */
+	U32 mBitStep;
+
+	bool mRawFrameTruncated;
+	U64 mTruncatedEndingSample;
+	U64 mProgressSample;
+	bool mCaughtUp;
+	U32 mRecessiveCount;
+	U32 mDominantCount;
+	U32 mRawFrameIndex;
+	U64 mStartOfFrame;
+	U32 mIdentifier;
+	bool mIdentifierDecoded;
+	bool mExtendedIdentifier;
+	bool mFdFrame;
+	U32 mCrcValue;
+	bool mAck;
+
+	const U32* mSampleOffsets;
+	std::vector<U8> mRawBitResults;
+	std::vector<CanMarker> mCanMarkers;
+
+	bool mRemoteFrame;
+	U32 mNumDataBytes;
+
+	/* Filled in by AnalyzeRawFrame for the protocol layers, valid when mFrameDecoded is set */
+	CanDecodedFrame mDecodedFrame;
+	bool mFrameDecoded;
+
+	U32 mNumRawBits;
+	bool mCanError;
+	U64 mErrorStartingSample;
+	U64 mErrorEndingSample;
+	
+};
+
+extern "C" ANALYZER_EXPORT const char* __cdecl GetAnalyzerName();
+extern "C" ANALYZER_EXPORT Analyzer* __cdecl CreateAnalyzer( );
+extern "C" ANALYZER_EXPORT void __cdecl DestroyAnalyzer( Analyzer* analyzer );
+
+#endif //CAN_FD_ANALYZER_H
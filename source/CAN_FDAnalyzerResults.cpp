@@ -1,459 +1,1218 @@
-#include "CAN_FDAnalyzerResults.h"
-#include <AnalyzerHelpers.h>
-#include "CAN_FDAnalyzer.h"
-#include "CAN_FDAnalyzerSettings.h"
-#include <iostream>
-#include <sstream>
-
-CAN_FDAnalyzerResults::CAN_FDAnalyzerResults( CAN_FDAnalyzer* analyzer, CAN_FDAnalyzerSettings* settings )
-:	AnalyzerResults(),
-	mSettings( settings ),
-	mAnalyzer( analyzer )
-{
-}
-
-CAN_FDAnalyzerResults::~CAN_FDAnalyzerResults()
-{
-}
-
-void CAN_FDAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base )
-{
-	//we only need to pay attention to 'channel' if we're making bubbles for more than one channel (as set by AddChannelBubblesWillAppearOn)
-	ClearResultStrings();
-	Frame frame = GetFrame(frame_index);
-
-	switch (frame.mType)
-	{
-	case IdentifierField:
-	case IdentifierFieldEx:
-	{
-		char number_str[128];
-
-		if (frame.mType == IdentifierField)
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
-		else
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
-
-		std::stringstream ss;
-
-		AddResultString("Id");
-
-		ss << "Id: " << number_str;
-		AddResultString(ss.str().c_str());
-		ss.str("");
-
-		ss << "Identifier: " << number_str;
-		AddResultString(ss.str().c_str());
-		ss.str("");
-
-		if (frame.HasFlag(REMOTE_FRAME) == false)
-		{
-			if (frame.mType == IdentifierField)
-				ss << "11-bit CAN Identifier: " << number_str;
-			else
-				ss << "29-bit CAN Identifier: " << number_str;
-		}
-		else
-		{
-			if (frame.mType == IdentifierField)
-				ss << "11-bit CAN Identifier: " << number_str << " (RTR)";
-			else
-				ss << "29-bit CAN Identifier: " << number_str << " (RTR)";
-		}
-
-		AddResultString(ss.str().c_str());
-	}
-	break;
-
-	case FDIdentifier:
-	case FDIdentifierEx:
-	{
-		char number_str[128];
-
-		if (frame.mType == FDIdentifier)
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
-		else
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
-
-		std::stringstream ss;
-
-		AddResultString("Id");
-
-		ss << "FD-Id: " << number_str;
-		AddResultString(ss.str().c_str());
-		ss.str("");
-
-		ss << "FD-Identifier: " << number_str;
-		AddResultString(ss.str().c_str());
-		ss.str("");
-
-		if (frame.HasFlag(REMOTE_FRAME) == false)
-		{
-			if (frame.mType == FDIdentifier)
-				ss << "11-bit CAN-FD Identifier: " << number_str;
-			else
-				ss << "29-bit CAN-FD Identifier: " << number_str;
-		}
-		else
-		{
-			/* Note - remote frames are not used according to the spec */
-			if (frame.mType == FDIdentifier)
-				ss << "11-bit CAN-FD Identifier: " << number_str << " (RTR)";
-			else
-				ss << "29-bit CAN-FD Identifier: " << number_str << " (RTR)";
-		}
-
-		AddResultString(ss.str().c_str());
-	}
-	break;
-
-	case ControlField:
-	{
-		char number_str[128];
-		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 4, number_str, 128);
-
-		std::stringstream ss;
-		AddResultString("Ctrl");
-
-		ss << "Ctrl: " << number_str;
-		AddResultString(ss.str().c_str());
-		ss.str("");
-
-		ss << "Control Field: " << number_str;
-		AddResultString(ss.str().c_str());
-
-		ss << " bytes";
-		AddResultString(ss.str().c_str());
-	}
-	break;
-
-	case DataField:
-	{
-		char number_str[128];
-		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, 128);
-
-		AddResultString(number_str);
-
-		std::stringstream ss;
-		ss << "Data: " << number_str;
-		AddResultString(ss.str().c_str());
-		ss.str("");
-
-		ss << "Data Field Byte: " << number_str;
-		AddResultString(ss.str().c_str());
-	}
-	break;
-
-	case CrcField:
-	{
-		char number_str[128];
-		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 15, number_str, 128);
-
-		AddResultString("CRC");
-
-		std::stringstream ss;
-		ss << "CRC: " << number_str;
-		AddResultString(ss.str().c_str());
-		ss.str("");
-
-		ss << "CRC value: " << number_str;
-		AddResultString(ss.str().c_str());
-	}
-	break;
-
-	case AckField:
-	{
-		if (bool(frame.mData1) == true)
-			AddResultString("ACK");
-		else
-			AddResultString("NAK");
-	}
-	break;
-
-	case CanError:
-	{
-		AddResultString("E");
-		AddResultString("Error");
-	}
-	break;
-
-	}
-}
-
-void CAN_FDAnalyzerResults::GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id )
-{
-	//export_type_user_id is only important if we have more than one export type.
-	std::stringstream ss;
-	void* f = AnalyzerHelpers::StartFile(file);
-
-	U64 trigger_sample = mAnalyzer->GetTriggerSample();
-	U32 sample_rate = mAnalyzer->GetSampleRate();
-
-	ss << "Time [s],Packet,Type,Identifier,Control,Data,CRC,ACK" << std::endl;
-	U64 num_frames = GetNumFrames();
-	U64 num_packets = GetNumPackets();
-	for (U32 i = 0; i < num_packets; i++)
-	{
-		if (i != 0)
-		{
-			//below, we "continue" the loop rather than run to the end.  So we need to save to the file here.
-			ss << std::endl;
-
-			AnalyzerHelpers::AppendToFile((U8*)ss.str().c_str(), (U32)ss.str().length(), f);
-			ss.str(std::string());
-
-
-			if (UpdateExportProgressAndCheckForCancel(i, num_packets) == true)
-			{
-				AnalyzerHelpers::EndFile(f);
-				return;
-			}
-		}
-
-
-		U64 first_frame_id;
-		U64 last_frame_id;
-		GetFramesContainedInPacket(i, &first_frame_id, &last_frame_id);
-		Frame frame = GetFrame(first_frame_id);
-
-		//static void GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length );
-		char time_str[128];
-		AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
-
-		char packet_str[128];
-		AnalyzerHelpers::GetNumberString(i, Decimal, 0, packet_str, 128);
-
-		if (frame.HasFlag(REMOTE_FRAME) == false)
-			ss << time_str << "," << packet_str << ",DATA";
-		else
-			ss << time_str << "," << packet_str << ",REMOTE";
-
-		U64 frame_id = first_frame_id;
-
-		frame = GetFrame(frame_id);
-
-		char number_str[128];
-
-		if ((frame.mType == IdentifierField) || (frame.mType == FDIdentifier))
-		{
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
-			ss << "," << number_str;
-			++frame_id;
-		}
-		else if ((frame.mType == IdentifierFieldEx) || (frame.mType == FDIdentifierEx))
-		{
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
-			ss << "," << number_str;
-			++frame_id;
-		}
-		else
-		{
-			ss << ",";
-		}
-
-		if (frame_id > last_frame_id)
-			continue;
-
-		frame = GetFrame(frame_id);
-		if (frame.mType == ControlField)
-		{
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 4, number_str, 128);
-			ss << "," << number_str;
-			++frame_id;
-		}
-		else
-		{
-			ss << ",";
-		}
-		ss << ",";
-		if (frame_id > last_frame_id)
-			continue;
-
-		for (; ; )
-		{
-			frame = GetFrame(frame_id);
-			if (frame.mType != DataField)
-				break;
-
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, 128);
-			ss << number_str;
-			if (frame_id == last_frame_id)
-				break;
-
-			++frame_id;
-			if (GetFrame(frame_id).mType == DataField)
-				ss << " ";
-		}
-
-		if (frame_id > last_frame_id)
-			continue;
-
-		frame = GetFrame(frame_id);
-		if (frame.mType == CrcField)
-		{
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 15, number_str, 128);
-			ss << "," << number_str;
-			++frame_id;
-		}
-		else
-		{
-			ss << ",";
-		}
-		if (frame_id > last_frame_id)
-			continue;
-
-		frame = GetFrame(frame_id);
-		if (frame.mType == AckField)
-		{
-			if (bool(frame.mData1) == true)
-				ss << "," << "ACK";
-			else
-				ss << "," << "NAK";
-
-			++frame_id;
-		}
-		else
-		{
-			ss << ",";
-		}
-	}
-
-	UpdateExportProgressAndCheckForCancel(num_frames, num_frames);
-	AnalyzerHelpers::EndFile(f);
-}
-
-void CAN_FDAnalyzerResults::GenerateFrameTabularText( U64 frame_index, DisplayBase display_base )
-{
-	ClearTabularText();
-
-	Frame frame = GetFrame(frame_index);
-
-	switch (frame.mType)
-	{
-	case IdentifierField:
-	case IdentifierFieldEx:
-	{
-		char number_str[128];
-
-		if (frame.mType == IdentifierField)
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
-		else
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
-
-		std::stringstream ss;
-
-
-		if (frame.HasFlag(REMOTE_FRAME) == false)
-		{
-			if (frame.mType == IdentifierField)
-				ss << "Standard CAN Identifier: " << number_str;
-			else
-				ss << "Extended CAN Identifier: " << number_str;
-		}
-		else
-		{
-			if (frame.mType == IdentifierField)
-				ss << "Standard CAN Identifier: " << number_str << " (RTR)";
-			else
-				ss << "Extended CAN Identifier: " << number_str << " (RTR)";
-		}
-
-		AddTabularText(ss.str().c_str());
-	}
-	break;
-
-	case FDIdentifier:
-	case FDIdentifierEx:
-	{
-		char number_str[128];
-
-		if (frame.mType == FDIdentifier)
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
-		else
-			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
-
-		std::stringstream ss;
-
-
-		if (frame.HasFlag(REMOTE_FRAME) == false)
-		{
-			if (frame.mType == FDIdentifier)
-				ss << "11-bit FD-CAN Identifier: " << number_str;
-			else
-				ss << "29-bit FD-CAN Identifier: " << number_str;
-		}
-		else
-		{
-			if (frame.mType == FDIdentifier)
-				ss << "11-bit FD-CAN Identifier: " << number_str << " (RTR)";
-			else
-				ss << "29-bit FD-CAN Identifier: " << number_str << " (RTR)";
-		}
-
-		AddTabularText(ss.str().c_str());
-	}
-	break;
-
-	case ControlField:
-	{
-		char number_str[128];
-		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 4, number_str, 128);
-
-		std::stringstream ss;
-
-		ss << "Control Field: " << number_str;
-		ss << " bytes";
-		AddTabularText(ss.str().c_str());
-
-	}
-	break;
-	case DataField:
-	{
-		char number_str[128];
-		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, 128);
-
-		std::stringstream ss;
-
-		ss << "Data Field Byte: " << number_str;
-		AddTabularText(ss.str().c_str());
-	}
-	break;
-	case CrcField:
-	{
-		char number_str[128];
-		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 15, number_str, 128);
-
-		std::stringstream ss;
-
-		ss << "CRC value: " << number_str;
-		AddTabularText(ss.str().c_str());
-	}
-	break;
-	case AckField:
-	{
-		if (bool(frame.mData1) == true)
-			AddTabularText("ACK");
-		else
-			AddTabularText("NAK");
-	}
-	break;
-	case CanError:
-	{
-		AddTabularText("Error");
-	}
-	break;
-	}
-}
-
-void CAN_FDAnalyzerResults::GeneratePacketTabularText( U64 packet_id, DisplayBase display_base )
-{
-	ClearResultStrings();
-	AddResultString("not supported");
-
-}
-
-void CAN_FDAnalyzerResults::GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base )
-{
-	ClearResultStrings();
-	AddResultString("not supported");
+#include "CAN_FDAnalyzerResults.h"
+#include <AnalyzerHelpers.h>
+#include "CAN_FDAnalyzer.h"
+#include "CAN_FDAnalyzerSettings.h"
+#include "CAN_FDExportFile.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <cmath>
+#include <cstring>
+#include "CAN_FDIdTable.h"
+
+CAN_FDAnalyzerResults::CAN_FDAnalyzerResults( CAN_FDAnalyzer* analyzer, CAN_FDAnalyzerSettings* settings )
+:	AnalyzerResults(),
+	mSettings( settings ),
+	mAnalyzer( analyzer )
+{
+}
+
+CAN_FDAnalyzerResults::~CAN_FDAnalyzerResults()
+{
+}
+
+/* The control field holds the DLC code as sent, which on CAN-FD is not the number of bytes above 8 */
+static U32 GetDataBytes( Frame& control )
+{
+	static const U8 fd_data_bytes[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+
+	U32 dlc = U32(control.mData1 & 0xF);
+	if (control.HasFlag(FD_FRAME) == true)
+		return fd_data_bytes[dlc];
+
+	return std::min<U32>(dlc, 8);
+}
+
+static U32 GetCrcBits( Frame& crc )
+{
+	if (crc.HasFlag(CRC_21) == true)
+		return 21;
+
+	return (crc.HasFlag(FD_FRAME) == true) ? 17 : 15;
+}
+
+void CAN_FDAnalyzerResults::GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base )
+{
+	//we only need to pay attention to 'channel' if we're making bubbles for more than one channel (as set by AddChannelBubblesWillAppearOn)
+	ClearResultStrings();
+	Frame frame = GetFrame(frame_index);
+
+	/* With several buses decoded together, bubbles only go on the channel of the frame's own bus */
+	if (mSettings->GetBusChannel(U32(frame.mData2)) != channel)
+		return;
+
+	switch (frame.mType)
+	{
+	case IdentifierField:
+	case IdentifierFieldEx:
+	{
+		char number_str[128];
+
+		if (frame.mType == IdentifierField)
+			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
+		else
+			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
+
+		std::stringstream ss;
+
+		AddResultString("Id");
+
+		ss << "Id: " << number_str;
+		AddResultString(ss.str().c_str());
+		ss.str("");
+
+		ss << "Identifier: " << number_str;
+		AddResultString(ss.str().c_str());
+		ss.str("");
+
+		if (frame.HasFlag(REMOTE_FRAME) == false)
+		{
+			if (frame.mType == IdentifierField)
+				ss << "11-bit CAN Identifier: " << number_str;
+			else
+				ss << "29-bit CAN Identifier: " << number_str;
+		}
+		else
+		{
+			if (frame.mType == IdentifierField)
+				ss << "11-bit CAN Identifier: " << number_str << " (RTR)";
+			else
+				ss << "29-bit CAN Identifier: " << number_str << " (RTR)";
+		}
+
+		AddResultString(ss.str().c_str());
+	}
+	break;
+
+	case FDIdentifier:
+	case FDIdentifierEx:
+	{
+		char number_str[128];
+
+		if (frame.mType == FDIdentifier)
+			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
+		else
+			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
+
+		std::stringstream ss;
+
+		AddResultString("Id");
+
+		ss << "FD-Id: " << number_str;
+		AddResultString(ss.str().c_str());
+		ss.str("");
+
+		ss << "FD-Identifier: " << number_str;
+		AddResultString(ss.str().c_str());
+		ss.str("");
+
+		if (frame.HasFlag(REMOTE_FRAME) == false)
+		{
+			if (frame.mType == FDIdentifier)
+				ss << "11-bit CAN-FD Identifier: " << number_str;
+			else
+				ss << "29-bit CAN-FD Identifier: " << number_str;
+		}
+		else
+		{
+			/* Note - remote frames are not used according to the spec */
+			if (frame.mType == FDIdentifier)
+				ss << "11-bit CAN-FD Identifier: " << number_str << " (RTR)";
+			else
+				ss << "29-bit CAN-FD Identifier: " << number_str << " (RTR)";
+		}
+
+		AddResultString(ss.str().c_str());
+	}
+	break;
+
+	case ControlField:
+	{
+		char number_str[128];
+		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 4, number_str, 128);
+
+		std::stringstream ss;
+		AddResultString("Ctrl");
+
+		ss << "Ctrl: " << number_str;
+		AddResultString(ss.str().c_str());
+		ss.str("");
+
+		ss << "Control Field: " << number_str;
+		AddResultString(ss.str().c_str());
+
+		ss << ", " << GetDataBytes(frame) << " bytes";
+		AddResultString(ss.str().c_str());
+	}
+	break;
+
+	case DataField:
+	{
+		char number_str[128];
+		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, 128);
+
+		AddResultString(number_str);
+
+		std::stringstream ss;
+		ss << "Data: " << number_str;
+		AddResultString(ss.str().c_str());
+		ss.str("");
+
+		ss << "Data Field Byte: " << number_str;
+		AddResultString(ss.str().c_str());
+	}
+	break;
+
+	case CrcField:
+	{
+		char number_str[128];
+		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, GetCrcBits(frame), number_str, 128);
+
+		AddResultString("CRC");
+
+		std::stringstream ss;
+		ss << "CRC: " << number_str;
+		AddResultString(ss.str().c_str());
+		ss.str("");
+
+		ss << "CRC value: " << number_str;
+		AddResultString(ss.str().c_str());
+	}
+	break;
+
+	case AckField:
+	{
+		if (bool(frame.mData1) == true)
+			AddResultString("ACK");
+		else
+			AddResultString("NAK");
+	}
+	break;
+
+	case CanError:
+	{
+		AddResultString("E");
+		AddResultString("Error");
+	}
+	break;
+
+	}
+}
+
+void CAN_FDAnalyzerResults::GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id )
+{
+	if (export_type_user_id == ExportStatistics)
+	{
+		GenerateStatisticsExportFile(file, display_base);
+		mAnalyzer->GetTrace().Flush();
+		return;
+	}
+
+	if (export_type_user_id == ExportIsoTp)
+	{
+		GenerateIsoTpExportFile(file, display_base);
+		mAnalyzer->GetTrace().Flush();
+		return;
+	}
+
+	if (export_type_user_id == ExportJ1939)
+	{
+		GenerateJ1939ExportFile(file, display_base);
+		mAnalyzer->GetTrace().Flush();
+		return;
+	}
+
+	if (export_type_user_id == ExportSignals)
+	{
+		GenerateSignalsExportFile(file);
+		mAnalyzer->GetTrace().Flush();
+		return;
+	}
+
+	if (export_type_user_id == ExportChanges)
+	{
+		GenerateChangesExportFile(file, display_base);
+		mAnalyzer->GetTrace().Flush();
+		return;
+	}
+
+	GenerateFramesExportFile(file, display_base);
+	mAnalyzer->GetTrace().Flush();
+}
+
+void CAN_FDAnalyzerResults::GenerateFramesExportFile( const char* file, DisplayBase display_base )
+{
+	CanTrace& trace = mAnalyzer->GetTrace();
+	CanTraceScope trace_scope(trace, "Export frames", U64(0));
+
+	std::stringstream ss;
+	CAN_FDExportFile f;
+	f.Start(file, mSettings->mCompressExport);
+
+	std::chrono::steady_clock::time_point block_start = std::chrono::steady_clock::now();
+	U64 block_first_sample = 0;
+
+	U64 trigger_sample = mAnalyzer->GetTriggerSample();
+	U32 sample_rate = mAnalyzer->GetSampleRate();
+
+	bool multi_bus = mSettings->IsMultiBus();
+
+	if (multi_bus == true)
+		ss << "Time [s],Bus,Packet,Type,Identifier,Control,Data,CRC,ACK" << std::endl;
+	else
+		ss << "Time [s],Packet,Type,Identifier,Control,Data,CRC,ACK" << std::endl;
+
+	std::vector<U64> packets;
+	bool filtered;
+	U64 first_row;
+	U64 end_row;
+	GetExportRows(packets, filtered, first_row, end_row, trigger_sample, sample_rate);
+
+	U64 num_frames = GetNumFrames();
+	U64 num_rows = end_row - first_row;
+	for (U64 i = 0; i < num_rows; i++)
+	{
+		U64 packet_id = (filtered == true) ? packets[first_row + i] : (first_row + i);
+
+		U64 first_frame_id;
+		U64 last_frame_id;
+		GetFramesContainedInPacket(packet_id, &first_frame_id, &last_frame_id);
+
+		if ((i % TRACE_EXPORT_BLOCK_PACKETS) == 0)
+		{
+			U64 first_sample = GetFrame(first_frame_id).mStartingSampleInclusive;
+			if (i != 0)
+				trace.AddEvent("Export block", block_start, block_first_sample, first_sample);
+
+			block_start = std::chrono::steady_clock::now();
+			block_first_sample = first_sample;
+		}
+
+		AppendPacketRow(ss, packet_id, first_frame_id, last_frame_id, display_base, trigger_sample, sample_rate, multi_bus);
+		ss << std::endl;
+
+		f.Append(ss);
+
+		if (UpdateExportProgressAndCheckForCancel(i, num_rows) == true)
+		{
+			f.End();
+			return;
+		}
+	}
+
+	/* Nothing but the header if there are no packets */
+	f.Append(ss);
+
+	if (num_frames > 0)
+	{
+		U64 last_sample = GetFrame(num_frames - 1).mEndingSampleInclusive;
+		trace.AddEvent("Export block", block_start, block_first_sample, last_sample);
+		trace_scope.SetLastSample(last_sample);
+	}
+
+	UpdateExportProgressAndCheckForCancel(num_rows, num_rows);
+	f.End();
+}
+
+void CAN_FDAnalyzerResults::GetExportRows( std::vector<U64>& packets, bool& filtered, U64& first_row, U64& end_row, U64 trigger_sample, U32 sample_rate )
+{
+	/* Limited to some identifiers, only the packets the identifier index lists for them are visited. Row */
+	/* i is then packets[first_row + i], otherwise packet first_row + i. */
+	CanIdFilter filter;
+	filter.Parse(mSettings->mExportIdentifiers);
+
+	packets.clear();
+	filtered = (filter.IsEmpty() == false);
+	if (filtered == true)
+		mAnalyzer->GetIdIndex().GetPackets(filter, packets);
+
+	/* Limited to a time window, the packets at its ends are found by binary search */
+	U64 first_packet;
+	U64 end_packet;
+	GetExportWindow(first_packet, end_packet, trigger_sample, sample_rate);
+
+	first_row = first_packet;
+	end_row = end_packet;
+	if (filtered == true)
+	{
+		first_row = std::lower_bound(packets.begin(), packets.end(), first_packet) - packets.begin();
+		end_row = std::lower_bound(packets.begin(), packets.end(), end_packet) - packets.begin();
+	}
+}
+
+void CAN_FDAnalyzerResults::GetExportWindow( U64& first_packet, U64& end_packet, U64 trigger_sample, U32 sample_rate )
+{
+	first_packet = 0;
+	end_packet = GetNumPackets();
+
+	bool has_from;
+	bool has_to;
+	double from;
+	double to;
+	CAN_FDAnalyzerSettings::ParseWindowTime(mSettings->mExportFrom, has_from, from);
+	CAN_FDAnalyzerSettings::ParseWindowTime(mSettings->mExportTo, has_to, to);
+
+	if (has_from == true)
+		first_packet = FindFirstPacketFrom(GetExportSample(from, trigger_sample, sample_rate), first_packet, end_packet);
+
+	/* Up to and including packets starting on the last sample of the window */
+	if (has_to == true)
+	{
+		S64 to_sample = GetExportSample(to, trigger_sample, sample_rate);
+		end_packet = FindFirstPacketFrom(to_sample + 1, first_packet, end_packet);
+	}
+}
+
+S64 CAN_FDAnalyzerResults::GetExportSample( double seconds, U64 trigger_sample, U32 sample_rate )
+{
+	return S64(trigger_sample) + S64(floor(seconds * double(sample_rate) + 0.5));
+}
+
+U64 CAN_FDAnalyzerResults::FindFirstPacketFrom( S64 sample, U64 first_packet, U64 end_packet )
+{
+	/* Packets are committed in the order they start in, so their start samples are sorted */
+	while (first_packet < end_packet)
+	{
+		U64 middle = first_packet + ((end_packet - first_packet) / 2);
+
+		U64 first_frame_id;
+		U64 last_frame_id;
+		GetFramesContainedInPacket(middle, &first_frame_id, &last_frame_id);
+
+		if (S64(GetFrame(first_frame_id).mStartingSampleInclusive) < sample)
+			first_packet = middle + 1;
+		else
+			end_packet = middle;
+	}
+	return first_packet;
+}
+
+void CAN_FDAnalyzerResults::AppendPacketRow( std::stringstream& ss, U64 packet_id, U64 first_frame_id, U64 last_frame_id, DisplayBase display_base, U64 trigger_sample, U32 sample_rate, bool multi_bus )
+{
+	Frame frame = GetFrame(first_frame_id);
+
+	//static void GetTimeString( U64 sample, U64 trigger_sample, U32 sample_rate_hz, char* result_string, U32 result_string_max_length );
+	char time_str[128];
+	AnalyzerHelpers::GetTimeString(frame.mStartingSampleInclusive, trigger_sample, sample_rate, time_str, 128);
+
+	char packet_str[128];
+	AnalyzerHelpers::GetNumberString(packet_id, Decimal, 0, packet_str, 128);
+
+	ss << time_str;
+	if (multi_bus == true)
+		ss << "," << frame.mData2;
+
+	if (frame.HasFlag(REMOTE_FRAME) == false)
+		ss << "," << packet_str << ",DATA";
+	else
+		ss << "," << packet_str << ",REMOTE";
+
+	U64 frame_id = first_frame_id;
+
+	char number_str[128];
+
+	if ((frame.mType == IdentifierField) || (frame.mType == FDIdentifier))
+	{
+		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
+		ss << "," << number_str;
+		++frame_id;
+	}
+	else if ((frame.mType == IdentifierFieldEx) || (frame.mType == FDIdentifierEx))
+	{
+		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
+		ss << "," << number_str;
+		++frame_id;
+	}
+	else
+	{
+		ss << ",";
+	}
+
+	if (frame_id > last_frame_id)
+		return;
+
+	Frame control = GetFrame(frame_id);
+	if (control.mType == ControlField)
+	{
+		AnalyzerHelpers::GetNumberString(control.mData1, display_base, 4, number_str, 128);
+		ss << "," << number_str;
+		++frame_id;
+	}
+	else
+	{
+		ss << ",";
+	}
+	ss << ",";
+	if (frame_id > last_frame_id)
+		return;
+
+	for (; ; )
+	{
+		Frame data = GetFrame(frame_id);
+		if (data.mType != DataField)
+			break;
+
+		AnalyzerHelpers::GetNumberString(data.mData1, display_base, 8, number_str, 128);
+		ss << number_str;
+		if (frame_id == last_frame_id)
+			break;
+
+		++frame_id;
+		if (GetFrame(frame_id).mType == DataField)
+			ss << " ";
+	}
+
+	if (frame_id > last_frame_id)
+		return;
+
+	Frame crc = GetFrame(frame_id);
+	if (crc.mType == CrcField)
+	{
+		AnalyzerHelpers::GetNumberString(crc.mData1, display_base, GetCrcBits(crc), number_str, 128);
+		ss << "," << number_str;
+		++frame_id;
+	}
+	else
+	{
+		ss << ",";
+	}
+	if (frame_id > last_frame_id)
+		return;
+
+	Frame ack = GetFrame(frame_id);
+	if (ack.mType == AckField)
+	{
+		if (bool(ack.mData1) == true)
+			ss << "," << "ACK";
+		else
+			ss << "," << "NAK";
+	}
+	else
+	{
+		ss << ",";
+	}
+}
+
+void CAN_FDAnalyzerResults::GenerateStatisticsExportFile( const char* file, DisplayBase display_base )
+{
+	/* Everything here was accumulated while decoding, so the export is proportional to the number of */
+	/* time bins and identifiers rather than the number of frames */
+	CanTraceScope trace_scope(mAnalyzer->GetTrace(), "Export statistics", U64(0));
+
+	CAN_FDExportFile f;
+	f.Start(file, mSettings->mCompressExport);
+
+	for (U32 bus = 0; bus < CAN_FD_MAX_BUSES; bus++)
+	{
+		if (mSettings->IsBusEnabled(bus) == false)
+			continue;
+
+		if (mSettings->IsMultiBus() == true)
+		{
+			std::stringstream ss;
+			if (bus != 0)
+				ss << std::endl;
+			ss << "Bus," << bus << std::endl;
+			f.Append(ss);
+		}
+
+		if (AppendBusStatistics(f, bus, display_base) == false)
+			break;
+	}
+
+	f.End();
+}
+
+void CAN_FDAnalyzerResults::GenerateIsoTpExportFile( const char* file, DisplayBase display_base )
+{
+	/* The transfers were reassembled while decoding, so this only formats them */
+	CanTraceScope trace_scope(mAnalyzer->GetTrace(), "Export ISO-TP", U64(0));
+
+	CAN_FDIsoTp& iso_tp = mAnalyzer->GetIsoTp();
+	std::vector<U32> order;
+	iso_tp.GetStartOrder(order);
+
+	U64 trigger_sample = mAnalyzer->GetTriggerSample();
+	U32 sample_rate = mAnalyzer->GetSampleRate();
+	bool multi_bus = mSettings->IsMultiBus();
+
+	CAN_FDExportFile f;
+	f.Start(file, mSettings->mCompressExport);
+
+	std::stringstream ss;
+	if (multi_bus == true)
+		ss << "Time [s],Bus,Transaction,Identifier,Flow control identifier,Length,Frames,Status,Data" << std::endl;
+	else
+		ss << "Time [s],Transaction,Identifier,Flow control identifier,Length,Frames,Status,Data" << std::endl;
+
+	CanIsoTpMessage message;
+	for (U32 i = 0; i < order.size(); i++)
+	{
+		if (iso_tp.GetMessage(order[i], message) == false)
+			continue;
+
+		char time_str[128];
+		AnalyzerHelpers::GetTimeString(message.mStartingSample, trigger_sample, sample_rate, time_str, 128);
+
+		char number_str[128];
+		ss << time_str;
+		if (multi_bus == true)
+			ss << "," << message.mBus;
+		ss << "," << message.mTransactionId;
+
+		AnalyzerHelpers::GetNumberString(message.mIdentifier, display_base, message.mExtended ? 32 : 12, number_str, 128);
+		ss << "," << number_str << ",";
+
+		if (message.mHasFlowControl == true)
+		{
+			AnalyzerHelpers::GetNumberString(message.mFlowControlIdentifier, display_base, message.mExtended ? 32 : 12, number_str, 128);
+			ss << number_str;
+		}
+
+		ss << "," << message.mLength << "," << (message.mFrames + message.mFlowControlFrames) << "," << CAN_FDIsoTp::GetStatusString(message.mStatus) << ",";
+
+		for (U32 b = 0; b < message.mData.size(); b++)
+		{
+			AnalyzerHelpers::GetNumberString(message.mData[b], display_base, 8, number_str, 128);
+			if (b != 0)
+				ss << " ";
+			ss << number_str;
+		}
+		ss << std::endl;
+
+		f.Append(ss);
+
+		if (UpdateExportProgressAndCheckForCancel(i, order.size()) == true)
+		{
+			f.End();
+			return;
+		}
+	}
+
+	f.Append(ss);
+	UpdateExportProgressAndCheckForCancel(order.size(), order.size());
+	f.End();
+}
+
+void CAN_FDAnalyzerResults::GenerateJ1939ExportFile( const char* file, DisplayBase display_base )
+{
+	/* Parameter groups in time order, then the per-PGN summary of each bus */
+	CanTraceScope trace_scope(mAnalyzer->GetTrace(), "Export J1939", U64(0));
+
+	CAN_FDJ1939& j1939 = mAnalyzer->GetJ1939();
+	std::vector<U32> order;
+	j1939.GetStartOrder(order);
+
+	U64 trigger_sample = mAnalyzer->GetTriggerSample();
+	U32 sample_rate = mAnalyzer->GetSampleRate();
+	bool multi_bus = mSettings->IsMultiBus();
+
+	CAN_FDExportFile f;
+	f.Start(file, mSettings->mCompressExport);
+
+	std::stringstream ss;
+	if (multi_bus == true)
+		ss << "Time [s],Bus,Priority,PGN,Source,Destination,Transport,Length,Status,Data" << std::endl;
+	else
+		ss << "Time [s],Priority,PGN,Source,Destination,Transport,Length,Status,Data" << std::endl;
+
+	CanJ1939Record record;
+	std::vector<U8> data;
+	for (U32 i = 0; i < order.size(); i++)
+	{
+		if (j1939.GetRecord(order[i], record, data) == false)
+			continue;
+
+		char time_str[128];
+		AnalyzerHelpers::GetTimeString(record.mStartingSample, trigger_sample, sample_rate, time_str, 128);
+
+		char number_str[128];
+		ss << time_str;
+		if (multi_bus == true)
+			ss << "," << record.mBus;
+		ss << "," << U32(record.mPriority);
+
+		AnalyzerHelpers::GetNumberString(record.mPgn, display_base, 18, number_str, 128);
+		ss << "," << number_str;
+		AnalyzerHelpers::GetNumberString(record.mSourceAddress, display_base, 8, number_str, 128);
+		ss << "," << number_str;
+		AnalyzerHelpers::GetNumberString(record.mDestinationAddress, display_base, 8, number_str, 128);
+		ss << "," << number_str;
+
+		ss << "," << CAN_FDJ1939::GetTransportString(record.mTransport) << "," << record.mLength << "," << CAN_FDJ1939::GetStatusString(record.mStatus) << ",";
+
+		for (U32 b = 0; b < data.size(); b++)
+		{
+			AnalyzerHelpers::GetNumberString(data[b], display_base, 8, number_str, 128);
+			if (b != 0)
+				ss << " ";
+			ss << number_str;
+		}
+		ss << std::endl;
+
+		f.Append(ss);
+
+		if (UpdateExportProgressAndCheckForCancel(i, order.size()) == true)
+		{
+			f.End();
+			return;
+		}
+	}
+
+	for (U32 bus = 0; bus < CAN_FD_MAX_BUSES; bus++)
+	{
+		if (mSettings->IsBusEnabled(bus) == false)
+			continue;
+
+		AppendPgnStatistics(f, bus, display_base);
+	}
+
+	UpdateExportProgressAndCheckForCancel(order.size(), order.size());
+	f.End();
+}
+
+void CAN_FDAnalyzerResults::GenerateSignalsExportFile( const char* file )
+{
+	/* One row per signal value. Multiplexed signals the frame doesn't carry are left out. */
+	CanTraceScope trace_scope(mAnalyzer->GetTrace(), "Export signals", U64(0));
+
+	CAN_FDDbc& dbc = mAnalyzer->GetDbc();
+	std::vector<CanDbcMessage> messages;
+	dbc.GetMessages(messages);
+	U32 num_records = dbc.GetNumRecords();
+
+	U64 trigger_sample = mAnalyzer->GetTriggerSample();
+	U32 sample_rate = mAnalyzer->GetSampleRate();
+	bool multi_bus = mSettings->IsMultiBus();
+
+	CAN_FDExportFile f;
+	f.Start(file, mSettings->mCompressExport);
+
+	std::stringstream ss;
+	ss.precision(12);
+
+	std::string dbc_error = dbc.GetError();
+	if (dbc_error.empty() == false)
+	{
+		ss << "DBC file not loaded: " << dbc_error << std::endl;
+		f.Append(ss);
+		UpdateExportProgressAndCheckForCancel(0, 0);
+		f.End();
+		return;
+	}
+
+	if (multi_bus == true)
+		ss << "Time [s],Bus,Message,Signal,Value,Unit" << std::endl;
+	else
+		ss << "Time [s],Message,Signal,Value,Unit" << std::endl;
+
+	CanDbcRecord record;
+	std::vector<double> values;
+	for (U32 i = 0; i < num_records; i++)
+	{
+		/* Decoded with other definitions if the file was loaded again since the messages were copied */
+		if ((dbc.GetRecord(i, record, values) == false) || (record.mMessage >= messages.size()) ||
+			(values.size() != messages[record.mMessage].mSignals.size()))
+			continue;
+
+		char time_str[128];
+		AnalyzerHelpers::GetTimeString(record.mStartingSample, trigger_sample, sample_rate, time_str, 128);
+
+		const CanDbcMessage& message = messages[record.mMessage];
+		for (U32 v = 0; v < values.size(); v++)
+		{
+			if (std::isnan(values[v]) == true)
+				continue;
+
+			const CanDbcSignal& signal = message.mSignals[v];
+			ss << time_str;
+			if (multi_bus == true)
+				ss << "," << record.mBus;
+			ss << "," << message.mName << "," << signal.mName << "," << values[v] << "," << signal.mUnit << std::endl;
+		}
+
+		f.Append(ss);
+
+		if (UpdateExportProgressAndCheckForCancel(i, num_records) == true)
+		{
+			f.End();
+			return;
+		}
+	}
+
+	UpdateExportProgressAndCheckForCancel(num_records, num_records);
+	f.End();
+}
+
+/* What the changes export keeps of the last frame seen with each identifier */
+class CanChangesState
+{
+public:
+	CanChangesState()
+	:	mLastSample( 0 ),
+		mPeriod( 0 ),
+		mUnchanged( 0 ),
+		mDlc( 0 ),
+		mNumDataBytes( 0 )
+	{
+	}
+
+	U64 mLastSample;
+	U64 mPeriod;		/* smoothed interval between frames, 0 until there have been two */
+	U64 mUnchanged;		/* frames left out since the last row */
+	U32 mDlc;
+	U32 mNumDataBytes;
+	U8 mData[CAN_FD_MAX_DATA_BYTES];
+};
+
+void CAN_FDAnalyzerResults::GenerateChangesExportFile( const char* file, DisplayBase display_base )
+{
+	/* One row for the first frame with each identifier, then only for frames whose payload differs from */
+	/* the one before or that come after a gap. The rows are limited like the frames export. */
+	CanTraceScope trace_scope(mAnalyzer->GetTrace(), "Export changes", U64(0));
+
+	U64 trigger_sample = mAnalyzer->GetTriggerSample();
+	U32 sample_rate = mAnalyzer->GetSampleRate();
+	bool multi_bus = mSettings->IsMultiBus();
+
+	CAN_FDExportFile f;
+	f.Start(file, mSettings->mCompressExport);
+
+	std::stringstream ss;
+	if (multi_bus == true)
+		ss << "Time [s],Bus,Packet,Identifier,Change,Unchanged,Control,Data" << std::endl;
+	else
+		ss << "Time [s],Packet,Identifier,Change,Unchanged,Control,Data" << std::endl;
+
+	std::vector<U64> packets;
+	bool filtered;
+	U64 first_row;
+	U64 end_row;
+	GetExportRows(packets, filtered, first_row, end_row, trigger_sample, sample_rate);
+
+	CanIdTable<CanChangesState> states[CAN_FD_MAX_BUSES];
+	U8 data[CAN_FD_MAX_DATA_BYTES];
+
+	U64 num_rows = end_row - first_row;
+	for (U64 i = 0; i < num_rows; i++)
+	{
+		/* Most packets don't make a row, so progress is checked for each one */
+		if (UpdateExportProgressAndCheckForCancel(i, num_rows) == true)
+		{
+			f.End();
+			return;
+		}
+
+		U64 packet_id = (filtered == true) ? packets[first_row + i] : (first_row + i);
+
+		U64 first_frame_id;
+		U64 last_frame_id;
+		GetFramesContainedInPacket(packet_id, &first_frame_id, &last_frame_id);
+
+		/* Remote frames and frames with errors have no payload to compare */
+		Frame id_frame = GetFrame(first_frame_id);
+		bool extended = ((id_frame.mType == IdentifierFieldEx) || (id_frame.mType == FDIdentifierEx));
+		bool valid = (extended == true) || (id_frame.mType == IdentifierField) || (id_frame.mType == FDIdentifier);
+		if (id_frame.HasFlag(REMOTE_FRAME) == true)
+			valid = false;
+
+		U32 dlc = 0;
+		U32 num_data_bytes = 0;
+		for (U64 frame_id = first_frame_id + 1; (frame_id <= last_frame_id) && (valid == true); frame_id++)
+		{
+			Frame frame = GetFrame(frame_id);
+			if (frame.mType == ControlField)
+				dlc = U32(frame.mData1);
+			else if ((frame.mType == DataField) && (num_data_bytes < CAN_FD_MAX_DATA_BYTES))
+				data[num_data_bytes++] = U8(frame.mData1);
+			else if (frame.mType == CanError)
+				valid = false;
+		}
+
+		if (valid == false)
+			continue;
+
+		U32 bus = U32(id_frame.mData2);
+		U32 identifier = U32(id_frame.mData1);
+		U64 sample = id_frame.mStartingSampleInclusive;
+
+		CanChangesState* state = states[bus].Find(identifier, extended);
+		const char* change;
+		if (state == NULL)
+		{
+			state = &states[bus].Get(identifier, extended);
+			change = "NEW";
+		}
+		else
+		{
+			U64 interval = sample - state->mLastSample;
+			bool gap = (state->mPeriod > 0) && (interval > (state->mPeriod * CHANGES_EXPORT_GAP_PERIODS));
+
+			bool changed = (dlc != state->mDlc) || (num_data_bytes != state->mNumDataBytes) || (memcmp(data, state->mData, num_data_bytes) != 0);
+
+			/* The period follows the usual interval, missing frames are left out of it */
+			if (state->mPeriod == 0)
+				state->mPeriod = interval;
+			else if (gap == false)
+				state->mPeriod = state->mPeriod - (state->mPeriod / 8) + (interval / 8);
+
+			if ((changed == true) && (gap == true))
+				change = "DATA GAP";
+			else if (changed == true)
+				change = "DATA";
+			else if (gap == true)
+				change = "GAP";
+			else
+				change = NULL;
+		}
+
+		state->mLastSample = sample;
+
+		if (change == NULL)
+		{
+			state->mUnchanged++;
+			continue;
+		}
+
+		char time_str[128];
+		AnalyzerHelpers::GetTimeString(sample, trigger_sample, sample_rate, time_str, 128);
+
+		char number_str[128];
+		ss << time_str;
+		if (multi_bus == true)
+			ss << "," << bus;
+
+		AnalyzerHelpers::GetNumberString(packet_id, Decimal, 0, number_str, 128);
+		ss << "," << number_str;
+		AnalyzerHelpers::GetNumberString(identifier, display_base, (extended == true) ? 32 : 12, number_str, 128);
+		ss << "," << number_str;
+		ss << "," << change << "," << state->mUnchanged;
+
+		AnalyzerHelpers::GetNumberString(dlc, display_base, 4, number_str, 128);
+		ss << "," << number_str << ",";
+
+		for (U32 b = 0; b < num_data_bytes; b++)
+		{
+			AnalyzerHelpers::GetNumberString(data[b], display_base, 8, number_str, 128);
+			if (b != 0)
+				ss << " ";
+			ss << number_str;
+		}
+		ss << std::endl;
+
+		f.Append(ss);
+
+		state->mUnchanged = 0;
+		state->mDlc = dlc;
+		state->mNumDataBytes = num_data_bytes;
+		memcpy(state->mData, data, num_data_bytes);
+	}
+
+	f.Append(ss);
+	UpdateExportProgressAndCheckForCancel(num_rows, num_rows);
+	f.End();
+}
+
+void CAN_FDAnalyzerResults::AppendPgnStatistics( CAN_FDExportFile& f, U32 bus, DisplayBase display_base )
+{
+	std::vector<CanPgnStatisticsRow> rows;
+	mAnalyzer->GetJ1939().GetPgnStatistics(bus, rows);
+
+	double sample_rate = double(mAnalyzer->GetSampleRate());
+
+	std::stringstream ss;
+	ss << std::endl;
+	if (mSettings->IsMultiBus() == true)
+		ss << "Bus," << bus << std::endl;
+	ss << "PGN,Messages,Transport messages,Bytes,Sources,Rate [1/s]" << std::endl;
+
+	for (U32 i = 0; i < rows.size(); i++)
+	{
+		CanPgnStatistics& statistics = rows[i].mStatistics;
+
+		U32 sources = 0;
+		for (U32 w = 0; w < 8; w++)
+		{
+			for (U32 bits = statistics.mSources[w]; bits != 0; bits &= bits - 1)
+				sources++;
+		}
+
+		char number_str[128];
+		AnalyzerHelpers::GetNumberString(rows[i].mPgn, display_base, 18, number_str, 128);
+
+		ss << number_str << "," << statistics.mMessages << "," << statistics.mTransportMessages << "," << statistics.mBytes << "," << sources << ",";
+		if (statistics.mLastSample > statistics.mFirstSample)
+			ss << (double(statistics.mMessages - 1) * sample_rate / double(statistics.mLastSample - statistics.mFirstSample));
+		ss << std::endl;
+
+		f.Append(ss);
+	}
+
+	f.Append(ss);
+}
+
+bool CAN_FDAnalyzerResults::AppendBusStatistics( CAN_FDExportFile& f, U32 bus, DisplayBase display_base )
+{
+	CAN_FDBusStatistics& statistics = mAnalyzer->GetBusStatistics(bus);
+
+	std::vector<CanLoadBin> bins;
+	std::vector<CanIdStatisticsRow> identifiers;
+	statistics.GetSnapshot(bins, identifiers);
+
+	double sample_rate = double(statistics.GetSampleRate());
+	U64 bin_samples = statistics.GetBinSamples();
+	U64 trigger_sample = mAnalyzer->GetTriggerSample();
+
+	std::stringstream ss;
+
+	U64 total_frames = 0;
+	U64 total_errors = 0;
+	U64 total_busy = 0;
+	for (U32 i = 0; i < bins.size(); i++)
+	{
+		total_frames += bins[i].mFrames;
+		total_errors += bins[i].mErrors;
+		total_busy += bins[i].mBusySamples;
+	}
+
+	double total_time = double(bins.size() * bin_samples) / sample_rate;
+
+	ss << "Frames," << total_frames << std::endl;
+	ss << "Errors," << total_errors << std::endl;
+	if (bins.empty() == false)
+		ss << "Bus load [%]," << (100.0 * double(total_busy) / double(bins.size() * bin_samples)) << std::endl;
+	ss << std::endl;
+
+	ss << "Time [s],Frames,Errors,Bus load [%]" << std::endl;
+	for (U32 i = 0; i < bins.size(); i++)
+	{
+		char time_str[128];
+		AnalyzerHelpers::GetTimeString(i * bin_samples, trigger_sample, statistics.GetSampleRate(), time_str, 128);
+
+		ss << time_str << "," << bins[i].mFrames << "," << bins[i].mErrors << "," << (100.0 * double(bins[i].mBusySamples) / double(bin_samples)) << std::endl;
+
+		f.Append(ss);
+
+		if (UpdateExportProgressAndCheckForCancel(i, bins.size() + identifiers.size()) == true)
+			return false;
+	}
+	ss << std::endl;
+
+	ss << "Identifier,Format,Frames,Rate [1/s],Mean period [s],Jitter [s],Min period [s],Max period [s]" << std::endl;
+	for (U32 i = 0; i < identifiers.size(); i++)
+	{
+		CanIdStatistics& id = identifiers[i].mStatistics;
+
+		char number_str[128];
+		AnalyzerHelpers::GetNumberString(identifiers[i].mIdentifier, display_base, identifiers[i].mExtended ? 32 : 12, number_str, 128);
+
+		ss << number_str << "," << (identifiers[i].mExtended ? "29-bit" : "11-bit") << "," << id.mFrames;
+
+		if (total_time > 0.0)
+			ss << "," << (double(id.mFrames) / total_time);
+		else
+			ss << ",";
+
+		if (id.mPeriods > 0)
+		{
+			double jitter = 0.0;
+			if (id.mPeriods > 1)
+				jitter = sqrt(id.mPeriodM2 / double(id.mPeriods - 1));
+
+			ss << "," << (id.mPeriodMean / sample_rate) << "," << (jitter / sample_rate);
+			ss << "," << (double(id.mMinPeriod) / sample_rate) << "," << (double(id.mMaxPeriod) / sample_rate);
+		}
+		else
+		{
+			ss << ",,,,";
+		}
+		ss << std::endl;
+
+		f.Append(ss);
+	}
+
+	UpdateExportProgressAndCheckForCancel(bins.size() + identifiers.size(), bins.size() + identifiers.size());
+	return true;
+}
+
+void CAN_FDAnalyzerResults::GenerateFrameTabularText( U64 frame_index, DisplayBase display_base )
+{
+	ClearTabularText();
+
+	Frame frame = GetFrame(frame_index);
+
+	switch (frame.mType)
+	{
+	case IdentifierField:
+	case IdentifierFieldEx:
+	{
+		char number_str[128];
+
+		if (frame.mType == IdentifierField)
+			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
+		else
+			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
+
+		std::stringstream ss;
+		AppendBusPrefix(ss, frame);
+
+		if (frame.HasFlag(REMOTE_FRAME) == false)
+		{
+			if (frame.mType == IdentifierField)
+				ss << "Standard CAN Identifier: " << number_str;
+			else
+				ss << "Extended CAN Identifier: " << number_str;
+		}
+		else
+		{
+			if (frame.mType == IdentifierField)
+				ss << "Standard CAN Identifier: " << number_str << " (RTR)";
+			else
+				ss << "Extended CAN Identifier: " << number_str << " (RTR)";
+		}
+
+		AddTabularText(ss.str().c_str());
+	}
+	break;
+
+	case FDIdentifier:
+	case FDIdentifierEx:
+	{
+		char number_str[128];
+
+		if (frame.mType == FDIdentifier)
+			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 12, number_str, 128);
+		else
+			AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 32, number_str, 128);
+
+		std::stringstream ss;
+		AppendBusPrefix(ss, frame);
+
+		if (frame.HasFlag(REMOTE_FRAME) == false)
+		{
+			if (frame.mType == FDIdentifier)
+				ss << "11-bit FD-CAN Identifier: " << number_str;
+			else
+				ss << "29-bit FD-CAN Identifier: " << number_str;
+		}
+		else
+		{
+			if (frame.mType == FDIdentifier)
+				ss << "11-bit FD-CAN Identifier: " << number_str << " (RTR)";
+			else
+				ss << "29-bit FD-CAN Identifier: " << number_str << " (RTR)";
+		}
+
+		AddTabularText(ss.str().c_str());
+	}
+	break;
+
+	case ControlField:
+	{
+		char number_str[128];
+		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 4, number_str, 128);
+
+		std::stringstream ss;
+
+		ss << "Control Field: " << number_str;
+		ss << ", " << GetDataBytes(frame) << " bytes";
+		AddTabularText(ss.str().c_str());
+
+	}
+	break;
+	case DataField:
+	{
+		char number_str[128];
+		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, 8, number_str, 128);
+
+		std::stringstream ss;
+
+		ss << "Data Field Byte: " << number_str;
+		AddTabularText(ss.str().c_str());
+	}
+	break;
+	case CrcField:
+	{
+		char number_str[128];
+		AnalyzerHelpers::GetNumberString(frame.mData1, display_base, GetCrcBits(frame), number_str, 128);
+
+		std::stringstream ss;
+
+		ss << "CRC value: " << number_str;
+		AddTabularText(ss.str().c_str());
+	}
+	break;
+	case AckField:
+	{
+		if (bool(frame.mData1) == true)
+			AddTabularText("ACK");
+		else
+			AddTabularText("NAK");
+	}
+	break;
+	case CanError:
+	{
+		std::stringstream ss;
+		AppendBusPrefix(ss, frame);
+		ss << "Error";
+		AddTabularText(ss.str().c_str());
+	}
+	break;
+	}
+}
+
+void CAN_FDAnalyzerResults::AppendBusPrefix( std::stringstream& ss, Frame& frame )
+{
+	if (mSettings->IsMultiBus() == true)
+		ss << "Bus " << frame.mData2 << " ";
+}
+
+void CAN_FDAnalyzerResults::GeneratePacketTabularText( U64 /*packet_id*/, DisplayBase /*display_base*/ )
+{
+	ClearResultStrings();
+	AddResultString("not supported");
+
+}
+
+void CAN_FDAnalyzerResults::GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base )
+{
+	ClearResultStrings();
+
+	/* Transactions are the ISO-TP transfers */
+	CanIsoTpMessage message;
+	if (mAnalyzer->GetIsoTp().GetMessageByTransaction(transaction_id, message) == false)
+	{
+		AddResultString("ISO-TP transfer in progress");
+		return;
+	}
+
+	char number_str[128];
+	AnalyzerHelpers::GetNumberString(message.mIdentifier, display_base, message.mExtended ? 32 : 12, number_str, 128);
+
+	std::stringstream ss;
+	if (mSettings->IsMultiBus() == true)
+		ss << "Bus " << message.mBus << " ";
+	ss << "ISO-TP " << number_str << " " << message.mLength << " bytes";
+	if (message.mStatus != IsoTpComplete)
+		ss << " (" << CAN_FDIsoTp::GetStatusString(message.mStatus) << ")";
+
+	for (U32 b = 0; (b < message.mData.size()) && (b < ISO_TP_TABULAR_BYTES); b++)
+	{
+		AnalyzerHelpers::GetNumberString(message.mData[b], display_base, 8, number_str, 128);
+		ss << ((b == 0) ? ": " : " ") << number_str;
+	}
+	if (message.mData.size() > ISO_TP_TABULAR_BYTES)
+		ss << " ...";
+
+	AddResultString(ss.str().c_str());
 }
\ No newline at end of file
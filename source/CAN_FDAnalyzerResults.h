@@ -1,32 +1,63 @@
-#ifndef CAN_FD_ANALYZER_RESULTS
-#define CAN_FD_ANALYZER_RESULTS
-
-#include <AnalyzerResults.h>
-
-enum CanFrameType { IdentifierField, IdentifierFieldEx, FDIdentifier, FDIdentifierEx, ControlField, DataField, CrcField, AckField, CanError };
-#define REMOTE_FRAME ( 1 << 0 )
-
-class CAN_FDAnalyzer;
-class CAN_FDAnalyzerSettings;
-
-class CAN_FDAnalyzerResults : public AnalyzerResults
-{
-public:
-	CAN_FDAnalyzerResults( CAN_FDAnalyzer* analyzer, CAN_FDAnalyzerSettings* settings );
-	virtual ~CAN_FDAnalyzerResults();
-
-	virtual void GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base );
-	virtual void GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id );
-
-	virtual void GenerateFrameTabularText(U64 frame_index, DisplayBase display_base );
-	virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base );
-	virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base );
-
-protected: //functions
-
-protected:  //vars
-	CAN_FDAnalyzerSettings* mSettings;
-	CAN_FDAnalyzer* mAnalyzer;
-};
-
-#endif //CAN_FD_ANALYZER_RESULTS
+#ifndef CAN_FD_ANALYZER_RESULTS
+#define CAN_FD_ANALYZER_RESULTS
+
+#include <AnalyzerResults.h>
+#include <sstream>
+#include <vector>
+
+enum CanFrameType { IdentifierField, IdentifierFieldEx, FDIdentifier, FDIdentifierEx, ControlField, DataField, CrcField, AckField, CanError };
+#define REMOTE_FRAME ( 1 << 0 )
+#define FD_FRAME ( 1 << 1 )		/* on the control and CRC fields of a CAN-FD frame */
+#define CRC_21 ( 1 << 2 )		/* on the CRC field of a CAN-FD frame with more than 16 data bytes */
+
+enum CanExportType { ExportFrames, ExportStatistics, ExportIsoTp, ExportJ1939, ExportSignals, ExportChanges };
+
+/* Exports are traced in blocks of this many packets */
+#define TRACE_EXPORT_BLOCK_PACKETS 1024
+
+/* Payload bytes shown for an ISO-TP transfer in the tabular view, the export has all of them */
+#define ISO_TP_TABULAR_BYTES 32
+
+/* The changes export also writes a frame that comes more than this many of its identifier's usual */
+/* periods after the one before, as frames are missing in between */
+#define CHANGES_EXPORT_GAP_PERIODS 2
+
+class CAN_FDAnalyzer;
+class CAN_FDAnalyzerSettings;
+class CAN_FDExportFile;
+
+class CAN_FDAnalyzerResults : public AnalyzerResults
+{
+public:
+	CAN_FDAnalyzerResults( CAN_FDAnalyzer* analyzer, CAN_FDAnalyzerSettings* settings );
+	virtual ~CAN_FDAnalyzerResults();
+
+	virtual void GenerateBubbleText( U64 frame_index, Channel& channel, DisplayBase display_base );
+	virtual void GenerateExportFile( const char* file, DisplayBase display_base, U32 export_type_user_id );
+
+	virtual void GenerateFrameTabularText(U64 frame_index, DisplayBase display_base );
+	virtual void GeneratePacketTabularText( U64 packet_id, DisplayBase display_base );
+	virtual void GenerateTransactionTabularText( U64 transaction_id, DisplayBase display_base );
+
+protected: //functions
+	void GenerateFramesExportFile( const char* file, DisplayBase display_base );
+	void GetExportRows( std::vector<U64>& packets, bool& filtered, U64& first_row, U64& end_row, U64 trigger_sample, U32 sample_rate );
+	void GetExportWindow( U64& first_packet, U64& end_packet, U64 trigger_sample, U32 sample_rate );
+	S64 GetExportSample( double seconds, U64 trigger_sample, U32 sample_rate );
+	U64 FindFirstPacketFrom( S64 sample, U64 first_packet, U64 end_packet );
+	void AppendPacketRow( std::stringstream& ss, U64 packet_id, U64 first_frame_id, U64 last_frame_id, DisplayBase display_base, U64 trigger_sample, U32 sample_rate, bool multi_bus );
+	void GenerateStatisticsExportFile( const char* file, DisplayBase display_base );
+	void GenerateIsoTpExportFile( const char* file, DisplayBase display_base );
+	void GenerateJ1939ExportFile( const char* file, DisplayBase display_base );
+	void GenerateSignalsExportFile( const char* file );
+	void GenerateChangesExportFile( const char* file, DisplayBase display_base );
+	void AppendPgnStatistics( CAN_FDExportFile& f, U32 bus, DisplayBase display_base );
+	bool AppendBusStatistics( CAN_FDExportFile& f, U32 bus, DisplayBase display_base );
+	void AppendBusPrefix( std::stringstream& ss, Frame& frame );
+
+protected:  //vars
+	CAN_FDAnalyzerSettings* mSettings;
+	CAN_FDAnalyzer* mAnalyzer;
+};
+
+#endif //CAN_FD_ANALYZER_RESULTS
@@ -1,142 +1,752 @@
-#include "CAN_FDAnalyzerSettings.h"
-#include <AnalyzerHelpers.h>
-
-
-CAN_FDAnalyzerSettings::CAN_FDAnalyzerSettings()
-:	mInputChannel( UNDEFINED_CHANNEL ),
-    mBitRateHdr ( 1000000 ),
-	mBitRateData ( 1000000 ),
-	mInverted (false)
-{
-	mInputChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
-	mInputChannelInterface->SetTitleAndTooltip( "CAN-FD", "Controller Area Network (Flexible Data Rate) - Input" );
-	mInputChannelInterface->SetChannel( mInputChannel );
-
-	mBitRateHdrInterface.reset( new AnalyzerSettingInterfaceInteger() );
-	mBitRateHdrInterface->SetTitleAndTooltip( "Header Bit Rate (Bits/S)",  "Specify the header bit rate in bits per second." );
-	mBitRateHdrInterface->SetMax( 8000000 );
-	mBitRateHdrInterface->SetMin( 1 );
-	mBitRateHdrInterface->SetInteger(mBitRateHdr);
-
-	mBitRateDataInterface.reset(new AnalyzerSettingInterfaceInteger());
-	mBitRateDataInterface->SetTitleAndTooltip("Data Bit Rate (Bits/S)", "Specify the data bit rate in bits per second.");
-	mBitRateDataInterface->SetMax(8000000);
-	mBitRateDataInterface->SetMin(1);
-	mBitRateDataInterface->SetInteger(mBitRateData);
-
-	mInvertedInterface.reset(new AnalyzerSettingInterfaceBool());
-	mInvertedInterface->SetTitleAndTooltip("Inverted (CAN High)", "Use this option when recording CAN High directly");
-	mInvertedInterface->SetValue(mInverted);
-
-	AddInterface(mInputChannelInterface.get());
-	AddInterface(mBitRateHdrInterface.get());
-	AddInterface(mBitRateDataInterface.get());
-	AddInterface(mInvertedInterface.get());
-
-	AddExportOption( 0, "Export as text/csv file" );
-	AddExportExtension( 0, "text", "txt" );
-	AddExportExtension( 0, "csv", "csv" );
-
-	ClearChannels();
-	AddChannel( mInputChannel, "Serial", false );
-}
-
-CAN_FDAnalyzerSettings::~CAN_FDAnalyzerSettings()
-{
-}
-
-bool CAN_FDAnalyzerSettings::SetSettingsFromInterfaces()
-{
-	Channel can_chan;
-	U32 hdrrate;
-	U32 datarate;
-
-	can_chan = mInputChannelInterface->GetChannel();
-	hdrrate = mBitRateHdrInterface->GetInteger();
-	datarate = mBitRateDataInterface->GetInteger();
-
-	if (can_chan == UNDEFINED_CHANNEL)
-	{
-		SetErrorText("Please select a valid input channel for the CAN-FD interface.");
-		return false;
-	}
-
-	if (datarate < hdrrate)
-	{
-		SetErrorText("Data rate must be greater than or equal to header rate.");
-		return false;
-	}
-
-	if ((datarate % hdrrate) != 0)
-	{
-		SetErrorText("Data rate must be an integer multiple of header rate.");
-		return false;
-	}
-	
-	mInputChannel = can_chan;
-	mBitRateHdr = hdrrate;
-	mBitRateData = datarate;
-	mInverted = mInvertedInterface->GetValue();
-
-	ClearChannels();
-	AddChannel( mInputChannel, "CAN_FD", true );
-
-	return true;
-}
-
-void CAN_FDAnalyzerSettings::UpdateInterfacesFromSettings()
-{
-	mInputChannelInterface->SetChannel( mInputChannel );
-	mBitRateHdrInterface->SetInteger( mBitRateHdr );
-	mBitRateDataInterface->SetInteger( mBitRateData );
-	mInvertedInterface->SetValue( mInverted );
-}
-
-void CAN_FDAnalyzerSettings::LoadSettings( const char* settings )
-{
-	SimpleArchive text_archive;
-	text_archive.SetString( settings );
-
-	const char* name_string;
-
-	text_archive >> &name_string;
-
-	if (strcmp(name_string, "CAN-FD Analyser") != 0)
-		AnalyzerHelpers::Assert("CAN-FD Analyser: Settings string does not belong to...");
-
-	text_archive >> mInputChannel;
-	text_archive >> mBitRateHdr;
-	text_archive >> mBitRateData;
-	text_archive >> mInverted;
-
-	ClearChannels();
-	AddChannel( mInputChannel, "CAN_FD", true );
-
-	UpdateInterfacesFromSettings();
-}
-
-const char* CAN_FDAnalyzerSettings::SaveSettings()
-{
-	SimpleArchive text_archive;
-
-	text_archive << "CAN-FD Analyser";
-	text_archive << mInputChannel;
-	text_archive << mBitRateHdr;
-	text_archive << mBitRateData;
-	text_archive << mInverted;
-
-	return SetReturnString( text_archive.GetString() );
-}
-
-BitState CAN_FDAnalyzerSettings::Recessive()
-{
-	if (mInverted)
-		return BIT_LOW;
-	return BIT_HIGH;
-}
-BitState CAN_FDAnalyzerSettings::Dominant()
-{
-	if (mInverted)
-		return BIT_HIGH;
-	return BIT_LOW;
-}
\ No newline at end of file
+#include "CAN_FDAnalyzerSettings.h"
+#include <AnalyzerHelpers.h>
+#include "CAN_FDIdFilter.h"
+#include "CAN_FDDbc.h"
+#include "CAN_FDExportFile.h"
+#include <cstdlib>
+#include <sstream>
+
+
+CAN_FDAnalyzerSettings::CAN_FDAnalyzerSettings()
+:	mInputChannel( UNDEFINED_CHANNEL ),
+    mBitRateHdr ( 1000000 ),
+	mBitRateData ( 1000000 ),
+	mInverted (false),
+	mAutoDetect (false),
+	mSkimMode (false),
+	mCommitIntervalFrames (256),
+	mCommitIntervalMs (50),
+	mGlitchFilterNs (0),
+	mIsoTpReassembly (false),
+	mIsoTpTimeoutMs (1000),
+	mJ1939Decoding (false),
+	mCompressExport (false),
+	mDecodeFromCaptureStart (false)
+{
+	mInputChannelInterface.reset( new AnalyzerSettingInterfaceChannel() );
+	mInputChannelInterface->SetTitleAndTooltip( "CAN-FD", "Controller Area Network (Flexible Data Rate) - Input" );
+	mInputChannelInterface->SetChannel( mInputChannel );
+
+	mBitRateHdrInterface.reset( new AnalyzerSettingInterfaceInteger() );
+	mBitRateHdrInterface->SetTitleAndTooltip( "Header Bit Rate (Bits/S)",  "Specify the header bit rate in bits per second." );
+	mBitRateHdrInterface->SetMax( 8000000 );
+	mBitRateHdrInterface->SetMin( 1 );
+	mBitRateHdrInterface->SetInteger(mBitRateHdr);
+
+	mBitRateDataInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mBitRateDataInterface->SetTitleAndTooltip("Data Bit Rate (Bits/S)", "Specify the data bit rate in bits per second.");
+	mBitRateDataInterface->SetMax(8000000);
+	mBitRateDataInterface->SetMin(1);
+	mBitRateDataInterface->SetInteger(mBitRateData);
+
+	mInvertedInterface.reset(new AnalyzerSettingInterfaceBool());
+	mInvertedInterface->SetTitleAndTooltip("Inverted (CAN High)", "Use this option when recording CAN High directly");
+	mInvertedInterface->SetValue(mInverted);
+
+	mAutoDetectInterface.reset(new AnalyzerSettingInterfaceBool());
+	mAutoDetectInterface->SetTitleAndTooltip("Auto-detect bit rates and polarity", "Measure header bit rate, data bit rate and polarity from the first frames of the capture. The detected values replace the ones above and the capture is decoded again.");
+	mAutoDetectInterface->SetValue(mAutoDetect);
+
+	mSkimModeInterface.reset(new AnalyzerSettingInterfaceBool());
+	mSkimModeInterface->SetTitleAndTooltip("Arbitration only (skim)", "Decode only identifier, format and DLC of each frame, then skip to the next bus idle period. A frame followed by an error flag before its end of frame is left out, including one with a CRC error.");
+	mSkimModeInterface->SetValue(mSkimMode);
+
+	mCommitIntervalFramesInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mCommitIntervalFramesInterface->SetTitleAndTooltip("Commit interval (frames)", "Publish decoded results after at most this many CAN frames. 1 commits after every frame.");
+	mCommitIntervalFramesInterface->SetMax(1000000);
+	mCommitIntervalFramesInterface->SetMin(1);
+	mCommitIntervalFramesInterface->SetInteger(mCommitIntervalFrames);
+
+	mCommitIntervalMsInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mCommitIntervalMsInterface->SetTitleAndTooltip("Commit interval (ms)", "Publish decoded results after at most this much processing time, even if the frame count has not been reached.");
+	mCommitIntervalMsInterface->SetMax(10000);
+	mCommitIntervalMsInterface->SetMin(1);
+	mCommitIntervalMsInterface->SetInteger(mCommitIntervalMs);
+
+	mGlitchFilterNsInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mGlitchFilterNsInterface->SetTitleAndTooltip("Glitch filter (ns)", "Ignore pulses shorter than this. 0 turns the filter off. It is limited to a quarter of the data bit time.");
+	mGlitchFilterNsInterface->SetMax(1000000);
+	mGlitchFilterNsInterface->SetMin(0);
+	mGlitchFilterNsInterface->SetInteger(mGlitchFilterNs);
+
+	mPerfCounterFileInterface.reset(new AnalyzerSettingInterfaceText());
+	mPerfCounterFileInterface->SetTitleAndTooltip("Performance counter file", "Optional. Decoder performance counters are written to this file whenever the decoder has caught up with the capture.");
+	mPerfCounterFileInterface->SetTextType(AnalyzerSettingInterfaceText::FilePath);
+	mPerfCounterFileInterface->SetText(mPerfCounterFile.c_str());
+
+	mTraceFileInterface.reset(new AnalyzerSettingInterfaceText());
+	mTraceFileInterface->SetTitleAndTooltip("Trace file (Chrome JSON)", "Optional. A timeline of decoder and export phases is written to this file, for chrome://tracing or Perfetto.");
+	mTraceFileInterface->SetTextType(AnalyzerSettingInterfaceText::FilePath);
+	mTraceFileInterface->SetText(mTraceFile.c_str());
+
+	mIsoTpReassemblyInterface.reset(new AnalyzerSettingInterfaceBool());
+	mIsoTpReassemblyInterface->SetTitleAndTooltip("ISO-TP reassembly", "Reassemble ISO 15765-2 transfers (normal addressing) while decoding. They are grouped as transactions and can be exported.");
+	mIsoTpReassemblyInterface->SetValue(mIsoTpReassembly);
+
+	mIsoTpIdentifiersInterface.reset(new AnalyzerSettingInterfaceText());
+	mIsoTpIdentifiersInterface->SetTitleAndTooltip("ISO-TP identifiers", "Hex identifiers and ranges carrying ISO-TP, for example 7DF, 7E0-7EF, 18DA0000-18DBFFFF. Empty for all data frames.");
+	mIsoTpIdentifiersInterface->SetText(mIsoTpIdentifiers.c_str());
+
+	mIsoTpTimeoutMsInterface.reset(new AnalyzerSettingInterfaceInteger());
+	mIsoTpTimeoutMsInterface->SetTitleAndTooltip("ISO-TP timeout (ms)", "A transfer is abandoned when its next frame takes longer than this.");
+	mIsoTpTimeoutMsInterface->SetMax(60000);
+	mIsoTpTimeoutMsInterface->SetMin(1);
+	mIsoTpTimeoutMsInterface->SetInteger(mIsoTpTimeoutMs);
+
+	mJ1939DecodingInterface.reset(new AnalyzerSettingInterfaceBool());
+	mJ1939DecodingInterface->SetTitleAndTooltip("J1939 decoding", "Decode PGN and addresses of 29-bit frames and reassemble BAM and RTS/CTS transport sessions while decoding, for the J1939 export.");
+	mJ1939DecodingInterface->SetValue(mJ1939Decoding);
+
+	mDbcFileInterface.reset(new AnalyzerSettingInterfaceText());
+	mDbcFileInterface->SetTitleAndTooltip("DBC file", "Optional. Signals of the messages defined in this file are decoded to physical values, for the DBC signal export.");
+	mDbcFileInterface->SetTextType(AnalyzerSettingInterfaceText::FilePath);
+	mDbcFileInterface->SetText(mDbcFile.c_str());
+
+	mExportIdentifiersInterface.reset(new AnalyzerSettingInterfaceText());
+	mExportIdentifiersInterface->SetTitleAndTooltip("Export identifiers", "Hex identifiers and ranges the frames export is limited to, for example 7DF, 7E0-7EF. Empty to export all frames.");
+	mExportIdentifiersInterface->SetText(mExportIdentifiers.c_str());
+
+	mExportFromInterface.reset(new AnalyzerSettingInterfaceText());
+	mExportFromInterface->SetTitleAndTooltip("Export from (s)", "Frames export starts with the first frame at or after this time, in seconds relative to the trigger. Empty for the start of the capture.");
+	mExportFromInterface->SetText(mExportFrom.c_str());
+
+	mExportToInterface.reset(new AnalyzerSettingInterfaceText());
+	mExportToInterface->SetTitleAndTooltip("Export to (s)", "Frames export ends with the last frame starting at or before this time, in seconds relative to the trigger. Empty for the end of the capture.");
+	mExportToInterface->SetText(mExportTo.c_str());
+
+	mCompressExportInterface.reset(new AnalyzerSettingInterfaceBool());
+	mCompressExportInterface->SetTitleAndTooltip("Compress exports (gzip)", "Every export is gzip compressed as it is written, to the chosen file name with .gz added.");
+	mCompressExportInterface->SetValue(mCompressExport);
+
+	mDecodeCacheFolderInterface.reset(new AnalyzerSettingInterfaceText());
+	mDecodeCacheFolderInterface->SetTitleAndTooltip("Decode cache folder", "Optional. Decoded results are kept in this folder, so the same capture opened again with the same settings is not decoded again, along with an index of where frames start.");
+	mDecodeCacheFolderInterface->SetTextType(AnalyzerSettingInterfaceText::FolderPath);
+	mDecodeCacheFolderInterface->SetText(mDecodeCacheFolder.c_str());
+
+	mDecodeFromInterface.reset(new AnalyzerSettingInterfaceText());
+	mDecodeFromInterface->SetTitleAndTooltip("Decode from (s)", "Only frames starting at or after this time are decoded, in seconds relative to the trigger. Empty for the start of the capture.");
+	mDecodeFromInterface->SetText(mDecodeFrom.c_str());
+
+	mDecodeToInterface.reset(new AnalyzerSettingInterfaceText());
+	mDecodeToInterface->SetTitleAndTooltip("Decode to (s)", "Decoding stops at the first frame starting after this time, in seconds relative to the trigger. Empty for the end of the capture.");
+	mDecodeToInterface->SetText(mDecodeTo.c_str());
+
+	mDecodeFromCaptureStartInterface.reset(new AnalyzerSettingInterfaceBool());
+	mDecodeFromCaptureStartInterface->SetTitleAndTooltip("Decode times from capture start", "The decode from and to times are seconds from the start of the capture rather than from the trigger.");
+	mDecodeFromCaptureStartInterface->SetValue(mDecodeFromCaptureStart);
+
+	mTriggerFirstWindowInterface.reset(new AnalyzerSettingInterfaceText());
+	mTriggerFirstWindowInterface->SetTitleAndTooltip("Trigger-first window (s)", "Optional. Frames within this many seconds either side of the trigger are decoded and shown first, then the whole capture is decoded again in order. Not used with a decode window.");
+	mTriggerFirstWindowInterface->SetText(mTriggerFirstWindow.c_str());
+
+	AddInterface(mInputChannelInterface.get());
+	AddInterface(mBitRateHdrInterface.get());
+	AddInterface(mBitRateDataInterface.get());
+	AddInterface(mInvertedInterface.get());
+	AddInterface(mAutoDetectInterface.get());
+	AddInterface(mSkimModeInterface.get());
+	AddInterface(mCommitIntervalFramesInterface.get());
+	AddInterface(mCommitIntervalMsInterface.get());
+	AddInterface(mGlitchFilterNsInterface.get());
+	AddInterface(mPerfCounterFileInterface.get());
+	AddInterface(mTraceFileInterface.get());
+	AddInterface(mIsoTpReassemblyInterface.get());
+	AddInterface(mIsoTpIdentifiersInterface.get());
+	AddInterface(mIsoTpTimeoutMsInterface.get());
+	AddInterface(mJ1939DecodingInterface.get());
+	AddInterface(mDbcFileInterface.get());
+	AddInterface(mExportIdentifiersInterface.get());
+	AddInterface(mExportFromInterface.get());
+	AddInterface(mExportToInterface.get());
+	if (CAN_FDExportFile::IsCompressionAvailable() == true)
+		AddInterface(mCompressExportInterface.get());
+	AddInterface(mDecodeCacheFolderInterface.get());
+	AddInterface(mDecodeFromInterface.get());
+	AddInterface(mDecodeToInterface.get());
+	AddInterface(mDecodeFromCaptureStartInterface.get());
+	AddInterface(mTriggerFirstWindowInterface.get());
+
+	for (U32 i = 0; i < CAN_FD_EXTRA_BUSES; i++)
+	{
+		std::stringstream name;
+		name << "Bus " << (i + 1);
+
+		mExtraChannel[i] = UNDEFINED_CHANNEL;
+		mExtraBitRateHdr[i] = 500000;
+		mExtraBitRateData[i] = 2000000;
+		mExtraInverted[i] = false;
+
+		mExtraChannelInterface[i].reset(new AnalyzerSettingInterfaceChannel());
+		mExtraChannelInterface[i]->SetTitleAndTooltip((name.str() + " CAN-FD").c_str(), "Additional bus decoded in the same pass, results are tagged with the bus number. Select None if unused.");
+		mExtraChannelInterface[i]->SetChannel(mExtraChannel[i]);
+		mExtraChannelInterface[i]->SetSelectionOfNoneIsAllowed(true);
+
+		mExtraBitRateHdrInterface[i].reset(new AnalyzerSettingInterfaceInteger());
+		mExtraBitRateHdrInterface[i]->SetTitleAndTooltip((name.str() + " Header Bit Rate (Bits/S)").c_str(), "Specify the header bit rate of this bus in bits per second.");
+		mExtraBitRateHdrInterface[i]->SetMax(8000000);
+		mExtraBitRateHdrInterface[i]->SetMin(1);
+		mExtraBitRateHdrInterface[i]->SetInteger(mExtraBitRateHdr[i]);
+
+		mExtraBitRateDataInterface[i].reset(new AnalyzerSettingInterfaceInteger());
+		mExtraBitRateDataInterface[i]->SetTitleAndTooltip((name.str() + " Data Bit Rate (Bits/S)").c_str(), "Specify the data bit rate of this bus in bits per second.");
+		mExtraBitRateDataInterface[i]->SetMax(8000000);
+		mExtraBitRateDataInterface[i]->SetMin(1);
+		mExtraBitRateDataInterface[i]->SetInteger(mExtraBitRateData[i]);
+
+		mExtraInvertedInterface[i].reset(new AnalyzerSettingInterfaceBool());
+		mExtraInvertedInterface[i]->SetTitleAndTooltip((name.str() + " Inverted (CAN High)").c_str(), "Use this option when recording CAN High of this bus directly");
+		mExtraInvertedInterface[i]->SetValue(mExtraInverted[i]);
+
+		AddInterface(mExtraChannelInterface[i].get());
+		AddInterface(mExtraBitRateHdrInterface[i].get());
+		AddInterface(mExtraBitRateDataInterface[i].get());
+		AddInterface(mExtraInvertedInterface[i].get());
+	}
+
+	AddExportOption( 0, "Export as text/csv file" );
+	AddExportExtension( 0, "text", "txt" );
+	AddExportExtension( 0, "csv", "csv" );
+
+	AddExportOption( 1, "Export bus statistics as text/csv file" );
+	AddExportExtension( 1, "text", "txt" );
+	AddExportExtension( 1, "csv", "csv" );
+
+	AddExportOption( 2, "Export ISO-TP transfers as text/csv file" );
+	AddExportExtension( 2, "text", "txt" );
+	AddExportExtension( 2, "csv", "csv" );
+
+	AddExportOption( 3, "Export J1939 parameter groups as text/csv file" );
+	AddExportExtension( 3, "text", "txt" );
+	AddExportExtension( 3, "csv", "csv" );
+
+	AddExportOption( 4, "Export DBC signals as text/csv file" );
+	AddExportExtension( 4, "text", "txt" );
+	AddExportExtension( 4, "csv", "csv" );
+
+	AddExportOption( 5, "Export payload changes as text/csv file" );
+	AddExportExtension( 5, "text", "txt" );
+	AddExportExtension( 5, "csv", "csv" );
+
+	ClearChannels();
+	AddChannel( mInputChannel, "Serial", false );
+}
+
+CAN_FDAnalyzerSettings::~CAN_FDAnalyzerSettings()
+{
+}
+
+bool CAN_FDAnalyzerSettings::SetSettingsFromInterfaces()
+{
+	Channel can_chan;
+	U32 hdrrate;
+	U32 datarate;
+
+	can_chan = mInputChannelInterface->GetChannel();
+	hdrrate = mBitRateHdrInterface->GetInteger();
+	datarate = mBitRateDataInterface->GetInteger();
+
+	if (can_chan == UNDEFINED_CHANNEL)
+	{
+		SetErrorText("Please select a valid input channel for the CAN-FD interface.");
+		return false;
+	}
+
+	if (CheckBitRates(0, hdrrate, datarate) == false)
+		return false;
+
+	for (U32 i = 0; i < CAN_FD_EXTRA_BUSES; i++)
+	{
+		Channel extra_chan = mExtraChannelInterface[i]->GetChannel();
+		if (extra_chan == UNDEFINED_CHANNEL)
+			continue;
+
+		if (extra_chan == can_chan)
+		{
+			SetErrorText("Each bus must use a different input channel.");
+			return false;
+		}
+
+		for (U32 j = 0; j < i; j++)
+		{
+			if (mExtraChannelInterface[j]->GetChannel() == extra_chan)
+			{
+				SetErrorText("Each bus must use a different input channel.");
+				return false;
+			}
+		}
+
+		if (CheckBitRates(i + 1, mExtraBitRateHdrInterface[i]->GetInteger(), mExtraBitRateDataInterface[i]->GetInteger()) == false)
+			return false;
+	}
+
+	CanIdFilter iso_tp_identifiers;
+	if (iso_tp_identifiers.Parse(mIsoTpIdentifiersInterface->GetText()) == false)
+	{
+		SetErrorText("ISO-TP identifiers must be hex identifiers or ranges, separated by commas.");
+		return false;
+	}
+
+	CanIdFilter export_identifiers;
+	if (export_identifiers.Parse(mExportIdentifiersInterface->GetText()) == false)
+	{
+		SetErrorText("Export identifiers must be hex identifiers or ranges, separated by commas.");
+		return false;
+	}
+
+	bool has_export_from;
+	bool has_export_to;
+	double export_from;
+	double export_to;
+	if ((ParseWindowTime(mExportFromInterface->GetText(), has_export_from, export_from) == false) ||
+		(ParseWindowTime(mExportToInterface->GetText(), has_export_to, export_to) == false))
+	{
+		SetErrorText("Export times must be numbers of seconds, or empty.");
+		return false;
+	}
+
+	if ((has_export_from == true) && (has_export_to == true) && (export_to < export_from))
+	{
+		SetErrorText("Export to must not be before export from.");
+		return false;
+	}
+
+	bool has_decode_from;
+	bool has_decode_to;
+	double decode_from;
+	double decode_to;
+	if ((ParseWindowTime(mDecodeFromInterface->GetText(), has_decode_from, decode_from) == false) ||
+		(ParseWindowTime(mDecodeToInterface->GetText(), has_decode_to, decode_to) == false))
+	{
+		SetErrorText("Decode times must be numbers of seconds, or empty.");
+		return false;
+	}
+
+	if ((has_decode_from == true) && (has_decode_to == true) && (decode_to < decode_from))
+	{
+		SetErrorText("Decode to must not be before decode from.");
+		return false;
+	}
+
+	bool has_trigger_first_window;
+	double trigger_first_window;
+	if ((ParseWindowTime(mTriggerFirstWindowInterface->GetText(), has_trigger_first_window, trigger_first_window) == false) ||
+		(trigger_first_window < 0.0))
+	{
+		SetErrorText("Trigger-first window must be a positive number of seconds, or empty.");
+		return false;
+	}
+
+	CAN_FDDbc dbc;
+	std::string dbc_error;
+	if (dbc.Load(mDbcFileInterface->GetText(), dbc_error) == false)
+	{
+		SetErrorText(dbc_error.c_str());
+		return false;
+	}
+
+	mInputChannel = can_chan;
+	mBitRateHdr = hdrrate;
+	mBitRateData = datarate;
+	mInverted = mInvertedInterface->GetValue();
+	mAutoDetect = mAutoDetectInterface->GetValue();
+	mSkimMode = mSkimModeInterface->GetValue();
+	mCommitIntervalFrames = mCommitIntervalFramesInterface->GetInteger();
+	mCommitIntervalMs = mCommitIntervalMsInterface->GetInteger();
+	mGlitchFilterNs = mGlitchFilterNsInterface->GetInteger();
+	mPerfCounterFile = mPerfCounterFileInterface->GetText();
+	mTraceFile = mTraceFileInterface->GetText();
+	mIsoTpReassembly = mIsoTpReassemblyInterface->GetValue();
+	mIsoTpIdentifiers = mIsoTpIdentifiersInterface->GetText();
+	mIsoTpTimeoutMs = mIsoTpTimeoutMsInterface->GetInteger();
+	mJ1939Decoding = mJ1939DecodingInterface->GetValue();
+	mDbcFile = mDbcFileInterface->GetText();
+	mExportIdentifiers = mExportIdentifiersInterface->GetText();
+	mExportFrom = mExportFromInterface->GetText();
+	mExportTo = mExportToInterface->GetText();
+	mCompressExport = mCompressExportInterface->GetValue();
+	mDecodeCacheFolder = mDecodeCacheFolderInterface->GetText();
+	mDecodeFrom = mDecodeFromInterface->GetText();
+	mDecodeTo = mDecodeToInterface->GetText();
+	mDecodeFromCaptureStart = mDecodeFromCaptureStartInterface->GetValue();
+	mTriggerFirstWindow = mTriggerFirstWindowInterface->GetText();
+
+	for (U32 i = 0; i < CAN_FD_EXTRA_BUSES; i++)
+	{
+		mExtraChannel[i] = mExtraChannelInterface[i]->GetChannel();
+		mExtraBitRateHdr[i] = mExtraBitRateHdrInterface[i]->GetInteger();
+		mExtraBitRateData[i] = mExtraBitRateDataInterface[i]->GetInteger();
+		mExtraInverted[i] = mExtraInvertedInterface[i]->GetValue();
+	}
+
+	AddBusChannels();
+
+	return true;
+}
+
+bool CAN_FDAnalyzerSettings::CheckBitRates(U32 bus, U32 hdrrate, U32 datarate)
+{
+	std::stringstream ss;
+	if (bus > 0)
+		ss << "Bus " << bus << ": ";
+
+	if (datarate < hdrrate)
+	{
+		ss << "Data rate must be greater than or equal to header rate.";
+		SetErrorText(ss.str().c_str());
+		return false;
+	}
+
+	if ((datarate % hdrrate) != 0)
+	{
+		ss << "Data rate must be an integer multiple of header rate.";
+		SetErrorText(ss.str().c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool CAN_FDAnalyzerSettings::ParseWindowTime(const std::string& text, bool& is_set, double& seconds)
+{
+	is_set = false;
+	seconds = 0.0;
+
+	const char* p = text.c_str();
+	while ((*p == ' ') || (*p == '\t'))
+		p++;
+	if (*p == 0)
+		return true;
+
+	char* end;
+	seconds = strtod(p, &end);
+	if (end == p)
+		return false;
+
+	while ((*end == ' ') || (*end == '\t'))
+		end++;
+	if (*end != 0)
+		return false;
+
+	is_set = true;
+	return true;
+}
+
+void CAN_FDAnalyzerSettings::AddBusChannels()
+{
+	ClearChannels();
+	AddChannel( mInputChannel, "CAN_FD", true );
+
+	for (U32 i = 0; i < CAN_FD_EXTRA_BUSES; i++)
+	{
+		if (mExtraChannel[i] == UNDEFINED_CHANNEL)
+			continue;
+
+		std::stringstream name;
+		name << "CAN_FD bus " << (i + 1);
+		AddChannel( mExtraChannel[i], name.str().c_str(), true );
+	}
+}
+
+void CAN_FDAnalyzerSettings::UpdateInterfacesFromSettings()
+{
+	mInputChannelInterface->SetChannel( mInputChannel );
+	mBitRateHdrInterface->SetInteger( mBitRateHdr );
+	mBitRateDataInterface->SetInteger( mBitRateData );
+	mInvertedInterface->SetValue( mInverted );
+	mAutoDetectInterface->SetValue( mAutoDetect );
+	mSkimModeInterface->SetValue( mSkimMode );
+	mCommitIntervalFramesInterface->SetInteger( mCommitIntervalFrames );
+	mCommitIntervalMsInterface->SetInteger( mCommitIntervalMs );
+	mGlitchFilterNsInterface->SetInteger( mGlitchFilterNs );
+	mPerfCounterFileInterface->SetText( mPerfCounterFile.c_str() );
+	mTraceFileInterface->SetText( mTraceFile.c_str() );
+	mIsoTpReassemblyInterface->SetValue( mIsoTpReassembly );
+	mIsoTpIdentifiersInterface->SetText( mIsoTpIdentifiers.c_str() );
+	mIsoTpTimeoutMsInterface->SetInteger( mIsoTpTimeoutMs );
+	mJ1939DecodingInterface->SetValue( mJ1939Decoding );
+	mDbcFileInterface->SetText( mDbcFile.c_str() );
+	mExportIdentifiersInterface->SetText( mExportIdentifiers.c_str() );
+	mExportFromInterface->SetText( mExportFrom.c_str() );
+	mExportToInterface->SetText( mExportTo.c_str() );
+	mCompressExportInterface->SetValue( mCompressExport );
+	mDecodeCacheFolderInterface->SetText( mDecodeCacheFolder.c_str() );
+	mDecodeFromInterface->SetText( mDecodeFrom.c_str() );
+	mDecodeToInterface->SetText( mDecodeTo.c_str() );
+	mDecodeFromCaptureStartInterface->SetValue( mDecodeFromCaptureStart );
+	mTriggerFirstWindowInterface->SetText( mTriggerFirstWindow.c_str() );
+
+	for (U32 i = 0; i < CAN_FD_EXTRA_BUSES; i++)
+	{
+		mExtraChannelInterface[i]->SetChannel( mExtraChannel[i] );
+		mExtraBitRateHdrInterface[i]->SetInteger( mExtraBitRateHdr[i] );
+		mExtraBitRateDataInterface[i]->SetInteger( mExtraBitRateData[i] );
+		mExtraInvertedInterface[i]->SetValue( mExtraInverted[i] );
+	}
+}
+
+void CAN_FDAnalyzerSettings::LoadSettings( const char* settings )
+{
+	SimpleArchive text_archive;
+	text_archive.SetString( settings );
+
+	const char* name_string;
+
+	text_archive >> &name_string;
+
+	if (strcmp(name_string, "CAN-FD Analyser") != 0)
+		AnalyzerHelpers::Assert("CAN-FD Analyser: Settings string does not belong to...");
+
+	text_archive >> mInputChannel;
+	text_archive >> mBitRateHdr;
+	text_archive >> mBitRateData;
+	text_archive >> mInverted;
+
+	/* Settings added after the first release - older settings strings simply end early */
+	bool skim_mode;
+	if (text_archive >> skim_mode)
+		mSkimMode = skim_mode;
+
+	U32 commit_frames;
+	U32 commit_ms;
+	if ((text_archive >> commit_frames) && (text_archive >> commit_ms))
+	{
+		mCommitIntervalFrames = commit_frames;
+		mCommitIntervalMs = commit_ms;
+	}
+
+	bool auto_detect;
+	if (text_archive >> auto_detect)
+		mAutoDetect = auto_detect;
+
+	for (U32 i = 0; i < CAN_FD_EXTRA_BUSES; i++)
+	{
+		Channel extra_chan;
+		U32 extra_hdr;
+		U32 extra_data;
+		bool extra_inverted;
+		if ((text_archive >> extra_chan) && (text_archive >> extra_hdr) && (text_archive >> extra_data) && (text_archive >> extra_inverted))
+		{
+			mExtraChannel[i] = extra_chan;
+			mExtraBitRateHdr[i] = extra_hdr;
+			mExtraBitRateData[i] = extra_data;
+			mExtraInverted[i] = extra_inverted;
+		}
+	}
+
+	U32 glitch_filter;
+	if (text_archive >> glitch_filter)
+		mGlitchFilterNs = glitch_filter;
+
+	const char* perf_counter_file;
+	if (text_archive >> &perf_counter_file)
+		mPerfCounterFile = perf_counter_file;
+
+	const char* trace_file;
+	if (text_archive >> &trace_file)
+		mTraceFile = trace_file;
+
+	bool iso_tp_reassembly;
+	const char* iso_tp_identifiers;
+	U32 iso_tp_timeout;
+	if ((text_archive >> iso_tp_reassembly) && (text_archive >> &iso_tp_identifiers) && (text_archive >> iso_tp_timeout))
+	{
+		mIsoTpReassembly = iso_tp_reassembly;
+		mIsoTpIdentifiers = iso_tp_identifiers;
+		mIsoTpTimeoutMs = iso_tp_timeout;
+	}
+
+	bool j1939_decoding;
+	if (text_archive >> j1939_decoding)
+		mJ1939Decoding = j1939_decoding;
+
+	const char* dbc_file;
+	if (text_archive >> &dbc_file)
+		mDbcFile = dbc_file;
+
+	const char* export_identifiers;
+	if (text_archive >> &export_identifiers)
+		mExportIdentifiers = export_identifiers;
+
+	/* Each string read reuses the archive's buffer, so it is copied before the next one is read */
+	const char* export_from;
+	if (text_archive >> &export_from)
+		mExportFrom = export_from;
+
+	const char* export_to;
+	if (text_archive >> &export_to)
+		mExportTo = export_to;
+
+	bool compress_export;
+	if (text_archive >> compress_export)
+		mCompressExport = compress_export;
+
+	const char* decode_cache_folder;
+	if (text_archive >> &decode_cache_folder)
+		mDecodeCacheFolder = decode_cache_folder;
+
+	const char* decode_from;
+	if (text_archive >> &decode_from)
+		mDecodeFrom = decode_from;
+
+	const char* decode_to;
+	if (text_archive >> &decode_to)
+		mDecodeTo = decode_to;
+
+	bool decode_from_capture_start;
+	if (text_archive >> decode_from_capture_start)
+		mDecodeFromCaptureStart = decode_from_capture_start;
+
+	const char* trigger_first_window;
+	if (text_archive >> &trigger_first_window)
+		mTriggerFirstWindow = trigger_first_window;
+
+	AddBusChannels();
+
+	UpdateInterfacesFromSettings();
+}
+
+const char* CAN_FDAnalyzerSettings::SaveSettings()
+{
+	SimpleArchive text_archive;
+
+	text_archive << "CAN-FD Analyser";
+	text_archive << mInputChannel;
+	text_archive << mBitRateHdr;
+	text_archive << mBitRateData;
+	text_archive << mInverted;
+	text_archive << mSkimMode;
+	text_archive << mCommitIntervalFrames;
+	text_archive << mCommitIntervalMs;
+	text_archive << mAutoDetect;
+
+	for (U32 i = 0; i < CAN_FD_EXTRA_BUSES; i++)
+	{
+		text_archive << mExtraChannel[i];
+		text_archive << mExtraBitRateHdr[i];
+		text_archive << mExtraBitRateData[i];
+		text_archive << mExtraInverted[i];
+	}
+
+	text_archive << mGlitchFilterNs;
+	text_archive << mPerfCounterFile.c_str();
+	text_archive << mTraceFile.c_str();
+	text_archive << mIsoTpReassembly;
+	text_archive << mIsoTpIdentifiers.c_str();
+	text_archive << mIsoTpTimeoutMs;
+	text_archive << mJ1939Decoding;
+	text_archive << mDbcFile.c_str();
+	text_archive << mExportIdentifiers.c_str();
+	text_archive << mExportFrom.c_str();
+	text_archive << mExportTo.c_str();
+	text_archive << mCompressExport;
+	text_archive << mDecodeCacheFolder.c_str();
+	text_archive << mDecodeFrom.c_str();
+	text_archive << mDecodeTo.c_str();
+	text_archive << mDecodeFromCaptureStart;
+	text_archive << mTriggerFirstWindow.c_str();
+
+	return SetReturnString( text_archive.GetString() );
+}
+
+std::string CAN_FDAnalyzerSettings::GetDecodeSettings()
+{
+	/* Protocol layers, exports, commit intervals and diagnostics are left out: the cache holds the */
+	/* decoded frames, which are fed through the protocol layers again when it is replayed */
+	SimpleArchive text_archive;
+
+	text_archive << mInputChannel;
+	text_archive << mBitRateHdr;
+	text_archive << mBitRateData;
+	text_archive << mInverted;
+	text_archive << mSkimMode;
+
+	for (U32 i = 0; i < CAN_FD_EXTRA_BUSES; i++)
+	{
+		text_archive << mExtraChannel[i];
+		text_archive << mExtraBitRateHdr[i];
+		text_archive << mExtraBitRateData[i];
+		text_archive << mExtraInverted[i];
+	}
+
+	text_archive << mGlitchFilterNs;
+	text_archive << mDecodeFrom.c_str();
+	text_archive << mDecodeTo.c_str();
+	text_archive << mDecodeFromCaptureStart;
+	text_archive << mTriggerFirstWindow.c_str();
+
+	return text_archive.GetString();
+}
+
+BitState CAN_FDAnalyzerSettings::Recessive()
+{
+	if (mInverted)
+		return BIT_LOW;
+	return BIT_HIGH;
+}
+BitState CAN_FDAnalyzerSettings::Dominant()
+{
+	if (mInverted)
+		return BIT_HIGH;
+	return BIT_LOW;
+}
+
+bool CAN_FDAnalyzerSettings::IsBusEnabled(U32 bus)
+{
+	if (bus == 0)
+		return true;
+	return (mExtraChannel[bus - 1] != UNDEFINED_CHANNEL);
+}
+
+bool CAN_FDAnalyzerSettings::IsMultiBus()
+{
+	for (U32 i = 1; i < CAN_FD_MAX_BUSES; i++)
+	{
+		if (IsBusEnabled(i) == true)
+			return true;
+	}
+	return false;
+}
+
+Channel CAN_FDAnalyzerSettings::GetBusChannel(U32 bus)
+{
+	if (bus == 0)
+		return mInputChannel;
+	return mExtraChannel[bus - 1];
+}
+
+U32 CAN_FDAnalyzerSettings::GetBusBitRateHdr(U32 bus)
+{
+	if (bus == 0)
+		return mBitRateHdr;
+	return mExtraBitRateHdr[bus - 1];
+}
+
+U32 CAN_FDAnalyzerSettings::GetBusBitRateData(U32 bus)
+{
+	if (bus == 0)
+		return mBitRateData;
+	return mExtraBitRateData[bus - 1];
+}
+
+bool CAN_FDAnalyzerSettings::GetBusInverted(U32 bus)
+{
+	if (bus == 0)
+		return mInverted;
+	return mExtraInverted[bus - 1];
+}
+
+void CAN_FDAnalyzerSettings::SetBusParameters(U32 bus, U32 bit_rate_hdr, U32 bit_rate_data, bool inverted)
+{
+	if (bus == 0)
+	{
+		mBitRateHdr = bit_rate_hdr;
+		mBitRateData = bit_rate_data;
+		mInverted = inverted;
+	}
+	else
+	{
+		mExtraBitRateHdr[bus - 1] = bit_rate_hdr;
+		mExtraBitRateData[bus - 1] = bit_rate_data;
+		mExtraInverted[bus - 1] = inverted;
+	}
+}
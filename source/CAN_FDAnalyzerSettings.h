@@ -1,35 +1,110 @@
-#ifndef CAN_FD_ANALYZER_SETTINGS
-#define CAN_FD_ANALYZER_SETTINGS
-
-#include <AnalyzerSettings.h>
-#include <AnalyzerTypes.h>
-
-class CAN_FDAnalyzerSettings : public AnalyzerSettings
-{
-public:
-	CAN_FDAnalyzerSettings();
-	virtual ~CAN_FDAnalyzerSettings();
-
-	virtual bool SetSettingsFromInterfaces();
-	void UpdateInterfacesFromSettings();
-	virtual void LoadSettings( const char* settings );
-	virtual const char* SaveSettings();
-
-	
-	Channel mInputChannel;
-	U32 mBitRateHdr;
-	U32 mBitRateData;
-	bool mInverted;
-
-	BitState Recessive();
-	BitState Dominant();
-
-
-protected:
-	std::auto_ptr< AnalyzerSettingInterfaceChannel >	mInputChannelInterface;
-	std::auto_ptr< AnalyzerSettingInterfaceInteger >	mBitRateHdrInterface;
-	std::auto_ptr< AnalyzerSettingInterfaceInteger >	mBitRateDataInterface;
-	std::auto_ptr< AnalyzerSettingInterfaceBool > mInvertedInterface;
-};
-
-#endif //CAN_FD_ANALYZER_SETTINGS
+#ifndef CAN_FD_ANALYZER_SETTINGS
+#define CAN_FD_ANALYZER_SETTINGS
+
+#include <AnalyzerSettings.h>
+#include <AnalyzerTypes.h>
+#include <string>
+
+/* Bus 0 is configured by the original input channel settings, the others by the extra bus settings */
+#define CAN_FD_MAX_BUSES 4
+#define CAN_FD_EXTRA_BUSES (CAN_FD_MAX_BUSES - 1)
+
+class CAN_FDAnalyzerSettings : public AnalyzerSettings
+{
+public:
+	CAN_FDAnalyzerSettings();
+	virtual ~CAN_FDAnalyzerSettings();
+
+	virtual bool SetSettingsFromInterfaces();
+	void UpdateInterfacesFromSettings();
+	virtual void LoadSettings( const char* settings );
+	virtual const char* SaveSettings();
+
+	/* Only the settings that change the decoded frames, which key the decode cache */
+	std::string GetDecodeSettings();
+
+	
+	Channel mInputChannel;
+	U32 mBitRateHdr;
+	U32 mBitRateData;
+	bool mInverted;
+	bool mAutoDetect;
+	bool mSkimMode;
+	U32 mCommitIntervalFrames;
+	U32 mCommitIntervalMs;
+	U32 mGlitchFilterNs;
+	std::string mPerfCounterFile;
+	std::string mTraceFile;
+
+	bool mIsoTpReassembly;
+	std::string mIsoTpIdentifiers;
+	U32 mIsoTpTimeoutMs;
+	bool mJ1939Decoding;
+	std::string mDbcFile;
+	std::string mExportIdentifiers;
+	std::string mExportFrom;
+	std::string mExportTo;
+	bool mCompressExport;
+	std::string mDecodeCacheFolder;
+	std::string mDecodeFrom;
+	std::string mDecodeTo;
+	bool mDecodeFromCaptureStart;
+	std::string mTriggerFirstWindow;
+
+	/* Additional buses decoded in the same pass, bus n is at index n - 1. Unused buses have no channel. */
+	Channel mExtraChannel[CAN_FD_EXTRA_BUSES];
+	U32 mExtraBitRateHdr[CAN_FD_EXTRA_BUSES];
+	U32 mExtraBitRateData[CAN_FD_EXTRA_BUSES];
+	bool mExtraInverted[CAN_FD_EXTRA_BUSES];
+
+	BitState Recessive();
+	BitState Dominant();
+
+	bool IsBusEnabled(U32 bus);
+	bool IsMultiBus();
+	Channel GetBusChannel(U32 bus);
+	U32 GetBusBitRateHdr(U32 bus);
+	U32 GetBusBitRateData(U32 bus);
+	bool GetBusInverted(U32 bus);
+	void SetBusParameters(U32 bus, U32 bit_rate_hdr, U32 bit_rate_data, bool inverted);
+
+	/* Export and decode window times are seconds relative to the trigger, an empty text leaves that end open */
+	static bool ParseWindowTime(const std::string& text, bool& is_set, double& seconds);
+
+
+protected:
+	std::auto_ptr< AnalyzerSettingInterfaceChannel >	mInputChannelInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger >	mBitRateHdrInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger >	mBitRateDataInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool > mInvertedInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool > mAutoDetectInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool > mSkimModeInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mCommitIntervalFramesInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mCommitIntervalMsInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mGlitchFilterNsInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mPerfCounterFileInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mTraceFileInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool > mIsoTpReassemblyInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mIsoTpIdentifiersInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mIsoTpTimeoutMsInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool > mJ1939DecodingInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mDbcFileInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mExportIdentifiersInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mExportFromInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mExportToInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool > mCompressExportInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mDecodeCacheFolderInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mDecodeFromInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mDecodeToInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceBool > mDecodeFromCaptureStartInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceText > mTriggerFirstWindowInterface;
+	std::auto_ptr< AnalyzerSettingInterfaceChannel > mExtraChannelInterface[CAN_FD_EXTRA_BUSES];
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mExtraBitRateHdrInterface[CAN_FD_EXTRA_BUSES];
+	std::auto_ptr< AnalyzerSettingInterfaceInteger > mExtraBitRateDataInterface[CAN_FD_EXTRA_BUSES];
+	std::auto_ptr< AnalyzerSettingInterfaceBool > mExtraInvertedInterface[CAN_FD_EXTRA_BUSES];
+
+	void AddBusChannels();
+	bool CheckBitRates(U32 bus, U32 hdrrate, U32 datarate);
+};
+
+#endif //CAN_FD_ANALYZER_SETTINGS
@@ -0,0 +1,113 @@
+#include "CAN_FDBusStatistics.h"
+
+CAN_FDBusStatistics::CAN_FDBusStatistics()
+:	mSampleRateHz(0),
+	mBinSamples(1)
+{
+}
+
+CAN_FDBusStatistics::~CAN_FDBusStatistics()
+{
+}
+
+void CAN_FDBusStatistics::Reset(U32 sample_rate_hz)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mSampleRateHz = sample_rate_hz;
+	mBinSamples = ((U64)sample_rate_hz * STATISTICS_BIN_MS) / 1000;
+	if (mBinSamples == 0)
+		mBinSamples = 1;
+
+	mBins.clear();
+	mIdentifiers.Clear();
+}
+
+void CAN_FDBusStatistics::AddFrame(U32 identifier, bool extended, U64 starting_sample, U64 ending_sample)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	GetBin(starting_sample).mFrames++;
+	AddBusyTime(starting_sample, ending_sample);
+
+	CanIdStatistics& id = mIdentifiers.Get(identifier, extended);
+
+	if (id.mFrames == 0)
+	{
+		id.mFirstSample = starting_sample;
+	}
+	else
+	{
+		U64 period = starting_sample - id.mLastSample;
+
+		id.mPeriods++;
+		double delta = double(period) - id.mPeriodMean;
+		id.mPeriodMean += delta / double(id.mPeriods);
+		id.mPeriodM2 += delta * (double(period) - id.mPeriodMean);
+
+		if ((id.mPeriods == 1) || (period < id.mMinPeriod))
+			id.mMinPeriod = period;
+		if (period > id.mMaxPeriod)
+			id.mMaxPeriod = period;
+	}
+
+	id.mFrames++;
+	id.mLastSample = starting_sample;
+}
+
+void CAN_FDBusStatistics::AddError(U64 starting_sample, U64 ending_sample)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	GetBin(starting_sample).mErrors++;
+	AddBusyTime(starting_sample, ending_sample);
+}
+
+U32 CAN_FDBusStatistics::GetSampleRate()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mSampleRateHz;
+}
+
+U64 CAN_FDBusStatistics::GetBinSamples()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mBinSamples;
+}
+
+void CAN_FDBusStatistics::GetSnapshot(std::vector<CanLoadBin>& bins, std::vector<CanIdStatisticsRow>& identifiers)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	bins = mBins;
+
+	identifiers.resize(mIdentifiers.GetCount());
+	for (U32 i = 0; i < mIdentifiers.GetCount(); i++)
+	{
+		identifiers[i].mIdentifier = mIdentifiers.GetIdentifier(i);
+		identifiers[i].mExtended = mIdentifiers.IsExtended(i);
+		identifiers[i].mStatistics = mIdentifiers.GetEntry(i);
+	}
+}
+
+CanLoadBin& CAN_FDBusStatistics::GetBin(U64 sample)
+{
+	U64 bin = sample / mBinSamples;
+	if (bin >= mBins.size())
+		mBins.resize((size_t)bin + 1);
+
+	return mBins[(size_t)bin];
+}
+
+void CAN_FDBusStatistics::AddBusyTime(U64 starting_sample, U64 ending_sample)
+{
+	/* A frame only rarely straddles a bin boundary, so this is normally a single iteration */
+	while (starting_sample <= ending_sample)
+	{
+		U64 bin_end = ((starting_sample / mBinSamples) + 1) * mBinSamples - 1;
+		U64 segment_end = (ending_sample < bin_end) ? ending_sample : bin_end;
+
+		GetBin(starting_sample).mBusySamples += segment_end - starting_sample + 1;
+		starting_sample = segment_end + 1;
+	}
+}
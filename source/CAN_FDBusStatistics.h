@@ -0,0 +1,75 @@
+#ifndef CAN_FD_BUS_STATISTICS
+#define CAN_FD_BUS_STATISTICS
+
+#include <AnalyzerTypes.h>
+#include "CAN_FDIdTable.h"
+#include <mutex>
+#include <vector>
+
+/* Bus load and error counts are accumulated in fixed time bins */
+#define STATISTICS_BIN_MS 100
+
+class CanLoadBin
+{
+public:
+	CanLoadBin() : mBusySamples(0), mFrames(0), mErrors(0) {}
+
+	U64 mBusySamples;
+	U32 mFrames;
+	U32 mErrors;
+};
+
+class CanIdStatistics
+{
+public:
+	CanIdStatistics() : mFrames(0), mFirstSample(0), mLastSample(0), mPeriods(0), mPeriodMean(0.0), mPeriodM2(0.0), mMinPeriod(0), mMaxPeriod(0) {}
+
+	U64 mFrames;
+	U64 mFirstSample;
+	U64 mLastSample;
+
+	/* Running mean and sum of squared deviations of the frame period, in samples (Welford) */
+	U64 mPeriods;
+	double mPeriodMean;
+	double mPeriodM2;
+	U64 mMinPeriod;
+	U64 mMaxPeriod;
+};
+
+class CanIdStatisticsRow
+{
+public:
+	U32 mIdentifier;
+	bool mExtended;
+	CanIdStatistics mStatistics;
+};
+
+/* Streaming statistics, updated once per decoded frame with O(1) work, so that the summaries need no extra */
+/* pass over the capture. The worker thread adds frames while an export may be reading a snapshot. */
+
+class CAN_FDBusStatistics
+{
+public:
+	CAN_FDBusStatistics();
+	~CAN_FDBusStatistics();
+
+	void Reset(U32 sample_rate_hz);
+	void AddFrame(U32 identifier, bool extended, U64 starting_sample, U64 ending_sample);
+	void AddError(U64 starting_sample, U64 ending_sample);
+
+	U32 GetSampleRate();
+	U64 GetBinSamples();
+	void GetSnapshot(std::vector<CanLoadBin>& bins, std::vector<CanIdStatisticsRow>& identifiers);
+
+protected:
+	CanLoadBin& GetBin(U64 sample);
+	void AddBusyTime(U64 starting_sample, U64 ending_sample);
+
+	std::mutex mMutex;
+	U32 mSampleRateHz;
+	U64 mBinSamples;
+	std::vector<CanLoadBin> mBins;
+	CanIdTable<CanIdStatistics> mIdentifiers;
+};
+
+#endif //CAN_FD_BUS_STATISTICS
@@ -0,0 +1,328 @@
+#include "CAN_FDDbc.h"
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+/* Pseudo message that holds signals not assigned to any message */
+#define DBC_INDEPENDENT_SIGNALS_ID 0xC0000000
+
+/* Set in a DBC message id for 29-bit identifiers */
+#define DBC_EXTENDED_ID_FLAG 0x80000000
+
+CAN_FDDbc::CAN_FDDbc()
+{
+}
+
+CAN_FDDbc::~CAN_FDDbc()
+{
+}
+
+bool CAN_FDDbc::Load(const std::string& file, std::string& error)
+{
+	CanIdTable<S32> message_index;
+	std::vector<CanDbcMessage> messages;
+
+	bool loaded = Parse(file, message_index, messages, error);
+	if (loaded == false)
+	{
+		message_index.Clear();
+		messages.clear();
+	}
+
+	/* The records index the messages they were decoded with */
+	std::lock_guard<std::mutex> lock(mMutex);
+	mRecords.clear();
+	mValues.clear();
+	mMessageIndex = message_index;
+	mMessages.swap(messages);
+	mError = (loaded == true) ? std::string() : error;
+	return loaded;
+}
+
+bool CAN_FDDbc::Parse(const std::string& file, CanIdTable<S32>& message_index, std::vector<CanDbcMessage>& messages, std::string& error)
+{
+	if (file.empty() == false)
+	{
+		std::ifstream in(file.c_str());
+		if (in.is_open() == false)
+		{
+			error = "Can't open the DBC file " + file;
+			return false;
+		}
+
+		std::string line;
+		U32 line_number = 0;
+		CanDbcMessage* message = NULL;
+
+		while (std::getline(in, line))
+		{
+			line_number++;
+
+			size_t first = line.find_first_not_of(" \t");
+			if (first == std::string::npos)
+				continue;
+
+			if (line.compare(first, 4, "BO_ ") == 0)
+			{
+				U32 identifier;
+				bool extended;
+				CanDbcMessage parsed;
+				if (ParseMessage(line.substr(first), identifier, extended, parsed) == false)
+				{
+					std::stringstream ss;
+					ss << "DBC file line " << line_number << ": can't read the message definition";
+					error = ss.str();
+					return false;
+				}
+
+				message = NULL;
+				if ((identifier == DBC_INDEPENDENT_SIGNALS_ID) || (message_index.Find(identifier & 0x1FFFFFFF, extended) != NULL))
+					continue;
+
+				message_index.Get(identifier & 0x1FFFFFFF, extended) = (S32)messages.size();
+				messages.push_back(parsed);
+				message = &messages.back();
+			}
+			else if (line.compare(first, 4, "SG_ ") == 0)
+			{
+				CanDbcSignal signal;
+				if (ParseSignal(line.substr(first), signal) == false)
+				{
+					std::stringstream ss;
+					ss << "DBC file line " << line_number << ": can't read the signal definition";
+					error = ss.str();
+					return false;
+				}
+
+				if (message == NULL)
+					continue;
+
+				if (signal.mMultiplexor == true)
+					message->mMultiplexor = (S32)message->mSignals.size();
+				message->mSignals.push_back(signal);
+			}
+			else if (line.compare(first, 3, "BO_") != 0)
+			{
+				/* Anything else ends the signal list of the message */
+				message = NULL;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool CAN_FDDbc::ParseMessage(const std::string& line, U32& identifier, bool& extended, CanDbcMessage& message)
+{
+	/* BO_ <id> <name>: <dlc> <transmitter> */
+	std::istringstream in(line.substr(4));
+
+	unsigned long long id;
+	std::string name;
+	if (!(in >> id >> name))
+		return false;
+
+	if ((name.empty() == false) && (name[name.size() - 1] == ':'))
+		name.erase(name.size() - 1);
+	if (name.empty() == true)
+		return false;
+
+	identifier = U32(id);
+	extended = ((identifier & DBC_EXTENDED_ID_FLAG) != 0);
+	message.mName = name;
+	return true;
+}
+
+bool CAN_FDDbc::ParseSignal(const std::string& line, CanDbcSignal& signal)
+{
+	/* SG_ <name> [M|m<n>] : <start>|<length>@<order><sign> (<scale>,<offset>) [<min>|<max>] "<unit>" <receivers> */
+	size_t colon = line.find(':');
+	if (colon == std::string::npos)
+		return false;
+
+	std::istringstream names(line.substr(4, colon - 4));
+	std::string multiplex;
+	if (!(names >> signal.mName))
+		return false;
+	names >> multiplex;
+
+	signal.mMultiplexor = false;
+	signal.mMultiplexed = false;
+	signal.mMultiplexValue = 0;
+	if (multiplex == "M")
+	{
+		signal.mMultiplexor = true;
+	}
+	else if ((multiplex.empty() == false) && (multiplex[0] == 'm'))
+	{
+		signal.mMultiplexed = true;
+		signal.mMultiplexValue = (U32)strtoul(multiplex.c_str() + 1, NULL, 10);
+	}
+
+	unsigned int start;
+	unsigned int length;
+	char order;
+	char sign;
+	double scale;
+	double offset;
+	if (sscanf(line.c_str() + colon + 1, " %u|%u@%c%c (%lf,%lf)", &start, &length, &order, &sign, &scale, &offset) != 6)
+		return false;
+
+	if ((length == 0) || (length > 64) || ((order != '0') && (order != '1')) || ((sign != '+') && (sign != '-')))
+		return false;
+
+	signal.mUnit.clear();
+	size_t quote = line.find('"', colon);
+	if (quote != std::string::npos)
+	{
+		size_t end = line.find('"', quote + 1);
+		if (end != std::string::npos)
+			signal.mUnit = line.substr(quote + 1, end - quote - 1);
+	}
+
+	if (order == '1')
+	{
+		/* Intel: the start bit is the least significant one, the signal runs up through the following bytes */
+		signal.mLsbByte = start / 8;
+		signal.mShift = start % 8;
+		signal.mByteStep = 1;
+		signal.mNumBytes = (signal.mShift + length + 7) / 8;
+		signal.mLastByte = signal.mLsbByte + signal.mNumBytes - 1;
+	}
+	else
+	{
+		/* Motorola: the start bit is the most significant one, the signal runs down into the following bytes */
+		U32 msb_byte = start / 8;
+		U32 msb_bits = (start % 8) + 1;
+		if (length <= msb_bits)
+		{
+			signal.mLsbByte = msb_byte;
+			signal.mShift = msb_bits - length;
+		}
+		else
+		{
+			U32 remaining = length - msb_bits;
+			signal.mLsbByte = msb_byte + ((remaining + 7) / 8);
+			signal.mShift = (8 - (remaining % 8)) % 8;
+		}
+		signal.mByteStep = -1;
+		signal.mNumBytes = signal.mLsbByte - msb_byte + 1;
+		signal.mLastByte = signal.mLsbByte;
+	}
+
+	if (signal.mLastByte >= CAN_FD_MAX_DATA_BYTES)
+		return false;
+
+	signal.mMask = (length == 64) ? ~U64(0) : ((U64(1) << length) - 1);
+	signal.mSignBit = (sign == '-') ? (U64(1) << (length - 1)) : 0;
+	signal.mScale = scale;
+	signal.mOffset = offset;
+	return true;
+}
+
+bool CAN_FDDbc::IsLoaded()
+{
+	return (mMessages.empty() == false);
+}
+
+std::string CAN_FDDbc::GetError()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mError;
+}
+
+void CAN_FDDbc::AddFrame(CanDecodedFrame& frame)
+{
+	if (frame.mRemoteFrame == true)
+		return;
+
+	S32* index = mMessageIndex.Find(frame.mIdentifier, frame.mExtended);
+	if (index == NULL)
+		return;
+
+	const CanDbcMessage& message = mMessages[*index];
+	U32 num_signals = (U32)message.mSignals.size();
+
+	U32 multiplex_value = 0;
+	bool have_multiplex_value = false;
+	if (message.mMultiplexor >= 0)
+	{
+		const CanDbcSignal& multiplexor = message.mSignals[message.mMultiplexor];
+		if (multiplexor.mLastByte < frame.mNumDataBytes)
+		{
+			multiplex_value = U32(ExtractSignal(multiplexor, frame.mData));
+			have_multiplex_value = true;
+		}
+	}
+
+	CanDbcRecord record;
+	record.mStartingSample = frame.mStartingSample;
+	record.mBus = frame.mBus;
+	record.mMessage = (U32)*index;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	record.mValueOffset = mValues.size();
+	mRecords.push_back(record);
+
+	for (U32 i = 0; i < num_signals; i++)
+	{
+		const CanDbcSignal& signal = message.mSignals[i];
+
+		if ((signal.mLastByte >= frame.mNumDataBytes) ||
+			((signal.mMultiplexed == true) && ((have_multiplex_value == false) || (signal.mMultiplexValue != multiplex_value))))
+		{
+			mValues.push_back(std::numeric_limits<double>::quiet_NaN());
+			continue;
+		}
+
+		double raw = ExtractSignal(signal, frame.mData);
+		mValues.push_back((raw * signal.mScale) + signal.mOffset);
+	}
+}
+
+double CAN_FDDbc::ExtractSignal(const CanDbcSignal& signal, const U8* data)
+{
+	const U8* byte = data + signal.mLsbByte;
+	U64 raw = *byte >> signal.mShift;
+	U32 bits = 8 - signal.mShift;
+
+	for (U32 i = 1; i < signal.mNumBytes; i++)
+	{
+		byte += signal.mByteStep;
+		raw |= U64(*byte) << bits;
+		bits += 8;
+	}
+
+	raw &= signal.mMask;
+
+	if ((raw & signal.mSignBit) != 0)
+		return double(S64(raw | ~signal.mMask));
+	return double(raw);
+}
+
+U32 CAN_FDDbc::GetNumRecords()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return (U32)mRecords.size();
+}
+
+bool CAN_FDDbc::GetRecord(U32 index, CanDbcRecord& record, std::vector<double>& values)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (index >= mRecords.size())
+		return false;
+
+	record = mRecords[index];
+	U32 num_signals = (U32)mMessages[record.mMessage].mSignals.size();
+	values.assign(mValues.begin() + record.mValueOffset, mValues.begin() + record.mValueOffset + num_signals);
+	return true;
+}
+
+void CAN_FDDbc::GetMessages(std::vector<CanDbcMessage>& messages)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	messages = mMessages;
+}
@@ -0,0 +1,96 @@
+#ifndef CAN_FD_DBC
+#define CAN_FD_DBC
+
+#include <AnalyzerTypes.h>
+#include "CAN_FDDecodedFrame.h"
+#include "CAN_FDIdTable.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Signal extraction from a DBC file. Each signal is compiled once into a plan that reads its bytes */
+/* starting from the one holding its least significant bit, so Intel and Motorola signals take the same */
+/* path and only differ in the direction the bytes are walked. */
+
+class CanDbcSignal
+{
+public:
+	std::string mName;
+	std::string mUnit;
+
+	/* Extraction plan */
+	U32 mLsbByte;			/* byte holding the least significant bit */
+	S32 mByteStep;			/* +1 for Intel (little endian), -1 for Motorola (big endian) */
+	U32 mNumBytes;
+	U32 mShift;				/* position of the least significant bit in mLsbByte */
+	U32 mLastByte;			/* highest byte index read, frames shorter than this don't carry the signal */
+	U64 mMask;
+	U64 mSignBit;			/* 0 for unsigned signals */
+	double mScale;
+	double mOffset;
+
+	/* Multiplexing: the multiplexor signal selects which of the multiplexed signals are present */
+	bool mMultiplexor;
+	bool mMultiplexed;
+	U32 mMultiplexValue;
+};
+
+class CanDbcMessage
+{
+public:
+	CanDbcMessage() : mMultiplexor(-1) {}
+
+	std::string mName;
+	std::vector<CanDbcSignal> mSignals;
+	S32 mMultiplexor;		/* index of the multiplexor signal, -1 if none */
+};
+
+/* Values of one frame, the frame's signals in DBC order are in the value arena from mValueOffset. */
+/* Multiplexed signals that the frame doesn't carry are NaN. */
+class CanDbcRecord
+{
+public:
+	U64 mStartingSample;
+	U32 mBus;
+	U32 mMessage;
+	U64 mValueOffset;
+};
+
+class CAN_FDDbc
+{
+public:
+	CAN_FDDbc();
+	~CAN_FDDbc();
+
+	/* Replaces the loaded definitions and clears the records decoded with the old ones. An empty file */
+	/* name unloads them, and so does a file that can't be read, whose error is kept for the export. */
+	bool Load(const std::string& file, std::string& error);
+	bool IsLoaded();
+	std::string GetError();
+
+	/* Decoding thread */
+	void AddFrame(CanDecodedFrame& frame);
+
+	/* Exports, while decoding continues */
+	U32 GetNumRecords();
+	bool GetRecord(U32 index, CanDbcRecord& record, std::vector<double>& values);
+	void GetMessages(std::vector<CanDbcMessage>& messages);
+
+protected:
+	bool Parse(const std::string& file, CanIdTable<S32>& message_index, std::vector<CanDbcMessage>& messages, std::string& error);
+	bool ParseMessage(const std::string& line, U32& identifier, bool& extended, CanDbcMessage& message);
+	bool ParseSignal(const std::string& line, CanDbcSignal& signal);
+	double ExtractSignal(const CanDbcSignal& signal, const U8* data);
+
+	/* Messages by identifier, for the dispatch, and in file order, for the records. Only replaced by Load */
+	/* on the decoding thread, under the mutex for the exports. */
+	CanIdTable<S32> mMessageIndex;
+	std::vector<CanDbcMessage> mMessages;
+
+	std::mutex mMutex;
+	std::string mError;
+	std::vector<CanDbcRecord> mRecords;
+	std::vector<double> mValues;
+};
+
+#endif //CAN_FD_DBC
@@ -0,0 +1,588 @@
+#include "CAN_FDDecodeCache.h"
+#include "CAN_FDVarint.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Changed whenever the layout of the file changes, older files are then simply not used */
+static const char gCacheMagic[8] = { 'C', 'A', 'N', 'F', 'D', 'D', 'C', '2' };
+
+/* Each block starts with its length in 8 bytes, so a block cut short by an interrupted write can be told */
+#define CACHE_BLOCK_LENGTH_BYTES 8
+
+CAN_FDDecodeCache::CAN_FDDecodeCache()
+:	mRecording( false ),
+	mFingerprinting( false ),
+	mNumBuses( 0 ),
+	mSampleRate( 0 ),
+	mFingerprint( 0 ),
+	mLastBus( 0xFFFFFFFF ),
+	mLastSample( 0 ),
+	mFile( NULL ),
+	mHeaderWritten( false ),
+	mMapped( NULL ),
+	mMappedSize( 0 ),
+	mMapHandle( NULL ),
+	mFirstReplayBlock( 0 ),
+	mValidSize( 0 ),
+	mBlockOffset( 0 ),
+	mBlockEnd( 0 ),
+	mRead( NULL ),
+	mReadSample( 0 ),
+	mReplayProgressSample( 0 )
+{
+}
+
+CAN_FDDecodeCache::~CAN_FDDecodeCache()
+{
+	Reset();
+}
+
+void CAN_FDDecodeCache::Reset()
+{
+	UnmapFile();
+
+	if (mFile != NULL)
+	{
+		fclose(mFile);
+		mFile = NULL;
+	}
+
+	mRecording = false;
+	mFingerprinting = false;
+	mHeaderWritten = false;
+	mOps.clear();
+	mUnwritten.clear();
+	mReplayProgress.clear();
+}
+
+void CAN_FDDecodeCache::Start(const std::string& folder, U32 num_buses)
+{
+	Reset();
+
+	mFolder = folder;
+	mNumBuses = num_buses;
+	mFingerprint = gFnvOffsetBasis;
+	mLastBus = 0xFFFFFFFF;
+	mLastSample = 0;
+
+	mRecording = true;
+	mFingerprinting = true;
+}
+
+void CAN_FDDecodeCache::AddToFingerprint(const CanRawFrame& raw)
+{
+	U8 flags = (raw.mGarbage ? 1 : 0) | (raw.mCanError ? 2 : 0) | (raw.mTruncated ? 4 : 0);
+
+	mFingerprint = Fnv1a(mFingerprint, &raw.mBusIndex, sizeof(raw.mBusIndex));
+	mFingerprint = Fnv1a(mFingerprint, &raw.mStartOfFrame, sizeof(raw.mStartOfFrame));
+	mFingerprint = Fnv1a(mFingerprint, &flags, sizeof(flags));
+	if (raw.mRawBits.empty() == false)
+		mFingerprint = Fnv1a(mFingerprint, &raw.mRawBits[0], raw.mRawBits.size());
+}
+
+void CAN_FDDecodeCache::AppendHeader(std::vector<U8>& bytes)
+{
+	bytes.insert(bytes.end(), gCacheMagic, gCacheMagic + sizeof(gCacheMagic));
+	AppendVarint(bytes, mNumBuses);
+	AppendVarint(bytes, mSampleRate);
+	AppendVarint(bytes, CAN_DECODE_CACHE_FINGERPRINT_FRAMES);
+	AppendVarint(bytes, mFingerprint);
+	AppendVarint(bytes, mSettings.size());
+	bytes.insert(bytes.end(), mSettings.begin(), mSettings.end());
+}
+
+bool CAN_FDDecodeCache::Open(const std::string& settings, U32 sample_rate, U64 progress_sample, const std::vector<CanCacheBusProgress>& progress, bool allow_replay)
+{
+	mFingerprinting = false;
+	mSettings = settings;
+	mSampleRate = sample_rate;
+
+	/* The fingerprinted frames make up the first block, which has to match the file's exactly */
+	EndBlock(progress_sample, progress);
+
+	U64 key = Fnv1a(gFnvOffsetBasis, settings.c_str(), settings.size());
+	key = Fnv1a(key, &sample_rate, sizeof(sample_rate));
+	key = Fnv1a(key, &mNumBuses, sizeof(mNumBuses));
+	key = Fnv1a(key, &mFingerprint, sizeof(mFingerprint));
+
+	char name[64];
+	snprintf(name, sizeof(name), "%016llx.canfdcache", (unsigned long long)key);
+
+	mPath = mFolder;
+	if ((mPath.empty() == false) && (mPath[mPath.size() - 1] != '/') && (mPath[mPath.size() - 1] != '\\'))
+		mPath += "/";
+	mPath += name;
+
+	if ((allow_replay == false) || (MapFile(mPath) == false))
+		return false;
+
+	std::vector<U8> expected;
+	AppendHeader(expected);
+	expected.insert(expected.end(), mUnwritten.begin(), mUnwritten.end());
+
+	if ((mMappedSize < expected.size()) || (memcmp(mMapped, &expected[0], expected.size()) != 0))
+	{
+		UnmapFile();
+		return false;
+	}
+
+	/* Only whole blocks are used. Their operations are checked here, so replaying them can't fail part way. */
+	mFirstReplayBlock = expected.size();
+	mValidSize = mFirstReplayBlock;
+
+	U64 offset = mFirstReplayBlock;
+	for (; ; )
+	{
+		U64 ops_offset;
+		U64 end_offset;
+		U64 block_progress_sample;
+		std::vector<CanCacheBusProgress> block_progress;
+		if (ReadBlockHeader(offset, ops_offset, end_offset, block_progress_sample, block_progress) == false)
+			break;
+
+		const U8* p = mMapped + ops_offset;
+		const U8* end = mMapped + end_offset;
+		mReadSample = 0;
+
+		CanCacheRecord record;
+		bool valid = true;
+		while ((p < end) && (valid == true))
+			valid = ParseRecord(p, end, record);
+
+		if (valid == false)
+			break;
+
+		mValidSize = end_offset;
+		mReplayProgressSample = block_progress_sample;
+		mReplayProgress.swap(block_progress);
+		offset = end_offset;
+	}
+
+	if (mValidSize == mFirstReplayBlock)
+	{
+		UnmapFile();
+		return false;
+	}
+
+	return true;
+}
+
+bool CAN_FDDecodeCache::ReadBlockHeader(U64 offset, U64& ops_offset, U64& end_offset, U64& progress_sample, std::vector<CanCacheBusProgress>& progress)
+{
+	if ((mMappedSize - offset) < CACHE_BLOCK_LENGTH_BYTES)
+		return false;
+
+	U64 length = 0;
+	for (U32 i = 0; i < CACHE_BLOCK_LENGTH_BYTES; i++)
+		length |= U64(mMapped[offset + i]) << (8 * i);
+
+	offset += CACHE_BLOCK_LENGTH_BYTES;
+	if ((mMappedSize - offset) < length)
+		return false;
+
+	const U8* p = mMapped + offset;
+	const U8* end = p + length;
+
+	if (ReadBoundedVarint(p, end, progress_sample) == false)
+		return false;
+
+	progress.resize(mNumBuses);
+	for (U32 i = 0; i < mNumBuses; i++)
+	{
+		if ((ReadBoundedVarint(p, end, progress[i].mProgressSample) == false) ||
+			(ReadBoundedVarint(p, end, progress[i].mLastStartOfFrame) == false))
+			return false;
+	}
+
+	ops_offset = U64(p - mMapped);
+	end_offset = offset + length;
+	return true;
+}
+
+void CAN_FDDecodeCache::BeginReplay(bool accept)
+{
+	if (accept == false)
+	{
+		/* Replaced from the start at the next flush */
+		UnmapFile();
+		return;
+	}
+
+	mRecording = false;
+	mBlockOffset = mFirstReplayBlock;
+	mBlockEnd = mFirstReplayBlock;
+	mRead = NULL;
+}
+
+bool CAN_FDDecodeCache::ReadRecord(CanCacheRecord& record)
+{
+	for (; ; )
+	{
+		if ((mRead != NULL) && (mRead < (mMapped + mBlockEnd)))
+		{
+			const U8* end = mMapped + mBlockEnd;
+			ParseRecord(mRead, end, record);
+			return true;
+		}
+
+		if (mBlockEnd >= mValidSize)
+			break;
+
+		U64 ops_offset;
+		U64 progress_sample;
+		std::vector<CanCacheBusProgress> progress;
+		mBlockOffset = mBlockEnd;
+		ReadBlockHeader(mBlockOffset, ops_offset, mBlockEnd, progress_sample, progress);
+
+		mRead = mMapped + ops_offset;
+		mReadSample = 0;
+	}
+
+	/* Everything replayed, so recording carries on at the end of the file. A block cut short is dropped. */
+	std::vector<U8> valid;
+	bool truncate = (mValidSize < mMappedSize);
+	if (truncate == true)
+		valid.assign(mMapped, mMapped + mValidSize);
+
+	UnmapFile();
+
+	if (truncate == true)
+	{
+		mFile = fopen(mPath.c_str(), "wb");
+		if ((mFile != NULL) && (fwrite(&valid[0], 1, valid.size(), mFile) != valid.size()))
+		{
+			fclose(mFile);
+			mFile = NULL;
+		}
+	}
+	else
+	{
+		mFile = fopen(mPath.c_str(), "ab");
+	}
+
+	mHeaderWritten = true;
+	mUnwritten.clear();
+	mOps.clear();
+	mLastBus = 0xFFFFFFFF;
+	mLastSample = 0;
+	mRecording = (mFile != NULL);
+	return false;
+}
+
+bool CAN_FDDecodeCache::ParseRecord(const U8*& p, const U8* end, CanCacheRecord& record)
+{
+	U64 value;
+	U64 length;
+
+	if (p >= end)
+		return false;
+
+	U8 op = *p++;
+	if (op >= CacheOpCount)
+		return false;
+	record.mOp = (CanCacheOp)op;
+
+	switch (record.mOp)
+	{
+	case CacheOpBus:
+		if ((ReadBoundedVarint(p, end, value) == false) || (value >= mNumBuses))
+			return false;
+		record.mBusIndex = U32(value);
+		return true;
+
+	case CacheOpFrame:
+		if ((ReadSample(p, end, value) == false) || (ReadBoundedVarint(p, end, length) == false) || ((end - p) < 2))
+			return false;
+		record.mFrame.mStartingSampleInclusive = S64(value);
+		record.mFrame.mEndingSampleInclusive = S64(value + length);
+		record.mFrame.mType = *p++;
+		record.mFrame.mFlags = *p++;
+		return ReadBoundedVarint(p, end, record.mFrame.mData1);
+
+	case CacheOpMarkers:
+		if (ReadBoundedVarint(p, end, length) == false)
+			return false;
+
+		record.mMarkerSamples.clear();
+		record.mMarkerStuffed.clear();
+		for (U64 i = 0; i < length; i++)
+		{
+			if (ReadBoundedVarint(p, end, value) == false)
+				return false;
+
+			mReadSample += UnZigZag(value >> 1);
+			record.mMarkerSamples.push_back(mReadSample);
+			record.mMarkerStuffed.push_back(U8(value & 1));
+		}
+		return true;
+
+	case CacheOpCommitPacket:
+		if ((ReadBoundedVarint(p, end, value) == false) || (ReadSample(p, end, record.mStartingSample) == false))
+			return false;
+		record.mIdentifier = U32(value >> 1);
+		record.mExtended = ((value & 1) != 0);
+		return true;
+
+	case CacheOpCancelPacket:
+		return true;
+
+	case CacheOpStatisticsFrame:
+		if ((ReadBoundedVarint(p, end, value) == false) || (ReadSample(p, end, record.mStartingSample) == false) || (ReadBoundedVarint(p, end, length) == false))
+			return false;
+		record.mIdentifier = U32(value >> 1);
+		record.mExtended = ((value & 1) != 0);
+		record.mEndingSample = record.mStartingSample + length;
+		return true;
+
+	case CacheOpStatisticsError:
+		if ((ReadSample(p, end, record.mStartingSample) == false) || (ReadBoundedVarint(p, end, length) == false))
+			return false;
+		record.mEndingSample = record.mStartingSample + length;
+		return true;
+
+	case CacheOpDecodedFrame:
+	{
+		CanDecodedFrame& frame = record.mDecodedFrame;
+		if ((ReadBoundedVarint(p, end, value) == false) || (p >= end))
+			return false;
+		frame.mIdentifier = U32(value >> 1);
+		frame.mExtended = ((value & 1) != 0);
+
+		U8 flags = *p++;
+		frame.mFdFrame = ((flags & 1) != 0);
+		frame.mRemoteFrame = ((flags & 2) != 0);
+		frame.mAck = ((flags & 4) != 0);
+
+		if ((ReadSample(p, end, frame.mStartingSample) == false) || (ReadBoundedVarint(p, end, length) == false))
+			return false;
+		frame.mEndingSample = frame.mStartingSample + length;
+
+		if ((ReadBoundedVarint(p, end, value) == false) || (value > CAN_FD_MAX_DATA_BYTES) || (U64(end - p) < value))
+			return false;
+		frame.mNumDataBytes = U32(value);
+		memcpy(frame.mData, p, frame.mNumDataBytes);
+		p += frame.mNumDataBytes;
+		return true;
+	}
+
+	default:
+		return false;
+	}
+}
+
+bool CAN_FDDecodeCache::ReadSample(const U8*& p, const U8* end, U64& sample)
+{
+	U64 value;
+	if (ReadBoundedVarint(p, end, value) == false)
+		return false;
+
+	mReadSample += UnZigZag(value);
+	sample = mReadSample;
+	return true;
+}
+
+void CAN_FDDecodeCache::AddSample(U64 sample)
+{
+	/* Samples go up most of the time, but not between buses, hence zigzag */
+	AppendVarint(mOps, ZigZag(S64(sample - mLastSample)));
+	mLastSample = sample;
+}
+
+void CAN_FDDecodeCache::AddBus(U32 bus_index)
+{
+	if (bus_index == mLastBus)
+		return;
+
+	mOps.push_back(CacheOpBus);
+	AppendVarint(mOps, bus_index);
+	mLastBus = bus_index;
+}
+
+void CAN_FDDecodeCache::AddFrame(const Frame& frame)
+{
+	mOps.push_back(CacheOpFrame);
+	AddSample(U64(frame.mStartingSampleInclusive));
+	AppendVarint(mOps, U64(frame.mEndingSampleInclusive - frame.mStartingSampleInclusive));
+	mOps.push_back(frame.mType);
+	mOps.push_back(frame.mFlags);
+	AppendVarint(mOps, frame.mData1);
+}
+
+void CAN_FDDecodeCache::AddMarkers(const std::vector<U64>& samples, const std::vector<U8>& stuffed)
+{
+	mOps.push_back(CacheOpMarkers);
+	AppendVarint(mOps, samples.size());
+	for (U32 i = 0; i < samples.size(); i++)
+	{
+		AppendVarint(mOps, (ZigZag(S64(samples[i] - mLastSample)) << 1) | stuffed[i]);
+		mLastSample = samples[i];
+	}
+}
+
+void CAN_FDDecodeCache::AddCommitPacket(U32 identifier, bool extended, U64 starting_sample)
+{
+	mOps.push_back(CacheOpCommitPacket);
+	AppendVarint(mOps, (U64(identifier) << 1) | (extended ? 1 : 0));
+	AddSample(starting_sample);
+}
+
+void CAN_FDDecodeCache::AddCancelPacket()
+{
+	mOps.push_back(CacheOpCancelPacket);
+}
+
+void CAN_FDDecodeCache::AddStatisticsFrame(U32 identifier, bool extended, U64 starting_sample, U64 ending_sample)
+{
+	mOps.push_back(CacheOpStatisticsFrame);
+	AppendVarint(mOps, (U64(identifier) << 1) | (extended ? 1 : 0));
+	AddSample(starting_sample);
+	AppendVarint(mOps, ending_sample - starting_sample);
+}
+
+void CAN_FDDecodeCache::AddStatisticsError(U64 starting_sample, U64 ending_sample)
+{
+	mOps.push_back(CacheOpStatisticsError);
+	AddSample(starting_sample);
+	AppendVarint(mOps, ending_sample - starting_sample);
+}
+
+void CAN_FDDecodeCache::AddDecodedFrame(const CanDecodedFrame& frame)
+{
+	mOps.push_back(CacheOpDecodedFrame);
+	AppendVarint(mOps, (U64(frame.mIdentifier) << 1) | (frame.mExtended ? 1 : 0));
+	mOps.push_back((frame.mFdFrame ? 1 : 0) | (frame.mRemoteFrame ? 2 : 0) | (frame.mAck ? 4 : 0));
+	AddSample(frame.mStartingSample);
+	AppendVarint(mOps, frame.mEndingSample - frame.mStartingSample);
+	AppendVarint(mOps, frame.mNumDataBytes);
+	mOps.insert(mOps.end(), frame.mData, frame.mData + frame.mNumDataBytes);
+}
+
+void CAN_FDDecodeCache::EndBlock(U64 progress_sample, const std::vector<CanCacheBusProgress>& progress)
+{
+	std::vector<U8> head;
+	AppendVarint(head, progress_sample);
+	for (U32 i = 0; i < mNumBuses; i++)
+	{
+		AppendVarint(head, progress[i].mProgressSample);
+		AppendVarint(head, progress[i].mLastStartOfFrame);
+	}
+
+	U64 length = head.size() + mOps.size();
+	for (U32 i = 0; i < CACHE_BLOCK_LENGTH_BYTES; i++)
+		mUnwritten.push_back(U8(length >> (8 * i)));
+
+	mUnwritten.insert(mUnwritten.end(), head.begin(), head.end());
+	mUnwritten.insert(mUnwritten.end(), mOps.begin(), mOps.end());
+
+	/* Each block decodes on its own */
+	mOps.clear();
+	mLastBus = 0xFFFFFFFF;
+	mLastSample = 0;
+}
+
+void CAN_FDDecodeCache::Flush(U64 progress_sample, const std::vector<CanCacheBusProgress>& progress)
+{
+	if ((mRecording == false) || (mFingerprinting == true))
+		return;
+
+	if (mOps.empty() == false)
+		EndBlock(progress_sample, progress);
+
+	if (mUnwritten.empty() == true)
+		return;
+
+	if (mHeaderWritten == false)
+	{
+		std::vector<U8> header;
+		AppendHeader(header);
+		mUnwritten.insert(mUnwritten.begin(), header.begin(), header.end());
+
+		if (mFile != NULL)
+			fclose(mFile);
+		mFile = fopen(mPath.c_str(), "wb");
+		mHeaderWritten = true;
+	}
+
+	/* A cache that can't be written is no worse than having none */
+	if ((mFile == NULL) || (fwrite(&mUnwritten[0], 1, mUnwritten.size(), mFile) != mUnwritten.size()) || (fflush(mFile) != 0))
+	{
+		Reset();
+		return;
+	}
+
+	mUnwritten.clear();
+}
+
+bool CAN_FDDecodeCache::MapFile(const std::string& path)
+{
+	UnmapFile();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	HANDLE mapping = NULL;
+	if ((GetFileSizeEx(file, &size) != 0) && (size.QuadPart > 0))
+		mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+
+	if (mapping == NULL)
+		return false;
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	mMapHandle = mapping;
+	mMapped = (const U8*)view;
+	mMappedSize = U64(size.QuadPart);
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	void* view = MAP_FAILED;
+	if ((fstat(fd, &st) == 0) && (st.st_size > 0))
+		view = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (view == MAP_FAILED)
+		return false;
+
+	mMapped = (const U8*)view;
+	mMappedSize = U64(st.st_size);
+#endif
+
+	return true;
+}
+
+void CAN_FDDecodeCache::UnmapFile()
+{
+	if (mMapped == NULL)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mMapped);
+	CloseHandle((HANDLE)mMapHandle);
+	mMapHandle = NULL;
+#else
+	munmap((void*)mMapped, size_t(mMappedSize));
+#endif
+
+	mMapped = NULL;
+	mMappedSize = 0;
+}
@@ -0,0 +1,146 @@
+#ifndef CAN_FD_DECODE_CACHE
+#define CAN_FD_DECODE_CACHE
+
+#include <AnalyzerResults.h>
+#include <AnalyzerTypes.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "CAN_FDDecodedFrame.h"
+#include "CAN_FDFrameReader.h"
+
+/* Results of a decode kept in a file, so reopening the same capture with the same settings replays them */
+/* instead of decoding again. The file is a journal of the calls that put results into the results store */
+/* and the protocol layers, in blocks that each end with where every bus's reader had got to. */
+/* */
+/* A capture is recognised by its first CAN_DECODE_CACHE_FINGERPRINT_FRAMES raw frames, which are */
+/* decoded as usual and hashed together with the sample rate and the decode settings. The file name */
+/* comes from that hash. Before anything is replayed, the last start of frame on each bus is checked */
+/* against the capture. */
+
+#define CAN_DECODE_CACHE_FINGERPRINT_FRAMES 32
+
+enum CanCacheOp
+{
+	CacheOpBus,
+	CacheOpFrame,
+	CacheOpMarkers,
+	CacheOpCommitPacket,
+	CacheOpCancelPacket,
+	CacheOpStatisticsFrame,
+	CacheOpStatisticsError,
+	CacheOpDecodedFrame,
+	CacheOpCount
+};
+
+/* Where the reader of one bus had got to at the end of a block */
+class CanCacheBusProgress
+{
+public:
+	U64 mProgressSample;
+	U64 mLastStartOfFrame;	/* 0 while the bus has had no frames */
+};
+
+/* One operation read back from the file. The fields used depend on mOp. */
+class CanCacheRecord
+{
+public:
+	CanCacheOp mOp;
+	U32 mBusIndex;						/* CacheOpBus */
+	Frame mFrame;						/* CacheOpFrame, mData2 is left to the analyzer */
+	std::vector<U64> mMarkerSamples;	/* CacheOpMarkers */
+	std::vector<U8> mMarkerStuffed;
+	U32 mIdentifier;					/* packets and statistics */
+	bool mExtended;
+	U64 mStartingSample;
+	U64 mEndingSample;
+	CanDecodedFrame mDecodedFrame;		/* CacheOpDecodedFrame, mBus and mPacketId are left to the analyzer */
+};
+
+/* Recorded and replayed by the analyzer's worker thread only */
+class CAN_FDDecodeCache
+{
+public:
+	CAN_FDDecodeCache();
+	~CAN_FDDecodeCache();
+
+	/* Closes the file and stops recording */
+	void Reset();
+
+	/* Starts recording into memory and fingerprinting, the file is found or created by Open */
+	void Start(const std::string& folder, U32 num_buses);
+	void AddToFingerprint(const CanRawFrame& raw);
+
+	/* Ends the fingerprinted block. Returns true if the file for this capture and these settings exists */
+	/* and has more to replay, or false to carry on recording into a new file. Without allow_replay an */
+	/* existing file is always replaced. */
+	bool Open(const std::string& settings, U32 sample_rate, U64 progress_sample, const std::vector<CanCacheBusProgress>& progress, bool allow_replay);
+
+	/* Where the readers were at the end of the file, valid once Open returned true */
+	const std::vector<CanCacheBusProgress>& GetReplayProgress() const { return mReplayProgress; }
+	U64 GetReplayProgressSample() const { return mReplayProgressSample; }
+
+	/* After Open returned true: with accept, reads the records back one at a time and carries on */
+	/* recording after them once ReadRecord has returned false. Without, the file is replaced instead. */
+	void BeginReplay(bool accept);
+	bool ReadRecord(CanCacheRecord& record);
+
+	bool IsRecording() const { return mRecording; }
+
+	/* Recording, from the worker thread as the results are produced */
+	void AddBus(U32 bus_index);
+	void AddFrame(const Frame& frame);
+	void AddMarkers(const std::vector<U64>& samples, const std::vector<U8>& stuffed);
+	void AddCommitPacket(U32 identifier, bool extended, U64 starting_sample);
+	void AddCancelPacket();
+	void AddStatisticsFrame(U32 identifier, bool extended, U64 starting_sample, U64 ending_sample);
+	void AddStatisticsError(U64 starting_sample, U64 ending_sample);
+	void AddDecodedFrame(const CanDecodedFrame& frame);
+
+	/* Ends the block and writes everything not yet in the file, with each commit of the results. Only */
+	/* between two raw frames. */
+	void Flush(U64 progress_sample, const std::vector<CanCacheBusProgress>& progress);
+
+protected: //functions
+	void AddSample(U64 sample);
+	bool ReadSample(const U8*& p, const U8* end, U64& sample);
+	bool ParseRecord(const U8*& p, const U8* end, CanCacheRecord& record);
+	void EndBlock(U64 progress_sample, const std::vector<CanCacheBusProgress>& progress);
+	void AppendHeader(std::vector<U8>& bytes);
+	bool MapFile(const std::string& path);
+	void UnmapFile();
+	bool ReadBlockHeader(U64 offset, U64& ops_offset, U64& end_offset, U64& progress_sample, std::vector<CanCacheBusProgress>& progress);
+
+protected: //vars
+	bool mRecording;
+	bool mFingerprinting;
+	std::string mFolder;
+	std::string mPath;
+	U32 mNumBuses;
+	U32 mSampleRate;
+	std::string mSettings;
+	U64 mFingerprint;
+
+	/* Operations of the current block, and whole blocks waiting to be written */
+	std::vector<U8> mOps;
+	std::vector<U8> mUnwritten;
+	U32 mLastBus;
+	U64 mLastSample;
+	FILE* mFile;
+	bool mHeaderWritten;
+
+	/* The mapped file while replaying */
+	const U8* mMapped;
+	U64 mMappedSize;
+	void* mMapHandle;
+	U64 mFirstReplayBlock;
+	U64 mValidSize;
+	U64 mBlockOffset;
+	U64 mBlockEnd;
+	const U8* mRead;
+	U64 mReadSample;
+	std::vector<CanCacheBusProgress> mReplayProgress;
+	U64 mReplayProgressSample;
+};
+
+#endif //CAN_FD_DECODE_CACHE
@@ -0,0 +1,27 @@
+#ifndef CAN_FD_DECODED_FRAME
+#define CAN_FD_DECODED_FRAME
+
+#include <AnalyzerTypes.h>
+
+#define CAN_FD_MAX_DATA_BYTES 64
+
+/* A complete frame as decoded by AnalyzeRawFrame, handed to the protocol layers that sit on top of it */
+class CanDecodedFrame
+{
+public:
+	U32 mBus;
+	U32 mIdentifier;
+	bool mExtended;
+	bool mFdFrame;
+	bool mRemoteFrame;
+	bool mAck;
+
+	U64 mStartingSample;
+	U64 mEndingSample;
+	U64 mPacketId;
+
+	U32 mNumDataBytes;
+	U8 mData[CAN_FD_MAX_DATA_BYTES];
+};
+
+#endif //CAN_FD_DECODED_FRAME
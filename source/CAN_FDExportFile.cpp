@@ -0,0 +1,184 @@
+#include "CAN_FDExportFile.h"
+#include <AnalyzerHelpers.h>
+#include <cstring>
+
+CAN_FDExportFile::CAN_FDExportFile()
+:	mFile( NULL ),
+	mCompress( false )
+{
+#ifdef CAN_FD_HAVE_ZLIB
+	mPending = false;
+	mFinish = false;
+#endif
+}
+
+CAN_FDExportFile::~CAN_FDExportFile()
+{
+	End();
+}
+
+bool CAN_FDExportFile::IsCompressionAvailable()
+{
+#ifdef CAN_FD_HAVE_ZLIB
+	return true;
+#else
+	return false;
+#endif
+}
+
+void CAN_FDExportFile::Start(const char* file, bool compress)
+{
+	mCompress = (compress == true) && (IsCompressionAvailable() == true);
+	mBlock.clear();
+	mBlock.reserve(CAN_EXPORT_BLOCK_BYTES * 2);
+
+	std::string file_name = file;
+	if (mCompress == true)
+	{
+		if ((file_name.size() < 3) || (file_name.compare(file_name.size() - 3, 3, ".gz") != 0))
+			file_name += ".gz";
+	}
+
+	mFile = AnalyzerHelpers::StartFile(file_name.c_str());
+
+#ifdef CAN_FD_HAVE_ZLIB
+	if (mCompress == true)
+	{
+		memset(&mStream, 0, sizeof(mStream));
+
+		/* The fastest level, as compression rather than formatting sets the pace. 15 window bits, */
+		/* plus 16 for a gzip header and trailer rather than a zlib one. */
+		if (deflateInit2(&mStream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		{
+			mCompress = false;
+			return;
+		}
+
+		mPendingBlock.clear();
+		mPendingBlock.reserve(CAN_EXPORT_BLOCK_BYTES * 2);
+		mDeflated.resize(CAN_EXPORT_BLOCK_BYTES);
+
+		mPending = false;
+		mFinish = false;
+		mThread = std::thread(&CAN_FDExportFile::CompressThread, this);
+	}
+#endif
+}
+
+void CAN_FDExportFile::Append(std::stringstream& ss)
+{
+	std::string text = ss.str();
+	ss.str(std::string());
+
+	mBlock.insert(mBlock.end(), text.begin(), text.end());
+	if (mBlock.size() >= CAN_EXPORT_BLOCK_BYTES)
+		WriteBlock();
+}
+
+void CAN_FDExportFile::WriteBlock()
+{
+	if (mBlock.empty() == true)
+		return;
+
+#ifdef CAN_FD_HAVE_ZLIB
+	if (mCompress == true)
+	{
+		/* The two blocks are swapped rather than copied, once the previous one has been compressed */
+		std::unique_lock<std::mutex> lock(mMutex);
+		while (mPending == true)
+			mCondition.wait(lock);
+
+		mPendingBlock.swap(mBlock);
+		mPending = true;
+		mCondition.notify_all();
+
+		mBlock.clear();
+		return;
+	}
+#endif
+
+	AnalyzerHelpers::AppendToFile((U8*)&mBlock[0], (U32)mBlock.size(), mFile);
+	mBlock.clear();
+}
+
+void CAN_FDExportFile::End()
+{
+	if (mFile == NULL)
+		return;
+
+	WriteBlock();
+
+#ifdef CAN_FD_HAVE_ZLIB
+	if (mCompress == true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mFinish = true;
+			mCondition.notify_all();
+		}
+		mThread.join();
+		deflateEnd(&mStream);
+	}
+#endif
+
+	AnalyzerHelpers::EndFile(mFile);
+	mFile = NULL;
+}
+
+#ifdef CAN_FD_HAVE_ZLIB
+void CAN_FDExportFile::CompressThread()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (; ; )
+	{
+		while ((mPending == false) && (mFinish == false))
+			mCondition.wait(lock);
+
+		if (mPending == true)
+		{
+			lock.unlock();
+			Deflate(mPendingBlock, Z_NO_FLUSH);
+			mPendingBlock.clear();
+			lock.lock();
+
+			mPending = false;
+			mCondition.notify_all();
+			continue;
+		}
+
+		/* Finishing only once the last block has been compressed */
+		lock.unlock();
+		std::vector<char> none;
+		Deflate(none, Z_FINISH);
+		return;
+	}
+}
+
+void CAN_FDExportFile::Deflate(std::vector<char>& block, int flush)
+{
+	mStream.next_in = (Bytef*)(block.empty() ? NULL : &block[0]);
+	mStream.avail_in = (uInt)block.size();
+
+	for (; ; )
+	{
+		mStream.next_out = (Bytef*)&mDeflated[0];
+		mStream.avail_out = (uInt)mDeflated.size();
+
+		int result = deflate(&mStream, flush);
+
+		U32 deflated = U32(mDeflated.size() - mStream.avail_out);
+		if (deflated > 0)
+			AnalyzerHelpers::AppendToFile((U8*)&mDeflated[0], deflated, mFile);
+
+		if (flush == Z_FINISH)
+		{
+			if (result != Z_OK)
+				return;
+		}
+		else if (mStream.avail_out != 0)
+		{
+			return;
+		}
+	}
+}
+#endif
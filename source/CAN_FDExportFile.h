@@ -0,0 +1,65 @@
+#ifndef CAN_FD_EXPORT_FILE
+#define CAN_FD_EXPORT_FILE
+
+#include <AnalyzerTypes.h>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef CAN_FD_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/* Export text is gathered into blocks of about this many bytes before being written or compressed */
+#define CAN_EXPORT_BLOCK_BYTES ( 256 * 1024 )
+
+/* Output of the exports, either written as it is or gzip compressed as it is written. Compression runs */
+/* on a thread of its own with two blocks: the export formats into one while the other is compressed. */
+/* Builds without zlib (CAN_FD_HAVE_ZLIB undefined) always write the text as it is. */
+class CAN_FDExportFile
+{
+public:
+	CAN_FDExportFile();
+	~CAN_FDExportFile();
+
+	static bool IsCompressionAvailable();
+
+	/* With compress, ".gz" is added to the file name unless it already ends in it */
+	void Start(const char* file, bool compress);
+
+	/* Takes the text out of the stream, leaving it empty for the next row */
+	void Append(std::stringstream& ss);
+	void End();
+
+protected: //functions
+	void WriteBlock();
+
+#ifdef CAN_FD_HAVE_ZLIB
+	void CompressThread();
+	void Deflate(std::vector<char>& block, int flush);
+#endif
+
+protected: //vars
+	void* mFile;
+	bool mCompress;
+
+	std::vector<char> mBlock;	/* being filled by the export */
+
+#ifdef CAN_FD_HAVE_ZLIB
+	/* Owned by the compression thread while mPending is set */
+	std::vector<char> mPendingBlock;
+	std::vector<char> mDeflated;
+	z_stream mStream;
+
+	std::thread mThread;
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mPending;
+	bool mFinish;
+#endif
+};
+
+#endif //CAN_FD_EXPORT_FILE
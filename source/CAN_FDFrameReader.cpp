@@ -0,0 +1,488 @@
+#include "CAN_FDFrameReader.h"
+#include "CAN_FDAnalyzer.h"
+#include "CAN_FDAnalyzerSettings.h"
+
+CAN_FDFrameReader::CAN_FDFrameReader(CAN_FDAnalyzer* analyzer, CAN_FDAnalyzerSettings* settings, CanPerfCounters& perf, CanTrace& trace)
+:	mAnalyzer( analyzer ),
+	mSettings( settings ),
+	mPerf( perf ),
+	mTrace( trace ),
+	mBuses( NULL ),
+	mCurrentBusIndex( 0 ),
+	mBusHorizon( 0 ),
+	mCommitWhenCaughtUp( false ),
+	mLevelStartEarliest( 0 ),
+	mLevelStartLatest( 0 ),
+	mCAN_FD( NULL ),
+	mSampleOffsets( NULL )
+{
+}
+
+void CAN_FDFrameReader::Start(std::vector<CanBusState>& buses, bool commit_when_caught_up)
+{
+	mBuses = &buses;
+	mCommitWhenCaughtUp = commit_when_caught_up;
+
+	/* Get to an inter-frame gap at the slow timing */
+	for (U32 i = 0; i < mBuses->size(); i++)
+	{
+		SelectBus(i);
+		WaitFor7RecessiveBits();
+	}
+
+	ResetBusHorizon();
+}
+
+void CAN_FDFrameReader::Continue(std::vector<CanBusState>& buses, bool commit_when_caught_up)
+{
+	mBuses = &buses;
+	mCommitWhenCaughtUp = commit_when_caught_up;
+
+	ResetBusHorizon();
+}
+
+bool CAN_FDFrameReader::AdvanceToStartOfFrame(CanBusState& bus, U64 start_of_frame, bool check_capture_end)
+{
+	AnalyzerChannelData* channel = bus.mChannelData;
+	if (start_of_frame <= channel->GetSampleNumber())
+		return false;
+
+	/* Edge by edge, so a capture that ends sooner than the one decoded before is noticed rather than */
+	/* waited on. The channel then only moves up to the next edge. */
+	while (check_capture_end == true)
+	{
+		if (channel->DoMoreTransitionsExistInCurrentData() == false)
+			return false;
+
+		if (channel->GetSampleOfNextEdge() >= (start_of_frame - 1))
+			break;
+
+		CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+		channel->AdvanceToNextEdge();
+	}
+
+	CAN_PERF_COUNT(mPerf, PerfAdvanceToAbsPosition);
+	channel->AdvanceToAbsPosition(start_of_frame - 1);
+
+	CAN_PERF_COUNT(mPerf, PerfWouldAdvance);
+	return (channel->GetBitState() == bus.mRecessive) && (channel->WouldAdvancingCauseTransition(1) == true);
+}
+
+void CAN_FDFrameReader::SkipTo(std::vector<CanBusState>& buses, U32 index, U64 sample)
+{
+	mBuses = &buses;
+	SelectBus(index);
+
+	if (sample > mCAN_FD->GetSampleNumber())
+	{
+		CAN_PERF_COUNT(mPerf, PerfAdvanceToAbsPosition);
+		mCAN_FD->AdvanceToAbsPosition(sample);
+	}
+
+	WaitFor7RecessiveBits();
+}
+
+void CAN_FDFrameReader::ResetBusHorizon()
+{
+	/* Every bus is idle up to where its channel is */
+	mBusHorizon = 0;
+	for (U32 i = 0; i < mBuses->size(); i++)
+	{
+		U64 sample = (*mBuses)[i].mChannelData->GetSampleNumber();
+		if ((i == 0) || (sample < mBusHorizon))
+			mBusHorizon = sample;
+	}
+}
+
+void CAN_FDFrameReader::ReadRawFrame(CanRawFrame& raw)
+{
+	for (; ; )
+	{
+		SelectBus(GetNextBus());
+
+		if (mCAN_FD->GetBitState() == mRecessive)
+		{
+			CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+			mCAN_FD->AdvanceToNextEdge();
+		}
+
+		//we're at the first DOMINANT edge of the frame
+		if (mGlitchSamples > 0)
+		{
+			CAN_PERF_COUNT(mPerf, PerfWouldAdvance);
+			if (mCAN_FD->WouldAdvancingCauseTransition(mGlitchSamples) == true)
+			{
+				//too short for a start of frame, just a spike on the idle bus.
+				CAN_PERF_COUNT(mPerf, PerfGlitchesIgnored);
+				CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+				mCAN_FD->AdvanceToNextEdge();
+				continue;
+			}
+		}
+
+		break;
+	}
+
+	GetRawFrame(raw);
+
+	if (raw.mGarbage == true)
+	{
+		/* Noise rather than a frame, none of it goes into the results */
+		CAN_PERF_COUNT(mPerf, PerfGarbageBailouts);
+		SkipNoise();
+		WaitFor7RecessiveBits();
+	}
+	else if (raw.mCanError == true)
+	{
+		WaitFor7RecessiveBits();
+	}
+	else if (raw.mTruncated == true)
+	{
+		SkipRestOfFrame(raw);
+	}
+
+	raw.mProgressSample = mCAN_FD->GetSampleNumber();
+	raw.mCaughtUp = (mCAN_FD->DoMoreTransitionsExistInCurrentData() == false);
+}
+
+void CAN_FDFrameReader::SelectBus(U32 index)
+{
+	CanBusState& bus = (*mBuses)[index];
+	mCurrentBusIndex = index;
+
+	mCAN_FD = bus.mChannelData;
+	mRecessive = bus.mRecessive;
+	mDominant = bus.mDominant;
+	mPolarity = bus.mPolarity;
+	mBitRateFactor = bus.mBitRateFactor;
+	mNumSamplesIn7Bits = bus.mNumSamplesIn7Bits;
+	mMaxRawBits = bus.mMaxRawBits;
+	mGlitchSamples = bus.mGlitchSamples;
+	mSampleOffsets = &bus.mSampleOffsets[0];
+}
+
+U32 CAN_FDFrameReader::GetNextBus()
+{
+	std::vector<CanBusState>& buses = *mBuses;
+
+	if (buses.size() == 1)
+		return 0;
+
+	/* Every bus is either sitting on the dominant edge of its next frame, or idle and known to stay */
+	/* recessive up to the horizon. Idle buses are searched up to the horizon, which is pushed further out */
+	/* while they all stay idle. A frame's results start after its start of frame bit, which is longer on */
+	/* a slower bus, so the buses are ordered by where that bit ends. The horizon is taken out to the */
+	/* earliest such sample before that bus is chosen, so no other bus can start a frame whose results */
+	/* would come first, and packets from the different buses are added in time order. The rest of a */
+	/* frame's fields stay with it, so they can still overlap the next frame on another bus. */
+	U64 step = buses[0].mNumSamplesIn7Bits;
+	for (U32 i = 1; i < buses.size(); i++)
+	{
+		if (buses[i].mNumSamplesIn7Bits < step)
+			step = buses[i].mNumSamplesIn7Bits;
+	}
+
+	for (; ; )
+	{
+		U32 next_bus = 0;
+		U64 next_start = 0;
+		bool found = false;
+
+		for (U32 i = 0; i < buses.size(); i++)
+		{
+			AnalyzerChannelData* channel = buses[i].mChannelData;
+
+			if ((channel->GetBitState() != buses[i].mDominant) && (channel->GetSampleNumber() < mBusHorizon))
+			{
+				CAN_PERF_COUNT(mPerf, PerfWouldAdvance);
+				if (channel->WouldAdvancingToAbsPositionCauseTransition(mBusHorizon) == true)
+				{
+					CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+					channel->AdvanceToNextEdge();
+				}
+			}
+
+			if (channel->GetBitState() != buses[i].mDominant)
+				continue;
+
+			U64 results_start = channel->GetSampleNumber() + buses[i].mSampleOffsets[1];
+			if ((found == false) || (results_start < next_start))
+			{
+				next_bus = i;
+				next_start = results_start;
+				found = true;
+			}
+		}
+
+		if (found == true)
+		{
+			if (next_start <= mBusHorizon)
+				return next_bus;
+
+			/* Searches the idle buses again, up to where the chosen frame's results start */
+			mBusHorizon = next_start;
+			continue;
+		}
+
+		mBusHorizon += step;
+		if (step < 0x80000000)
+			step *= 2;
+
+		mAnalyzer->CheckIfThreadShouldExit();
+	}
+}
+
+void CAN_FDFrameReader::WaitFor7RecessiveBits()
+{
+	CAN_PERF_TIME(mPerf, PerfTimeIdleWait);
+	CanTraceScope trace_scope(mTrace, "Idle wait", mCAN_FD);
+
+	if (mCAN_FD->GetBitState() == mDominant)
+	{
+		CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+		mCAN_FD->AdvanceToNextEdge();
+	}
+
+	U64 idle_start = mCAN_FD->GetSampleNumber();
+
+	for (; ; )
+	{
+		CAN_PERF_COUNT(mPerf, PerfWouldAdvance);
+		if (mCAN_FD->WouldAdvancingToAbsPositionCauseTransition(idle_start + mNumSamplesIn7Bits) == false)
+			return;
+
+		CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+		mCAN_FD->AdvanceToNextEdge();
+
+		//dominant spikes shorter than the glitch filter don't end the idle period.
+		if (mGlitchSamples > 0)
+		{
+			CAN_PERF_COUNT(mPerf, PerfWouldAdvance);
+			if (mCAN_FD->WouldAdvancingCauseTransition(mGlitchSamples) == true)
+			{
+				CAN_PERF_COUNT(mPerf, PerfGlitchesIgnored);
+				CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+				mCAN_FD->AdvanceToNextEdge();
+				continue;
+			}
+		}
+
+		CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+		mCAN_FD->AdvanceToNextEdge();
+		idle_start = mCAN_FD->GetSampleNumber();
+	}
+}
+
+void CAN_FDFrameReader::SkipRestOfFrame(CanRawFrame& raw)
+{
+	/* In skim mode the rest of the frame is skipped by edges, without sampling the data and CRC bits. */
+	/* Stuffing keeps every dominant run in a frame under 6 slow bits, so a longer one is an error flag, */
+	/* and the frame is then cancelled as a sampled one would be. Otherwise the frame ends 7 slow bits */
+	/* into the recessive run that follows its last dominant edge. The run the raw frame ended in is */
+	/* timed from the bounds GetRawFrame left, so an error flag is never seen where there is none and */
+	/* the idle time never runs into the next frame. */
+	CAN_PERF_TIME(mPerf, PerfTimeIdleWait);
+	CanTraceScope trace_scope(mTrace, "Skim skip", mCAN_FD);
+
+	U64 error_flag_samples = (U64(mNumSamplesIn7Bits) * 6) / 7;
+	U64 level_start = (mCAN_FD->GetBitState() == mDominant) ? mLevelStartLatest : mLevelStartEarliest;
+
+	for (; ; )
+	{
+		if (mCAN_FD->GetBitState() == mDominant)
+		{
+			CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+			mCAN_FD->AdvanceToNextEdge();
+
+			U64 dominant_end = mCAN_FD->GetSampleNumber();
+			if ((dominant_end - level_start) >= error_flag_samples)
+			{
+				raw.mCanError = true;
+				raw.mErrorStartingSample = level_start;
+				raw.mErrorEndingSample = dominant_end;
+				WaitFor7RecessiveBits();
+				return;
+			}
+
+			level_start = dominant_end;
+		}
+
+		CAN_PERF_COUNT(mPerf, PerfWouldAdvance);
+		if (mCAN_FD->WouldAdvancingToAbsPositionCauseTransition(level_start + mNumSamplesIn7Bits) == false)
+		{
+			raw.mTruncatedEndingSample = level_start + mNumSamplesIn7Bits;
+			return;
+		}
+
+		CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+		mCAN_FD->AdvanceToNextEdge();
+
+		//dominant spikes shorter than the glitch filter don't end the recessive run.
+		if (mGlitchSamples > 0)
+		{
+			CAN_PERF_COUNT(mPerf, PerfWouldAdvance);
+			if (mCAN_FD->WouldAdvancingCauseTransition(mGlitchSamples) == true)
+			{
+				CAN_PERF_COUNT(mPerf, PerfGlitchesIgnored);
+				CAN_PERF_COUNT(mPerf, PerfAdvanceToNextEdge);
+				mCAN_FD->AdvanceToNextEdge();
+				continue;
+			}
+		}
+
+		level_start = mCAN_FD->GetSampleNumber();
+	}
+}
+
+void CAN_FDFrameReader::SkipNoise()
+{
+	/* Step through the burst a 7 bit window at a time rather than edge by edge, until a whole window */
+	/* passes without any transitions */
+	CAN_PERF_TIME(mPerf, PerfTimeIdleWait);
+	CanTraceScope trace_scope(mTrace, "Noise skip", mCAN_FD);
+
+	for (; ; )
+	{
+		CAN_PERF_COUNT(mPerf, PerfAdvanceToAbsPosition);
+		if (mCAN_FD->AdvanceToAbsPosition(mCAN_FD->GetSampleNumber() + mNumSamplesIn7Bits) == 0)
+			return;
+	}
+}
+
+BitState CAN_FDFrameReader::GetFilteredBitState(U64 sample, U32& transitions)
+{
+	/* A pulse shorter than the filter can cover at most one of three samples spaced by the filter width, */
+	/* so the majority of them is the level without the glitch */
+	CAN_PERF_ADD(mPerf, PerfAdvanceToAbsPosition, 3);
+
+	transitions = mCAN_FD->AdvanceToAbsPosition(sample - mGlitchSamples);
+	BitState before = mCAN_FD->GetBitState();
+
+	transitions += mCAN_FD->AdvanceToAbsPosition(sample);
+	BitState at = mCAN_FD->GetBitState();
+
+	transitions += mCAN_FD->AdvanceToAbsPosition(sample + mGlitchSamples);
+	BitState after = mCAN_FD->GetBitState();
+
+	if (before == after)
+		return before;
+	return at;
+}
+
+void CAN_FDFrameReader::GetRawFrame(CanRawFrame& raw)
+{
+	CAN_PERF_TIME(mPerf, PerfTimeRawFrame);
+	CanTraceScope trace_scope(mTrace, "Raw frame", mCAN_FD);
+
+	raw.mBusIndex = mCurrentBusIndex;
+	raw.mCanError = false;
+	raw.mTruncated = false;
+	raw.mGarbage = false;
+	raw.mRawBits.clear();
+
+	U32 recessive_count = 0;
+	U32 dominant_count = 0;
+
+	if (mCAN_FD->GetBitState() != mDominant)
+		AnalyzerHelpers::Assert("GetFrameOrError assumes we start DOMINANT");
+
+	U64 start_of_frame = mCAN_FD->GetSampleNumber();
+	raw.mStartOfFrame = start_of_frame;
+	mLevelStartEarliest = start_of_frame;
+	mLevelStartLatest = start_of_frame;
+	U8 last_level = CAN_DOMINANT;
+
+	U32 i = 0;
+	U32 j = 0;
+	//what we're going to do now is capture a sequence up until we get 7 recessive bits (at slow timing) in a row.
+	for (; ; )
+	{
+		if (i >= mMaxRawBits)
+		{
+			if (mSettings->mSkimMode == true)
+			{
+				//we have everything up to the control field, the rest of the frame is skipped.
+				raw.mTruncated = true;
+				break;
+			}
+
+			//we are in garbage data most likely, lets get out of here.
+			raw.mGarbage = true;
+			break;
+		}
+
+		U32 transitions;
+		BitState bit;
+
+		CAN_PERF_COUNT(mPerf, PerfRawBitsSampled);
+
+		if (mGlitchSamples == 0)
+		{
+			CAN_PERF_COUNT(mPerf, PerfAdvanceToAbsPosition);
+			transitions = mCAN_FD->AdvanceToAbsPosition(start_of_frame + mSampleOffsets[i]);
+			bit = mCAN_FD->GetBitState();
+		}
+		else
+		{
+			bit = GetFilteredBitState(start_of_frame + mSampleOffsets[i], transitions);
+		}
+		i++;
+
+		if (transitions > NOISE_EDGES_PER_BIT)
+		{
+			//far too many edges for one bit, this is a noise burst.
+			raw.mGarbage = true;
+			break;
+		}
+
+		if ((transitions > 0) && (mCommitWhenCaughtUp == true))
+			mAnalyzer->CommitResultsIfCaughtUp(mCAN_FD);
+
+		/* Stored as the bus level, so the decoder doesn't need to know the polarity */
+		U8 level = U8(bit) ^ mPolarity;
+		raw.mRawBits.push_back(level);
+
+		if (level != last_level)
+		{
+			mLevelStartEarliest = (i >= 2) ? (start_of_frame + mSampleOffsets[i - 2] + 1) : start_of_frame;
+			mLevelStartLatest = start_of_frame + mSampleOffsets[i - 1];
+			last_level = level;
+		}
+
+		if (level == CAN_DOMINANT)
+		{
+			//the bit is DOMINANT
+			dominant_count++;
+			recessive_count = 0;
+
+			if (dominant_count == (6 * mBitRateFactor))
+			{
+				//we have detected an error.
+
+				raw.mCanError = true;
+				raw.mErrorStartingSample = start_of_frame + mSampleOffsets[i - (5 * mBitRateFactor)];
+				raw.mErrorEndingSample = start_of_frame + mSampleOffsets[i];	/* one past the last raw bit at most, see InitSampleOffsets */
+
+				//don't use any of these error bits in analysis.
+				for (j = 0; j < (6 * mBitRateFactor); j++)
+				{
+					raw.mRawBits.pop_back();
+				}
+
+				break;
+			}
+		}
+		else
+		{
+			//the bit is RECESSIVE
+			recessive_count++;
+			dominant_count = 0;
+
+			if (recessive_count == (7 * mBitRateFactor))
+			{
+				//we're done.
+				break;
+			}
+		}
+	}
+}
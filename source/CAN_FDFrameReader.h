@@ -0,0 +1,128 @@
+#ifndef CAN_FD_FRAME_READER_H
+#define CAN_FD_FRAME_READER_H
+
+#include <AnalyzerChannelData.h>
+#include <AnalyzerTypes.h>
+#include <vector>
+#include "CAN_FDPerfCounters.h"
+#include "CAN_FDTrace.h"
+
+/* More edges than this between two sample points can't be a CAN signal, even with ringing on the edges */
+#define NOISE_EDGES_PER_BIT 4
+
+/* Bus levels of the raw bits, whatever the polarity of the capture */
+#define CAN_DOMINANT 0
+#define CAN_RECESSIVE 1
+
+/* Decoder state that differs between the buses decoded in one pass */
+class CanBusState
+{
+public:
+	U32 mBus;
+	Channel mChannel;
+	AnalyzerChannelData* mChannelData;
+
+	/* From the settings, or as detected */
+	U32 mBitRateHdr;
+	U32 mBitRateData;
+	bool mInverted;
+
+	BitState mRecessive;
+	BitState mDominant;
+	U8 mPolarity;			/* XORed with a sampled BitState to give the bus level */
+
+	U32 mBitRateFactor;
+	U32 mNumSamplesIn7Bits;
+	U32 mMaxRawBits;
+	U32 mGlitchSamples;
+	std::vector<U32> mSampleOffsets;
+};
+
+/* One frame's worth of bits, sampled at the data bit rate from the start of frame, as handed from the */
+/* frame reader to the decoder */
+class CanRawFrame
+{
+public:
+	U32 mBusIndex;
+	U64 mStartOfFrame;
+	std::vector<U8> mRawBits;	/* CAN_DOMINANT or CAN_RECESSIVE */
+
+	bool mGarbage;		/* noise rather than a frame, there is nothing to decode */
+	bool mTruncated;	/* skim mode, sampled up to the end of the control field only */
+	bool mCanError;
+	U64 mErrorStartingSample;
+	U64 mErrorEndingSample;
+	U64 mTruncatedEndingSample;	/* skim mode, 7 slow bits after the start of the trailing recessive bits */
+
+	U64 mProgressSample;	/* where the reader was when it finished with the frame */
+	bool mCaughtUp;			/* and whether it had used up the edges available at that point */
+};
+
+class CAN_FDAnalyzer;
+class CAN_FDAnalyzerSettings;
+
+/* All channel access once decoding has started: finds the next frame on any of the buses and samples */
+/* its raw bits, skipping idle time, glitches and noise. It runs on the analyzer's worker thread. */
+class CAN_FDFrameReader
+{
+public:
+	CAN_FDFrameReader(CAN_FDAnalyzer* analyzer, CAN_FDAnalyzerSettings* settings, CanPerfCounters& perf, CanTrace& trace);
+
+	/* Gets every bus to an inter-frame gap. With commit_when_caught_up, the analyzer's results are */
+	/* committed whenever the reader uses up the available edges part way through a frame. */
+	void Start(std::vector<CanBusState>& buses, bool commit_when_caught_up);
+
+	/* Carries on from where each bus's channel is, left there by reading a frame or moved on to where */
+	/* reading one left it before */
+	void Continue(std::vector<CanBusState>& buses, bool commit_when_caught_up);
+
+	/* Moves a bus's channel to just before a start of frame found by an earlier decode, for Continue to */
+	/* read on from that frame. False if the channel is already past it or the capture has no dominant */
+	/* edge there. With check_capture_end, from a decode of what may have been a longer capture, also */
+	/* false if the capture ends before it. */
+	bool AdvanceToStartOfFrame(CanBusState& bus, U64 start_of_frame, bool check_capture_end);
+
+	/* Moves one bus's channel on to the sample and then to an inter-frame gap, for Continue to read on */
+	/* from there */
+	void SkipTo(std::vector<CanBusState>& buses, U32 index, U64 sample);
+	void ReadRawFrame(CanRawFrame& raw);
+
+protected: //functions
+	void SelectBus(U32 index);
+	U32 GetNextBus();
+	void ResetBusHorizon();
+	void WaitFor7RecessiveBits();
+	void SkipRestOfFrame(CanRawFrame& raw);
+	void SkipNoise();
+	BitState GetFilteredBitState(U64 sample, U32& transitions);
+	void GetRawFrame(CanRawFrame& raw);
+
+protected: //vars
+	CAN_FDAnalyzer* mAnalyzer;
+	CAN_FDAnalyzerSettings* mSettings;
+	CanPerfCounters& mPerf;
+	CanTrace& mTrace;
+
+	std::vector<CanBusState>* mBuses;
+	U32 mCurrentBusIndex;
+	U64 mBusHorizon;
+	bool mCommitWhenCaughtUp;
+
+	/* Where the level the raw frame ended on started: after the last raw bit at the other level, and */
+	/* at or before the first raw bit at this one */
+	U64 mLevelStartEarliest;
+	U64 mLevelStartLatest;
+
+	/* Copied from the current bus by SelectBus */
+	AnalyzerChannelData* mCAN_FD;
+	BitState mRecessive;
+	BitState mDominant;
+	U8 mPolarity;
+	U32 mBitRateFactor;
+	U32 mNumSamplesIn7Bits;
+	U32 mMaxRawBits;
+	U32 mGlitchSamples;
+	const U32* mSampleOffsets;
+};
+
+#endif //CAN_FD_FRAME_READER_H
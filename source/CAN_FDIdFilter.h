@@ -0,0 +1,99 @@
+#ifndef CAN_FD_ID_FILTER
+#define CAN_FD_ID_FILTER
+
+#include <AnalyzerTypes.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/* Set of identifiers given as a list of hex identifiers and ranges, such as "7DF, 7E0-7EF, 18DA00F1". */
+/* Ranges apply to 11-bit and 29-bit identifiers alike. An empty list matches every identifier. */
+
+class CanIdRange
+{
+public:
+	U32 mFirst;
+	U32 mLast;
+};
+
+class CanIdFilter
+{
+public:
+	/* Returns false, leaving the filter as it was, if the text is not a valid list */
+	bool Parse(const std::string& text)
+	{
+		std::vector<CanIdRange> ranges;
+		const char* p = text.c_str();
+
+		for (; ; )
+		{
+			while ((*p == ' ') || (*p == ',') || (*p == ';') || (*p == '\t'))
+				p++;
+			if (*p == 0)
+				break;
+
+			CanIdRange range;
+			if (ParseIdentifier(p, range.mFirst) == false)
+				return false;
+
+			while (*p == ' ')
+				p++;
+
+			range.mLast = range.mFirst;
+			if (*p == '-')
+			{
+				p++;
+				while (*p == ' ')
+					p++;
+
+				if (ParseIdentifier(p, range.mLast) == false)
+					return false;
+				if (range.mLast < range.mFirst)
+					return false;
+			}
+
+			ranges.push_back(range);
+		}
+
+		mRanges.swap(ranges);
+		return true;
+	}
+
+	bool IsEmpty() const
+	{
+		return mRanges.empty();
+	}
+
+	bool Matches(U32 identifier) const
+	{
+		if (mRanges.empty() == true)
+			return true;
+
+		for (U32 i = 0; i < mRanges.size(); i++)
+		{
+			if ((identifier >= mRanges[i].mFirst) && (identifier <= mRanges[i].mLast))
+				return true;
+		}
+		return false;
+	}
+
+protected:
+	static bool ParseIdentifier(const char*& p, U32& identifier)
+	{
+		if ((p[0] == '0') && ((p[1] == 'x') || (p[1] == 'X')))
+			p += 2;
+
+		char* end;
+		unsigned long value = strtoul(p, &end, 16);
+		if ((end == p) || (value > 0x1FFFFFFF))
+			return false;
+
+		p = end;
+		identifier = (U32)value;
+		return true;
+	}
+
+	std::vector<CanIdRange> mRanges;
+};
+
+#endif //CAN_FD_ID_FILTER
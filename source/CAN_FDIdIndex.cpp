@@ -0,0 +1,179 @@
+#include "CAN_FDIdIndex.h"
+#include "CAN_FDVarint.h"
+#include <algorithm>
+
+CAN_FDIdIndex::CAN_FDIdIndex()
+{
+}
+
+CAN_FDIdIndex::~CAN_FDIdIndex()
+{
+}
+
+void CAN_FDIdIndex::Reset()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (U32 i = 0; i < CAN_FD_MAX_BUSES; i++)
+		mLists[i].Clear();
+}
+
+void CAN_FDIdIndex::AddPacket(U32 bus, U32 identifier, bool extended, U64 packet_id, U64 starting_sample)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	CanPostingList& list = mLists[bus].Get(identifier, extended);
+	/* Sample deltas are zigzag encoded, so a frame out of order costs bytes rather than the list */
+	AppendVarint(list.mDeltas, packet_id - list.mLastPacketId);
+	AppendVarint(list.mDeltas, ZigZag(S64(starting_sample - list.mLastSample)));
+
+	if ((list.mCount % CAN_ID_INDEX_SKIP_ENTRIES) == 0)
+	{
+		CanPostingSkip skip;
+		skip.mOffset = list.mDeltas.size();
+		skip.mPacketId = packet_id;
+		skip.mStartingSample = starting_sample;
+		list.mSkips.push_back(skip);
+	}
+
+	list.mCount++;
+	list.mLastPacketId = packet_id;
+	list.mLastSample = starting_sample;
+}
+
+void CAN_FDIdIndex::GetPackets(const CanIdFilter& filter, std::vector<U64>& packets)
+{
+	packets.clear();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	U32 num_lists = 0;
+	for (U32 bus = 0; bus < CAN_FD_MAX_BUSES; bus++)
+	{
+		CanIdTable<CanPostingList>& lists = mLists[bus];
+		for (U32 i = 0; i < lists.GetCount(); i++)
+		{
+			if (filter.Matches(lists.GetIdentifier(i)) == false)
+				continue;
+
+			CanPostingList& list = lists.GetEntry(i);
+			if (list.mCount == 0)
+				continue;
+
+			packets.reserve(packets.size() + list.mCount);
+
+			const U8* p = &list.mDeltas[0];
+			U64 packet_id = 0;
+			for (U64 n = 0; n < list.mCount; n++)
+			{
+				packet_id += ReadVarint(p);
+				ReadVarint(p);
+				packets.push_back(packet_id);
+			}
+
+			num_lists++;
+		}
+	}
+
+	/* Each list is in order already, only several of them need merging */
+	if (num_lists > 1)
+		std::sort(packets.begin(), packets.end());
+}
+
+U32 CAN_FDIdIndex::FindBlock(CanPostingList& list, U64 sample)
+{
+	/* Number of blocks whose first entry starts before the sample */
+	U32 first = 0;
+	U32 last = (U32)list.mSkips.size();
+	while (first < last)
+	{
+		U32 middle = first + ((last - first) / 2);
+		if (list.mSkips[middle].mStartingSample < sample)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+	return first;
+}
+
+void CAN_FDIdIndex::DecodeBlock(CanPostingList& list, U32 block, std::vector<CanPostingSkip>& entries)
+{
+	const CanPostingSkip& skip = list.mSkips[block];
+	U64 num_entries = std::min<U64>(CAN_ID_INDEX_SKIP_ENTRIES, list.mCount - (U64(block) * CAN_ID_INDEX_SKIP_ENTRIES));
+
+	entries.resize((size_t)num_entries);
+	entries[0] = skip;
+
+	const U8* p = &list.mDeltas[0] + skip.mOffset;
+	for (U32 i = 1; i < num_entries; i++)
+	{
+		entries[i].mPacketId = entries[i - 1].mPacketId + ReadVarint(p);
+		entries[i].mStartingSample = entries[i - 1].mStartingSample + UnZigZag(ReadVarint(p));
+	}
+}
+
+bool CAN_FDIdIndex::FindNext(U32 bus, U32 identifier, bool extended, U64 sample, U64& packet_id, U64& starting_sample)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	CanPostingList* list = mLists[bus].Find(identifier, extended);
+	if ((list == NULL) || (list->mCount == 0))
+		return false;
+
+	/* The answer is in the last block starting before the sample, or else it is the next block's first entry */
+	U32 block = FindBlock(*list, sample);
+	if (block > 0)
+	{
+		std::vector<CanPostingSkip> entries;
+		DecodeBlock(*list, block - 1, entries);
+		for (U32 i = 0; i < entries.size(); i++)
+		{
+			if (entries[i].mStartingSample >= sample)
+			{
+				packet_id = entries[i].mPacketId;
+				starting_sample = entries[i].mStartingSample;
+				return true;
+			}
+		}
+	}
+
+	if (block >= list->mSkips.size())
+		return false;
+
+	packet_id = list->mSkips[block].mPacketId;
+	starting_sample = list->mSkips[block].mStartingSample;
+	return true;
+}
+
+bool CAN_FDIdIndex::FindPrevious(U32 bus, U32 identifier, bool extended, U64 sample, U64& packet_id, U64& starting_sample)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	CanPostingList* list = mLists[bus].Find(identifier, extended);
+	if ((list == NULL) || (list->mCount == 0))
+		return false;
+
+	U32 block = FindBlock(*list, sample);
+	if (block == 0)
+		return false;
+
+	std::vector<CanPostingSkip> entries;
+	DecodeBlock(*list, block - 1, entries);
+
+	U32 i = (U32)entries.size();
+	while ((i > 1) && (entries[i - 1].mStartingSample >= sample))
+		i--;
+
+	packet_id = entries[i - 1].mPacketId;
+	starting_sample = entries[i - 1].mStartingSample;
+	return true;
+}
+
+U64 CAN_FDIdIndex::GetCount(U32 bus, U32 identifier, bool extended)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	CanPostingList* list = mLists[bus].Find(identifier, extended);
+	if (list == NULL)
+		return 0;
+	return list->mCount;
+}
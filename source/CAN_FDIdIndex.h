@@ -0,0 +1,65 @@
+#ifndef CAN_FD_ID_INDEX
+#define CAN_FD_ID_INDEX
+
+#include <AnalyzerTypes.h>
+#include "CAN_FDIdTable.h"
+#include "CAN_FDIdFilter.h"
+#include "CAN_FDAnalyzerSettings.h"
+#include <mutex>
+#include <vector>
+
+/* Packets of each identifier on each bus, so one identifier can be found or exported without walking */
+/* every frame. Each identifier has a posting list per bus of packet number and start sample deltas as varints, typically four */
+/* or five bytes a frame, with a skip entry every CAN_ID_INDEX_SKIP_ENTRIES entries for the lookups. */
+
+#define CAN_ID_INDEX_SKIP_ENTRIES 64
+
+/* Where an entry's deltas end, and the values they decode to, so decoding can start from there */
+class CanPostingSkip
+{
+public:
+	U64 mOffset;
+	U64 mPacketId;
+	U64 mStartingSample;
+};
+
+class CanPostingList
+{
+public:
+	CanPostingList() : mCount(0), mLastPacketId(0), mLastSample(0) {}
+
+	std::vector<U8> mDeltas;
+	std::vector<CanPostingSkip> mSkips;
+	U64 mCount;
+	U64 mLastPacketId;
+	U64 mLastSample;
+};
+
+/* Fed with every committed packet by the worker thread, read by exports and lookups while decoding continues */
+class CAN_FDIdIndex
+{
+public:
+	CAN_FDIdIndex();
+	~CAN_FDIdIndex();
+
+	void Reset();
+	void AddPacket(U32 bus, U32 identifier, bool extended, U64 packet_id, U64 starting_sample);
+
+	/* Packets of all identifiers the filter matches, on any bus, in packet order */
+	void GetPackets(const CanIdFilter& filter, std::vector<U64>& packets);
+
+	/* First packet of the identifier on the bus starting at or after the sample, and last one starting before it */
+	bool FindNext(U32 bus, U32 identifier, bool extended, U64 sample, U64& packet_id, U64& starting_sample);
+	bool FindPrevious(U32 bus, U32 identifier, bool extended, U64 sample, U64& packet_id, U64& starting_sample);
+
+	U64 GetCount(U32 bus, U32 identifier, bool extended);
+
+protected:
+	U32 FindBlock(CanPostingList& list, U64 sample);
+	void DecodeBlock(CanPostingList& list, U32 block, std::vector<CanPostingSkip>& entries);
+
+	std::mutex mMutex;
+	CanIdTable<CanPostingList> mLists[CAN_FD_MAX_BUSES];
+};
+
+#endif //CAN_FD_ID_INDEX
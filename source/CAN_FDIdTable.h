@@ -0,0 +1,159 @@
+#ifndef CAN_FD_ID_TABLE
+#define CAN_FD_ID_TABLE
+
+#include <AnalyzerTypes.h>
+#include <vector>
+
+/* Identifier keyed table used for the per-identifier state kept while decoding. */
+/* 11-bit identifiers index a flat array directly, 29-bit identifiers go through an open addressing hash table. */
+/* Entries are stored densely in order of first appearance, so iterating over them is cheap. */
+
+#define CAN_STANDARD_ID_COUNT 2048
+
+template <class T>
+class CanIdTable
+{
+public:
+	CanIdTable()
+	{
+		Clear();
+	}
+
+	void Clear()
+	{
+		mStandardIndex.assign(CAN_STANDARD_ID_COUNT, -1);
+		mExtendedKeys.assign(64, 0);
+		mExtendedIndex.assign(64, -1);
+		mNumExtended = 0;
+		mEntries.clear();
+		mIdentifiers.clear();
+		mExtended.clear();
+	}
+
+	/* Returns the entry for this identifier, creating a default constructed one if it is not there yet */
+	T& Get(U32 identifier, bool extended)
+	{
+		S32 index = Lookup(identifier, extended, true);
+		return mEntries[index];
+	}
+
+	/* Returns NULL for identifiers that have not been seen */
+	T* Find(U32 identifier, bool extended)
+	{
+		S32 index = Lookup(identifier, extended, false);
+		if (index < 0)
+			return NULL;
+		return &mEntries[index];
+	}
+
+	U32 GetCount() const
+	{
+		return (U32)mEntries.size();
+	}
+
+	T& GetEntry(U32 index)
+	{
+		return mEntries[index];
+	}
+
+	U32 GetIdentifier(U32 index) const
+	{
+		return mIdentifiers[index];
+	}
+
+	bool IsExtended(U32 index) const
+	{
+		return mExtended[index];
+	}
+
+protected:
+	S32 Lookup(U32 identifier, bool extended, bool insert)
+	{
+		if (extended == false)
+		{
+			identifier &= (CAN_STANDARD_ID_COUNT - 1);
+			if ((mStandardIndex[identifier] < 0) && (insert == true))
+				mStandardIndex[identifier] = AddEntry(identifier, false);
+
+			return mStandardIndex[identifier];
+		}
+
+		U32 mask = (U32)mExtendedKeys.size() - 1;
+		U32 slot = Hash(identifier) & mask;
+		for (; ; )
+		{
+			if (mExtendedIndex[slot] < 0)
+				break;
+
+			if (mExtendedKeys[slot] == identifier)
+				return mExtendedIndex[slot];
+
+			slot = (slot + 1) & mask;
+		}
+
+		if (insert == false)
+			return -1;
+
+		S32 index = AddEntry(identifier, true);
+		mExtendedKeys[slot] = identifier;
+		mExtendedIndex[slot] = index;
+		mNumExtended++;
+
+		/* Keep the load factor at or below one half */
+		if ((mNumExtended * 2) > mExtendedKeys.size())
+			GrowExtended();
+
+		return index;
+	}
+
+	S32 AddEntry(U32 identifier, bool extended)
+	{
+		mEntries.push_back(T());
+		mIdentifiers.push_back(identifier);
+		mExtended.push_back(extended);
+		return (S32)mEntries.size() - 1;
+	}
+
+	void GrowExtended()
+	{
+		std::vector<U32> keys(mExtendedKeys.size() * 2, 0);
+		std::vector<S32> indices(mExtendedKeys.size() * 2, -1);
+		U32 mask = (U32)keys.size() - 1;
+
+		for (U32 i = 0; i < mExtendedKeys.size(); i++)
+		{
+			if (mExtendedIndex[i] < 0)
+				continue;
+
+			U32 slot = Hash(mExtendedKeys[i]) & mask;
+			while (indices[slot] >= 0)
+				slot = (slot + 1) & mask;
+
+			keys[slot] = mExtendedKeys[i];
+			indices[slot] = mExtendedIndex[i];
+		}
+
+		mExtendedKeys.swap(keys);
+		mExtendedIndex.swap(indices);
+	}
+
+	static U32 Hash(U32 identifier)
+	{
+		/* 29-bit identifiers often differ only in a few low bits (source address, node id), so mix them up */
+		identifier ^= identifier >> 16;
+		identifier *= 0x7feb352d;
+		identifier ^= identifier >> 15;
+		return identifier;
+	}
+
+	std::vector<S32> mStandardIndex;
+	std::vector<U32> mExtendedKeys;
+	std::vector<S32> mExtendedIndex;
+	U32 mNumExtended;
+
+	std::vector<T> mEntries;
+	std::vector<U32> mIdentifiers;
+	std::vector<bool> mExtended;
+};
+
+#endif //CAN_FD_ID_TABLE
@@ -0,0 +1,352 @@
+#include "CAN_FDIsoTp.h"
+#include <algorithm>
+#include <utility>
+
+/* Protocol control information, the high nibble of the first data byte */
+#define ISO_TP_SINGLE_FRAME 0
+#define ISO_TP_FIRST_FRAME 1
+#define ISO_TP_CONSECUTIVE_FRAME 2
+#define ISO_TP_FLOW_CONTROL 3
+
+#define ISO_TP_FLOW_CONTINUE 0
+#define ISO_TP_FLOW_WAIT 1
+#define ISO_TP_FLOW_OVERFLOW 2
+
+/* PDU format of 29-bit normal fixed addressing, with target and source address in the low two bytes */
+#define ISO_TP_NORMAL_FIXED_PF_PHYSICAL 0xDA
+
+CAN_FDIsoTp::CAN_FDIsoTp()
+:	mTimeoutSamples( 0 ),
+	mNextTransactionId( 0 )
+{
+}
+
+CAN_FDIsoTp::~CAN_FDIsoTp()
+{
+}
+
+void CAN_FDIsoTp::Reset(U32 sample_rate_hz, U32 timeout_ms, const std::string& identifiers)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mIdentifiers.Parse(identifiers);
+	mTimeoutSamples = (U64(sample_rate_hz) * timeout_ms) / 1000;
+	mNextTransactionId = 0;
+
+	for (U32 i = 0; i < CAN_FD_MAX_BUSES; i++)
+		mSessions[i].Clear();
+
+	mMessages.clear();
+	mMessageByTransaction.clear();
+}
+
+bool CAN_FDIsoTp::AddFrame(CanDecodedFrame& frame, U64& transaction_id)
+{
+	if ((frame.mRemoteFrame == true) || (frame.mNumDataBytes == 0))
+		return false;
+
+	if (mIdentifiers.Matches(frame.mIdentifier) == false)
+		return false;
+
+	const U8* data = frame.mData;
+	U32 num_bytes = frame.mNumDataBytes;
+	U32 pci = data[0] >> 4;
+
+	if (pci == ISO_TP_FLOW_CONTROL)
+		return AddFlowControl(frame, transaction_id);
+
+	if (pci > ISO_TP_FLOW_CONTROL)
+		return false;
+
+	CanIsoTpSession& session = mSessions[frame.mBus].Get(frame.mIdentifier, frame.mExtended);
+
+	if ((session.mActive == true) && ((frame.mStartingSample - session.mLastSample) > mTimeoutSamples))
+		FinishMessage(session, IsoTpTimeout);
+
+	if (pci == ISO_TP_SINGLE_FRAME)
+	{
+		/* CAN-FD frames longer than 8 bytes escape the length into the second byte */
+		U32 length = data[0] & 0x0F;
+		U32 offset = 1;
+		if ((length == 0) && (num_bytes > 8))
+		{
+			length = data[1];
+			offset = 2;
+		}
+
+		if ((length == 0) || ((length + offset) > num_bytes))
+			return false;
+
+		if (session.mActive == true)
+			FinishMessage(session, IsoTpInterrupted);
+
+		StartMessage(session, frame, length);
+		AppendData(session, data + offset, length);
+		transaction_id = session.mMessage.mTransactionId;
+		FinishMessage(session, IsoTpComplete);
+		return true;
+	}
+
+	if (pci == ISO_TP_FIRST_FRAME)
+	{
+		/* A first frame always fills the frame. Lengths over 4095 escape into a 32-bit length. */
+		if (num_bytes < 8)
+			return false;
+
+		U32 length = ((data[0] & 0x0F) << 8) | data[1];
+		U32 offset = 2;
+		if (length == 0)
+		{
+			length = (U32(data[2]) << 24) | (U32(data[3]) << 16) | (U32(data[4]) << 8) | data[5];
+			offset = 6;
+		}
+
+		if (length <= (num_bytes - offset))
+			return false;
+
+		if (session.mActive == true)
+			FinishMessage(session, IsoTpInterrupted);
+
+		StartMessage(session, frame, length);
+		transaction_id = session.mMessage.mTransactionId;
+
+		if (length > ISO_TP_MAX_MESSAGE_BYTES)
+		{
+			FinishMessage(session, IsoTpTooLong);
+			return true;
+		}
+
+		AppendData(session, data + offset, num_bytes - offset);
+		session.mNextSequenceNumber = 1;
+		session.mAwaitingFlowControl = true;
+		session.mBlockSize = 0;
+		session.mBlockFrames = 0;
+		return true;
+	}
+
+	/* Consecutive frame */
+	if (session.mActive == false)
+		return false;
+
+	CanIsoTpMessage& message = session.mMessage;
+	transaction_id = message.mTransactionId;
+	message.mFrames++;
+	message.mEndingSample = frame.mEndingSample;
+	session.mLastSample = frame.mStartingSample;
+
+	if ((data[0] & 0x0F) != session.mNextSequenceNumber)
+	{
+		FinishMessage(session, IsoTpSequenceError);
+		return true;
+	}
+
+	U32 remaining = message.mLength - (U32)message.mData.size();
+	AppendData(session, data + 1, std::min<U32>(num_bytes - 1, remaining));
+	session.mNextSequenceNumber = (session.mNextSequenceNumber + 1) & 0x0F;
+
+	session.mBlockFrames++;
+	if ((session.mBlockSize > 0) && (session.mBlockFrames >= session.mBlockSize))
+		session.mAwaitingFlowControl = true;
+
+	if (message.mData.size() >= message.mLength)
+		FinishMessage(session, IsoTpComplete);
+
+	return true;
+}
+
+void CAN_FDIsoTp::Finish()
+{
+	for (U32 bus = 0; bus < CAN_FD_MAX_BUSES; bus++)
+	{
+		CanIdTable<CanIsoTpSession>& sessions = mSessions[bus];
+		for (U32 i = 0; i < sessions.GetCount(); i++)
+		{
+			if (sessions.GetEntry(i).mActive == true)
+				FinishMessage(sessions.GetEntry(i), IsoTpTimeout);
+		}
+	}
+}
+
+bool CAN_FDIsoTp::AddFlowControl(CanDecodedFrame& frame, U64& transaction_id)
+{
+	if (frame.mNumDataBytes < 3)
+		return false;
+
+	CanIsoTpSession* session = FindFlowControlSession(frame);
+	if (session == NULL)
+		return false;
+
+	CanIsoTpMessage& message = session->mMessage;
+	transaction_id = message.mTransactionId;
+	message.mFlowControlFrames++;
+	message.mFlowControlIdentifier = frame.mIdentifier;
+	message.mHasFlowControl = true;
+	message.mEndingSample = frame.mEndingSample;
+	session->mLastSample = frame.mStartingSample;
+
+	switch (frame.mData[0] & 0x0F)
+	{
+	case ISO_TP_FLOW_CONTINUE:
+		session->mAwaitingFlowControl = false;
+		session->mBlockSize = frame.mData[1];
+		session->mBlockFrames = 0;
+		break;
+	case ISO_TP_FLOW_WAIT:
+		break;
+	default:
+		FinishMessage(*session, IsoTpOverflow);
+		break;
+	}
+
+	return true;
+}
+
+CanIsoTpSession* CAN_FDIsoTp::FindFlowControlSession(CanDecodedFrame& frame)
+{
+	CanIdTable<CanIsoTpSession>& sessions = mSessions[frame.mBus];
+
+	/* With normal fixed addressing the sender's identifier is the flow control one with the addresses swapped */
+	if ((frame.mExtended == true) && (((frame.mIdentifier >> 16) & 0xFF) == ISO_TP_NORMAL_FIXED_PF_PHYSICAL))
+	{
+		U32 sender = (frame.mIdentifier & 0x1FFF0000) | ((frame.mIdentifier & 0xFF) << 8) | ((frame.mIdentifier >> 8) & 0xFF);
+		CanIsoTpSession* session = sessions.Find(sender, true);
+		if ((session != NULL) && (session->mActive == true) && (session->mAwaitingFlowControl == true))
+			return session;
+	}
+
+	/* Otherwise the transfer that already had flow control from this identifier, or else the oldest one */
+	/* still waiting for its first */
+	CanIsoTpSession* oldest = NULL;
+	for (U32 i = 0; i < sessions.GetCount(); i++)
+	{
+		CanIsoTpSession& session = sessions.GetEntry(i);
+		if ((session.mActive == false) || (session.mAwaitingFlowControl == false))
+			continue;
+
+		if ((sessions.GetIdentifier(i) == frame.mIdentifier) && (sessions.IsExtended(i) == frame.mExtended))
+			continue;
+
+		if (session.mMessage.mHasFlowControl == true)
+		{
+			if (session.mMessage.mFlowControlIdentifier == frame.mIdentifier)
+				return &session;
+			continue;
+		}
+
+		if ((frame.mStartingSample - session.mLastSample) > mTimeoutSamples)
+			continue;
+
+		if ((oldest == NULL) || (session.mMessage.mStartingSample < oldest->mMessage.mStartingSample))
+			oldest = &session;
+	}
+
+	return oldest;
+}
+
+void CAN_FDIsoTp::StartMessage(CanIsoTpSession& session, CanDecodedFrame& frame, U32 length)
+{
+	session.mActive = true;
+	session.mLastSample = frame.mStartingSample;
+	session.mAwaitingFlowControl = false;
+
+	CanIsoTpMessage& message = session.mMessage;
+	message.mBus = frame.mBus;
+	message.mIdentifier = frame.mIdentifier;
+	message.mExtended = frame.mExtended;
+	message.mFdFrames = frame.mFdFrame;
+	message.mFlowControlIdentifier = 0;
+	message.mHasFlowControl = false;
+	message.mStartingSample = frame.mStartingSample;
+	message.mEndingSample = frame.mEndingSample;
+	message.mTransactionId = mNextTransactionId++;
+	message.mLength = length;
+	message.mFrames = 1;
+	message.mFlowControlFrames = 0;
+	message.mStatus = IsoTpComplete;
+	message.mData.clear();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mMessageByTransaction.push_back(-1);
+}
+
+void CAN_FDIsoTp::AppendData(CanIsoTpSession& session, const U8* data, U32 num_bytes)
+{
+	session.mMessage.mData.insert(session.mMessage.mData.end(), data, data + num_bytes);
+}
+
+void CAN_FDIsoTp::FinishMessage(CanIsoTpSession& session, CanIsoTpStatus status)
+{
+	session.mActive = false;
+	session.mAwaitingFlowControl = false;
+	session.mMessage.mStatus = status;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mMessageByTransaction[session.mMessage.mTransactionId] = (S32)mMessages.size();
+	mMessages.push_back(CanIsoTpMessage());
+	std::swap(mMessages.back(), session.mMessage);
+}
+
+U32 CAN_FDIsoTp::GetNumMessages()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return (U32)mMessages.size();
+}
+
+bool CAN_FDIsoTp::GetMessage(U32 index, CanIsoTpMessage& message)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (index >= mMessages.size())
+		return false;
+
+	message = mMessages[index];
+	return true;
+}
+
+bool CAN_FDIsoTp::GetMessageByTransaction(U64 transaction_id, CanIsoTpMessage& message)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if ((transaction_id >= mMessageByTransaction.size()) || (mMessageByTransaction[transaction_id] < 0))
+		return false;
+
+	message = mMessages[mMessageByTransaction[transaction_id]];
+	return true;
+}
+
+void CAN_FDIsoTp::GetStartOrder(std::vector<U32>& indices)
+{
+	/* Messages are published as they finish, so interleaved transfers on different identifiers are sorted */
+	/* back into the order they started in */
+	std::vector<std::pair<U64, U32> > starts;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		starts.reserve(mMessages.size());
+		for (U32 i = 0; i < mMessages.size(); i++)
+			starts.push_back(std::make_pair(mMessages[i].mStartingSample, i));
+	}
+
+	std::stable_sort(starts.begin(), starts.end());
+
+	indices.resize(starts.size());
+	for (U32 i = 0; i < starts.size(); i++)
+		indices[i] = starts[i].second;
+}
+
+const char* CAN_FDIsoTp::GetStatusString(CanIsoTpStatus status)
+{
+	switch (status)
+	{
+	case IsoTpComplete:
+		return "OK";
+	case IsoTpTimeout:
+		return "Timeout";
+	case IsoTpSequenceError:
+		return "Sequence error";
+	case IsoTpInterrupted:
+		return "Interrupted";
+	case IsoTpOverflow:
+		return "Overflow";
+	case IsoTpTooLong:
+		return "Too long";
+	}
+	return "";
+}
@@ -0,0 +1,97 @@
+#ifndef CAN_FD_ISO_TP
+#define CAN_FD_ISO_TP
+
+#include <AnalyzerTypes.h>
+#include "CAN_FDDecodedFrame.h"
+#include "CAN_FDIdFilter.h"
+#include "CAN_FDIdTable.h"
+#include "CAN_FDAnalyzerSettings.h"
+#include <mutex>
+#include <vector>
+
+/* ISO 15765-2 (ISO-TP) reassembly with normal addressing, classic CAN and CAN-FD frames. */
+/* Transfers are tracked per bus and sending identifier. Flow control frames come from the receiver's */
+/* identifier and are matched to the transfer waiting for them. */
+
+/* Longest transfer reassembled, longer ones (32-bit first frame lengths) are reported but not stored */
+#define ISO_TP_MAX_MESSAGE_BYTES (16 * 1024 * 1024)
+
+enum CanIsoTpStatus { IsoTpComplete, IsoTpTimeout, IsoTpSequenceError, IsoTpInterrupted, IsoTpOverflow, IsoTpTooLong };
+
+class CanIsoTpMessage
+{
+public:
+	CanIsoTpMessage() : mBus(0), mIdentifier(0), mExtended(false), mFdFrames(false), mFlowControlIdentifier(0), mHasFlowControl(false),
+		mStartingSample(0), mEndingSample(0), mTransactionId(0), mLength(0), mFrames(0), mFlowControlFrames(0), mStatus(IsoTpComplete) {}
+
+	U32 mBus;
+	U32 mIdentifier;
+	bool mExtended;
+	bool mFdFrames;
+	U32 mFlowControlIdentifier;
+	bool mHasFlowControl;
+
+	U64 mStartingSample;
+	U64 mEndingSample;
+	U64 mTransactionId;
+
+	U32 mLength;				/* as announced in the single or first frame */
+	U32 mFrames;
+	U32 mFlowControlFrames;
+	CanIsoTpStatus mStatus;
+	std::vector<U8> mData;
+};
+
+class CanIsoTpSession
+{
+public:
+	CanIsoTpSession() : mActive(false), mNextSequenceNumber(0), mLastSample(0), mAwaitingFlowControl(false), mBlockSize(0), mBlockFrames(0) {}
+
+	bool mActive;
+	U32 mNextSequenceNumber;
+	U64 mLastSample;
+	bool mAwaitingFlowControl;
+	U32 mBlockSize;			/* consecutive frames allowed by the last flow control, 0 for no limit */
+	U32 mBlockFrames;
+	CanIsoTpMessage mMessage;
+};
+
+/* Fed with every decoded data frame by the worker thread. Finished transfers, complete or not, are */
+/* published for the exports and the tabular view, which read them while decoding continues. */
+class CAN_FDIsoTp
+{
+public:
+	CAN_FDIsoTp();
+	~CAN_FDIsoTp();
+
+	void Reset(U32 sample_rate_hz, U32 timeout_ms, const std::string& identifiers);
+	bool AddFrame(CanDecodedFrame& frame, U64& transaction_id);
+
+	/* At the end of the decode, records the transfers still waiting for frames as timed out */
+	void Finish();
+
+	U32 GetNumMessages();
+	bool GetMessage(U32 index, CanIsoTpMessage& message);
+	bool GetMessageByTransaction(U64 transaction_id, CanIsoTpMessage& message);
+	void GetStartOrder(std::vector<U32>& indices);
+
+	static const char* GetStatusString(CanIsoTpStatus status);
+
+protected:
+	void StartMessage(CanIsoTpSession& session, CanDecodedFrame& frame, U32 length);
+	void AppendData(CanIsoTpSession& session, const U8* data, U32 num_bytes);
+	void FinishMessage(CanIsoTpSession& session, CanIsoTpStatus status);
+	bool AddFlowControl(CanDecodedFrame& frame, U64& transaction_id);
+	CanIsoTpSession* FindFlowControlSession(CanDecodedFrame& frame);
+
+	CanIdFilter mIdentifiers;
+	U64 mTimeoutSamples;
+	U64 mNextTransactionId;
+	CanIdTable<CanIsoTpSession> mSessions[CAN_FD_MAX_BUSES];
+
+	std::mutex mMutex;
+	std::vector<CanIsoTpMessage> mMessages;
+	std::vector<S32> mMessageByTransaction;
+};
+
+#endif //CAN_FD_ISO_TP
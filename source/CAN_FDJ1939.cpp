@@ -0,0 +1,334 @@
+#include "CAN_FDJ1939.h"
+#include <algorithm>
+#include <utility>
+
+/* PDU formats of the transport protocol, connection management (TP.CM) and data transfer (TP.DT) */
+#define J1939_PF_TP_CM 0xEC
+#define J1939_PF_TP_DT 0xEB
+
+/* PDU formats from here on are broadcast (PDU2), the PDU specific byte is then part of the PGN */
+#define J1939_PF_PDU2 0xF0
+
+#define J1939_CM_RTS 16
+#define J1939_CM_CTS 17
+#define J1939_CM_END_OF_MESSAGE_ACK 19
+#define J1939_CM_BAM 32
+#define J1939_CM_ABORT 255
+
+CAN_FDJ1939::CAN_FDJ1939()
+:	mTimeoutSamples( 0 )
+{
+}
+
+CAN_FDJ1939::~CAN_FDJ1939()
+{
+}
+
+void CAN_FDJ1939::Reset(U32 sample_rate_hz)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	mTimeoutSamples = (U64(sample_rate_hz) * J1939_TRANSPORT_TIMEOUT_MS) / 1000;
+
+	for (U32 i = 0; i < CAN_FD_MAX_BUSES; i++)
+	{
+		mSessions[i].Clear();
+		mPgnStatistics[i].Clear();
+	}
+
+	mRecords.clear();
+	mData.clear();
+}
+
+void CAN_FDJ1939::AddFrame(CanDecodedFrame& frame)
+{
+	if ((frame.mExtended == false) || (frame.mRemoteFrame == true))
+		return;
+
+	U32 identifier = frame.mIdentifier;
+	U32 pdu_format = (identifier >> 16) & 0xFF;
+	U32 pdu_specific = (identifier >> 8) & 0xFF;
+
+	CanJ1939Record header;
+	header.mStartingSample = frame.mStartingSample;
+	header.mEndingSample = frame.mEndingSample;
+	header.mBus = frame.mBus;
+	header.mPriority = U8((identifier >> 26) & 0x07);
+	header.mSourceAddress = U8(identifier & 0xFF);
+	header.mTransport = J1939Single;
+	header.mStatus = J1939Complete;
+	header.mLength = frame.mNumDataBytes;
+
+	/* PDU1 formats are addressed to one node, and the PGN has a zero low byte */
+	header.mPgn = (identifier >> 8) & 0x3FF00;
+	if (pdu_format < J1939_PF_PDU2)
+	{
+		header.mDestinationAddress = U8(pdu_specific);
+	}
+	else
+	{
+		header.mPgn |= pdu_specific;
+		header.mDestinationAddress = J1939_GLOBAL_ADDRESS;
+	}
+
+	if (pdu_format == J1939_PF_TP_CM)
+	{
+		ExpireSessions(frame.mBus, frame.mStartingSample);
+		AddConnectionManagement(frame, header);
+	}
+	else if (pdu_format == J1939_PF_TP_DT)
+	{
+		ExpireSessions(frame.mBus, frame.mStartingSample);
+		AddDataTransfer(frame, header);
+	}
+	else
+	{
+		AddRecord(header, frame.mData, frame.mNumDataBytes);
+	}
+}
+
+void CAN_FDJ1939::Finish()
+{
+	for (U32 bus = 0; bus < CAN_FD_MAX_BUSES; bus++)
+	{
+		CanIdTable<CanJ1939Session>& sessions = mSessions[bus];
+		for (U32 i = 0; i < sessions.GetCount(); i++)
+		{
+			if (sessions.GetEntry(i).mActive == true)
+				FinishSession(sessions.GetEntry(i), J1939Timeout);
+		}
+	}
+}
+
+void CAN_FDJ1939::AddConnectionManagement(CanDecodedFrame& frame, CanJ1939Record& header)
+{
+	if (frame.mNumDataBytes < 8)
+		return;
+
+	const U8* data = frame.mData;
+	U32 pgn = data[5] | (U32(data[6]) << 8) | (U32(data[7]) << 16);
+
+	switch (data[0])
+	{
+	case J1939_CM_RTS:
+	case J1939_CM_BAM:
+	{
+		U32 length = data[1] | (U32(data[2]) << 8);
+		U32 num_packets = data[3];
+		if ((length > J1939_MAX_TRANSPORT_BYTES) || (num_packets == 0))
+			return;
+
+		bool broadcast = (data[0] == J1939_CM_BAM);
+		U8 destination = broadcast ? J1939_GLOBAL_ADDRESS : header.mDestinationAddress;
+
+		CanJ1939Session& session = GetSession(header.mBus, header.mSourceAddress, destination);
+		if (session.mActive == true)
+			FinishSession(session, J1939Interrupted);
+
+		session.mActive = true;
+		session.mNumPackets = num_packets;
+		session.mNextSequence = 1;
+		session.mLastSample = frame.mStartingSample;
+		session.mData.clear();
+		session.mData.reserve(length);
+
+		session.mRecord = header;
+		session.mRecord.mPgn = pgn;
+		session.mRecord.mDestinationAddress = destination;
+		session.mRecord.mTransport = broadcast ? J1939Bam : J1939RtsCts;
+		session.mRecord.mLength = length;
+		break;
+	}
+	case J1939_CM_CTS:
+	{
+		/* From the receiver, which may ask for packets again from an earlier one */
+		CanJ1939Session* session = FindSession(header.mBus, header.mDestinationAddress, header.mSourceAddress);
+		if (session == NULL)
+			return;
+
+		session->mLastSample = frame.mStartingSample;
+		if ((data[1] > 0) && (data[2] > 0) && (data[2] <= session->mNextSequence))
+		{
+			session->mNextSequence = data[2];
+			session->mData.resize(std::min<size_t>(session->mData.size(), (data[2] - 1) * 7));
+		}
+		break;
+	}
+	case J1939_CM_END_OF_MESSAGE_ACK:
+		break;
+	case J1939_CM_ABORT:
+	{
+		/* Either side may abort */
+		CanJ1939Session* session = FindSession(header.mBus, header.mSourceAddress, header.mDestinationAddress);
+		if (session == NULL)
+			session = FindSession(header.mBus, header.mDestinationAddress, header.mSourceAddress);
+		if (session != NULL)
+			FinishSession(*session, J1939Aborted);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void CAN_FDJ1939::AddDataTransfer(CanDecodedFrame& frame, CanJ1939Record& header)
+{
+	if (frame.mNumDataBytes < 2)
+		return;
+
+	CanJ1939Session* session = FindSession(header.mBus, header.mSourceAddress, header.mDestinationAddress);
+	if (session == NULL)
+		return;
+
+	session->mLastSample = frame.mStartingSample;
+	session->mRecord.mEndingSample = frame.mEndingSample;
+
+	U32 sequence = frame.mData[0];
+	if (sequence != session->mNextSequence)
+	{
+		FinishSession(*session, J1939SequenceError);
+		return;
+	}
+
+	U32 remaining = session->mRecord.mLength - (U32)session->mData.size();
+	U32 num_bytes = std::min<U32>(std::min<U32>(frame.mNumDataBytes - 1, 7), remaining);
+	session->mData.insert(session->mData.end(), frame.mData + 1, frame.mData + 1 + num_bytes);
+	session->mNextSequence++;
+
+	if ((sequence >= session->mNumPackets) || (session->mData.size() >= session->mRecord.mLength))
+		FinishSession(*session, J1939Complete);
+}
+
+CanJ1939Session& CAN_FDJ1939::GetSession(U32 bus, U8 source_address, U8 destination_address)
+{
+	/* Keyed as if an extended identifier, so every address pair goes through the hash table */
+	return mSessions[bus].Get((U32(source_address) << 8) | destination_address, true);
+}
+
+CanJ1939Session* CAN_FDJ1939::FindSession(U32 bus, U8 source_address, U8 destination_address)
+{
+	CanJ1939Session* session = mSessions[bus].Find((U32(source_address) << 8) | destination_address, true);
+	if ((session == NULL) || (session->mActive == false))
+		return NULL;
+	return session;
+}
+
+void CAN_FDJ1939::ExpireSessions(U32 bus, U64 sample)
+{
+	/* Including sessions the frame doesn't belong to, which would otherwise wait for the end of the decode */
+	CanIdTable<CanJ1939Session>& sessions = mSessions[bus];
+	for (U32 i = 0; i < sessions.GetCount(); i++)
+	{
+		CanJ1939Session& session = sessions.GetEntry(i);
+		if ((session.mActive == true) && ((sample - session.mLastSample) > mTimeoutSamples))
+			FinishSession(session, J1939Timeout);
+	}
+}
+
+void CAN_FDJ1939::FinishSession(CanJ1939Session& session, CanJ1939Status status)
+{
+	session.mActive = false;
+	session.mRecord.mStatus = status;
+
+	AddRecord(session.mRecord, session.mData.empty() ? NULL : &session.mData[0], (U32)session.mData.size());
+}
+
+void CAN_FDJ1939::AddRecord(CanJ1939Record& record, const U8* data, U32 num_bytes)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	record.mDataOffset = mData.size();
+	record.mNumDataBytes = num_bytes;
+	mData.insert(mData.end(), data, data + num_bytes);
+	mRecords.push_back(record);
+
+	CanPgnStatistics& statistics = mPgnStatistics[record.mBus].Get(record.mPgn, true);
+	if (statistics.mMessages == 0)
+		statistics.mFirstSample = record.mStartingSample;
+	statistics.mLastSample = record.mStartingSample;
+	statistics.mMessages++;
+	if (record.mTransport != J1939Single)
+		statistics.mTransportMessages++;
+	statistics.mBytes += num_bytes;
+	statistics.mSources[record.mSourceAddress >> 5] |= 1 << (record.mSourceAddress & 31);
+}
+
+U32 CAN_FDJ1939::GetNumRecords()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return (U32)mRecords.size();
+}
+
+bool CAN_FDJ1939::GetRecord(U32 index, CanJ1939Record& record, std::vector<U8>& data)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (index >= mRecords.size())
+		return false;
+
+	record = mRecords[index];
+	data.assign(mData.begin() + record.mDataOffset, mData.begin() + record.mDataOffset + record.mNumDataBytes);
+	return true;
+}
+
+void CAN_FDJ1939::GetStartOrder(std::vector<U32>& indices)
+{
+	/* Transport messages are recorded when they finish, after the single frames sent meanwhile */
+	std::vector<std::pair<U64, U32> > starts;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		starts.reserve(mRecords.size());
+		for (U32 i = 0; i < mRecords.size(); i++)
+			starts.push_back(std::make_pair(mRecords[i].mStartingSample, i));
+	}
+
+	std::stable_sort(starts.begin(), starts.end());
+
+	indices.resize(starts.size());
+	for (U32 i = 0; i < starts.size(); i++)
+		indices[i] = starts[i].second;
+}
+
+void CAN_FDJ1939::GetPgnStatistics(U32 bus, std::vector<CanPgnStatisticsRow>& rows)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	CanIdTable<CanPgnStatistics>& table = mPgnStatistics[bus];
+	rows.resize(table.GetCount());
+	for (U32 i = 0; i < table.GetCount(); i++)
+	{
+		rows[i].mPgn = table.GetIdentifier(i);
+		rows[i].mStatistics = table.GetEntry(i);
+	}
+}
+
+const char* CAN_FDJ1939::GetTransportString(U32 transport)
+{
+	switch (transport)
+	{
+	case J1939Bam:
+		return "BAM";
+	case J1939RtsCts:
+		return "RTS/CTS";
+	default:
+		return "";
+	}
+}
+
+const char* CAN_FDJ1939::GetStatusString(U32 status)
+{
+	switch (status)
+	{
+	case J1939Complete:
+		return "OK";
+	case J1939Timeout:
+		return "Timeout";
+	case J1939SequenceError:
+		return "Sequence error";
+	case J1939Aborted:
+		return "Aborted";
+	case J1939Interrupted:
+		return "Interrupted";
+	default:
+		return "";
+	}
+}
@@ -0,0 +1,123 @@
+#ifndef CAN_FD_J1939
+#define CAN_FD_J1939
+
+#include <AnalyzerTypes.h>
+#include "CAN_FDDecodedFrame.h"
+#include "CAN_FDIdTable.h"
+#include "CAN_FDAnalyzerSettings.h"
+#include <mutex>
+#include <vector>
+
+/* SAE J1939 on 29-bit frames: priority, PGN and addresses of every frame, and reassembly of the J1939-21 */
+/* transport protocol, both broadcast (BAM) and connection mode (RTS/CTS). */
+
+/* Largest message the transport protocol can carry, 255 packets of 7 bytes */
+#define J1939_MAX_TRANSPORT_BYTES 1785
+
+/* A transport session is abandoned when its next frame takes longer than this (T1 to T4 are 750 to 1250 ms). */
+/* Sessions are checked whenever another transport frame arrives on their bus, and at the end of the decode. */
+#define J1939_TRANSPORT_TIMEOUT_MS 1250
+
+#define J1939_GLOBAL_ADDRESS 0xFF
+
+enum CanJ1939Transport { J1939Single, J1939Bam, J1939RtsCts };
+enum CanJ1939Status { J1939Complete, J1939Timeout, J1939SequenceError, J1939Aborted, J1939Interrupted };
+
+/* One parameter group, either a single frame or a reassembled transport message. The payload is kept */
+/* in a byte arena shared by all records. */
+class CanJ1939Record
+{
+public:
+	U64 mStartingSample;
+	U64 mEndingSample;
+	U32 mBus;
+	U32 mPgn;
+	U8 mPriority;
+	U8 mSourceAddress;
+	U8 mDestinationAddress;
+	U8 mTransport;
+	U8 mStatus;
+	U32 mLength;			/* as announced, the payload may be shorter for unfinished transfers */
+	U32 mNumDataBytes;
+	U64 mDataOffset;
+};
+
+class CanJ1939Session
+{
+public:
+	CanJ1939Session() : mActive(false), mNumPackets(0), mNextSequence(0), mLastSample(0), mRecord() {}
+
+	bool mActive;
+	U32 mNumPackets;
+	U32 mNextSequence;
+	U64 mLastSample;
+	CanJ1939Record mRecord;
+	std::vector<U8> mData;
+};
+
+class CanPgnStatistics
+{
+public:
+	CanPgnStatistics() : mMessages(0), mTransportMessages(0), mBytes(0), mFirstSample(0), mLastSample(0)
+	{
+		for (U32 i = 0; i < 8; i++)
+			mSources[i] = 0;
+	}
+
+	U64 mMessages;
+	U64 mTransportMessages;
+	U64 mBytes;
+	U64 mFirstSample;
+	U64 mLastSample;
+	U32 mSources[8];		/* bit per source address */
+};
+
+class CanPgnStatisticsRow
+{
+public:
+	U32 mPgn;
+	CanPgnStatistics mStatistics;
+};
+
+/* Fed with every decoded 29-bit data frame by the worker thread, read by the export while decoding continues */
+class CAN_FDJ1939
+{
+public:
+	CAN_FDJ1939();
+	~CAN_FDJ1939();
+
+	void Reset(U32 sample_rate_hz);
+	void AddFrame(CanDecodedFrame& frame);
+
+	/* At the end of the decode, records the transport sessions still waiting for frames as timed out */
+	void Finish();
+
+	U32 GetNumRecords();
+	bool GetRecord(U32 index, CanJ1939Record& record, std::vector<U8>& data);
+	void GetStartOrder(std::vector<U32>& indices);
+	void GetPgnStatistics(U32 bus, std::vector<CanPgnStatisticsRow>& rows);
+
+	static const char* GetTransportString(U32 transport);
+	static const char* GetStatusString(U32 status);
+
+protected:
+	void AddConnectionManagement(CanDecodedFrame& frame, CanJ1939Record& header);
+	void AddDataTransfer(CanDecodedFrame& frame, CanJ1939Record& header);
+	CanJ1939Session& GetSession(U32 bus, U8 source_address, U8 destination_address);
+	CanJ1939Session* FindSession(U32 bus, U8 source_address, U8 destination_address);
+	void ExpireSessions(U32 bus, U64 sample);
+	void FinishSession(CanJ1939Session& session, CanJ1939Status status);
+	void AddRecord(CanJ1939Record& record, const U8* data, U32 num_bytes);
+
+	U64 mTimeoutSamples;
+
+	/* Transport sessions per bus, keyed by source address << 8 | destination address */
+	CanIdTable<CanJ1939Session> mSessions[CAN_FD_MAX_BUSES];
+
+	std::mutex mMutex;
+	std::vector<CanJ1939Record> mRecords;
+	std::vector<U8> mData;
+	CanIdTable<CanPgnStatistics> mPgnStatistics[CAN_FD_MAX_BUSES];
+};
+
+#endif //CAN_FD_J1939
@@ -0,0 +1,71 @@
+#include "CAN_FDPerfCounters.h"
+#include <AnalyzerHelpers.h>
+#include <sstream>
+
+static const char* gCounterNames[PerfCounterCount] =
+{
+	"AdvanceToAbsPosition calls",
+	"AdvanceToNextEdge calls",
+	"WouldAdvancing calls",
+	"Raw bits sampled",
+	"Bits used",
+	"Stuff bits",
+	"Classic frames (11-bit)",
+	"Classic frames (29-bit)",
+	"FD frames (11-bit)",
+	"FD frames (29-bit)",
+	"Remote frames",
+	"Incomplete frames",
+	"Error resyncs",
+	"Garbage bail-outs",
+	"Glitches ignored"
+};
+
+static const char* gTimerNames[PerfTimerCount] =
+{
+	"Idle wait",
+	"GetRawFrame",
+	"AnalyzeRawFrame",
+	"Result emission"
+};
+
+CanPerfCounters::CanPerfCounters()
+{
+	Reset();
+}
+
+void CanPerfCounters::Reset()
+{
+	for (U32 i = 0; i < PerfCounterCount; i++)
+		mCounts[i] = 0;
+
+	for (U32 i = 0; i < PerfTimerCount; i++)
+		mNanoseconds[i] = 0;
+}
+
+void CanPerfCounters::WriteToFile(const char* file)
+{
+#if CAN_FD_PERF_COUNTERS
+	std::stringstream ss;
+
+	ss << "Counter,Value" << std::endl;
+	for (U32 i = 0; i < PerfCounterCount; i++)
+		ss << gCounterNames[i] << "," << mCounts[i] << std::endl;
+
+	U64 frames = mCounts[PerfFramesClassic] + mCounts[PerfFramesClassicExtended] + mCounts[PerfFramesFD] + mCounts[PerfFramesFDExtended];
+
+	ss << std::endl;
+	ss << "Phase,Time [ms],Per frame [us]" << std::endl;
+	for (U32 i = 0; i < PerfTimerCount; i++)
+	{
+		ss << gTimerNames[i] << "," << (double(mNanoseconds[i]) / 1000000.0) << ",";
+		if (frames > 0)
+			ss << (double(mNanoseconds[i]) / 1000.0 / double(frames));
+		ss << std::endl;
+	}
+
+	void* f = AnalyzerHelpers::StartFile(file);
+	AnalyzerHelpers::AppendToFile((U8*)ss.str().c_str(), (U32)ss.str().length(), f);
+	AnalyzerHelpers::EndFile(f);
+#endif
+}
@@ -0,0 +1,85 @@
+#ifndef CAN_FD_PERF_COUNTERS_H
+#define CAN_FD_PERF_COUNTERS_H
+
+#include <AnalyzerTypes.h>
+#include <chrono>
+
+/* Decoder performance counters. Build with CAN_FD_PERF_COUNTERS=0 to compile all counting out of the hot paths. */
+#ifndef CAN_FD_PERF_COUNTERS
+#define CAN_FD_PERF_COUNTERS 1
+#endif
+
+enum CanPerfCounter
+{
+	PerfAdvanceToAbsPosition,
+	PerfAdvanceToNextEdge,
+	PerfWouldAdvance,
+	PerfRawBitsSampled,
+	PerfBitsUsed,
+	PerfStuffBits,
+	PerfFramesClassic,
+	PerfFramesClassicExtended,
+	PerfFramesFD,
+	PerfFramesFDExtended,
+	PerfFramesRemote,
+	PerfFramesIncomplete,
+	PerfErrorResyncs,
+	PerfGarbageBailouts,
+	PerfGlitchesIgnored,
+	PerfCounterCount
+};
+
+enum CanPerfTimer
+{
+	PerfTimeIdleWait,
+	PerfTimeRawFrame,
+	PerfTimeAnalyze,
+	PerfTimeResults,
+	PerfTimerCount
+};
+
+class CanPerfCounters
+{
+public:
+	CanPerfCounters();
+
+	void Reset();
+	void WriteToFile(const char* file);
+
+	U64 mCounts[PerfCounterCount];
+	U64 mNanoseconds[PerfTimerCount];
+};
+
+/* Adds the time until the end of the enclosing scope to one of the timers */
+class CanPerfScopedTimer
+{
+public:
+	CanPerfScopedTimer(CanPerfCounters& counters, CanPerfTimer timer)
+	:	mCounters(counters),
+		mTimer(timer),
+		mStart(std::chrono::steady_clock::now())
+	{
+	}
+
+	~CanPerfScopedTimer()
+	{
+		mCounters.mNanoseconds[mTimer] += (U64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mStart).count();
+	}
+
+protected:
+	CanPerfCounters& mCounters;
+	CanPerfTimer mTimer;
+	std::chrono::steady_clock::time_point mStart;
+};
+
+#if CAN_FD_PERF_COUNTERS
+#define CAN_PERF_COUNT(counters, counter) ((counters).mCounts[counter]++)
+#define CAN_PERF_ADD(counters, counter, amount) ((counters).mCounts[counter] += (amount))
+#define CAN_PERF_TIME(counters, timer) CanPerfScopedTimer can_perf_scoped_timer((counters), (timer))
+#else
+#define CAN_PERF_COUNT(counters, counter) ((void)0)
+#define CAN_PERF_ADD(counters, counter, amount) ((void)0)
+#define CAN_PERF_TIME(counters, timer) ((void)0)
+#endif
+
+#endif //CAN_FD_PERF_COUNTERS_H
@@ -1,499 +1,1306 @@
-#include "CAN_FDSimulationDataGenerator.h"
-#include "CAN_FDAnalyzerSettings.h"
-
-#include <AnalyzerHelpers.h>
-
-CAN_FDSimulationDataGenerator::CAN_FDSimulationDataGenerator()
-{
-}
-
-CAN_FDSimulationDataGenerator::~CAN_FDSimulationDataGenerator()
-{
-}
-
-void CAN_FDSimulationDataGenerator::Initialize( U32 simulation_sample_rate, CAN_FDAnalyzerSettings* settings )
-{
-	mSimulationSampleRateHz = simulation_sample_rate;
-	mSettings = settings;
-
-	mClockGeneratorHdr.Init(mSettings->mBitRateHdr, simulation_sample_rate);
-	mClockGeneratorData.Init(mSettings->mBitRateData, simulation_sample_rate);
-
-	mCanFDSimulationData.SetChannel(mSettings->mInputChannel);
-	mCanFDSimulationData.SetSampleRate(simulation_sample_rate);
-	mCanFDSimulationData.SetInitialBitState(mSettings->Recessive());
-
-	mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(10.0));
-	mValue = 0;
-}
-
-U32 CAN_FDSimulationDataGenerator::GenerateSimulationData(U64 largest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels)
-{
-	U64 adjusted_largest_sample_requested = AnalyzerHelpers::AdjustSimulationTargetSample(largest_sample_requested, sample_rate, mSimulationSampleRateHz);
-
-	std::vector<U8> data;
-	std::vector<U8> empty_data;
-
-	while (mCanFDSimulationData.GetCurrentSampleNumber() < adjusted_largest_sample_requested)
-	{
-		data.clear();
-		data.push_back(mValue + 0);
-		data.push_back(mValue + 1);
-		data.push_back(mValue + 2);
-		data.push_back(mValue + 3);
-
-		data.push_back(mValue + 4);
-		data.push_back(mValue + 5);
-		data.push_back(mValue + 6);
-		data.push_back(mValue + 7);
-
-		mValue++;
-
-
-		CreateDataOrRemoteFrame(123, false, false, data, true);
-		WriteFrame();
-
-		CreateDataOrRemoteFrame(321, true, false, data, true);
-		WriteFrame();
-
-		CreateDataOrRemoteFrame(456, true, false, data, true);
-		WriteFrame(true);
-
-		mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(40));
-
-		CreateDataOrRemoteFrame(123, false, true, empty_data, true);
-		WriteFrame();
-
-		CreateDataOrRemoteFrame(321, true, true, empty_data, true);
-		WriteFrame();
-
-		mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(100));
-	}
-
-	*simulation_channels = &mCanFDSimulationData;
-	return 1;  // we are retuning the size of the SimulationChannelDescriptor array.  In our case, the "array" is length 1.
-}
-
-void CAN_FDSimulationDataGenerator::CreateDataOrRemoteFrame(U32 identifier, bool use_extended_frame_format, bool remote_frame, std::vector<U8>& data, bool get_ack_in_response)
-{
-	//A DATA FRAME is composed of seven different bit fields:
-	//START OF FRAME, ARBITRATION FIELD, CONTROL FIELD, DATA FIELD, CRC
-	//FIELD, ACK FIELD, END OF FRAME. The DATA FIELD can be of length zero.
-
-	mFakeStuffedBits.clear();
-	mFakeFixedFormBits.clear();
-	mFakeStartOfFrameField.clear();
-	mFakeArbitrationField.clear();
-	mFakeControlField.clear();
-	mFakeDataField.clear();
-	mFakeCrcFieldWithoutDelimiter.clear();
-	mFakeAckField.clear();
-	mFakeEndOfFrame.clear();
-
-	//START OF FRAME (Standard Format as well as Extended Format)
-	//The START OF FRAME (SOF) marks the beginning of DATA FRAMES and REMOTE
-	//FRAMEs. It consists of a single dominant bit.
-	//A station is only allowed to start transmission when the bus is idle (see INTERFRAME
-	//Spacing). All stations have to synchronize to the leading edge caused by START OF
-	//FRAME (see HARD SYNCHRONIZATION) of the station starting transmission first.
-
-	mFakeStartOfFrameField.push_back(mSettings->Dominant());
-
-	//ARBITRATION FIELD
-	//The format of the ARBITRATION FIELD is different for Standard Format and
-	//Extended Format Frames.
-
-	//In Standard Format the ARBITRATION FIELD consists of the 11 bit IDENTIFIER
-	//and the RTR-BIT. The IDENTIFIER bits are denoted ID-28 ... ID-18.
-
-	//In Extended Format the ARBITRATION FIELD consists of the 29 bit IDENTIFIER,
-	//the SRR-Bit, the IDE-Bit, and the RTR-BIT. The IDENTIFIER bits are denoted ID-28
-	//... ID-0.
-
-	if (use_extended_frame_format == true)
-	{
-		U32 mask = 1 << 28;  //28 bits in exdended format's identifier.
-
-		//IDENTIFIER - Extended Format
-		//In contrast to the Standard Format the Extended Format consists of 29 bits. The
-		//format comprises two sections:
-
-		//Base ID
-		//The Base ID consists of 11 bits. It is transmitted in the order from ID-28 to ID-18. It
-		//is equivalent to format of the Standard Identifier. The Base ID defines the Extended
-		//Frames base priority.
-
-		//Extended ID
-		//The Extended ID consists of 18 bits. It is transmitted in the order of ID-17 to ID-0.
-
-		//11 bits of identifier:
-		for (U32 i = 0; i < 11; i++)
-		{
-			if ((mask & identifier) == 0)
-				mFakeArbitrationField.push_back(mSettings->Dominant());
-			else
-				mFakeArbitrationField.push_back(mSettings->Recessive());
-
-			mask >>= 1;
-		}
-
-		//the next bit is SRR
-		//SRR BIT (Extended Format)
-		//Substitute Remote Request BIT
-		//The SRR is a recessive bit. It is transmitted in Extended Frames at the position of the
-		//RTR bit in Standard Frames and so substitutes the RTR-Bit in the Standard Frame.
-		//Therefore, collisions of a Standard Frame and an Extended Frame, the Base ID (see
-		//Extended IDENTIFIER below) of which is the same as the Standard Frames Identifier,
-		//are resolved in such a way that the Standard Frame prevails the Extended Frame.
-
-		mFakeArbitrationField.push_back(mSettings->Recessive());  //SSR bit
-
-		//the next bit is IDE
-		//IDE BIT (Extended Format)
-		//Identifier Extension Bit
-		//The IDE Bit belongs to
-		//- the ARBITRATION FIELD for the Extended Format
-		//- the Control Field for the Standard Format
-		//The IDE bit in the Standard Format is transmitted dominant, whereas in the Extended
-		//Format the IDE bit is recessive.
-
-		mFakeArbitrationField.push_back(mSettings->Recessive()); //IDE bit
-
-		//18 bits of identifier:
-		for (U32 i = 0; i < 18; i++)
-		{
-			if ((mask & identifier) == 0)
-				mFakeArbitrationField.push_back(mSettings->Dominant());
-			else
-				mFakeArbitrationField.push_back(mSettings->Recessive());
-
-			mask >>= 1;
-		}
-
-		//the next bit is RTR
-		//RTR BIT (Standard Format as well as Extended Format)
-		//Remote Transmission Request BIT
-		//In DATA FRAMEs the RTR BIT has to be dominant. Within a REMOTE FRAME the
-		//RTR BIT has to be recessive.
-
-		if (remote_frame == true)
-			mFakeArbitrationField.push_back(mSettings->Recessive()); //RTR bit
-		else
-			mFakeArbitrationField.push_back(mSettings->Dominant()); //RTR bit
-
-
-		//next is the control field.  r1, r0, DLC3, DLC2, DLC1, DLC0
-
-		//CONTROL FIELD (Standard Format as well as Extended Format)
-		//The CONTROL FIELD consists of six bits. The format of the CONTROL FIELD is
-		//different for Standard Format and Extended Format. Frames in Standard Format
-		//include the DATA LENGTH CODE, the IDE bit, which is transmitted dominant (see
-		//above), and the reserved bit r0. Frames in the Extended Format include the DATA
-		//LENGTH CODE and two reserved bits r1 and r0. The reserved bits have to be sent
-		//dominant, but receivers accept dominant and recessive bits in all combinations.
-
-		mFakeControlField.push_back(mSettings->Recessive()); //r1 bit
-		mFakeControlField.push_back(mSettings->Recessive()); //r0 bit
-	}
-	else
-	{
-		//IDENTIFIER
-		//IDENTIFIER - Standard Format
-		//The IDENTIFIERs length is 11 bits and corresponds to the Base ID in Extended
-		//Format. These bits are transmitted in the order from ID-28 to ID-18. The least
-		//significant bit is ID-18. The 7 most significant bits (ID-28 - ID-22) must not be all
-		//recessive.
-
-		//In a Standard Frame the IDENTIFIER is followed by the RTR bit.
-		//RTR BIT (Standard Format as well as Extended Format)
-		//Remote Transmission Request BIT
-		//In DATA FRAMEs the RTR BIT has to be dominant. Within a REMOTE FRAME the
-		//RTR BIT has to be recessive.
-
-
-		U32 mask = 1 << 10;
-		for (U32 i = 0; i < 11; i++)
-		{
-			if ((mask & identifier) == 0)
-				mFakeArbitrationField.push_back(mSettings->Dominant());
-			else
-				mFakeArbitrationField.push_back(mSettings->Recessive());
-
-			mask >>= 1;
-		}
-
-		//the next bit is RTR
-		//RTR BIT (Standard Format as well as Extended Format)
-		//Remote Transmission Request BIT
-		//In DATA FRAMEs the RTR BIT has to be dominant. Within a REMOTE FRAME the
-		//RTR BIT has to be recessive.
-
-		if (remote_frame == true)
-			mFakeArbitrationField.push_back(mSettings->Recessive()); //RTR bit
-		else
-			mFakeArbitrationField.push_back(mSettings->Dominant()); //RTR bit
-
-		//next is the control field.  r1, r0, DLC3, DLC2, DLC1, DLC0
-
-		//CONTROL FIELD (Standard Format as well as Extended Format)
-		//The CONTROL FIELD consists of six bits. The format of the CONTROL FIELD is
-		//different for Standard Format and Extended Format. Frames in Standard Format
-		//include the DATA LENGTH CODE, the IDE bit, which is transmitted dominant (see
-		//above), and the reserved bit r0. Frames in the Extended Format include the DATA
-		//LENGTH CODE and two reserved bits r1 and r0. The reserved bits have to be sent
-		//dominant, but receivers accept dominant and recessive bits in all combinations.
-
-		mFakeControlField.push_back(mSettings->Dominant()); //IDE bit
-		mFakeControlField.push_back(mSettings->Dominant()); //r0 bit
-	}
-
-
-	//send 4 bits for the length of the attached data.
-	U32 data_size = (U32)data.size();
-	if (data_size > 9)
-		AnalyzerHelpers::Assert("can't sent more than 8 bytes");
-
-	if (remote_frame == true)
-		if (data_size != 0)
-			AnalyzerHelpers::Assert("remote frames can't send data");
-
-	U32 mask = 1 << 3;
-	for (U32 i = 0; i < 4; i++)
-	{
-		if ((mask & data_size) == 0)
-			mFakeControlField.push_back(mSettings->Dominant());
-		else
-			mFakeControlField.push_back(mSettings->Recessive());
-
-		mask >>= 1;
-	}
-
-	//next is the DATA FIELD
-	//DATA FIELD (Standard Format as well as Extended Format)
-	//The DATA FIELD consists of the data to be transferred within a DATA FRAME. It can
-	//contain from 0 to 8 bytes, which each contain 8 bits which are transferred MSB first.
-
-	if (remote_frame == false)
-	{
-		for (U32 i = 0; i < data_size; i++)
-		{
-			U32 dat = data[i];
-			U32 mask = 0x80;
-
-			for (U32 j = 0; j < 8; j++)
-			{
-				if ((mask & dat) == 0)
-					mFakeDataField.push_back(mSettings->Dominant());
-				else
-					mFakeDataField.push_back(mSettings->Recessive());
-
-				mask >>= 1;
-			}
-		}
-	}
-
-	//CRC FIELD (Standard Format as well as Extended Format)
-	//contains the CRC SEQUENCE followed by a CRC DELIMITER.
-
-	AddCrc();
-
-
-	//ACK FIELD (Standard Format as well as Extended Format)
-	//The ACK FIELD is two bits long and contains the ACK SLOT and the ACK DELIMITER.
-	//In the ACK FIELD the transmitting station sends two recessive bits.
-	//A RECEIVER which has received a valid message correctly, reports this to the
-	//TRANSMITTER by sending a dominant bit during the ACK SLOT (it sends ACK).
-
-	//ACK SLOT
-	//All stations having received the matching CRC SEQUENCE report this within the ACK
-	//SLOT by superscribing the recessive bit of the TRANSMITTER by a dominant bit.
-
-	if (get_ack_in_response == true)
-		mFakeAckField.push_back(mSettings->Dominant());
-	else
-		mFakeAckField.push_back(mSettings->Recessive());
-
-	//ACK DELIMITER
-	//The ACK DELIMITER is the second bit of the ACK FIELD and has to be a recessive
-	//bit. As a consequence, the ACK SLOT is surrounded by two recessive bits (CRC
-	//DELIMITER, ACK DELIMITER).
-
-	mFakeAckField.push_back(mSettings->Recessive());
-
-	//END OF FRAME (Standard Format as well as Extended Format)
-	//Each DATA FRAME and REMOTE FRAME is delimited by a flag sequence consisting
-	//of seven recessive bits.
-
-	for (U32 i = 0; i < 7; i++)
-		mFakeEndOfFrame.push_back(mSettings->Recessive());
-
-
-	mFakeFixedFormBits.insert(mFakeFixedFormBits.end(), mFakeAckField.begin(), mFakeAckField.end());
-	mFakeFixedFormBits.insert(mFakeFixedFormBits.end(), mFakeEndOfFrame.begin(), mFakeEndOfFrame.end());
-}
-
-void CAN_FDSimulationDataGenerator::AddCrc()
-{
-	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeStartOfFrameField.begin(), mFakeStartOfFrameField.end());
-	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeArbitrationField.begin(), mFakeArbitrationField.end());
-	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeControlField.begin(), mFakeControlField.end());
-	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeDataField.begin(), mFakeDataField.end());
-
-	U32 bits_for_crc = (U32)mFakeStuffedBits.size();
-	U16 crc = ComputeCrc(mFakeStuffedBits, bits_for_crc);
-	U32 mask = 0x4000;
-	for (U32 i = 0; i < 15; i++)
-	{
-		if ((mask & crc) == 0)
-			mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Dominant());
-		else
-			mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Recessive());
-
-		mask >>= 1;
-	}
-
-	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeCrcFieldWithoutDelimiter.begin(), mFakeCrcFieldWithoutDelimiter.end());
-
-	//CRC DELIMITER (Standard Format as well as Extended Format)
-	//The CRC SEQUENCE is followed by the CRC DELIMITER which consists of a single
-	//recessive bit.
-
-	mFakeFixedFormBits.push_back(mSettings->Recessive());
-}
-
-U16 CAN_FDSimulationDataGenerator::ComputeCrc(std::vector<BitState>& bits, U32 num_bits)
-{
-	//note that this is a 15 bit CRC (not 16-bit)
-
-	//CRC FIELD (Standard Format as well as Extended Format)
-	//contains the CRC SEQUENCE followed by a CRC DELIMITER.
-	//CRC SEQUENCE (Standard Format as well as Extended Format)
-	//The frame check sequence is derived from a cyclic redundancy code best suited for
-	///frames with bit counts less than 127 bits (BCH Code).
-	//In order to carry out the CRC calculation the polynomial to be divided is defined as the
-	//polynomial, the coefficients of which are given by the destuffed bit stream consisting of
-	//START OF FRAME, ARBITRATION FIELD, CONTROL FIELD, DATA FIELD (if
-	///present) and, for the 15 lowest coefficients, by 0. This polynomial is divided (the
-	//coefficients are calculated modulo-2) by the generator-polynomial:
-	//X15 + X14 + X10 + X8 + X7 + X4 + X3 + 1.
-	//The remainder of this polynomial division is the CRC SEQUENCE transmitted over the
-	//bus. In order to implement this function, a 15 bit shift register CRC_RG(14:0) can be
-	//used. If NXTBIT denotes the next bit of the bit stream, given by the destuffed bit
-	//sequence from START OF FRAME until the end of the DATA FIELD, the CRC
-	//SEQUENCE is calculated as follows:
-
-	//CRC_RG = 0; // initialize shift register
-	//REPEAT
-	//CRCNXT = NXTBIT EXOR CRC_RG(14);
-	//CRC_RG(14:1) = CRC_RG(13:0); // shift left by
-	//CRC_RG(0) = 0; // 1 position
-	//IF CRCNXT THEN
-	//CRC_RG(14:0) = CRC_RG(14:0) EXOR (4599hex);
-	//ENDIF
-	//UNTIL (CRC SEQUENCE starts or there is an ERROR condition)
-
-	//After the transmission / reception of the last bit of the DATA FIELD, CRC_RG contains
-	//the CRC sequence.
-
-	U16 crc_result = 0;
-	for (U32 i = 0; i < num_bits; i++)
-	{
-		BitState next_bit = bits[i];
-
-		//Exclusive or
-		if ((crc_result & 0x4000) != 0)
-		{
-			next_bit = Invert(next_bit);  //if the msb of crc_result is zero, then next_bit is not inverted; otherwise, it is.
-		}
-
-		crc_result <<= 1;
-
-		if (next_bit == mSettings->Recessive()) //normally bit high.
-			crc_result ^= 0x4599;
-	}
-
-	return crc_result & 0x7FFF;
-}
-
-void CAN_FDSimulationDataGenerator::WriteFrame(bool error)
-{
-	U32 recessive_count = 0;
-	U32 dominant_count = 0;
-
-	//The frame segments START OF FRAME, ARBITRATION FIELD, CONTROL FIELD,
-	//DATA FIELD and CRC SEQUENCE are coded by the method of bit stuffing. Whenever
-	//a transmitter detects five consecutive bits of identical value in the bit stream to be
-	//transmitted it automatically inserts a complementary bit in the actual transmitted bit
-	//stream.
-
-	//The remaining bit fields of the DATA FRAME or REMOTE FRAME (CRC DELIMITER,
-	//ACK FIELD, and END OF FRAME) are of fixed form and not stuffed. The ERROR
-	//FRAME and the OVERLOAD FRAME are of fixed form as well and not coded by the
-	//method of bit stuffing.
-
-	U32 count = (U32)mFakeStuffedBits.size();
-
-	if (error == true)
-		count -= 9;
-
-	for (U32 i = 0; i < count; i++)
-	{
-
-		if (recessive_count == 5)
-		{
-			mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(1.0));
-			recessive_count = 0;
-			dominant_count = 1; // this stuffed bit counts
-
-			mCanFDSimulationData.Transition(); //to DOMINANT
-		}
-
-		if (dominant_count == 5)
-		{
-			mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(1.0));
-			dominant_count = 0;
-			recessive_count = 1; // this stuffed bit counts
-
-			mCanFDSimulationData.Transition(); //to RECESSIVE
-		}
-
-		BitState bit = mFakeStuffedBits[i];
-
-		if (bit == mSettings->Recessive())
-		{
-			recessive_count++;
-			dominant_count = 0;
-		}
-		else
-		{
-			dominant_count++;
-			recessive_count = 0;
-		}
-
-		mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(1.0));
-		mCanFDSimulationData.TransitionIfNeeded(bit);
-	}
-
-	if (error == true)
-	{
-		if (mCanFDSimulationData.GetCurrentBitState() != mSettings->Dominant())
-		{
-			mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(1.0));
-			mCanFDSimulationData.Transition(); //to DOMINANT
-		}
-
-		mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(8.0));
-
-		mCanFDSimulationData.Transition(); //to DOMINANT
-
-		return;
-	}
-
-	count = (U32)mFakeFixedFormBits.size();
-
-	for (U32 i = 0; i < count; i++)
-	{
-		mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(1.0));
-		mCanFDSimulationData.TransitionIfNeeded(mFakeFixedFormBits[i]);
-	}
-}
+#include "CAN_FDSimulationDataGenerator.h"
+#include "CAN_FDAnalyzerSettings.h"
+
+#include <AnalyzerHelpers.h>
+#include <cstring>
+
+/* Number of data bytes for each CAN-FD DLC value */
+static const U32 gFdDataBytes[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64 };
+
+/* Stuff count modulo 8, Gray coded as sent in the CAN-FD CRC field */
+static const U32 gStuffCountGray[8] = { 0, 1, 3, 2, 6, 7, 5, 4 };
+
+static const char* gFaultNames[SimFaultCount] = { "none", "stuff", "flip", "form", "ack", "error", "overload", "collision" };
+
+CanSimulationOptions::CanSimulationOptions()
+:	mFaultRate( 0 ),
+	mClockOffsetPpm( 0 ),
+	mJitterNs( 0 ),
+	mAsymmetryNs( 0 ),
+	mGlitchRate( 0 ),
+	mGlitchNs( 20 )
+{
+}
+
+CAN_FDSimulationDataGenerator::CAN_FDSimulationDataGenerator()
+:	mGroundTruth( NULL )
+{
+}
+
+CAN_FDSimulationDataGenerator::~CAN_FDSimulationDataGenerator()
+{
+	if (mGroundTruth != NULL)
+		fclose(mGroundTruth);
+}
+
+const char* CAN_FDSimulationDataGenerator::GetFaultName(CanSimFault fault)
+{
+	return gFaultNames[fault];
+}
+
+bool CAN_FDSimulationDataGenerator::ParseFaults(const std::string& text, U32& fault_mask)
+{
+	fault_mask = 0;
+
+	const char* p = text.c_str();
+	for (; ; )
+	{
+		while ((*p == ' ') || (*p == '\t'))
+			p++;
+
+		const char* name = p;
+		while ((*p != 0) && (*p != ',') && (*p != ' ') && (*p != '\t'))
+			p++;
+		size_t length = p - name;
+
+		while ((*p == ' ') || (*p == '\t'))
+			p++;
+
+		if (length == 0)
+		{
+			/* Only an empty list, not an empty name within one */
+			if ((*p != 0) || (fault_mask != 0))
+				return false;
+			break;
+		}
+
+		U32 fault = SimFaultNone + 1;
+		while ((fault < SimFaultCount) && ((strlen(gFaultNames[fault]) != length) || (strncmp(gFaultNames[fault], name, length) != 0)))
+			fault++;
+		if (fault == SimFaultCount)
+			return false;
+
+		fault_mask |= 1 << fault;
+
+		if (*p == 0)
+			return true;
+		if (*p != ',')
+			return false;
+		p++;
+	}
+
+	for (U32 fault = SimFaultNone + 1; fault < SimFaultCount; fault++)
+		fault_mask |= 1 << fault;
+	return true;
+}
+
+void CAN_FDSimulationDataGenerator::SetOptions(const CanSimulationOptions& options)
+{
+	mOptions = options;
+}
+
+void CAN_FDSimulationDataGenerator::Initialize( U32 simulation_sample_rate, CAN_FDAnalyzerSettings* settings )
+{
+	mSimulationSampleRateHz = simulation_sample_rate;
+	mSettings = settings;
+
+	mClockGeneratorHdr.Init(mSettings->mBitRateHdr, simulation_sample_rate);
+	mClockGeneratorData.Init(mSettings->mBitRateData, simulation_sample_rate);
+
+	/* The analyzer works in whole data bits per header bit, so the simulation does as well */
+	mBitRateFactor = mSettings->mBitRateData / mSettings->mBitRateHdr;
+	if (mBitRateFactor == 0)
+		mBitRateFactor = 1;
+
+	mCanFDSimulationData.SetChannel(mSettings->mInputChannel);
+	mCanFDSimulationData.SetSampleRate(simulation_sample_rate);
+	mCanFDSimulationData.SetInitialBitState(mSettings->Recessive());
+
+	mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(10.0));
+	mValue = 0;
+	mPass = 0;
+	mNoiseSeed = 1;
+
+	mFaultRate = mOptions.mFaultRate;
+	if (ParseFaults(mOptions.mFaults, mFaultMask) == false)
+		mFaultMask = 0;
+	mFaultSeed = 1;
+	mNextFault = SimFaultNone + 1;
+
+	double samples_per_ns = double(simulation_sample_rate) / 1000000000.0;
+	mClockOffsetPpm = mOptions.mClockOffsetPpm;
+	mJitterSamples = double(mOptions.mJitterNs) * samples_per_ns;
+	mAsymmetrySamples = double(mOptions.mAsymmetryNs) * samples_per_ns;
+	mGlitchRate = mOptions.mGlitchRate;
+	mGlitchSamples = U32(double(mOptions.mGlitchNs) * samples_per_ns + 0.5);
+	if (mGlitchSamples == 0)
+		mGlitchSamples = 1;
+	mImpairmentSeed = 1;
+	mImpaired = (mClockOffsetPpm > 0) || (mJitterSamples > 0.0) || (mAsymmetrySamples > 0.0) || (mGlitchRate > 0);
+	mFrameBits = 0;
+	mGlitchBit = 0xFFFFFFFF;
+	mGlitchSample = 0;
+
+	if (mGroundTruth != NULL)
+		fclose(mGroundTruth);
+	mGroundTruth = NULL;
+
+	/* Without the file the simulation carries on, it just has nothing to compare against */
+	if (mOptions.mGroundTruthFile.empty() == false)
+		mGroundTruth = fopen(mOptions.mGroundTruthFile.c_str(), "w");
+	if (mGroundTruth != NULL)
+		fprintf(mGroundTruth, "Time [s],End [s],Identifier,Fault,Fault at [s],Error flag at [s],Glitch at [s],Status\n");
+}
+
+U32 CAN_FDSimulationDataGenerator::GenerateSimulationData(U64 largest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channels)
+{
+	U64 adjusted_largest_sample_requested = AnalyzerHelpers::AdjustSimulationTargetSample(largest_sample_requested, sample_rate, mSimulationSampleRateHz);
+
+	std::vector<U8> data;
+	std::vector<U8> fd_data;
+	std::vector<U8> empty_data;
+
+	while (mCanFDSimulationData.GetCurrentSampleNumber() < adjusted_largest_sample_requested)
+	{
+		/* Successive passes step the classic frames through DLC 0 to 8 and the CAN-FD frames through */
+		/* DLC 0 to 15. The two CAN-FD frames take turns switching bit rate. */
+		data.clear();
+		for (U32 i = 0; i < (mPass % 9); i++)
+			data.push_back(mValue + i);
+
+		fd_data.clear();
+		for (U32 i = 0; i < gFdDataBytes[mPass % 16]; i++)
+			fd_data.push_back(mValue + i);
+
+		mValue++;
+
+
+		CreateDataOrRemoteFrame(123, false, false, data, true);
+		SendFrame();
+
+		CreateDataOrRemoteFrame(321, true, false, data, true);
+		SendFrame();
+
+		CreateFdFrame(654, false, (mPass & 1) == 0, fd_data, true);
+		SendFrame();
+
+		CreateFdFrame(987654, true, (mPass & 1) != 0, fd_data, true);
+		SendFrame();
+
+		CreateDataOrRemoteFrame(456, true, false, data, true);
+		SendFrame(true);
+
+		mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(40));
+
+		CreateDataOrRemoteFrame(123, false, true, empty_data, true);
+		SendFrame();
+
+		CreateDataOrRemoteFrame(321, true, true, empty_data, true);
+		SendFrame();
+
+		/* Now and then the bus picks up a burst of noise */
+		if ((mPass % 16) == 15)
+		{
+			mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(20));
+			WriteNoiseBurst(64);
+		}
+
+		mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(100));
+		mPass++;
+	}
+
+	if (mGroundTruth != NULL)
+		fflush(mGroundTruth);
+
+	*simulation_channels = &mCanFDSimulationData;
+	return 1;  // we are retuning the size of the SimulationChannelDescriptor array.  In our case, the "array" is length 1.
+}
+
+void CAN_FDSimulationDataGenerator::CreateDataOrRemoteFrame(U32 identifier, bool use_extended_frame_format, bool remote_frame, std::vector<U8>& data, bool get_ack_in_response)
+{
+	//A DATA FRAME is composed of seven different bit fields:
+	//START OF FRAME, ARBITRATION FIELD, CONTROL FIELD, DATA FIELD, CRC
+	//FIELD, ACK FIELD, END OF FRAME. The DATA FIELD can be of length zero.
+
+	mFakeStuffedBits.clear();
+	mFakeFixedFormBits.clear();
+	mFakeStartOfFrameField.clear();
+	mFakeArbitrationField.clear();
+	mFakeControlField.clear();
+	mFakeDataField.clear();
+	mFakeCrcFieldWithoutDelimiter.clear();
+	mFakeAckField.clear();
+	mFakeEndOfFrame.clear();
+
+	mFdFrame = false;
+	mBrsBitIndex = 0xFFFFFFFF;
+
+	mFrameIdentifier = identifier;
+	mFrameExtended = use_extended_frame_format;
+	mFrameRemote = remote_frame;
+	mFrameBitRateSwitch = false;
+	mFrameData = data;
+
+	//START OF FRAME (Standard Format as well as Extended Format)
+	//The START OF FRAME (SOF) marks the beginning of DATA FRAMES and REMOTE
+	//FRAMEs. It consists of a single dominant bit.
+	//A station is only allowed to start transmission when the bus is idle (see INTERFRAME
+	//Spacing). All stations have to synchronize to the leading edge caused by START OF
+	//FRAME (see HARD SYNCHRONIZATION) of the station starting transmission first.
+
+	mFakeStartOfFrameField.push_back(mSettings->Dominant());
+
+	//ARBITRATION FIELD
+	//The format of the ARBITRATION FIELD is different for Standard Format and
+	//Extended Format Frames.
+
+	//In Standard Format the ARBITRATION FIELD consists of the 11 bit IDENTIFIER
+	//and the RTR-BIT. The IDENTIFIER bits are denoted ID-28 ... ID-18.
+
+	//In Extended Format the ARBITRATION FIELD consists of the 29 bit IDENTIFIER,
+	//the SRR-Bit, the IDE-Bit, and the RTR-BIT. The IDENTIFIER bits are denoted ID-28
+	//... ID-0.
+
+	if (use_extended_frame_format == true)
+	{
+		U32 mask = 1 << 28;  //28 bits in exdended format's identifier.
+
+		//IDENTIFIER - Extended Format
+		//In contrast to the Standard Format the Extended Format consists of 29 bits. The
+		//format comprises two sections:
+
+		//Base ID
+		//The Base ID consists of 11 bits. It is transmitted in the order from ID-28 to ID-18. It
+		//is equivalent to format of the Standard Identifier. The Base ID defines the Extended
+		//Frames base priority.
+
+		//Extended ID
+		//The Extended ID consists of 18 bits. It is transmitted in the order of ID-17 to ID-0.
+
+		//11 bits of identifier:
+		for (U32 i = 0; i < 11; i++)
+		{
+			if ((mask & identifier) == 0)
+				mFakeArbitrationField.push_back(mSettings->Dominant());
+			else
+				mFakeArbitrationField.push_back(mSettings->Recessive());
+
+			mask >>= 1;
+		}
+
+		//the next bit is SRR
+		//SRR BIT (Extended Format)
+		//Substitute Remote Request BIT
+		//The SRR is a recessive bit. It is transmitted in Extended Frames at the position of the
+		//RTR bit in Standard Frames and so substitutes the RTR-Bit in the Standard Frame.
+		//Therefore, collisions of a Standard Frame and an Extended Frame, the Base ID (see
+		//Extended IDENTIFIER below) of which is the same as the Standard Frames Identifier,
+		//are resolved in such a way that the Standard Frame prevails the Extended Frame.
+
+		mFakeArbitrationField.push_back(mSettings->Recessive());  //SSR bit
+
+		//the next bit is IDE
+		//IDE BIT (Extended Format)
+		//Identifier Extension Bit
+		//The IDE Bit belongs to
+		//- the ARBITRATION FIELD for the Extended Format
+		//- the Control Field for the Standard Format
+		//The IDE bit in the Standard Format is transmitted dominant, whereas in the Extended
+		//Format the IDE bit is recessive.
+
+		mFakeArbitrationField.push_back(mSettings->Recessive()); //IDE bit
+
+		//18 bits of identifier:
+		for (U32 i = 0; i < 18; i++)
+		{
+			if ((mask & identifier) == 0)
+				mFakeArbitrationField.push_back(mSettings->Dominant());
+			else
+				mFakeArbitrationField.push_back(mSettings->Recessive());
+
+			mask >>= 1;
+		}
+
+		//the next bit is RTR
+		//RTR BIT (Standard Format as well as Extended Format)
+		//Remote Transmission Request BIT
+		//In DATA FRAMEs the RTR BIT has to be dominant. Within a REMOTE FRAME the
+		//RTR BIT has to be recessive.
+
+		if (remote_frame == true)
+			mFakeArbitrationField.push_back(mSettings->Recessive()); //RTR bit
+		else
+			mFakeArbitrationField.push_back(mSettings->Dominant()); //RTR bit
+
+
+		//next is the control field.  r1, r0, DLC3, DLC2, DLC1, DLC0
+
+		//CONTROL FIELD (Standard Format as well as Extended Format)
+		//The CONTROL FIELD consists of six bits. The format of the CONTROL FIELD is
+		//different for Standard Format and Extended Format. Frames in Standard Format
+		//include the DATA LENGTH CODE, the IDE bit, which is transmitted dominant (see
+		//above), and the reserved bit r0. Frames in the Extended Format include the DATA
+		//LENGTH CODE and two reserved bits r1 and r0. The reserved bits have to be sent
+		//dominant, but receivers accept dominant and recessive bits in all combinations.
+
+		mFakeControlField.push_back(mSettings->Dominant()); //r1 bit
+		mFakeControlField.push_back(mSettings->Dominant()); //r0 bit
+	}
+	else
+	{
+		//IDENTIFIER
+		//IDENTIFIER - Standard Format
+		//The IDENTIFIERs length is 11 bits and corresponds to the Base ID in Extended
+		//Format. These bits are transmitted in the order from ID-28 to ID-18. The least
+		//significant bit is ID-18. The 7 most significant bits (ID-28 - ID-22) must not be all
+		//recessive.
+
+		//In a Standard Frame the IDENTIFIER is followed by the RTR bit.
+		//RTR BIT (Standard Format as well as Extended Format)
+		//Remote Transmission Request BIT
+		//In DATA FRAMEs the RTR BIT has to be dominant. Within a REMOTE FRAME the
+		//RTR BIT has to be recessive.
+
+
+		U32 mask = 1 << 10;
+		for (U32 i = 0; i < 11; i++)
+		{
+			if ((mask & identifier) == 0)
+				mFakeArbitrationField.push_back(mSettings->Dominant());
+			else
+				mFakeArbitrationField.push_back(mSettings->Recessive());
+
+			mask >>= 1;
+		}
+
+		//the next bit is RTR
+		//RTR BIT (Standard Format as well as Extended Format)
+		//Remote Transmission Request BIT
+		//In DATA FRAMEs the RTR BIT has to be dominant. Within a REMOTE FRAME the
+		//RTR BIT has to be recessive.
+
+		if (remote_frame == true)
+			mFakeArbitrationField.push_back(mSettings->Recessive()); //RTR bit
+		else
+			mFakeArbitrationField.push_back(mSettings->Dominant()); //RTR bit
+
+		//next is the control field.  r1, r0, DLC3, DLC2, DLC1, DLC0
+
+		//CONTROL FIELD (Standard Format as well as Extended Format)
+		//The CONTROL FIELD consists of six bits. The format of the CONTROL FIELD is
+		//different for Standard Format and Extended Format. Frames in Standard Format
+		//include the DATA LENGTH CODE, the IDE bit, which is transmitted dominant (see
+		//above), and the reserved bit r0. Frames in the Extended Format include the DATA
+		//LENGTH CODE and two reserved bits r1 and r0. The reserved bits have to be sent
+		//dominant, but receivers accept dominant and recessive bits in all combinations.
+
+		mFakeControlField.push_back(mSettings->Dominant()); //IDE bit
+		mFakeControlField.push_back(mSettings->Dominant()); //r0 bit
+	}
+
+
+	//send 4 bits for the length of the attached data.
+	U32 data_size = (U32)data.size();
+	if (data_size > 8)
+		AnalyzerHelpers::Assert("can't sent more than 8 bytes");
+
+	if (remote_frame == true)
+		if (data_size != 0)
+			AnalyzerHelpers::Assert("remote frames can't send data");
+
+	U32 mask = 1 << 3;
+	for (U32 i = 0; i < 4; i++)
+	{
+		if ((mask & data_size) == 0)
+			mFakeControlField.push_back(mSettings->Dominant());
+		else
+			mFakeControlField.push_back(mSettings->Recessive());
+
+		mask >>= 1;
+	}
+
+	//next is the DATA FIELD
+	//DATA FIELD (Standard Format as well as Extended Format)
+	//The DATA FIELD consists of the data to be transferred within a DATA FRAME. It can
+	//contain from 0 to 8 bytes, which each contain 8 bits which are transferred MSB first.
+
+	if (remote_frame == false)
+	{
+		for (U32 i = 0; i < data_size; i++)
+		{
+			U32 dat = data[i];
+			U32 mask = 0x80;
+
+			for (U32 j = 0; j < 8; j++)
+			{
+				if ((mask & dat) == 0)
+					mFakeDataField.push_back(mSettings->Dominant());
+				else
+					mFakeDataField.push_back(mSettings->Recessive());
+
+				mask >>= 1;
+			}
+		}
+	}
+
+	//CRC FIELD (Standard Format as well as Extended Format)
+	//contains the CRC SEQUENCE followed by a CRC DELIMITER.
+
+	AddCrc();
+
+
+	AddAckAndEndOfFrame(get_ack_in_response);
+}
+
+void CAN_FDSimulationDataGenerator::CreateFdFrame(U32 identifier, bool use_extended_frame_format, bool bit_rate_switch, std::vector<U8>& data, bool get_ack_in_response)
+{
+	//A CAN-FD frame has the same fields as a classic DATA FRAME. The control field gains the
+	//FDF, res, BRS and ESI bits, the DLC codes up to 64 data bytes, and the CRC field carries
+	//a stuff count and a 17 or 21 bit CRC with fixed stuff bits. There are no remote frames.
+
+	mFakeStuffedBits.clear();
+	mFakeFixedFormBits.clear();
+	mFakeStartOfFrameField.clear();
+	mFakeArbitrationField.clear();
+	mFakeControlField.clear();
+	mFakeDataField.clear();
+	mFakeCrcFieldWithoutDelimiter.clear();
+	mFakeAckField.clear();
+	mFakeEndOfFrame.clear();
+
+	mFdFrame = true;
+
+	mFrameIdentifier = identifier;
+	mFrameExtended = use_extended_frame_format;
+	mFrameRemote = false;
+	mFrameBitRateSwitch = bit_rate_switch;
+	mFrameData = data;
+
+	mFakeStartOfFrameField.push_back(mSettings->Dominant());
+
+	U32 id_bits = 11;
+	if (use_extended_frame_format == true)
+		id_bits = 29;
+
+	U32 mask = 1 << (id_bits - 1);
+	for (U32 i = 0; i < id_bits; i++)
+	{
+		if ((mask & identifier) == 0)
+			mFakeArbitrationField.push_back(mSettings->Dominant());
+		else
+			mFakeArbitrationField.push_back(mSettings->Recessive());
+
+		mask >>= 1;
+
+		//in Extended Format the SRR and IDE bits follow the Base ID, both recessive
+		if ((use_extended_frame_format == true) && (i == 10))
+		{
+			mFakeArbitrationField.push_back(mSettings->Recessive()); //SRR bit
+			mFakeArbitrationField.push_back(mSettings->Recessive()); //IDE bit
+		}
+	}
+
+	//RRS replaces the RTR bit and is always dominant
+	mFakeArbitrationField.push_back(mSettings->Dominant()); //RRS bit
+
+	//CONTROL FIELD
+	//Standard Format: IDE, FDF, res, BRS, ESI, DLC3 ... DLC0
+	//Extended Format: FDF, res, BRS, ESI, DLC3 ... DLC0
+	//FDF is recessive to mark a CAN-FD frame. A recessive BRS switches to the data bit rate
+	//at its sample point, and a dominant ESI means the transmitter is error active.
+
+	if (use_extended_frame_format == false)
+		mFakeControlField.push_back(mSettings->Dominant()); //IDE bit
+
+	mFakeControlField.push_back(mSettings->Recessive()); //FDF bit
+	mFakeControlField.push_back(mSettings->Dominant()); //res bit
+
+	mBrsBitIndex = (U32)(mFakeStartOfFrameField.size() + mFakeArbitrationField.size() + mFakeControlField.size());
+	if (bit_rate_switch == true)
+		mFakeControlField.push_back(mSettings->Recessive()); //BRS bit
+	else
+		mFakeControlField.push_back(mSettings->Dominant()); //BRS bit
+
+	mFakeControlField.push_back(mSettings->Dominant()); //ESI bit
+
+	U32 data_size = (U32)data.size();
+	U32 dlc = 16;
+	for (U32 i = 0; i < 16; i++)
+	{
+		if (gFdDataBytes[i] == data_size)
+			dlc = i;
+	}
+
+	if (dlc == 16)
+		AnalyzerHelpers::Assert("CAN-FD data length must be one of the DLC sizes");
+
+	mask = 1 << 3;
+	for (U32 i = 0; i < 4; i++)
+	{
+		if ((mask & dlc) == 0)
+			mFakeControlField.push_back(mSettings->Dominant());
+		else
+			mFakeControlField.push_back(mSettings->Recessive());
+
+		mask >>= 1;
+	}
+
+	for (U32 i = 0; i < data_size; i++)
+	{
+		U32 dat = data[i];
+		U32 mask = 0x80;
+
+		for (U32 j = 0; j < 8; j++)
+		{
+			if ((mask & dat) == 0)
+				mFakeDataField.push_back(mSettings->Dominant());
+			else
+				mFakeDataField.push_back(mSettings->Recessive());
+
+			mask >>= 1;
+		}
+	}
+
+	AddFdCrc(data_size);
+
+	AddAckAndEndOfFrame(get_ack_in_response);
+}
+
+void CAN_FDSimulationDataGenerator::CreateFrame(U32 identifier)
+{
+	//the same kind of frame as the last one created, with another identifier
+	std::vector<U8> data = mFrameData;
+
+	if (mFdFrame == true)
+		CreateFdFrame(identifier, mFrameExtended, mFrameBitRateSwitch, data, true);
+	else
+		CreateDataOrRemoteFrame(identifier, mFrameExtended, mFrameRemote, data, true);
+}
+
+void CAN_FDSimulationDataGenerator::AddAckAndEndOfFrame(bool get_ack_in_response)
+{
+	//ACK FIELD (Standard Format as well as Extended Format)
+	//The ACK FIELD is two bits long and contains the ACK SLOT and the ACK DELIMITER.
+	//In the ACK FIELD the transmitting station sends two recessive bits.
+	//A RECEIVER which has received a valid message correctly, reports this to the
+	//TRANSMITTER by sending a dominant bit during the ACK SLOT (it sends ACK).
+
+	//ACK SLOT
+	//All stations having received the matching CRC SEQUENCE report this within the ACK
+	//SLOT by superscribing the recessive bit of the TRANSMITTER by a dominant bit.
+
+	if (get_ack_in_response == true)
+		mFakeAckField.push_back(mSettings->Dominant());
+	else
+		mFakeAckField.push_back(mSettings->Recessive());
+
+	//ACK DELIMITER
+	//The ACK DELIMITER is the second bit of the ACK FIELD and has to be a recessive
+	//bit. As a consequence, the ACK SLOT is surrounded by two recessive bits (CRC
+	//DELIMITER, ACK DELIMITER).
+
+	mFakeAckField.push_back(mSettings->Recessive());
+
+	//END OF FRAME (Standard Format as well as Extended Format)
+	//Each DATA FRAME and REMOTE FRAME is delimited by a flag sequence consisting
+	//of seven recessive bits.
+
+	for (U32 i = 0; i < 7; i++)
+		mFakeEndOfFrame.push_back(mSettings->Recessive());
+
+
+	mFakeFixedFormBits.insert(mFakeFixedFormBits.end(), mFakeAckField.begin(), mFakeAckField.end());
+	mFakeFixedFormBits.insert(mFakeFixedFormBits.end(), mFakeEndOfFrame.begin(), mFakeEndOfFrame.end());
+
+	//INTERFRAME SPACING
+	//The INTERMISSION consists of three recessive bits, after which the bus is idle.
+
+	for (U32 i = 0; i < 3; i++)
+		mFakeFixedFormBits.push_back(mSettings->Recessive());
+}
+
+void CAN_FDSimulationDataGenerator::AddCrc()
+{
+	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeStartOfFrameField.begin(), mFakeStartOfFrameField.end());
+	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeArbitrationField.begin(), mFakeArbitrationField.end());
+	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeControlField.begin(), mFakeControlField.end());
+	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeDataField.begin(), mFakeDataField.end());
+
+	U32 bits_for_crc = (U32)mFakeStuffedBits.size();
+	U16 crc = ComputeCrc(mFakeStuffedBits, bits_for_crc);
+	U32 mask = 0x4000;
+	for (U32 i = 0; i < 15; i++)
+	{
+		if ((mask & crc) == 0)
+			mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Dominant());
+		else
+			mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Recessive());
+
+		mask >>= 1;
+	}
+
+	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeCrcFieldWithoutDelimiter.begin(), mFakeCrcFieldWithoutDelimiter.end());
+
+	//CRC DELIMITER (Standard Format as well as Extended Format)
+	//The CRC SEQUENCE is followed by the CRC DELIMITER which consists of a single
+	//recessive bit.
+
+	mFakeFixedFormBits.push_back(mSettings->Recessive());
+}
+
+void CAN_FDSimulationDataGenerator::AddFdCrc(U32 num_data_bytes)
+{
+	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeStartOfFrameField.begin(), mFakeStartOfFrameField.end());
+	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeArbitrationField.begin(), mFakeArbitrationField.end());
+	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeControlField.begin(), mFakeControlField.end());
+	mFakeStuffedBits.insert(mFakeStuffedBits.end(), mFakeDataField.begin(), mFakeDataField.end());
+
+	//In CAN-FD the dynamic bit stuffing ends with the DATA FIELD. The CRC field starts with the
+	//number of stuff bits modulo 8, Gray coded and followed by an even parity bit, and the CRC
+	//covers the stuff bits as transmitted as well as the stuff count.
+
+	StuffBits(mFakeStuffedBits, mFakeFdStuffedBits);
+
+	U32 stuff_count = gStuffCountGray[(mFakeFdStuffedBits.size() - mFakeStuffedBits.size()) % 8];
+	U32 parity = 0;
+	U32 mask = 0x4;
+	for (U32 i = 0; i < 3; i++)
+	{
+		if ((mask & stuff_count) == 0)
+		{
+			mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Dominant());
+		}
+		else
+		{
+			mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Recessive());
+			parity ^= 1;
+		}
+
+		mask >>= 1;
+	}
+
+	if (parity == 0)
+		mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Dominant());
+	else
+		mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Recessive());
+
+	mFakeFdStuffedBits.insert(mFakeFdStuffedBits.end(), mFakeCrcFieldWithoutDelimiter.begin(), mFakeCrcFieldWithoutDelimiter.end());
+
+	//CRC-17 for up to 16 data bytes, CRC-21 above that
+	U32 crc_bits = 17;
+	if (num_data_bytes > 16)
+		crc_bits = 21;
+
+	U32 crc = ComputeFdCrc(mFakeFdStuffedBits, (U32)mFakeFdStuffedBits.size(), crc_bits);
+	mask = 1 << (crc_bits - 1);
+	for (U32 i = 0; i < crc_bits; i++)
+	{
+		if ((mask & crc) == 0)
+			mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Dominant());
+		else
+			mFakeCrcFieldWithoutDelimiter.push_back(mSettings->Recessive());
+
+		mask >>= 1;
+	}
+
+	//A receiver of a CAN-FD frame has to accept a CRC DELIMITER of up to two bits, as the transceiver
+	//delay can move the ACK SLOT back by one. Send two; the analyzer finds the ACK SLOT after one or two.
+
+	mFakeFixedFormBits.push_back(mSettings->Recessive());
+	mFakeFixedFormBits.push_back(mSettings->Recessive());
+}
+
+void CAN_FDSimulationDataGenerator::StuffBits(std::vector<BitState>& bits, std::vector<BitState>& stuffed_bits)
+{
+	//same rule as WriteFrame: after five identical bits a complementary bit is inserted, and
+	//the stuff bit counts towards the next run.
+
+	U32 recessive_count = 0;
+	U32 dominant_count = 0;
+
+	stuffed_bits.clear();
+
+	for (U32 i = 0; i < bits.size(); i++)
+	{
+		if (recessive_count == 5)
+		{
+			stuffed_bits.push_back(mSettings->Dominant());
+			recessive_count = 0;
+			dominant_count = 1;
+		}
+
+		if (dominant_count == 5)
+		{
+			stuffed_bits.push_back(mSettings->Recessive());
+			dominant_count = 0;
+			recessive_count = 1;
+		}
+
+		if (bits[i] == mSettings->Recessive())
+		{
+			recessive_count++;
+			dominant_count = 0;
+		}
+		else
+		{
+			dominant_count++;
+			recessive_count = 0;
+		}
+
+		stuffed_bits.push_back(bits[i]);
+	}
+}
+
+U16 CAN_FDSimulationDataGenerator::ComputeCrc(std::vector<BitState>& bits, U32 num_bits)
+{
+	//note that this is a 15 bit CRC (not 16-bit)
+
+	//CRC FIELD (Standard Format as well as Extended Format)
+	//contains the CRC SEQUENCE followed by a CRC DELIMITER.
+	//CRC SEQUENCE (Standard Format as well as Extended Format)
+	//The frame check sequence is derived from a cyclic redundancy code best suited for
+	///frames with bit counts less than 127 bits (BCH Code).
+	//In order to carry out the CRC calculation the polynomial to be divided is defined as the
+	//polynomial, the coefficients of which are given by the destuffed bit stream consisting of
+	//START OF FRAME, ARBITRATION FIELD, CONTROL FIELD, DATA FIELD (if
+	///present) and, for the 15 lowest coefficients, by 0. This polynomial is divided (the
+	//coefficients are calculated modulo-2) by the generator-polynomial:
+	//X15 + X14 + X10 + X8 + X7 + X4 + X3 + 1.
+	//The remainder of this polynomial division is the CRC SEQUENCE transmitted over the
+	//bus. In order to implement this function, a 15 bit shift register CRC_RG(14:0) can be
+	//used. If NXTBIT denotes the next bit of the bit stream, given by the destuffed bit
+	//sequence from START OF FRAME until the end of the DATA FIELD, the CRC
+	//SEQUENCE is calculated as follows:
+
+	//CRC_RG = 0; // initialize shift register
+	//REPEAT
+	//CRCNXT = NXTBIT EXOR CRC_RG(14);
+	//CRC_RG(14:1) = CRC_RG(13:0); // shift left by
+	//CRC_RG(0) = 0; // 1 position
+	//IF CRCNXT THEN
+	//CRC_RG(14:0) = CRC_RG(14:0) EXOR (4599hex);
+	//ENDIF
+	//UNTIL (CRC SEQUENCE starts or there is an ERROR condition)
+
+	//After the transmission / reception of the last bit of the DATA FIELD, CRC_RG contains
+	//the CRC sequence.
+
+	U16 crc_result = 0;
+	for (U32 i = 0; i < num_bits; i++)
+	{
+		BitState next_bit = bits[i];
+
+		//Exclusive or
+		if ((crc_result & 0x4000) != 0)
+		{
+			next_bit = Invert(next_bit);  //if the msb of crc_result is zero, then next_bit is not inverted; otherwise, it is.
+		}
+
+		crc_result <<= 1;
+
+		if (next_bit == mSettings->Recessive()) //normally bit high.
+			crc_result ^= 0x4599;
+	}
+
+	return crc_result & 0x7FFF;
+}
+
+U32 CAN_FDSimulationDataGenerator::ComputeFdCrc(std::vector<BitState>& bits, U32 num_bits, U32 crc_bits)
+{
+	//CRC-17: x17 + x16 + x14 + x13 + x11 + x6 + x4 + x3 + x1 + 1
+	//CRC-21: x21 + x20 + x13 + x11 + x7 + x4 + x3 + 1
+	//Same shift register as the classic CRC, but the register starts with its most significant bit set.
+
+	U32 polynomial = 0x3685B;
+	if (crc_bits == 21)
+		polynomial = 0x302899;
+
+	U32 top_bit = 1 << (crc_bits - 1);
+	U32 crc_result = top_bit;
+
+	for (U32 i = 0; i < num_bits; i++)
+	{
+		bool crc_next = (bits[i] == mSettings->Recessive());
+
+		if ((crc_result & top_bit) != 0)
+			crc_next = !crc_next;
+
+		crc_result <<= 1;
+
+		if (crc_next == true)
+			crc_result ^= polynomial;
+	}
+
+	return crc_result & ((top_bit << 1) - 1);
+}
+
+void CAN_FDSimulationDataGenerator::WriteBit(BitState bit, bool data_phase, bool shortened)
+{
+	if (mImpaired == true)
+	{
+		WriteImpairedBit(bit, data_phase, shortened);
+		return;
+	}
+
+	mCanFDSimulationData.TransitionIfNeeded(bit);
+
+	if ((shortened == true) && (mBitRateFactor > 1))
+	{
+		//the BRS bit: the data bit rate takes over before the end of its nominal bit time. The analyzer
+		//samples the bit after BRS one data bit before the end of it, so that is where the switch goes.
+		mCanFDSimulationData.Advance(mClockGeneratorData.AdvanceByHalfPeriod(double(mBitRateFactor - 1)));
+	}
+	else if (data_phase == true)
+	{
+		mCanFDSimulationData.Advance(mClockGeneratorData.AdvanceByHalfPeriod(1.0));
+	}
+	else
+	{
+		mCanFDSimulationData.Advance(mClockGeneratorHdr.AdvanceByHalfPeriod(1.0));
+	}
+}
+
+void CAN_FDSimulationDataGenerator::WriteImpairedBit(BitState bit, bool data_phase, bool shortened)
+{
+	//the same bit times as WriteBit, from the clocks of the node sending the frame
+	U32 bit_samples;
+	if ((shortened == true) && (mBitRateFactor > 1))
+		bit_samples = mNodeClockGeneratorData.AdvanceByHalfPeriod(double(mBitRateFactor - 1));
+	else if (data_phase == true)
+		bit_samples = mNodeClockGeneratorData.AdvanceByHalfPeriod(1.0);
+	else
+		bit_samples = mNodeClockGeneratorHdr.AdvanceByHalfPeriod(1.0);
+
+	U32 remaining = bit_samples;
+
+	if (bit != mCanFDSimulationData.GetCurrentBitState())
+	{
+		//every edge comes up to twice the jitter late, which is up to the jitter either way of where
+		//edges are on average. In the data phase a recessive edge comes later again, as the
+		//transceiver releases the bus more slowly than it drives it.
+		double delay = 0.0;
+		if (mJitterSamples > 0.0)
+			delay = 2.0 * mJitterSamples * double(GetNextRandom(mImpairmentSeed) % 1024) / 1023.0;
+		if ((data_phase == true) && (bit == mSettings->Recessive()))
+			delay += mAsymmetrySamples;
+
+		U32 delay_samples = U32(delay + 0.5);
+		if (delay_samples >= remaining)
+			delay_samples = (remaining > 0) ? (remaining - 1) : 0;
+
+		mCanFDSimulationData.Advance(delay_samples);
+		mCanFDSimulationData.Transition();
+		remaining -= delay_samples;
+	}
+
+	//a glitch somewhere in the rest of the bit, if it fits
+	if ((mFrameBits == mGlitchBit) && (remaining > (mGlitchSamples + 1)))
+	{
+		U32 offset = 1 + (GetNextRandom(mImpairmentSeed) % (remaining - mGlitchSamples - 1));
+		mCanFDSimulationData.Advance(offset);
+		mGlitchSample = mCanFDSimulationData.GetCurrentSampleNumber();
+		mCanFDSimulationData.Transition();
+		mCanFDSimulationData.Advance(mGlitchSamples);
+		mCanFDSimulationData.Transition();
+		remaining -= offset + mGlitchSamples;
+	}
+
+	mCanFDSimulationData.Advance(remaining);
+	mFrameBits++;
+}
+
+void CAN_FDSimulationDataGenerator::StartFrameTiming()
+{
+	if (mImpaired == false)
+		return;
+
+	//each identifier is sent by a node of its own, whose oscillator is off by a fixed amount
+	//somewhere between minus and plus the configured offset
+	U32 spread = ((mFrameIdentifier * 2654435761u) >> 16) % 2001;
+	double offset = double(mClockOffsetPpm) * (double(spread) - 1000.0) / 1000000000.0;
+	mNodeClockGeneratorHdr.Init(double(mSettings->mBitRateHdr) * (1.0 + offset), mSimulationSampleRateHz);
+	mNodeClockGeneratorData.Init(double(mSettings->mBitRateData) * (1.0 + offset), mSimulationSampleRateHz);
+
+	mFrameBits = 0;
+	mGlitchSample = 0;
+	mGlitchBit = 0xFFFFFFFF;
+	if ((mGlitchRate > 0) && ((GetNextRandom(mImpairmentSeed) % 100) < mGlitchRate))
+		mGlitchBit = GetNextRandom(mImpairmentSeed) % (U32)mFakeStuffedBits.size();
+}
+
+U32 CAN_FDSimulationDataGenerator::GetNextRandom(U32& seed)
+{
+	//faults and impairments each have a seed of their own, apart from the noise bursts, so turning
+	//one of them on doesn't change the others
+	seed = (seed * 1103515245) + 12345;
+	return seed >> 16;
+}
+
+CanSimFault CAN_FDSimulationDataGenerator::PickFault(U32& fault_bit)
+{
+	fault_bit = 0;
+
+	if ((mFaultRate == 0) || (mFaultMask == 0) || ((GetNextRandom(mFaultSeed) % 100) >= mFaultRate))
+		return SimFaultNone;
+
+	std::vector<BitState> stuffed_bits;
+	StuffBits(mFakeStuffedBits, stuffed_bits);
+	U32 num_stuff_bits = (U32)(stuffed_bits.size() - mFakeStuffedBits.size());
+
+	U32 arbitration_bits = (U32)(mFakeStartOfFrameField.size() + mFakeArbitrationField.size());
+	U32 data_start = arbitration_bits + (U32)mFakeControlField.size();
+	U32 crc_end = (U32)mFakeStuffedBits.size();
+	if (mFdFrame == true)
+		crc_end += (U32)mFakeCrcFieldWithoutDelimiter.size();
+
+	U32 max_identifier = (mFrameExtended == true) ? 0x1FFFFFFF : 0x7FF;
+
+	//the selected faults take turns, one that can't go in this frame is passed over
+	for (U32 i = SimFaultNone + 1; i < SimFaultCount; i++)
+	{
+		CanSimFault fault = (CanSimFault)mNextFault;
+		mNextFault = (mNextFault < (SimFaultCount - 1)) ? (mNextFault + 1) : (SimFaultNone + 1);
+
+		if ((mFaultMask & (1 << fault)) == 0)
+			continue;
+
+		//fault_bit is chosen from this many bits after the first
+		U32 first = 0;
+		U32 choices = 1;
+
+		if (fault == SimFaultStuff)
+		{
+			//which of the stuff bits is sent wrongly
+			choices = num_stuff_bits;
+		}
+		else if (fault == SimFaultBitFlip)
+		{
+			//a bit of the DATA FIELD or CRC SEQUENCE, counting the CAN-FD CRC field after the stuffed bits
+			first = data_start;
+			choices = crc_end - data_start;
+		}
+		else if (fault == SimFaultForm)
+		{
+			//0 for the CRC DELIMITER, 1 for the ACK DELIMITER
+			choices = 2;
+		}
+		else if (fault == SimFaultErrorFrame)
+		{
+			//the flag starts after this many stuffed bits, once arbitration is over
+			first = arbitration_bits;
+			choices = (U32)mFakeStuffedBits.size() - arbitration_bits;
+		}
+		else if (fault == SimFaultCollision)
+		{
+			if (mFrameIdentifier >= max_identifier)
+				choices = 0;
+		}
+
+		if (choices == 0)
+			continue;
+
+		fault_bit = first + (GetNextRandom(mFaultSeed) % choices);
+		return fault;
+	}
+
+	return SimFaultNone;
+}
+
+void CAN_FDSimulationDataGenerator::SendFrame(bool error)
+{
+	U64 starting_sample = mCanFDSimulationData.GetCurrentSampleNumber();
+
+	if (error == true)
+	{
+		//every pass has this one, an error flag 9 bits before the end of the CRC. It isn't sent again.
+		WriteFrame(SimFaultErrorFrame, (U32)mFakeStuffedBits.size() - 9);
+		AddGroundTruth(starting_sample, SimFaultErrorFrame, false);
+		return;
+	}
+
+	U32 fault_bit;
+	CanSimFault fault = PickFault(fault_bit);
+
+	if (fault == SimFaultCollision)
+	{
+		//the other node sends the next identifier up, so it drops out at the first bit where the two
+		//differ, sending recessive and seeing dominant. Until then both send the same bits, and the
+		//bus carries this frame alone.
+		U32 identifier = mFrameIdentifier;
+		CreateFrame(identifier + 1);
+		std::vector<BitState> other_bits = mFakeStuffedBits;
+		CreateFrame(identifier);
+
+		fault_bit = 0;
+		while (mFakeStuffedBits[fault_bit] == other_bits[fault_bit])
+			fault_bit++;
+
+		WriteFrame(SimFaultCollision, fault_bit);
+		AddGroundTruth(starting_sample, SimFaultCollision, true);
+
+		//the other node starts again as soon as the bus is free
+		CreateFrame(identifier + 1);
+		starting_sample = mCanFDSimulationData.GetCurrentSampleNumber();
+		WriteFrame();
+		AddGroundTruth(starting_sample, SimFaultNone, true);
+		return;
+	}
+
+	WriteFrame(fault, fault_bit);
+
+	//an overload frame delays the next frame, but this one was received
+	bool received = (fault == SimFaultNone) || (fault == SimFaultOverload);
+	AddGroundTruth(starting_sample, fault, received);
+
+	if (received == false)
+	{
+		//automatic retransmission after the error frame
+		starting_sample = mCanFDSimulationData.GetCurrentSampleNumber();
+		WriteFrame();
+		AddGroundTruth(starting_sample, SimFaultNone, true);
+	}
+}
+
+void CAN_FDSimulationDataGenerator::WriteFrame(CanSimFault fault, U32 fault_bit)
+{
+	U32 recessive_count = 0;
+	U32 dominant_count = 0;
+	U32 stuff_bits = 0;
+	bool data_phase = false;
+
+	mFaultSample = 0;
+	mErrorFlagSample = 0;
+	StartFrameTiming();
+
+	//The frame segments START OF FRAME, ARBITRATION FIELD, CONTROL FIELD,
+	//DATA FIELD and CRC SEQUENCE are coded by the method of bit stuffing. Whenever
+	//a transmitter detects five consecutive bits of identical value in the bit stream to be
+	//transmitted it automatically inserts a complementary bit in the actual transmitted bit
+	//stream.
+
+	//The remaining bit fields of the DATA FRAME or REMOTE FRAME (CRC DELIMITER,
+	//ACK FIELD, and END OF FRAME) are of fixed form and not stuffed. The ERROR
+	//FRAME and the OVERLOAD FRAME are of fixed form as well and not coded by the
+	//method of bit stuffing.
+
+	U32 count = (U32)mFakeStuffedBits.size();
+
+	if (fault == SimFaultErrorFrame)
+		count = fault_bit;
+
+	for (U32 i = 0; i < count; i++)
+	{
+		if ((recessive_count == 5) || (dominant_count == 5))
+		{
+			BitState stuff_bit = (recessive_count == 5) ? mSettings->Dominant() : mSettings->Recessive();
+
+			if ((fault == SimFaultStuff) && (stuff_bits == fault_bit))
+			{
+				//a sixth bit at the same level, every receiver flags the error from the next bit
+				mFaultSample = mCanFDSimulationData.GetCurrentSampleNumber();
+				WriteBit(Invert(stuff_bit), data_phase);
+				WriteErrorFrame();
+				return;
+			}
+
+			WriteBit(stuff_bit, data_phase);
+			stuff_bits++;
+
+			// this stuffed bit counts
+			if (stuff_bit == mSettings->Recessive())
+			{
+				recessive_count = 1;
+				dominant_count = 0;
+			}
+			else
+			{
+				dominant_count = 1;
+				recessive_count = 0;
+			}
+		}
+
+		BitState bit = mFakeStuffedBits[i];
+
+		if ((fault == SimFaultBitFlip) && (i == fault_bit))
+		{
+			bit = Invert(bit);
+			mFaultSample = mCanFDSimulationData.GetCurrentSampleNumber();
+		}
+		else if ((fault == SimFaultCollision) && (i == fault_bit))
+		{
+			mFaultSample = mCanFDSimulationData.GetCurrentSampleNumber();
+		}
+
+		if (bit == mSettings->Recessive())
+		{
+			recessive_count++;
+			dominant_count = 0;
+		}
+		else
+		{
+			dominant_count++;
+			recessive_count = 0;
+		}
+
+		if ((i == mBrsBitIndex) && (bit == mSettings->Recessive()))
+		{
+			WriteBit(bit, false, true);
+			data_phase = true;
+		}
+		else
+		{
+			WriteBit(bit, data_phase);
+		}
+	}
+
+	if (fault == SimFaultErrorFrame)
+	{
+		mFaultSample = mCanFDSimulationData.GetCurrentSampleNumber();
+		WriteErrorFrame();
+		return;
+	}
+
+	U32 crc_delimiter_bits = 1;
+
+	if (mFdFrame == true)
+	{
+		//The CAN-FD CRC field uses fixed stuff bits instead: one before the stuff count and then one
+		//after every fourth bit, each the complement of the bit before it. A run of five at the end of
+		//the DATA FIELD is broken by the first of them.
+
+		for (U32 i = 0; i < mFakeCrcFieldWithoutDelimiter.size(); i++)
+		{
+			if ((i % 4) == 0)
+				WriteBit(Invert(mCanFDSimulationData.GetCurrentBitState()), data_phase);
+
+			BitState bit = mFakeCrcFieldWithoutDelimiter[i];
+
+			if ((fault == SimFaultBitFlip) && ((mFakeStuffedBits.size() + i) == fault_bit))
+			{
+				bit = Invert(bit);
+				mFaultSample = mCanFDSimulationData.GetCurrentSampleNumber();
+			}
+
+			WriteBit(bit, data_phase);
+		}
+
+		crc_delimiter_bits = 2;
+	}
+	else if ((recessive_count == 5) || (dominant_count == 5))
+	{
+		//the CRC SEQUENCE is stuffed as well, so a run of five at its end still gets a stuff bit
+		WriteBit(Invert(mCanFDSimulationData.GetCurrentBitState()), data_phase);
+	}
+
+	//CRC DELIMITER, ACK SLOT, ACK DELIMITER, END OF FRAME and INTERMISSION
+	U32 ack_slot = crc_delimiter_bits;
+
+	count = (U32)mFakeFixedFormBits.size();
+
+	//an overload flag starts at the first bit of INTERMISSION
+	if (fault == SimFaultOverload)
+		count -= 3;
+
+	for (U32 i = 0; i < count; i++)
+	{
+		//the bit rate switches back at the end of the CRC DELIMITER
+		if (i == crc_delimiter_bits)
+			data_phase = false;
+
+		BitState bit = mFakeFixedFormBits[i];
+
+		if ((fault == SimFaultForm) && (i == ((fault_bit == 0) ? 0 : (ack_slot + 1))))
+		{
+			//a dominant delimiter, the error flag starts at the next bit
+			mFaultSample = mCanFDSimulationData.GetCurrentSampleNumber();
+			WriteBit(mSettings->Dominant(), data_phase);
+			WriteErrorFrame();
+			return;
+		}
+
+		if ((fault == SimFaultAck) || (fault == SimFaultBitFlip))
+		{
+			//nobody acknowledges a frame that failed the CRC check either. The transmitter flags a
+			//missing ACK from the ACK DELIMITER on, the receivers a CRC error after it.
+			if (i == ack_slot)
+			{
+				bit = mSettings->Recessive();
+				if (fault == SimFaultAck)
+					mFaultSample = mCanFDSimulationData.GetCurrentSampleNumber();
+			}
+
+			if (i == ((fault == SimFaultAck) ? (ack_slot + 1) : (ack_slot + 2)))
+			{
+				WriteErrorFrame();
+				return;
+			}
+		}
+
+		WriteBit(bit, data_phase);
+	}
+
+	if (fault == SimFaultOverload)
+	{
+		mFaultSample = mCanFDSimulationData.GetCurrentSampleNumber();
+		WriteErrorFrame();
+	}
+}
+
+void CAN_FDSimulationDataGenerator::WriteErrorFrame()
+{
+	//ERROR FRAME
+	//An ERROR FLAG of six dominant bits, which breaks the bit stuffing rule, followed by an
+	//ERROR DELIMITER of eight recessive bits. Both are sent at the nominal bit rate. An
+	//OVERLOAD FRAME has the same form.
+
+	mErrorFlagSample = mCanFDSimulationData.GetCurrentSampleNumber();
+
+	for (U32 i = 0; i < 6; i++)
+		WriteBit(mSettings->Dominant(), false);
+
+	for (U32 i = 0; i < 8; i++)
+		WriteBit(mSettings->Recessive(), false);
+}
+
+void CAN_FDSimulationDataGenerator::AddGroundTruth(U64 starting_sample, CanSimFault fault, bool received)
+{
+	if (mGroundTruth == NULL)
+		return;
+
+	CanSimulatedFrame frame;
+	frame.mStartingSample = starting_sample;
+	frame.mEndingSample = mCanFDSimulationData.GetCurrentSampleNumber();
+	frame.mIdentifier = mFrameIdentifier;
+	frame.mFault = fault;
+	frame.mFaultSample = mFaultSample;
+	frame.mErrorFlagSample = mErrorFlagSample;
+	frame.mGlitchSample = mGlitchSample;
+	frame.mReceived = received;
+
+	double sample_rate = double(mSimulationSampleRateHz);
+
+	fprintf(mGroundTruth, "%.9f,%.9f,", double(frame.mStartingSample) / sample_rate, double(frame.mEndingSample) / sample_rate);
+	fprintf(mGroundTruth, (mFrameExtended == true) ? "0x%08X," : "0x%03X,", frame.mIdentifier);
+	fprintf(mGroundTruth, "%s,", GetFaultName(frame.mFault));
+
+	if (frame.mFault != SimFaultNone)
+		fprintf(mGroundTruth, "%.9f", double(frame.mFaultSample) / sample_rate);
+	fprintf(mGroundTruth, ",");
+
+	if (frame.mErrorFlagSample != 0)
+		fprintf(mGroundTruth, "%.9f", double(frame.mErrorFlagSample) / sample_rate);
+	fprintf(mGroundTruth, ",");
+
+	if (frame.mGlitchSample != 0)
+		fprintf(mGroundTruth, "%.9f", double(frame.mGlitchSample) / sample_rate);
+	fprintf(mGroundTruth, ",%s\n", (frame.mReceived == true) ? "OK" : "ERROR");
+}
+
+void CAN_FDSimulationDataGenerator::WriteNoiseBurst(U32 num_edges)
+{
+	//pulses much shorter than a data bit at random spacing, as from a loose connector. An even
+	//number of edges leaves the bus recessive again.
+
+	U32 max_spacing = mSimulationSampleRateHz / mSettings->mBitRateData / 8;
+	if (max_spacing == 0)
+		max_spacing = 1;
+
+	num_edges &= ~1;
+
+	for (U32 i = 0; i < num_edges; i++)
+	{
+		mNoiseSeed = (mNoiseSeed * 1103515245) + 12345;
+		mCanFDSimulationData.Advance(1 + ((mNoiseSeed >> 16) % max_spacing));
+		mCanFDSimulationData.Transition();
+	}
+}
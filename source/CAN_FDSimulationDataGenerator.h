@@ -1,49 +1,160 @@
-#ifndef CAN_FD_SIMULATION_DATA_GENERATOR
-#define CAN_FD_SIMULATION_DATA_GENERATOR
-
-#include <SimulationChannelDescriptor.h>
-#include <string>
-#include <AnalyzerHelpers.h>
-
-class CAN_FDAnalyzerSettings;
-
-class CAN_FDSimulationDataGenerator
-{
-public:
-	CAN_FDSimulationDataGenerator();
-	~CAN_FDSimulationDataGenerator();
-
-	void Initialize( U32 simulation_sample_rate, CAN_FDAnalyzerSettings* settings );
-	U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channel );
-
-protected:
-	CAN_FDAnalyzerSettings* mSettings;
-	U32 mSimulationSampleRateHz;
-
-protected:  //functions
-
-	U16 ComputeCrc(std::vector<BitState>& bits, U32 num_bits);
-	void AddCrc();
-	void CreateDataOrRemoteFrame(U32 identifier, bool use_extended_frame_format, bool remote_frame, std::vector<U8>& data, bool get_ack_in_response);
-	void WriteFrame(bool error = false);
-
-protected:  //variables
-
-	ClockGenerator mClockGeneratorHdr;
-	ClockGenerator mClockGeneratorData;
-	SimulationChannelDescriptor mCanFDSimulationData;  //if we had more than one channel to simulate, they would need to be in an array
-
-	U8 mValue;
-
-	std::vector<BitState> mFakeStartOfFrameField;
-	std::vector<BitState> mFakeArbitrationField;
-	std::vector<BitState> mFakeControlField;
-	std::vector<BitState> mFakeDataField;
-	std::vector<BitState> mFakeCrcFieldWithoutDelimiter;
-	std::vector<BitState> mFakeAckField;
-	std::vector<BitState> mFakeEndOfFrame;
-	std::vector<BitState> mFakeStuffedBits;
-	std::vector<BitState> mFakeFixedFormBits;
-
-};
+#ifndef CAN_FD_SIMULATION_DATA_GENERATOR
+#define CAN_FD_SIMULATION_DATA_GENERATOR
+
+#include <SimulationChannelDescriptor.h>
+#include <cstdio>
+#include <string>
+#include <AnalyzerHelpers.h>
+
+/* Faults the simulation can put into a frame, in place of sending it cleanly. A frame destroyed by */
+/* an error flag is sent again straight after, as a controller would. */
+enum CanSimFault
+{
+	SimFaultNone,
+	SimFaultStuff,		/* a stuff bit sent at the wrong level, the error flag follows */
+	SimFaultBitFlip,	/* a data or CRC bit received wrongly, the error flag follows the ACK delimiter */
+	SimFaultForm,		/* the CRC or ACK delimiter dominant, the error flag follows */
+	SimFaultAck,		/* no node acknowledges, the error flag starts at the ACK delimiter */
+	SimFaultErrorFrame,	/* a receiver flags an error part way through the frame */
+	SimFaultOverload,	/* a receiver sends an overload frame after the frame */
+	SimFaultCollision,	/* a second node starts at the same time and loses arbitration, then sends its frame */
+	SimFaultCount
+};
+
+/* One frame as sent by the simulation, written to the ground truth file */
+class CanSimulatedFrame
+{
+public:
+	U64 mStartingSample;
+	U64 mEndingSample;			/* end of the frame, or of the error or overload frame after it */
+	U32 mIdentifier;
+	CanSimFault mFault;
+	U64 mFaultSample;			/* the faulty bit, or where the other node lost arbitration */
+	U64 mErrorFlagSample;		/* start of the error or overload flag, 0 without one */
+	U64 mGlitchSample;			/* start of a glitch put into the frame, 0 without one */
+	bool mReceived;				/* the receivers take the frame as valid */
+};
+
+/* What the simulation puts on the bus besides clean frames. These only drive the simulation, so they */
+/* are not analyzer settings and the runner sets them on the analyzer itself. */
+class CanSimulationOptions
+{
+public:
+	CanSimulationOptions();
+
+	U32 mFaultRate;					/* percentage of the frames given a fault, 0 for a clean bus */
+	std::string mFaults;			/* faults used in turn, as ParseFaults takes them */
+	std::string mGroundTruthFile;	/* every frame sent is listed here, empty for no file */
+
+	/* Physical layer impairments, none by default */
+	U32 mClockOffsetPpm;			/* each identifier's node is off by up to this much, either way */
+	U32 mJitterNs;					/* every edge moves by up to this much, either way */
+	U32 mAsymmetryNs;				/* data phase recessive edges come this much late */
+	U32 mGlitchRate;				/* percentage of the frames given a glitch */
+	U32 mGlitchNs;					/* width of each glitch, at least one sample */
+};
+
+class CAN_FDAnalyzerSettings;
+
+class CAN_FDSimulationDataGenerator
+{
+public:
+	CAN_FDSimulationDataGenerator();
+	~CAN_FDSimulationDataGenerator();
+
+	void SetOptions(const CanSimulationOptions& options);
+	void Initialize( U32 simulation_sample_rate, CAN_FDAnalyzerSettings* settings );
+	U32 GenerateSimulationData( U64 newest_sample_requested, U32 sample_rate, SimulationChannelDescriptor** simulation_channel );
+
+	/* Fault names as used in the settings and the ground truth file. The list is comma separated, */
+	/* empty for all of them. */
+	static const char* GetFaultName(CanSimFault fault);
+	static bool ParseFaults(const std::string& text, U32& fault_mask);
+
+protected:
+	CAN_FDAnalyzerSettings* mSettings;
+	CanSimulationOptions mOptions;
+	U32 mSimulationSampleRateHz;
+
+protected:  //functions
+
+	U16 ComputeCrc(std::vector<BitState>& bits, U32 num_bits);
+	U32 ComputeFdCrc(std::vector<BitState>& bits, U32 num_bits, U32 crc_bits);
+	void AddCrc();
+	void AddFdCrc(U32 num_data_bytes);
+	void AddAckAndEndOfFrame(bool get_ack_in_response);
+	void StuffBits(std::vector<BitState>& bits, std::vector<BitState>& stuffed_bits);
+	void CreateDataOrRemoteFrame(U32 identifier, bool use_extended_frame_format, bool remote_frame, std::vector<U8>& data, bool get_ack_in_response);
+	void CreateFdFrame(U32 identifier, bool use_extended_frame_format, bool bit_rate_switch, std::vector<U8>& data, bool get_ack_in_response);
+	void CreateFrame(U32 identifier);
+	void WriteBit(BitState bit, bool data_phase, bool shortened = false);
+	void WriteImpairedBit(BitState bit, bool data_phase, bool shortened);
+	void SendFrame(bool error = false);
+	CanSimFault PickFault(U32& fault_bit);
+	U32 GetNextRandom(U32& seed);
+	void StartFrameTiming();
+	void WriteFrame(CanSimFault fault = SimFaultNone, U32 fault_bit = 0);
+	void WriteErrorFrame();
+	void WriteNoiseBurst(U32 num_edges);
+	void AddGroundTruth(U64 starting_sample, CanSimFault fault, bool received);
+
+protected:  //variables
+
+	ClockGenerator mClockGeneratorHdr;
+	ClockGenerator mClockGeneratorData;
+	SimulationChannelDescriptor mCanFDSimulationData;  //if we had more than one channel to simulate, they would need to be in an array
+
+	U8 mValue;
+	U32 mPass;
+	U32 mBitRateFactor;
+	U32 mNoiseSeed;
+
+	bool mFdFrame;
+	U32 mBrsBitIndex;	/* Index of the BRS bit in mFakeStuffedBits, past the end if the bit rate doesn't switch */
+
+	/* What the current frame was created from, so it can be created again for another node */
+	U32 mFrameIdentifier;
+	bool mFrameExtended;
+	bool mFrameRemote;
+	bool mFrameBitRateSwitch;
+	std::vector<U8> mFrameData;
+
+	/* Fault injection, a share of mFaultRate percent of the frames get one of the faults in mFaultMask in turn */
+	U32 mFaultRate;
+	U32 mFaultMask;
+	U32 mFaultSeed;
+	U32 mNextFault;
+	U64 mFaultSample;
+	U64 mErrorFlagSample;
+
+	/* Physical layer impairments. Without any, every frame is sent with the ideal clocks above. */
+	bool mImpaired;
+	U32 mClockOffsetPpm;
+	double mJitterSamples;
+	double mAsymmetrySamples;
+	U32 mGlitchRate;
+	U32 mGlitchSamples;
+	U32 mImpairmentSeed;
+
+	/* The clocks of the node sending the current frame, and the bit of it that gets a glitch */
+	ClockGenerator mNodeClockGeneratorHdr;
+	ClockGenerator mNodeClockGeneratorData;
+	U32 mFrameBits;
+	U32 mGlitchBit;
+	U64 mGlitchSample;
+
+	FILE* mGroundTruth;
+
+	std::vector<BitState> mFakeStartOfFrameField;
+	std::vector<BitState> mFakeArbitrationField;
+	std::vector<BitState> mFakeControlField;
+	std::vector<BitState> mFakeDataField;
+	std::vector<BitState> mFakeCrcFieldWithoutDelimiter;
+	std::vector<BitState> mFakeAckField;
+	std::vector<BitState> mFakeEndOfFrame;
+	std::vector<BitState> mFakeStuffedBits;
+	std::vector<BitState> mFakeFixedFormBits;
+	std::vector<BitState> mFakeFdStuffedBits;
+
+};
 #endif //CAN_FD_SIMULATION_DATA_GENERATOR
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "CAN_FDSofIndex.h"
+#include "CAN_FDVarint.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+/* Changed whenever the layout of the file changes, older files are then simply not used */
+static const char gSofIndexMagic[8] = { 'C', 'A', 'N', 'F', 'D', 'S', 'I', '1' };
+
+static bool StartsBefore(const CanSofIndexEntry& entry, U64 sample)
+{
+	return entry.mStartOfFrame < sample;
+}
+
+CAN_FDSofIndex::CAN_FDSofIndex()
+:	mFingerprint( 0 ),
+	mFingerprintFrames( 0 ),
+	mNumBuses( 0 ),
+	mRewrite( false )
+{
+}
+
+void CAN_FDSofIndex::Open(const std::string& folder, const std::string& key, U32 num_buses)
+{
+	mLastStartOfFrame.assign(num_buses, 0);
+	mFramesSinceEntry.assign(num_buses, 0);
+
+	mOpenFolder = folder;
+	mOpenKey = key;
+	mFingerprint = gFnvOffsetBasis;
+	mFingerprintFrames = 0;
+
+	/* Nothing is found or saved until the capture is known */
+	if (num_buses != mNumBuses)
+	{
+		mFolder.clear();
+		mKey.clear();
+		mNumBuses = num_buses;
+	}
+	mEntries.resize(num_buses);
+}
+
+bool CAN_FDSofIndex::IsFingerprinted() const
+{
+	return (mFingerprintFrames >= CAN_SOF_INDEX_FINGERPRINT_FRAMES);
+}
+
+U64 CAN_FDSofIndex::GetFingerprint() const
+{
+	return mFingerprint;
+}
+
+void CAN_FDSofIndex::AddToFingerprint(U32 bus_index, U64 start_of_frame)
+{
+	/* Not the kind, frames before a decode window are added without decoding them */
+	mFingerprint = Fnv1a(mFingerprint, &bus_index, sizeof(bus_index));
+	mFingerprint = Fnv1a(mFingerprint, &start_of_frame, sizeof(start_of_frame));
+
+	mFingerprintFrames++;
+	if (IsFingerprinted() == false)
+		return;
+
+	std::stringstream ss;
+	ss << mOpenKey << " " << std::hex << mFingerprint;
+	std::string key = ss.str();
+
+	if ((mOpenFolder == mFolder) && (key == mKey))
+		return;
+
+	mFolder = mOpenFolder;
+	mKey = key;
+	mEntries.assign(mNumBuses, std::vector<CanSofIndexEntry>());
+	mUnsaved.clear();
+	mRewrite = true;
+	mPath.clear();
+
+	if (mFolder.empty() == true)
+		return;
+
+	char name[64];
+	snprintf(name, sizeof(name), "%016llx.canfdsof", (unsigned long long)Fnv1a(gFnvOffsetBasis, key.c_str(), key.size()));
+
+	mPath = mFolder;
+	if ((mPath[mPath.size() - 1] != '/') && (mPath[mPath.size() - 1] != '\\'))
+		mPath += "/";
+	mPath += name;
+
+	Load();
+}
+
+void CAN_FDSofIndex::Load()
+{
+	FILE* file = fopen(mPath.c_str(), "rb");
+	if (file == NULL)
+		return;
+
+	std::vector<U8> bytes;
+	U8 buffer[65536];
+	for (; ; )
+	{
+		size_t count = fread(buffer, 1, sizeof(buffer), file);
+		bytes.insert(bytes.end(), buffer, buffer + count);
+		if (count < sizeof(buffer))
+			break;
+	}
+	fclose(file);
+
+	if ((bytes.size() < sizeof(gSofIndexMagic)) || (memcmp(&bytes[0], gSofIndexMagic, sizeof(gSofIndexMagic)) != 0))
+		return;
+
+	const U8* p = &bytes[0] + sizeof(gSofIndexMagic);
+	const U8* end = &bytes[0] + bytes.size();
+
+	U64 num_buses;
+	if ((ReadBoundedVarint(p, end, num_buses) == false) || (num_buses != mNumBuses))
+		return;
+
+	/* Entries up to a damaged or cut short one are used, the file is then written again */
+	while (p < end)
+	{
+		const U8* record = p;
+		U64 bus_index;
+		CanSofIndexEntry entry;
+		if ((ReadBoundedVarint(p, end, bus_index) == false) || (bus_index >= mNumBuses) ||
+			(ReadBoundedVarint(p, end, entry.mStartOfFrame) == false) || (p >= end) || (*p >= SofKindCount))
+		{
+			p = record;
+			break;
+		}
+		entry.mKind = *p++;
+
+		std::vector<CanSofIndexEntry>& entries = mEntries[(U32)bus_index];
+		if ((entries.empty() == false) && (entry.mStartOfFrame <= entries.back().mStartOfFrame))
+		{
+			p = record;
+			break;
+		}
+		entries.push_back(entry);
+	}
+
+	mRewrite = (p != end);
+}
+
+void CAN_FDSofIndex::AddFrame(U32 bus_index, U64 start_of_frame, bool indexable, CanSofKind kind)
+{
+	std::vector<CanSofIndexEntry>& entries = mEntries[bus_index];
+
+	U64 previous = mLastStartOfFrame[bus_index];
+	mLastStartOfFrame[bus_index] = start_of_frame;
+
+	/* The entries held may be another capture's until then, the first frames are only counted */
+	if (IsFingerprinted() == false)
+	{
+		AddToFingerprint(bus_index, start_of_frame);
+		mFramesSinceEntry[bus_index]++;
+		return;
+	}
+
+	/* An entry between this frame and the one before it should have been a frame too. Entries before the */
+	/* first frame since Open or Resync are not checked. */
+	U64 from = (previous == 0) ? start_of_frame : (previous + 1);
+	std::vector<CanSofIndexEntry>::iterator next = std::lower_bound(entries.begin(), entries.end(), from, StartsBefore);
+	if ((next != entries.end()) && (next->mStartOfFrame < start_of_frame))
+	{
+		entries.erase(next, entries.end());
+		mUnsaved.clear();
+		mRewrite = true;
+		next = entries.end();
+	}
+
+	/* Within the part of the capture already indexed */
+	if (next != entries.end())
+	{
+		if (next->mStartOfFrame == start_of_frame)
+			mFramesSinceEntry[bus_index] = 0;
+		return;
+	}
+
+	mFramesSinceEntry[bus_index]++;
+	if ((indexable == false) || (mFramesSinceEntry[bus_index] < CAN_SOF_INDEX_INTERVAL))
+		return;
+
+	CanSofIndexEntry entry;
+	entry.mStartOfFrame = start_of_frame;
+	entry.mKind = (U8)kind;
+	entries.push_back(entry);
+	mFramesSinceEntry[bus_index] = 0;
+
+	if (mRewrite == false)
+		AppendEntry(mUnsaved, bus_index, entry);
+}
+
+void CAN_FDSofIndex::Resync()
+{
+	mLastStartOfFrame.assign(mLastStartOfFrame.size(), 0);
+}
+
+bool CAN_FDSofIndex::Find(U32 bus_index, U64 sample, CanSofIndexEntry& entry) const
+{
+	if (IsFingerprinted() == false)
+		return false;
+
+	const std::vector<CanSofIndexEntry>& entries = mEntries[bus_index];
+
+	std::vector<CanSofIndexEntry>::const_iterator after = std::lower_bound(entries.begin(), entries.end(), sample + 1, StartsBefore);
+	if (after == entries.begin())
+		return false;
+
+	entry = *(after - 1);
+	return true;
+}
+
+void CAN_FDSofIndex::AppendEntry(std::vector<U8>& bytes, U32 bus_index, const CanSofIndexEntry& entry)
+{
+	AppendVarint(bytes, bus_index);
+	AppendVarint(bytes, entry.mStartOfFrame);
+	bytes.push_back(entry.mKind);
+}
+
+void CAN_FDSofIndex::Save()
+{
+	if ((IsFingerprinted() == false) || (mPath.empty() == true) || ((mRewrite == false) && (mUnsaved.empty() == true)))
+		return;
+
+	FILE* file;
+	if (mRewrite == true)
+	{
+		/* Entries in bus order rather than as they were found, each bus's are still in sample order */
+		mUnsaved.assign(gSofIndexMagic, gSofIndexMagic + sizeof(gSofIndexMagic));
+		AppendVarint(mUnsaved, mNumBuses);
+		for (U32 i = 0; i < mNumBuses; i++)
+		{
+			for (U32 j = 0; j < mEntries[i].size(); j++)
+				AppendEntry(mUnsaved, i, mEntries[i][j]);
+		}
+
+		file = fopen(mPath.c_str(), "wb");
+	}
+	else
+	{
+		file = fopen(mPath.c_str(), "ab");
+	}
+
+	/* An index that can't be written is still kept in memory */
+	bool written = (file != NULL) && (fwrite(&mUnsaved[0], 1, mUnsaved.size(), file) == mUnsaved.size());
+	if (file != NULL)
+		written = (fclose(file) == 0) && (written == true);
+
+	if (written == false)
+		mPath.clear();
+
+	mUnsaved.clear();
+	mRewrite = false;
+}
@@ -0,0 +1,83 @@
+#ifndef CAN_FD_SOF_INDEX
+#define CAN_FD_SOF_INDEX
+
+#include <AnalyzerTypes.h>
+#include <string>
+#include <vector>
+
+/* Where frames start on each bus, one entry every CAN_SOF_INDEX_INTERVAL frames, so a later decode can */
+/* begin at a frame near any point of the capture instead of reading it from the start. It is built as */
+/* the capture is decoded and kept in the decode cache folder, in a file named after the bus timing it */
+/* depends on and the starts of the capture's first CAN_SOF_INDEX_FINGERPRINT_FRAMES frames, which tell */
+/* captures with the same timing apart. Until those have been read the index is empty. Entries are only */
+/* taken at frames that decoded without error. */
+/* */
+/* Every decode checks the entries it passes: a frame starting after an entry with none starting on it */
+/* means a different capture or a different decode, and the entries from there on are dropped. */
+
+#define CAN_SOF_INDEX_INTERVAL 64
+#define CAN_SOF_INDEX_FINGERPRINT_FRAMES 16
+
+enum CanSofKind { SofKindClassic, SofKindRemote, SofKindFd, SofKindCount };
+
+class CanSofIndexEntry
+{
+public:
+	U64 mStartOfFrame;
+	U8 mKind;	/* CanSofKind */
+};
+
+/* Used by the analyzer's worker thread only */
+class CAN_FDSofIndex
+{
+public:
+	CAN_FDSofIndex();
+
+	/* For a decode from the start of the capture, whose first frames are then added. Once they identify */
+	/* the capture, the entries already held for the same folder, key and capture are kept, otherwise */
+	/* they are loaded from the folder. Without a folder the index is kept in memory only. */
+	void Open(const std::string& folder, const std::string& key, U32 num_buses);
+	bool IsFingerprinted() const;
+
+	/* Tells captures apart once IsFingerprinted */
+	U64 GetFingerprint() const;
+
+	/* Every frame the decoder reads, in order on each bus. Noise is added too, as not indexable. */
+	void AddFrame(U32 bus_index, U64 start_of_frame, bool indexable, CanSofKind kind);
+
+	/* The decode is carrying on further into the capture, the frames in between are not missing */
+	void Resync();
+
+	/* The last entry at or before the sample, false if there is none */
+	bool Find(U32 bus_index, U64 sample, CanSofIndexEntry& entry) const;
+
+	/* Writes the entries added since the last save */
+	void Save();
+
+protected: //functions
+	void AppendEntry(std::vector<U8>& bytes, U32 bus_index, const CanSofIndexEntry& entry);
+	void AddToFingerprint(U32 bus_index, U64 start_of_frame);
+	void Load();
+
+protected: //vars
+	std::string mOpenFolder;
+	std::string mOpenKey;
+	U64 mFingerprint;
+	U32 mFingerprintFrames;
+
+	/* The capture the entries are for, set once the fingerprint is complete */
+	std::string mFolder;
+	std::string mKey;
+	std::string mPath;
+	U32 mNumBuses;
+
+	std::vector< std::vector<CanSofIndexEntry> > mEntries;
+	std::vector<U64> mLastStartOfFrame;		/* 0 before the first frame since Open or Resync */
+	std::vector<U32> mFramesSinceEntry;
+
+	/* Entries not yet in the file, or the whole file is written again after entries were dropped */
+	std::vector<U8> mUnsaved;
+	bool mRewrite;
+};
+
+#endif //CAN_FD_SOF_INDEX
@@ -0,0 +1,197 @@
+#include "CAN_FDTrace.h"
+#include <AnalyzerChannelData.h>
+#include <iomanip>
+#include <sstream>
+
+static std::atomic<U64> gNextTraceInstance(1);
+
+/* Each thread remembers the buffer it last used, and for which trace. Instance ids are never reused, */
+/* so a cached buffer can't belong to a trace that has since been destroyed. */
+static thread_local U64 gCachedTraceInstance = 0;
+static thread_local CanTraceBuffer* gCachedTraceBuffer = NULL;
+
+CanTraceBuffer::CanTraceBuffer(U32 thread_id)
+:	mThreadId(thread_id),
+	mEvents(TRACE_BUFFER_EVENTS),
+	mWritten(0),
+	mFlushed(0)
+{
+}
+
+CanTrace::CanTrace()
+:	mEnabled(false),
+	mInstanceId(gNextTraceInstance++),
+	mOrigin(std::chrono::steady_clock::now()),
+	mDropped(0)
+{
+}
+
+CanTrace::~CanTrace()
+{
+	Flush();
+
+	for (U32 i = 0; i < mBuffers.size(); i++)
+		delete mBuffers[i];
+}
+
+void CanTrace::Start(const std::string& file)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (mFile.is_open())
+		mFile.close();
+
+	/* Anything still buffered belongs to the previous run */
+	for (U32 i = 0; i < mBuffers.size(); i++)
+		mBuffers[i]->mFlushed = mBuffers[i]->mWritten.load(std::memory_order_acquire);
+
+	mDropped = 0;
+	mOrigin = std::chrono::steady_clock::now();
+
+	if (file.empty() == false)
+	{
+		mFile.open(file.c_str(), std::ios::out | std::ios::trunc);
+
+		/* The closing bracket is optional in the JSON array trace format, which lets the file be appended to */
+		if (mFile.is_open())
+			mFile << "[" << std::endl;
+	}
+
+	mEnabled.store(mFile.is_open(), std::memory_order_release);
+}
+
+bool CanTrace::IsEnabled() const
+{
+	return mEnabled.load(std::memory_order_relaxed);
+}
+
+CanTraceBuffer* CanTrace::GetThreadBuffer()
+{
+	if (gCachedTraceInstance == mInstanceId)
+		return gCachedTraceBuffer;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	CanTraceBuffer* buffer = new CanTraceBuffer((U32)mBuffers.size() + 1);
+	mBuffers.push_back(buffer);
+
+	gCachedTraceInstance = mInstanceId;
+	gCachedTraceBuffer = buffer;
+	return buffer;
+}
+
+void CanTrace::AddEvent(const char* name, std::chrono::steady_clock::time_point start, U64 first_sample, U64 last_sample)
+{
+	if (IsEnabled() == false)
+		return;
+
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	CanTraceBuffer* buffer = GetThreadBuffer();
+
+	U64 index = buffer->mWritten.load(std::memory_order_relaxed);
+	CanTraceEvent& event = buffer->mEvents[index % TRACE_BUFFER_EVENTS];
+
+	event.mName = name;
+	event.mStartNs = (U64)std::chrono::duration_cast<std::chrono::nanoseconds>(start - mOrigin).count();
+	event.mDurationNs = (U64)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	event.mFirstSample = first_sample;
+	event.mLastSample = last_sample;
+
+	buffer->mWritten.store(index + 1, std::memory_order_release);
+}
+
+void CanTrace::Flush()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (mFile.is_open() == false)
+		return;
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(3);
+
+	for (U32 b = 0; b < mBuffers.size(); b++)
+	{
+		CanTraceBuffer* buffer = mBuffers[b];
+		U64 written = buffer->mWritten.load(std::memory_order_acquire);
+
+		/* The writer has lapped us, the oldest events are gone */
+		if ((written - buffer->mFlushed) > TRACE_BUFFER_EVENTS)
+		{
+			mDropped += (written - buffer->mFlushed) - TRACE_BUFFER_EVENTS;
+			buffer->mFlushed = written - TRACE_BUFFER_EVENTS;
+		}
+
+		for (U64 i = buffer->mFlushed; i < written; i++)
+		{
+			CanTraceEvent event = buffer->mEvents[i % TRACE_BUFFER_EVENTS];
+
+			/* The writer may have overwritten this slot while it was being copied */
+			if ((buffer->mWritten.load(std::memory_order_acquire) - i) > TRACE_BUFFER_EVENTS)
+			{
+				mDropped++;
+				continue;
+			}
+
+			ss << "{\"name\":\"" << event.mName << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->mThreadId;
+			ss << ",\"ts\":" << (double(event.mStartNs) / 1000.0) << ",\"dur\":" << (double(event.mDurationNs) / 1000.0);
+			ss << ",\"args\":{\"first_sample\":" << event.mFirstSample << ",\"last_sample\":" << event.mLastSample << "}}," << std::endl;
+		}
+
+		buffer->mFlushed = written;
+	}
+
+	if (mDropped > 0)
+	{
+		ss << "{\"name\":\"dropped events\",\"ph\":\"C\",\"pid\":1,\"ts\":0,\"args\":{\"dropped\":" << mDropped << "}}," << std::endl;
+		mDropped = 0;
+	}
+
+	mFile << ss.str();
+	mFile.flush();
+}
+
+CanTraceScope::CanTraceScope(CanTrace& trace, const char* name, AnalyzerChannelData* channel)
+:	mTrace(NULL),
+	mName(name),
+	mChannel(channel),
+	mFirstSample(0),
+	mLastSample(0)
+{
+	if (trace.IsEnabled() == false)
+		return;
+
+	mTrace = &trace;
+	mFirstSample = channel->GetSampleNumber();
+	mStart = std::chrono::steady_clock::now();
+}
+
+CanTraceScope::CanTraceScope(CanTrace& trace, const char* name, U64 first_sample)
+:	mTrace(NULL),
+	mName(name),
+	mChannel(NULL),
+	mFirstSample(first_sample),
+	mLastSample(first_sample)
+{
+	if (trace.IsEnabled() == false)
+		return;
+
+	mTrace = &trace;
+	mStart = std::chrono::steady_clock::now();
+}
+
+CanTraceScope::~CanTraceScope()
+{
+	if (mTrace == NULL)
+		return;
+
+	if (mChannel != NULL)
+		mLastSample = mChannel->GetSampleNumber();
+
+	mTrace->AddEvent(mName, mStart, mFirstSample, mLastSample);
+}
+
+void CanTraceScope::SetLastSample(U64 sample)
+{
+	mLastSample = sample;
+}
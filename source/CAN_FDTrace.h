@@ -0,0 +1,88 @@
+#ifndef CAN_FD_TRACE_H
+#define CAN_FD_TRACE_H
+
+#include <AnalyzerTypes.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Optional timeline of decoder and export phases, written as Chrome trace event JSON (chrome://tracing, Perfetto). */
+/* Each thread records into its own ring buffer without locking. The buffers are drained into the trace file */
+/* at the same points where the decoder publishes its results, and after each export. */
+
+/* Events per thread kept between two flushes, older ones are dropped when a thread gets this far ahead */
+#define TRACE_BUFFER_EVENTS 65536
+
+class AnalyzerChannelData;
+
+class CanTraceEvent
+{
+public:
+	const char* mName;
+	U64 mStartNs;
+	U64 mDurationNs;
+	U64 mFirstSample;
+	U64 mLastSample;
+};
+
+/* Single producer ring buffer. The owning thread is the only writer, mWritten publishes its events. */
+class CanTraceBuffer
+{
+public:
+	CanTraceBuffer(U32 thread_id);
+
+	U32 mThreadId;
+	std::vector<CanTraceEvent> mEvents;
+	std::atomic<U64> mWritten;
+	U64 mFlushed;
+};
+
+class CanTrace
+{
+public:
+	CanTrace();
+	~CanTrace();
+
+	/* Starts a new trace file, or turns tracing off for an empty path */
+	void Start(const std::string& file);
+	bool IsEnabled() const;
+
+	void AddEvent(const char* name, std::chrono::steady_clock::time_point start, U64 first_sample, U64 last_sample);
+	void Flush();
+
+protected:
+	CanTraceBuffer* GetThreadBuffer();
+
+	std::atomic<bool> mEnabled;
+	U64 mInstanceId;
+	std::chrono::steady_clock::time_point mOrigin;
+
+	std::mutex mMutex;
+	std::vector<CanTraceBuffer*> mBuffers;
+	std::ofstream mFile;
+	U64 mDropped;
+};
+
+/* Records the time between construction and destruction as one event */
+class CanTraceScope
+{
+public:
+	CanTraceScope(CanTrace& trace, const char* name, AnalyzerChannelData* channel);
+	CanTraceScope(CanTrace& trace, const char* name, U64 first_sample);
+	~CanTraceScope();
+
+	void SetLastSample(U64 sample);
+
+protected:
+	CanTrace* mTrace;
+	const char* mName;
+	AnalyzerChannelData* mChannel;
+	U64 mFirstSample;
+	U64 mLastSample;
+	std::chrono::steady_clock::time_point mStart;
+};
+
+#endif //CAN_FD_TRACE_H
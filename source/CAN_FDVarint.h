@@ -0,0 +1,77 @@
+#ifndef CAN_FD_VARINT
+#define CAN_FD_VARINT
+
+#include <AnalyzerTypes.h>
+#include <cstddef>
+#include <vector>
+
+/* Little-endian base 128 integers, seven bits a byte with the top bit set on all but the last byte, and */
+/* the other helpers shared by the files the analyzer keeps */
+
+inline void AppendVarint(std::vector<U8>& bytes, U64 value)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back(U8(value | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back(U8(value));
+}
+
+inline U64 ReadVarint(const U8*& p)
+{
+	U64 value = 0;
+	U32 shift = 0;
+	for (; ; )
+	{
+		U8 byte = *p++;
+		value |= U64(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return value;
+		shift += 7;
+	}
+}
+
+/* Varints read from a file are bounded, a damaged file must not be read past its end */
+inline bool ReadBoundedVarint(const U8*& p, const U8* end, U64& value)
+{
+	value = 0;
+	for (U32 shift = 0; shift < 64; shift += 7)
+	{
+		if (p >= end)
+			return false;
+
+		U8 byte = *p++;
+		value |= U64(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+/* Signed values interleaved with the unsigned ones, so small values of either sign stay short */
+inline U64 ZigZag(S64 value)
+{
+	return (U64(value) << 1) ^ U64(value >> 63);
+}
+
+inline S64 UnZigZag(U64 value)
+{
+	return S64(value >> 1) ^ -S64(value & 1);
+}
+
+/* 64 bit FNV-1a, for naming files after what they depend on */
+static const U64 gFnvOffsetBasis = 0xCBF29CE484222325ull;
+
+inline U64 Fnv1a(U64 hash, const void* data, size_t size)
+{
+	const U8* p = (const U8*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= p[i];
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+#endif //CAN_FD_VARINT
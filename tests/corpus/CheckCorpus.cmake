@@ -0,0 +1,51 @@
+# Decodes one corpus edge list and compares the frames and statistics exports with the expected ones.
+# Also fails when decoding is slower than the file's baseline by more than the tolerance.
+#
+#   cmake -DRUNNER=<CAN_FDRunner> -DCORPUS=<dir> -DNAME=<file name> "-DARGS=<runner options>"
+#         -DBASELINE=<x real time> -DTOLERANCE=<percent> -DCHECK_THROUGHPUT=<ON/OFF> -P CheckCorpus.cmake
+
+separate_arguments(RUNNER_ARGS UNIX_COMMAND "${ARGS}")
+set(EDGES ${CORPUS}/${NAME}.edges)
+
+execute_process(COMMAND ${RUNNER} ${RUNNER_ARGS} --repeat 10 --edges ${EDGES} ${NAME}.frames.csv
+	RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE error)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "CAN_FDRunner failed on ${EDGES}: ${error}")
+endif()
+message("${output}")
+
+execute_process(COMMAND ${RUNNER} ${RUNNER_ARGS} --export-type 1 --edges ${EDGES} ${NAME}.stats.csv
+	RESULT_VARIABLE result OUTPUT_QUIET ERROR_VARIABLE error)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "CAN_FDRunner failed on ${EDGES}: ${error}")
+endif()
+
+foreach(export frames stats)
+	execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${NAME}.${export}.csv ${CORPUS}/${NAME}.${export}.csv RESULT_VARIABLE different)
+	if(NOT different EQUAL 0)
+		message(FATAL_ERROR "${NAME}.${export}.csv differs from ${CORPUS}/${NAME}.${export}.csv")
+	endif()
+endforeach()
+
+if(NOT CHECK_THROUGHPUT)
+	return()
+endif()
+
+# CMake only does integer sums, so the rates are compared in tenths, as the runner prints them
+string(REGEX MATCH "\\(([0-9]+)\\.([0-9]) x real time\\)" match "${output}")
+if(NOT match)
+	message(FATAL_ERROR "no throughput in the CAN_FDRunner output")
+endif()
+set(throughput "${CMAKE_MATCH_1}${CMAKE_MATCH_2}")
+
+string(REGEX MATCH "^([0-9]+)\\.([0-9])$" match "${BASELINE}")
+if(NOT match)
+	message(FATAL_ERROR "baseline ${BASELINE} is not a rate with one decimal place")
+endif()
+math(EXPR minimum "${CMAKE_MATCH_1}${CMAKE_MATCH_2} * (100 - ${TOLERANCE}) / 100")
+
+if(throughput LESS minimum)
+	math(EXPR whole "${throughput} / 10")
+	math(EXPR tenths "${throughput} % 10")
+	message(FATAL_ERROR "${NAME} decoded at ${whole}.${tenths} x real time, more than ${TOLERANCE}% below its baseline of ${BASELINE} x")
+endif()
@@ -0,0 +1,65 @@
+# Decodes an edge list written by encode_frames.py and compares the frames export with the one it wrote.
+# Every column but the time must match. The encoder gives each packet the time of its start of frame, and
+# the analyzer places a packet at the first raw bit it samples after it, so the time may be later by up
+# to WINDOW nanoseconds.
+#
+#   cmake -DRUNNER=<CAN_FDRunner> -DCORPUS=<dir> -DNAME=<file name> "-DARGS=<runner options>"
+#         -DWINDOW=<ns> -P CheckEncoded.cmake
+
+separate_arguments(RUNNER_ARGS UNIX_COMMAND "${ARGS}")
+set(EDGES ${CORPUS}/${NAME}.edges)
+set(EXPECTED ${CORPUS}/${NAME}.expected.csv)
+
+execute_process(COMMAND ${RUNNER} ${RUNNER_ARGS} --edges ${EDGES} ${NAME}.frames.csv
+	RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE error)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "CAN_FDRunner failed on ${EDGES}: ${error}")
+endif()
+message("${output}")
+
+# The times have 9 decimal places, so as whole nanoseconds they fit CMake's 64-bit integer sums
+function(time_ns time result)
+	string(REGEX MATCH "^([0-9]+)\\.0*([0-9]+)$" match "${time}")
+	if(NOT match)
+		message(FATAL_ERROR "${time} is not a time in seconds")
+	endif()
+	math(EXPR ns "${CMAKE_MATCH_1} * 1000000000 + ${CMAKE_MATCH_2}")
+	set(${result} ${ns} PARENT_SCOPE)
+endfunction()
+
+file(STRINGS ${EXPECTED} expected_lines)
+file(STRINGS ${NAME}.frames.csv got_lines)
+list(LENGTH expected_lines expected_count)
+list(LENGTH got_lines got_count)
+if(NOT expected_count EQUAL got_count)
+	message(FATAL_ERROR "${NAME}.frames.csv has ${got_count} lines, ${EXPECTED} has ${expected_count}")
+endif()
+
+list(GET expected_lines 0 expected_header)
+list(GET got_lines 0 got_header)
+if(NOT expected_header STREQUAL got_header)
+	message(FATAL_ERROR "${NAME}.frames.csv has the header ${got_header}")
+endif()
+
+math(EXPR last "${expected_count} - 1")
+foreach(row RANGE 1 ${last})
+	list(GET expected_lines ${row} expected_line)
+	list(GET got_lines ${row} got_line)
+	string(REGEX MATCH "^([^,]*),(.*)$" match "${expected_line}")
+	set(expected_time ${CMAKE_MATCH_1})
+	set(expected_rest "${CMAKE_MATCH_2}")
+	string(REGEX MATCH "^([^,]*),(.*)$" match "${got_line}")
+	set(got_time ${CMAKE_MATCH_1})
+	set(got_rest "${CMAKE_MATCH_2}")
+
+	if(NOT expected_rest STREQUAL got_rest)
+		message(FATAL_ERROR "line ${row} of ${NAME}.frames.csv is\n  ${got_line}\nnot\n  ${expected_line}")
+	endif()
+
+	time_ns(${expected_time} start)
+	time_ns(${got_time} time)
+	math(EXPR end "${start} + ${WINDOW}")
+	if((time LESS start) OR (time GREATER end))
+		message(FATAL_ERROR "line ${row} of ${NAME}.frames.csv is at ${got_time} s, more than ${WINDOW} ns from the start of frame at ${expected_time} s")
+	endif()
+endforeach()
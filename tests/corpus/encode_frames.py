@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+# Encodes a list of CAN and CAN-FD frames as an edge list for CAN_FDRunner --edges, and writes the frames
+# export the analyzer must produce for it. Written from ISO 11898-1:2015 without reference to the analyzer
+# or its simulation data generator, so the expected export comes from the frame list alone.
+#
+#   encode_frames.py [options] <frame list> <edge list> <expected frames export>
+#
+# Each line of the frame list is one frame, sent after the bus has been idle for --gap bits:
+#
+#   <kind> <identifier> <DLC> [<data bytes in hex>...]
+#
+# The kind is classic, remote, fd or fd_brs. An identifier of 3 hex digits or fewer is a base identifier,
+# one of 8 digits an extended one. The DLC is the 4-bit code sent, and for FD frames it maps to up to 64
+# data bytes. Blank lines and lines starting with # are skipped.
+#
+# Bit timing follows the standard. The arbitration phase uses the nominal bit time. In a frame with BRS
+# recessive, the data bit time takes over at the sample point of the BRS bit, and the nominal one again
+# at the sample point of the CRC delimiter. Every frame is acknowledged.
+#
+# The expected export gives each frame's start of frame as its time. CheckEncoded.cmake allows the
+# analyzer to place the packet up to two nominal bits after it.
+
+import argparse
+import sys
+
+DLC_BYTES = [0, 1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64]
+STUFF_COUNT_GRAY = [0b000, 0b001, 0b011, 0b010, 0b110, 0b111, 0b101, 0b100]
+
+DOMINANT = 0
+RECESSIVE = 1
+
+
+class Frame:
+	def __init__(self, kind, identifier, extended, dlc, data):
+		self.kind = kind
+		self.identifier = identifier
+		self.extended = extended
+		self.dlc = dlc
+		self.data = data
+
+	def is_fd(self):
+		return self.kind in ("fd", "fd_brs")
+
+
+def parse_frames(path):
+	frames = []
+	with open(path) as f:
+		for number, line in enumerate(f, 1):
+			line = line.split("#", 1)[0].strip()
+			if not line:
+				continue
+
+			fields = line.split()
+			kind = fields[0]
+			if kind not in ("classic", "remote", "fd", "fd_brs"):
+				sys.exit("%s:%d: unknown kind %s" % (path, number, kind))
+
+			extended = len(fields[1]) > 3
+			identifier = int(fields[1], 16)
+			if identifier >= (1 << (29 if extended else 11)):
+				sys.exit("%s:%d: identifier out of range" % (path, number))
+
+			dlc = int(fields[2])
+			if not 0 <= dlc <= 15:
+				sys.exit("%s:%d: DLC out of range" % (path, number))
+
+			data = [int(b, 16) for b in fields[3:]]
+			if kind == "remote":
+				expected_bytes = 0
+			elif kind == "classic":
+				expected_bytes = min(dlc, 8)
+			else:
+				expected_bytes = DLC_BYTES[dlc]
+			if len(data) != expected_bytes:
+				sys.exit("%s:%d: DLC %d needs %d data bytes, not %d" % (path, number, dlc, expected_bytes, len(data)))
+
+			frames.append(Frame(kind, identifier, extended, dlc, data))
+	return frames
+
+
+def bits_of(value, count):
+	return [(value >> (count - 1 - i)) & 1 for i in range(count)]
+
+
+def crc(bits, polynomial, width, initial):
+	# The shift register form of clause 10.4.2.6: the next bit XOR the register's top bit decides whether
+	# the polynomial is applied after the shift
+	register = initial
+	top = 1 << (width - 1)
+	mask = (1 << width) - 1
+	for bit in bits:
+		feedback = bit ^ (1 if (register & top) else 0)
+		register = (register << 1) & mask
+		if feedback:
+			register ^= polynomial & mask
+	return register
+
+
+def stuff(bits):
+	# A bit of the opposite level after every five bits of one level. A stuff bit counts towards the
+	# next run. Returns the stuffed bits, the number of stuff bits and where each bit went.
+	out = []
+	positions = []
+	run_level = None
+	run_length = 0
+	count = 0
+	for bit in bits:
+		positions.append(len(out))
+		out.append(bit)
+		if bit == run_level:
+			run_length += 1
+		else:
+			run_level = bit
+			run_length = 1
+
+		if run_length == 5:
+			out.append(1 - bit)
+			count += 1
+			run_level = 1 - bit
+			run_length = 1
+	return out, count, positions
+
+
+def header_bits(frame):
+	# SOF to the end of the control field, as (bits, index of BRS or None)
+	bits = [DOMINANT]
+	if frame.extended:
+		bits += bits_of(frame.identifier >> 18, 11)
+		bits += [RECESSIVE, RECESSIVE]	# SRR, IDE
+		bits += bits_of(frame.identifier & 0x3FFFF, 18)
+	else:
+		bits += bits_of(frame.identifier, 11)
+
+	brs_index = None
+	if frame.is_fd():
+		bits.append(DOMINANT)	# RRS
+		if not frame.extended:
+			bits.append(DOMINANT)	# IDE
+		bits += [RECESSIVE, DOMINANT]	# FDF, res
+		brs_index = len(bits)
+		bits.append(RECESSIVE if frame.kind == "fd_brs" else DOMINANT)
+		bits.append(DOMINANT)	# ESI, error active
+	else:
+		bits.append(RECESSIVE if frame.kind == "remote" else DOMINANT)	# RTR
+		if frame.extended:
+			bits += [DOMINANT, DOMINANT]	# r1, r0
+		else:
+			bits += [DOMINANT, DOMINANT]	# IDE, r0
+
+	bits += bits_of(frame.dlc, 4)
+	return bits, brs_index
+
+
+def encode(frame):
+	# The frame's bits on the bus up to the end of the CRC sequence, with the index of the BRS bit, and
+	# the CRC value the frame carries
+	bits, brs_index = header_bits(frame)
+	for byte in frame.data:
+		bits += bits_of(byte, 8)
+
+	if not frame.is_fd():
+		crc_value = crc(bits, 0x4599, 15, 0)
+		stuffed, _, _ = stuff(bits + bits_of(crc_value, 15))
+		return stuffed, None, crc_value
+
+	# Dynamic stuffing ends with the data field. The CRC field starts with the stuff count, and has a
+	# fixed stuff bit, the complement of the bit before it, before its first bit and after every fourth.
+	# A run of five at the end of the data field is broken by the first fixed stuff bit, not a dynamic one.
+	stuffed, count, positions = stuff(bits)
+	if positions[-1] != len(stuffed) - 1:
+		stuffed.pop()
+		count -= 1
+
+	gray = STUFF_COUNT_GRAY[count % 8]
+	stuff_count = bits_of(gray, 3) + [bin(gray).count("1") & 1]
+
+	if len(frame.data) > 16:
+		crc_value = crc(stuffed + stuff_count, 0x302899, 21, 1 << 20)
+		crc_bits = bits_of(crc_value, 21)
+	else:
+		crc_value = crc(stuffed + stuff_count, 0x3685B, 17, 1 << 16)
+		crc_bits = bits_of(crc_value, 17)
+
+	out = list(stuffed)
+	for i, bit in enumerate(stuff_count + crc_bits):
+		if i % 4 == 0:
+			out.append(1 - out[-1])
+		out.append(bit)
+	return out, positions[brs_index], crc_value
+
+
+class Line:
+	# Bus levels over time, kept as the times at which the level changes
+	def __init__(self):
+		self.time = 0.0
+		self.level = RECESSIVE
+		self.edges = []
+
+	def bit(self, level, length):
+		if level != self.level:
+			self.edges.append(self.time)
+			self.level = level
+		self.time += length
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Encode CAN and CAN-FD frames as an edge list")
+	parser.add_argument("--hdr", type=int, default=500000, help="nominal bit rate in bits/s")
+	parser.add_argument("--data", type=int, default=2000000, help="data phase bit rate in bits/s")
+	parser.add_argument("--rate", type=int, default=50000000, help="sample rate in samples/s")
+	parser.add_argument("--sample-point", type=float, default=80.0, help="nominal sample point in percent")
+	parser.add_argument("--data-sample-point", type=float, default=75.0, help="data phase sample point in percent")
+	parser.add_argument("--gap", type=float, default=20.0, help="idle nominal bits before each start of frame")
+	parser.add_argument("--inverted", action="store_true", help="the capture is of CAN High")
+	parser.add_argument("frames")
+	parser.add_argument("edges")
+	parser.add_argument("expected")
+	args = parser.parse_args()
+
+	nominal = float(args.rate) / args.hdr
+	data = float(args.rate) / args.data
+	sp_nominal = args.sample_point / 100.0
+	sp_data = args.data_sample_point / 100.0
+
+	frames = parse_frames(args.frames)
+	line = Line()
+	rows = []
+
+	for frame in frames:
+		line.bit(RECESSIVE, args.gap * nominal)
+		start_of_frame = line.time
+
+		bits, brs_index, crc_value = encode(frame)
+		switched = frame.kind == "fd_brs"
+		for i, bit in enumerate(bits):
+			if switched and i == brs_index:
+				length = sp_nominal * nominal + (1.0 - sp_data) * data
+			elif switched and i > brs_index:
+				length = data
+			else:
+				length = nominal
+			line.bit(bit, length)
+
+		if switched:
+			line.bit(RECESSIVE, sp_data * data + (1.0 - sp_nominal) * nominal)	# CRC delimiter
+		else:
+			line.bit(RECESSIVE, nominal)
+		line.bit(DOMINANT, nominal)	# ACK slot, acknowledged
+		line.bit(RECESSIVE, nominal)	# ACK delimiter
+		line.bit(RECESSIVE, 10 * nominal)	# EOF and intermission
+
+		rows.append((start_of_frame, frame, crc_value))
+
+	line.bit(RECESSIVE, args.gap * nominal)
+	num_samples = int(round(line.time))
+
+	# The edge list holds the logic level the analyzer sees. Recessive is high on CAN RX and low on CAN High.
+	idle_state = 0 if args.inverted else 1
+	with open(args.edges, "w") as out:
+		out.write("%d %d %d\n" % (args.rate, num_samples, idle_state))
+		for edge in line.edges:
+			out.write("%d\n" % int(round(edge)))
+
+	with open(args.expected, "w") as out:
+		out.write("Time [s],Packet,Type,Identifier,Control,Data,CRC,ACK\n")
+		for packet, (start_of_frame, frame, crc_value) in enumerate(rows):
+			identifier = ("0x%08X" if frame.extended else "0x%03X") % frame.identifier
+			crc_digits = 4 if not frame.is_fd() else (6 if len(frame.data) > 16 else 5)
+			out.write("%.9f,%d,%s,%s,0x%X,%s,0x%0*X,ACK\n" % (
+				int(round(start_of_frame)) / float(args.rate), packet, "REMOTE" if frame.kind == "remote" else "DATA",
+				identifier, frame.dlc, " ".join("0x%02X" % b for b in frame.data), crc_digits, crc_value))
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,111 @@
+# Decodes with a saved settings string and compares the export with the expected one. The settings
+# the analyzer saves again after loading the string must be the same string.
+#
+#   cmake -DRUNNER=<CAN_FDRunner> -DSETTINGS=<file> "-DARGS=<runner options>" -DEXPORT=<file>
+#         -DEXPECTED=<file> [-DRUNS=<n>] [-DCACHE=<folder> [-DTRACE=<file>]] [-DGUNZIP=<program>]
+#         [-DCOLUMNS=<n,n,...>] [-DORDERED=ON] -P CheckSettings.cmake
+#
+# With RUNS the capture is decoded that many times over, each one starting a new runner, and every
+# export has to match. The decode cache is checked this way: CACHE is its folder, emptied before the
+# first run, and the first run must leave a cache file in it. TRACE is the trace file the settings
+# write, and every later run must show replaying the cache in it. With GUNZIP the export is written
+# gzip compressed, to the file name with .gz added, and is decompressed with it. With COLUMNS only
+# those columns of the CSV exports are compared, counting from 0, for features that leave the other
+# columns out. With ORDERED the times in the first column of the export must never go back.
+
+function(read_columns file columns result)
+	file(STRINGS ${file} lines)
+	set(rows "")
+	foreach(line IN LISTS lines)
+		string(REPLACE "," ";" fields "${line}")
+		set(row "")
+		foreach(column IN LISTS columns)
+			list(GET fields ${column} field)
+			string(APPEND row "${field},")
+		endforeach()
+		string(APPEND rows "${row}\n")
+	endforeach()
+	set(${result} "${rows}" PARENT_SCOPE)
+endfunction()
+
+separate_arguments(RUNNER_ARGS UNIX_COMMAND "${ARGS}")
+file(READ ${SETTINGS} settings)
+string(REGEX REPLACE "[\r\n]+$" "" settings "${settings}")
+
+if(NOT RUNS)
+	set(RUNS 1)
+endif()
+
+if(CACHE)
+	file(REMOVE_RECURSE ${CACHE})
+	file(MAKE_DIRECTORY ${CACHE})
+endif()
+
+foreach(run RANGE 1 ${RUNS})
+	file(REMOVE ${EXPORT} ${EXPORT}.gz)
+	if(TRACE)
+		file(REMOVE ${TRACE})
+	endif()
+	execute_process(COMMAND ${RUNNER} ${RUNNER_ARGS} --settings "${settings}" --save-settings saved_${EXPORT}.txt ${EXPORT}
+		RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE error)
+	message("${output}${error}")
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "CAN_FDRunner failed")
+	endif()
+
+	if(GUNZIP)
+		if(EXISTS ${EXPORT})
+			message(FATAL_ERROR "${EXPORT} was written without compression")
+		endif()
+		execute_process(COMMAND ${GUNZIP} -c ${EXPORT}.gz OUTPUT_FILE ${EXPORT} RESULT_VARIABLE result)
+		if(NOT result EQUAL 0)
+			message(FATAL_ERROR "${EXPORT}.gz is not gzip compressed")
+		endif()
+	endif()
+
+	file(READ saved_${EXPORT}.txt saved)
+	string(REGEX REPLACE "[\r\n]+$" "" saved "${saved}")
+	if(NOT saved STREQUAL settings)
+		message(FATAL_ERROR "settings saved after loading differ:\n  loaded '${settings}'\n  saved  '${saved}'")
+	endif()
+
+	if(CACHE AND (run EQUAL 1))
+		file(GLOB cache_files ${CACHE}/*.canfdcache)
+		if(NOT cache_files)
+			message(FATAL_ERROR "no decode cache in ${CACHE} after the first run")
+		endif()
+	elseif(CACHE AND TRACE)
+		file(READ ${TRACE} trace)
+		string(FIND "${trace}" "\"name\":\"Cache replay\"" replay)
+		if(replay EQUAL -1)
+			message(FATAL_ERROR "run ${run} did not replay the decode cache")
+		endif()
+	endif()
+
+	if(ORDERED)
+		file(STRINGS ${EXPORT} lines)
+		list(REMOVE_AT lines 0)
+		set(previous 0.0)
+		foreach(line IN LISTS lines)
+			string(REGEX MATCH "^[^,]*" time "${line}")
+			if(time VERSION_LESS previous)
+				message(FATAL_ERROR "${EXPORT} goes back in time from ${previous} s to ${time} s")
+			endif()
+			set(previous ${time})
+		endforeach()
+	endif()
+
+	if(COLUMNS)
+		string(REPLACE "," ";" columns "${COLUMNS}")
+		read_columns(${EXPORT} "${columns}" exported)
+		read_columns(${EXPECTED} "${columns}" expected)
+		if(NOT exported STREQUAL expected)
+			message(FATAL_ERROR "columns ${COLUMNS} of ${EXPORT} differ from ${EXPECTED} on run ${run}")
+		endif()
+	else()
+		execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${EXPORT} ${EXPECTED} RESULT_VARIABLE different)
+		if(NOT different EQUAL 0)
+			message(FATAL_ERROR "${EXPORT} differs from ${EXPECTED} on run ${run}")
+		endif()
+	endif()
+endforeach()
@@ -0,0 +1,535 @@
+/* Headless driver for the CAN-FD analyzer, built against the SDK stand-in in sdk_standin/. */
+/* Decodes either the analyzer's own simulation data or an edge list file, reports the time taken */
+/* by the decoder, and writes one of the analyzer's exports. With a ground truth file from the */
+/* simulation, it also reports how the decoder coped with the faults put into the simulated frames. */
+
+#include "CAN_FDAnalyzer.h"
+#include "CAN_FDAnalyzerSettings.h"
+#include "CAN_FDAnalyzerResults.h"
+#include "CAN_FDSimulationDataGenerator.h"
+#include <AnalyzerStandIn.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+static void PrintUsage()
+{
+	printf("usage: CAN_FDRunner [options] <export file>\n");
+	printf("  --hdr <bits/s>         header bit rate (default 500000)\n");
+	printf("  --data <bits/s>        data bit rate (default 2000000)\n");
+	printf("  --inverted             the capture is of CAN High\n");
+	printf("  --settings <archive>   load a saved settings string, after the options above\n");
+	printf("  --save-settings <file> write the settings string the analyzer saves, after loading --settings\n");
+	printf("  --rate <samples/s>     simulation sample rate (default 50000000)\n");
+	printf("  --seconds <s>          length of simulated capture (default 1.0)\n");
+	printf("  --edges <file>         decode an edge list instead of simulating:\n");
+	printf("                         \"<sample rate> <samples> <initial state 0/1>\" then one edge sample per line.\n");
+	printf("                         Given again, each further list is put on the next channel, for the\n");
+	printf("                         buses of the saved settings\n");
+	printf("  --save-edges <file>    write the capture as an edge list for --edges, before decoding it\n");
+	printf("  --before-edges <file>  first decode this edge list on channel 0 with the same analyzer, as an\n");
+	printf("                         earlier capture of the same session\n");
+	printf("  --trigger <s>          time of the trigger from the start of the capture (default 0)\n");
+	printf("  --export-type <id>     export menu entry, 0 = frames, 1 = statistics (default 0)\n");
+	printf("  --repeat <n>           decode the capture n times and report the fastest (default 1)\n");
+	printf("  --fault-rate <percent> share of simulated frames given a protocol fault (default 0)\n");
+	printf("  --faults <list>        faults to use in turn, from stuff, flip, form, ack, error, overload,\n");
+	printf("                         collision (default all)\n");
+	printf("  --ppm <ppm>            oscillator offset of the simulated nodes, up to this either way\n");
+	printf("  --jitter-ns <ns>       random edge jitter in the simulation, either way\n");
+	printf("  --asymmetry-ns <ns>    extra delay of recessive edges in the simulated data phase\n");
+	printf("  --glitches <percent>  share of simulated frames given a glitch\n");
+	printf("  --glitch-ns <ns>       width of the simulated glitches (default 20)\n");
+	printf("  --ground-truth <file>  the simulation lists every frame sent here, the decoded results are\n");
+	printf("                         then compared with it\n");
+	printf("  --find <hex id>        look the identifier up in the identifier index on every bus, for the\n");
+	printf("                         packets either side of --at\n");
+	printf("  --at <s>               time from the start of the capture for --find (default 0)\n");
+}
+
+static bool LoadEdges(const char* file, const Channel& channel, AnalyzerStandIn::Capture& capture)
+{
+	std::ifstream in(file);
+	if (in.is_open() == false)
+		return false;
+
+	U32 sample_rate;
+	U64 num_samples;
+	U32 initial_state;
+	if (!(in >> sample_rate >> num_samples >> initial_state))
+		return false;
+
+	/* The channels of one capture share its sample rate, and it lasts as long as the longest list */
+	if (capture.mChannels.empty() == true)
+	{
+		capture.mSampleRateHz = sample_rate;
+		capture.mNumSamples = num_samples;
+	}
+	else if (sample_rate != capture.mSampleRateHz)
+	{
+		return false;
+	}
+	else if (num_samples > capture.mNumSamples)
+	{
+		capture.mNumSamples = num_samples;
+	}
+
+	AnalyzerStandIn::CaptureChannel capture_channel;
+	capture_channel.mChannel = channel;
+	capture_channel.mInitialBitState = (initial_state != 0) ? BIT_HIGH : BIT_LOW;
+
+	U64 edge;
+	while (in >> edge)
+		capture_channel.mEdges.push_back(edge);
+
+	capture.mTriggerSample = 0;
+	capture.mChannels.push_back(capture_channel);
+	return true;
+}
+
+static bool SaveEdges(const char* file, const AnalyzerStandIn::Capture& capture)
+{
+	std::ofstream out(file);
+	if ((out.is_open() == false) || (capture.mChannels.empty() == true))
+		return false;
+
+	const AnalyzerStandIn::CaptureChannel& capture_channel = capture.mChannels[0];
+	out << capture.mSampleRateHz << " " << capture.mNumSamples << " " << ((capture_channel.mInitialBitState == BIT_HIGH) ? 1 : 0) << "\n";
+	for (U32 i = 0; i < capture_channel.mEdges.size(); i++)
+		out << capture_channel.mEdges[i] << "\n";
+
+	return out.good();
+}
+
+static void ReportIdentifier(CAN_FDIdIndex& index, U32 identifier, U64 sample, U32 sample_rate)
+{
+	/* 11-bit identifiers as well as 29-bit ones can be below 0x800 */
+	for (U32 bus = 0; bus < CAN_FD_MAX_BUSES; bus++)
+	{
+		for (U32 e = 0; e < 2; e++)
+		{
+			bool extended = (e == 1);
+			if ((extended == false) && (identifier > 0x7FF))
+				continue;
+
+			U64 count = index.GetCount(bus, identifier, extended);
+			if (count == 0)
+				continue;
+
+			printf("bus %u, %s identifier %X: %llu packets", bus, extended ? "29-bit" : "11-bit", identifier, count);
+
+			U64 packet_id;
+			U64 starting_sample;
+			if (index.FindPrevious(bus, identifier, extended, sample, packet_id, starting_sample) == true)
+				printf(", previous packet %llu at %.9f s", packet_id, double(starting_sample) / double(sample_rate));
+			if (index.FindNext(bus, identifier, extended, sample, packet_id, starting_sample) == true)
+				printf(", next packet %llu at %.9f s", packet_id, double(starting_sample) / double(sample_rate));
+			printf("\n");
+		}
+	}
+}
+
+static bool LoadGroundTruth(const char* file, U32 sample_rate, std::vector<CanSimulatedFrame>& frames)
+{
+	std::ifstream in(file);
+	if (in.is_open() == false)
+		return false;
+
+	std::string line;
+	std::getline(in, line);
+
+	while (std::getline(in, line))
+	{
+		/* Time [s],End [s],Identifier,Fault,Fault at [s],Error flag at [s],Glitch at [s],Status */
+		std::vector<std::string> fields;
+		size_t start = 0;
+		for (; ; )
+		{
+			size_t comma = line.find(',', start);
+			fields.push_back(line.substr(start, comma - start));
+			if (comma == std::string::npos)
+				break;
+			start = comma + 1;
+		}
+
+		if (fields.size() != 8)
+			return false;
+
+		CanSimulatedFrame frame;
+		frame.mStartingSample = U64(atof(fields[0].c_str()) * sample_rate + 0.5);
+		frame.mEndingSample = U64(atof(fields[1].c_str()) * sample_rate + 0.5);
+		frame.mIdentifier = (U32)strtoul(fields[2].c_str(), NULL, 16);
+		frame.mFaultSample = U64(atof(fields[4].c_str()) * sample_rate + 0.5);
+		frame.mErrorFlagSample = U64(atof(fields[5].c_str()) * sample_rate + 0.5);
+		frame.mGlitchSample = U64(atof(fields[6].c_str()) * sample_rate + 0.5);
+		frame.mReceived = (fields[7] == "OK");
+
+		U32 fault = SimFaultNone;
+		while ((fault < SimFaultCount) && (fields[3] != CAN_FDSimulationDataGenerator::GetFaultName((CanSimFault)fault)))
+			fault++;
+		if (fault == SimFaultCount)
+			return false;
+		frame.mFault = (CanSimFault)fault;
+
+		frames.push_back(frame);
+	}
+
+	return true;
+}
+
+/* Which of the frames the nodes received were decoded, which faults show as an error in the results, */
+/* and for each kind of fault how many received frames after it were lost before one was decoded */
+/* again, and how long after the end of the error or overload frame that was */
+static void ReportGroundTruth(const std::vector<CanSimulatedFrame>& frames, AnalyzerResults* results, const AnalyzerStandIn::Capture& capture)
+{
+	std::vector<U64> packet_starts;
+	std::vector<U32> packet_identifiers;
+	for (U64 i = 0; i < results->GetNumPackets(); i++)
+	{
+		U64 first_frame_id;
+		U64 last_frame_id;
+		results->GetFramesContainedInPacket(i, &first_frame_id, &last_frame_id);
+
+		Frame frame = results->GetFrame(first_frame_id);
+		if (frame.mType > FDIdentifierEx)
+			continue;
+
+		packet_starts.push_back(frame.mStartingSampleInclusive);
+		packet_identifiers.push_back((U32)frame.mData1);
+	}
+
+	std::vector<U64> error_starts;
+	for (U64 i = 0; i < results->GetNumFrames(); i++)
+	{
+		Frame frame = results->GetFrame(i);
+		if (frame.mType == CanError)
+			error_starts.push_back(frame.mStartingSampleInclusive);
+	}
+
+	/* Frames running past the end of the capture are left out */
+	U32 num_frames = 0;
+	while ((num_frames < frames.size()) && (frames[num_frames].mEndingSample <= capture.mNumSamples))
+		num_frames++;
+
+	std::vector<bool> decoded(num_frames, false);
+	std::vector<bool> flagged(num_frames, false);
+	U32 packet = 0;
+	U32 error = 0;
+	for (U32 i = 0; i < num_frames; i++)
+	{
+		const CanSimulatedFrame& frame = frames[i];
+
+		while ((packet < packet_starts.size()) && (packet_starts[packet] < frame.mStartingSample))
+			packet++;
+		for (U32 j = packet; (j < packet_starts.size()) && (packet_starts[j] < frame.mEndingSample); j++)
+		{
+			if (packet_identifiers[j] == frame.mIdentifier)
+				decoded[i] = true;
+		}
+
+		while ((error < error_starts.size()) && (error_starts[error] < frame.mStartingSample))
+			error++;
+		flagged[i] = (error < error_starts.size()) && (error_starts[error] < frame.mEndingSample);
+	}
+
+	/* A frame that failed the CRC check is still decoded, the error flag comes after it */
+	U32 received = 0;
+	U32 decoded_count = 0;
+	U32 not_received_decoded = 0;
+	U32 glitched = 0;
+	U32 glitched_decoded = 0;
+	for (U32 i = 0; i < num_frames; i++)
+	{
+		if ((frames[i].mReceived == true) && (frames[i].mGlitchSample != 0))
+		{
+			glitched++;
+			if (decoded[i] == true)
+				glitched_decoded++;
+		}
+
+		if (frames[i].mReceived == true)
+			received++;
+		if ((frames[i].mReceived == true) && (decoded[i] == true))
+			decoded_count++;
+		if ((frames[i].mReceived == false) && (decoded[i] == true))
+			not_received_decoded++;
+	}
+
+	printf("ground truth: %u frames sent, %u received, %u of those decoded, %u lost, %u decoded but not received\n",
+		num_frames, received, decoded_count, received - decoded_count, not_received_decoded);
+	if (glitched > 0)
+		printf("%u received frames with a glitch, %u of those decoded\n", glitched, glitched_decoded);
+	printf("fault       count  flagged  lost after  recovery mean/max [us]\n");
+
+	double us_per_sample = 1000000.0 / double(capture.mSampleRateHz);
+	for (U32 fault = SimFaultNone + 1; fault < SimFaultCount; fault++)
+	{
+		U32 count = 0;
+		U32 flagged_count = 0;
+		U32 lost_after = 0;
+		U32 recoveries = 0;
+		U64 recovery_total = 0;
+		U64 recovery_max = 0;
+
+		for (U32 i = 0; i < num_frames; i++)
+		{
+			if (frames[i].mFault != fault)
+				continue;
+
+			count++;
+			if (frames[i].mErrorFlagSample == 0)
+				continue;
+
+			if (flagged[i] == true)
+				flagged_count++;
+
+			for (U32 j = i + 1; j < num_frames; j++)
+			{
+				if (frames[j].mReceived == false)
+					continue;
+
+				if (decoded[j] == false)
+				{
+					lost_after++;
+					continue;
+				}
+
+				U64 recovery = frames[j].mStartingSample - frames[i].mEndingSample;
+				recoveries++;
+				recovery_total += recovery;
+				if (recovery > recovery_max)
+					recovery_max = recovery;
+				break;
+			}
+		}
+
+		if (count == 0)
+			continue;
+
+		double recovery_mean = (recoveries > 0) ? (double(recovery_total) / double(recoveries)) : 0.0;
+		printf("%-10s %6u %8u %11u  %.1f / %.1f\n", CAN_FDSimulationDataGenerator::GetFaultName((CanSimFault)fault), count, flagged_count, lost_after,
+			recovery_mean * us_per_sample, double(recovery_max) * us_per_sample);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	U32 bit_rate_hdr = 500000;
+	U32 bit_rate_data = 2000000;
+	bool inverted = false;
+	const char* settings = NULL;
+	const char* save_settings_file = NULL;
+	U32 sample_rate = 50000000;
+	double seconds = 1.0;
+	std::vector<const char*> edges_files;
+	const char* save_edges_file = NULL;
+	const char* before_edges_file = NULL;
+	double trigger_seconds = 0.0;
+	U32 export_type = 0;
+	U32 repeat = 1;
+	CanSimulationOptions simulation_options;
+	const char* ground_truth_file = NULL;
+	const char* export_file = NULL;
+	const char* find = NULL;
+	double at_seconds = 0.0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool has_value = (i + 1) < argc;
+
+		if (arg == "--inverted")
+			inverted = true;
+		else if ((arg == "--hdr") && has_value)
+			bit_rate_hdr = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--data") && has_value)
+			bit_rate_data = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--settings") && has_value)
+			settings = argv[++i];
+		else if ((arg == "--save-settings") && has_value)
+			save_settings_file = argv[++i];
+		else if ((arg == "--rate") && has_value)
+			sample_rate = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--seconds") && has_value)
+			seconds = atof(argv[++i]);
+		else if ((arg == "--edges") && has_value)
+			edges_files.push_back(argv[++i]);
+		else if ((arg == "--save-edges") && has_value)
+			save_edges_file = argv[++i];
+		else if ((arg == "--before-edges") && has_value)
+			before_edges_file = argv[++i];
+		else if ((arg == "--trigger") && has_value)
+			trigger_seconds = atof(argv[++i]);
+		else if ((arg == "--export-type") && has_value)
+			export_type = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--repeat") && has_value)
+			repeat = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--fault-rate") && has_value)
+			simulation_options.mFaultRate = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--ppm") && has_value)
+			simulation_options.mClockOffsetPpm = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--jitter-ns") && has_value)
+			simulation_options.mJitterNs = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--asymmetry-ns") && has_value)
+			simulation_options.mAsymmetryNs = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--glitches") && has_value)
+			simulation_options.mGlitchRate = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--glitch-ns") && has_value)
+			simulation_options.mGlitchNs = (U32)strtoul(argv[++i], NULL, 10);
+		else if ((arg == "--faults") && has_value)
+			simulation_options.mFaults = argv[++i];
+		else if ((arg == "--ground-truth") && has_value)
+			ground_truth_file = argv[++i];
+		else if ((arg == "--find") && has_value)
+			find = argv[++i];
+		else if ((arg == "--at") && has_value)
+			at_seconds = atof(argv[++i]);
+		else if ((arg.compare(0, 2, "--") != 0) && (export_file == NULL))
+			export_file = argv[i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if ((export_file == NULL) || (repeat == 0))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	U32 fault_mask;
+	if (CAN_FDSimulationDataGenerator::ParseFaults(simulation_options.mFaults, fault_mask) == false)
+	{
+		fprintf(stderr, "faults must be stuff, flip, form, ack, error, overload or collision, separated by commas\n");
+		return 1;
+	}
+
+	CAN_FDAnalyzer* analyzer = (CAN_FDAnalyzer*)CreateAnalyzer();
+	CAN_FDAnalyzerSettings* analyzer_settings = (CAN_FDAnalyzerSettings*)analyzer->GetAnalyzerSettings();
+
+	analyzer_settings->mInputChannel = Channel(0, 0, DIGITAL);
+	analyzer_settings->mBitRateHdr = bit_rate_hdr;
+	analyzer_settings->mBitRateData = bit_rate_data;
+	analyzer_settings->mInverted = inverted;
+	if (settings != NULL)
+		analyzer_settings->LoadSettings(settings);
+
+	if (save_settings_file != NULL)
+	{
+		FILE* out = fopen(save_settings_file, "w");
+		if (out == NULL)
+		{
+			fprintf(stderr, "can't write settings %s\n", save_settings_file);
+			DestroyAnalyzer(analyzer);
+			return 1;
+		}
+		fprintf(out, "%s\n", analyzer_settings->SaveSettings());
+		fclose(out);
+	}
+
+	if ((ground_truth_file != NULL) && (edges_files.empty() == true))
+		simulation_options.mGroundTruthFile = ground_truth_file;
+	analyzer->SetSimulationOptions(simulation_options);
+
+	/* Settings the analyzer changed itself, such as detected bit rates, carry over to the next capture */
+	if (before_edges_file != NULL)
+	{
+		AnalyzerStandIn::Capture before;
+		if (LoadEdges(before_edges_file, Channel(0, 0, DIGITAL), before) == false)
+		{
+			fprintf(stderr, "can't read edge list %s\n", before_edges_file);
+			DestroyAnalyzer(analyzer);
+			return 1;
+		}
+
+		AnalyzerStandIn::RunAnalyzer(analyzer, before);
+		while (analyzer->NeedsRerun() == true)
+			AnalyzerStandIn::RunAnalyzer(analyzer, before);
+	}
+
+	AnalyzerStandIn::Capture capture;
+	if (edges_files.empty() == false)
+	{
+		for (U32 i = 0; i < edges_files.size(); i++)
+		{
+			if (LoadEdges(edges_files[i], Channel(0, i, DIGITAL), capture) == false)
+			{
+				fprintf(stderr, "can't read edge list %s\n", edges_files[i]);
+				DestroyAnalyzer(analyzer);
+				return 1;
+			}
+		}
+	}
+	else
+	{
+		AnalyzerStandIn::CaptureFromSimulation(analyzer, sample_rate, U64(double(sample_rate) * seconds), capture);
+	}
+
+	/* Both ways of getting the capture leave the trigger at its start */
+	capture.mTriggerSample = U64(trigger_seconds * double(capture.mSampleRateHz) + 0.5);
+	if ((trigger_seconds < 0.0) || (capture.mTriggerSample >= capture.mNumSamples))
+	{
+		fprintf(stderr, "the trigger must be within the capture\n");
+		DestroyAnalyzer(analyzer);
+		return 1;
+	}
+
+	if ((save_edges_file != NULL) && (SaveEdges(save_edges_file, capture) == false))
+	{
+		fprintf(stderr, "can't write edge list %s\n", save_edges_file);
+		DestroyAnalyzer(analyzer);
+		return 1;
+	}
+
+	double fastest_ms = 0.0;
+	for (U32 i = 0; i < repeat; i++)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		AnalyzerStandIn::RunAnalyzer(analyzer, capture);
+
+		/* Auto-detection asks for a second pass with the settings it found */
+		while (analyzer->NeedsRerun() == true)
+			AnalyzerStandIn::RunAnalyzer(analyzer, capture);
+
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if ((i == 0) || (ms < fastest_ms))
+			fastest_ms = ms;
+	}
+
+	AnalyzerResults* results = analyzer->GetAnalyzerResults();
+	U64 edges = 0;
+	for (U32 i = 0; i < capture.mChannels.size(); i++)
+		edges += capture.mChannels[i].mEdges.size();
+
+	double capture_seconds = double(capture.mNumSamples) / double(capture.mSampleRateHz);
+	printf("capture %.3f s, %llu edges\n", capture_seconds, edges);
+	printf("decoded %llu frames, %llu packets in %.3f ms (%.1f x real time)\n", results->GetNumFrames(), results->GetNumPackets(), fastest_ms, (capture_seconds * 1000.0) / fastest_ms);
+
+	if (find != NULL)
+		ReportIdentifier(analyzer->GetIdIndex(), (U32)strtoul(find, NULL, 16), U64(at_seconds * double(capture.mSampleRateHz)), capture.mSampleRateHz);
+
+	std::string dbc_error = analyzer->GetDbc().GetError();
+	if (dbc_error.empty() == false)
+		fprintf(stderr, "DBC file not loaded: %s\n", dbc_error.c_str());
+
+	if (ground_truth_file != NULL)
+	{
+		std::vector<CanSimulatedFrame> frames;
+		if (LoadGroundTruth(ground_truth_file, capture.mSampleRateHz, frames) == true)
+			ReportGroundTruth(frames, results, capture);
+		else
+			fprintf(stderr, "can't read ground truth %s\n", ground_truth_file);
+	}
+
+	results->GenerateExportFile(export_file, Hexadecimal, export_type);
+
+	DestroyAnalyzer(analyzer);
+	return 0;
+}